@@ -0,0 +1,100 @@
+// a02yyuw_parser.h — Sensor MCU: ring-buffered A02YYUW frame parser
+// Frame: 0xFF, dist_hi, dist_lo, sum  (sum = low byte of 0xFF + hi + lo), 9600 8N1.
+// The UART is drained in bulk into the ring (writeSpan/produce), then next() walks
+// it one byte at a time. On a checksum failure only the header byte is dropped and
+// the remaining bytes are re-scanned for 0xFF, so one corrupted byte costs at most
+// one frame. Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef A02_RING_SIZE
+#define A02_RING_SIZE 128   // power of two; ~130 ms of 9600-baud traffic
+#endif
+
+static const uint16_t A02_MIN_MM = 30;
+static const uint16_t A02_MAX_MM = 4500;
+
+struct A02yyuwParser {
+  uint8_t  ring[A02_RING_SIZE];
+  uint16_t head, tail;      // free-running; masked on access
+  uint8_t  win[4];          // partial frame, win[0] == 0xFF when wlen > 0
+  uint8_t  wlen;
+
+  // Counters (since reset)
+  uint32_t goodFrames;
+  uint32_t checksumErrors;
+  uint32_t outOfRange;
+  uint32_t skippedBytes;    // bytes discarded while hunting for a header
+  uint32_t overruns;        // bytes the caller could not fit into the ring
+
+  void reset() { memset(this, 0, sizeof(*this)); }
+
+  size_t used() const { return (uint16_t)(head - tail); }
+  size_t space() const { return A02_RING_SIZE - used(); }
+
+  // Contiguous free space for a direct bulk read (e.g. Serial.readBytes).
+  uint8_t *writeSpan(size_t &len) {
+    const size_t off = head & (A02_RING_SIZE - 1);
+    const size_t toEnd = A02_RING_SIZE - off;
+    len = space() < toEnd ? space() : toEnd;
+    return &ring[off];
+  }
+  void produce(size_t n) { head = (uint16_t)(head + n); }
+
+  // Copying variant; returns bytes accepted.
+  size_t feed(const uint8_t *data, size_t len) {
+    size_t done = 0;
+    while (done < len) {
+      size_t span;
+      uint8_t *dst = writeSpan(span);
+      if (!span) break;
+      if (span > len - done) span = len - done;
+      memcpy(dst, data + done, span);
+      produce(span);
+      done += span;
+    }
+    overruns += (uint32_t)(len - done);
+    return done;
+  }
+
+  // Next valid distance in millimetres, or false once the ring is exhausted.
+  bool next(uint16_t &distance_mm) {
+    while (head != tail) {
+      const uint8_t b = ring[tail & (A02_RING_SIZE - 1)];
+      tail = (uint16_t)(tail + 1);
+
+      if (wlen == 0 && b != 0xFF) { ++skippedBytes; continue; }
+      win[wlen++] = b;
+      if (wlen < 4) continue;
+      wlen = 0;
+
+      if ((uint8_t)(win[0] + win[1] + win[2]) != win[3]) {
+        ++checksumErrors;
+        resync();
+        continue;
+      }
+      const uint16_t raw_mm = (uint16_t)((win[1] << 8) | win[2]);
+      if (raw_mm < A02_MIN_MM || raw_mm > A02_MAX_MM) { ++outOfRange; continue; }
+
+      ++goodFrames;
+      distance_mm = raw_mm;
+      return true;
+    }
+    return false;
+  }
+
+  // Keep everything from the next 0xFF after the failed header onwards.
+  void resync() {
+    for (uint8_t i = 1; i < 4; ++i) {
+      if (win[i] == 0xFF) {
+        memmove(win, win + i, 4 - i);
+        wlen = (uint8_t)(4 - i);
+        skippedBytes += i;
+        return;
+      }
+    }
+    skippedBytes += 4;
+  }
+};
@@ -0,0 +1,70 @@
+// channel_cache.h — Sensor MCU: RTC-cached Wi-Fi channel of the webserver's AP
+// The webserver follows its router's channel, so the sensor has to find it. Instead
+// of a full scan every wake, the last working channel is kept in RTC memory and used
+// directly. Only after CHANNEL_RESCAN_AFTER consecutive failed sends to the webserver
+// does the next wake scan again: first a single-channel probe of the cached channel,
+// then a full sweep. The scan itself is a callback so this compiles on the host.
+#pragma once
+#include <stdint.h>
+
+#ifndef CHANNEL_RESCAN_AFTER
+#define CHANNEL_RESCAN_AFTER 4   // failed sendPacketTo(webserver) attempts (2 per wake)
+#endif
+
+// Place in RTC_DATA_ATTR; all-zero (cold boot) means "unknown, scan".
+struct ChannelCache {
+  uint8_t  channel;      // 0 = unknown
+  uint8_t  failStreak;   // consecutive failed sends on `channel`
+  uint32_t hits;         // wakes served from cache (no radio scan)
+  uint32_t misses;       // wakes that scanned
+  uint32_t probeHits;    // misses settled by the cached-channel probe alone
+};
+
+// Scan backend: channel 0 sweeps all channels, otherwise scans just that one.
+// Returns the channel the AP was seen on, or 0 if not found.
+typedef uint8_t (*ChannelScanFn)(uint8_t channel, void *ctx);
+
+enum ChannelSource : uint8_t { CH_CACHED, CH_PROBED, CH_SCANNED, CH_FALLBACK };
+
+static inline const char *channelSourceName(ChannelSource s) {
+  switch (s) {
+    case CH_CACHED:  return "cached";
+    case CH_PROBED:  return "probed";
+    case CH_SCANNED: return "scanned";
+    default:         return "fallback";
+  }
+}
+
+static inline uint8_t channelSelect(ChannelCache &c, ChannelScanFn scan, void *ctx,
+                                    ChannelSource &src, uint8_t fallback = 1) {
+  if (c.channel && c.failStreak < CHANNEL_RESCAN_AFTER) {
+    c.hits++;
+    src = CH_CACHED;
+    return c.channel;
+  }
+
+  c.misses++;
+  uint8_t ch = 0;
+  if (c.channel) {
+    ch = scan(c.channel, ctx);
+    if (ch) { c.probeHits++; src = CH_PROBED; }
+  }
+  if (!ch) {
+    ch = scan(0, ctx);
+    src = ch ? CH_SCANNED : CH_FALLBACK;
+  }
+
+  // Fresh budget either way: a known-but-silent channel is retried for another
+  // CHANNEL_RESCAN_AFTER sends before the next scan, so an offline AP can't make
+  // every wake pay for a full sweep.
+  c.failStreak = 0;
+  if (!ch) return c.channel ? c.channel : fallback;
+  c.channel = ch;
+  return ch;
+}
+
+// Feed back the outcome of every send attempt to the webserver.
+static inline void channelReport(ChannelCache &c, bool ok) {
+  if (ok) c.failStreak = 0;
+  else if (c.failStreak < 0xFF) c.failStreak++;
+}
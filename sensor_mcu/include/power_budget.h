@@ -0,0 +1,137 @@
+// power_budget.h — where a sensor's awake time goes, and what it costs per day
+// Shared verbatim by sensor_mcu and webserver_mcu (keep the copies equal).
+//
+// The sensor stamps each phase of a wake with the microsecond timer (PhaseClock) and
+// adds the durations to a PowerBudget kept in RTC memory. Once POWER_REPORT_WAKES
+// wakes have gone by, the next webserver batch carries a PowerBlock after its
+// readings: average ms per wake for each phase, over a window of that many wakes.
+// The webserver turns it into an estimated mAh/day per phase using the nominal
+// currents below. The absolute numbers are only as good as those currents. A phase
+// that starts taking longer (a scan that no longer hits the cache, acks that time
+// out) shows up regardless. Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef POWER_REPORT_WAKES
+#define POWER_REPORT_WAKES 16
+#endif
+#define POWER_BLOCK_TAG 0xE1
+#define POWER_SLEEP_MA  0.010f     // deep sleep, RTC timer + RTC memory
+
+enum PowerPhase : uint8_t {
+  PH_BOOT,       // reset -> sampling: the serial wait, radios off
+  PH_SAMPLE,     // UART sampling and the decision to send
+  PH_WAIT,       // jitter or slot wait, radio still off
+  PH_RADIO,      // Wi-Fi up, ESP-NOW init, channel switches and settles
+  PH_SCAN,       // findWebserverChannel()
+  PH_SEND,       // esp_now_send() until the ack (or its timeout)
+  PH_REPLY,      // listening for the slot reply or the receivers' acks
+  PH_SHUTDOWN,   // radios off, serial flush
+  PH_COUNT
+};
+
+static const char *const POWER_PHASE_NAMES[PH_COUNT] = {
+  "boot", "sample", "wait", "radio", "scan", "send", "reply", "shutdown"
+};
+
+// Nominal supply current per phase (mA): ESP32 at 240 MHz, A02YYUW powered while
+// sampling, radio receiving between frames.
+static const float POWER_PHASE_MA[PH_COUNT] = { 30, 40, 30, 100, 110, 120, 100, 30 };
+
+// ---- Sensor side ----
+struct PhaseClock {
+  uint8_t  cur = PH_BOOT;
+  int64_t  t0  = 0;              // the microsecond timer counts from boot
+  uint32_t us[PH_COUNT] = {};
+
+  void enter(uint8_t phase, int64_t nowUs) {
+    if (phase == cur) return;
+    us[cur] += (uint32_t)(nowUs - t0);
+    cur = phase;
+    t0  = nowUs;
+  }
+};
+
+// Place in RTC_DATA_ATTR; all-zero (cold boot) starts an empty window.
+struct PowerBudget {
+  uint32_t ms[PH_COUNT];         // awake time per phase over the window
+  uint32_t startT;               // RTC seconds the window's first wake began
+  uint16_t wakes, txWakes;
+};
+
+// Call last thing before deep sleep; closes the running phase.
+static inline void powerAddWake(PowerBudget &b, PhaseClock &c, int64_t nowUs, uint32_t wakeT, bool transmitted) {
+  c.enter(PH_COUNT, nowUs);
+  if (!b.wakes) b.startT = wakeT;
+  for (uint8_t i = 0; i < PH_COUNT; ++i) b.ms[i] += (c.us[i] + 500) / 1000;
+  if (b.wakes < 0xFFFF) b.wakes++;
+  if (transmitted && b.txWakes < 0xFFFF) b.txWakes++;
+}
+
+// Delivered: start a new window with the wake that sent it.
+static inline void powerReset(PowerBudget &b) { memset(&b, 0, sizeof(b)); }
+
+// ---- Wire format (after the readings of a webserver batch, before its crc8) ----
+#pragma pack(push,1)
+struct PowerBlock {
+  uint8_t  tag;                  // POWER_BLOCK_TAG
+  uint8_t  phases;               // avg_ms entries that follow; receivers skip ones they don't know
+  uint16_t wakes, txWakes;
+  uint32_t windowS;              // wall time the wakes span, sleeps included
+};
+#pragma pack(pop)
+
+// endT: when the current (not yet counted) wake began. Returns bytes written, 0 if
+// there's no room or nothing to report.
+static inline size_t powerEncode(const PowerBudget &b, uint32_t endT, uint8_t *out, size_t cap) {
+  const size_t len = sizeof(PowerBlock) + 2 * PH_COUNT;
+  if (!b.wakes || cap < len) return 0;
+  PowerBlock h{POWER_BLOCK_TAG, PH_COUNT, b.wakes, b.txWakes, endT > b.startT ? endT - b.startT : 0};
+  memcpy(out, &h, sizeof(h));
+  for (uint8_t i = 0; i < PH_COUNT; ++i) {
+    const uint32_t avg = (b.ms[i] + b.wakes / 2) / b.wakes;
+    const uint16_t v = avg > 0xFFFF ? 0xFFFF : (uint16_t)avg;
+    memcpy(out + sizeof(h) + 2 * i, &v, 2);
+  }
+  return len;
+}
+
+// ---- Webserver side ----
+struct PowerReport {
+  uint16_t avgMs[PH_COUNT];      // per wake
+  uint32_t windowS;
+  uint16_t wakes, txWakes;
+};
+
+static inline bool powerDecode(const uint8_t *d, size_t n, PowerReport &r) {
+  PowerBlock h;
+  if (n < sizeof(h)) return false;
+  memcpy(&h, d, sizeof(h));
+  if (h.tag != POWER_BLOCK_TAG || !h.wakes || !h.windowS || n < sizeof(h) + 2u * h.phases) return false;
+  memset(&r, 0, sizeof(r));
+  for (uint8_t i = 0; i < h.phases && i < PH_COUNT; ++i) memcpy(&r.avgMs[i], d + sizeof(h) + 2 * i, 2);
+  r.windowS = h.windowS;
+  r.wakes   = h.wakes;
+  r.txWakes = h.txWakes;
+  return true;
+}
+
+// Estimated mAh/day: per awake phase into perPhase (may be null), sleep into *sleep
+// (may be null); returns the total. Assumes the window's wake rate continues.
+static inline float powerMahPerDay(const PowerReport &r, float *perPhase, float *sleep) {
+  const float wakesPerDay = (float)r.wakes * 86400.0f / (float)r.windowS;
+  float total = 0, awakeS = 0;
+  for (uint8_t i = 0; i < PH_COUNT; ++i) {
+    const float mah = (float)r.avgMs[i] / 3.6e6f * POWER_PHASE_MA[i] * wakesPerDay;
+    if (perPhase) perPhase[i] = mah;
+    total  += mah;
+    awakeS += (float)r.avgMs[i] / 1000.0f;
+  }
+  float sleepS = 86400.0f - awakeS * wakesPerDay;
+  if (sleepS < 0) sleepS = 0;
+  const float s = POWER_SLEEP_MA * sleepS / 3600.0f;
+  if (sleep) *sleep = s;
+  return total + s;
+}
@@ -0,0 +1,192 @@
+// reading_history.h — Sensor MCU: RTC-resident reading history + send-on-change policy
+// Every wake pushes its median here (the struct lives in RTC_DATA_ATTR, so it survives
+// deep sleep). The radio is only brought up when historyShouldSend() says so; the
+// readings buffered since the last delivery then go to the webserver as one
+// delta-encoded batch, which the webserver unpacks with historyDecodeDeltas(). Shared
+// verbatim by sensor_mcu and webserver_mcu (keep the copies equal). Plain C++, no
+// Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef HISTORY_LEN
+#define HISTORY_LEN 16   // readings kept across deep sleep (max batch size)
+#endif
+
+struct HistoryEntry {
+  uint32_t t_s;     // RTC clock seconds (monotonic across deep sleep)
+  uint16_t mm;      // median, 0 if invalid
+  uint8_t  flags;   // SensorPacket flags
+};
+
+struct ReadingHistory {
+  HistoryEntry e[HISTORY_LEN];
+  uint8_t  head;          // next write slot
+  uint8_t  count;         // entries held (<= HISTORY_LEN)
+  uint8_t  unsent;        // newest entries not yet delivered to the webserver
+  bool     everSent;
+  bool     retry;         // last transmit failed
+  uint8_t  lastSentFlags;
+  uint16_t lastSentMm;
+  uint16_t wakesSinceTx;
+  uint32_t lastSentT;     // t_s of the newest reading delivered
+};
+
+struct SendPolicy {
+  uint16_t deltaMm;         // send when the level moved more than this since the last send
+  uint16_t nearRiskMm;      // always send at or below this distance
+  uint32_t heartbeatS;      // send at least this often (sleep lengths vary, so time not wakes)
+};
+
+enum SendReason : uint8_t {
+  SEND_NONE, SEND_FIRST, SEND_RETRY, SEND_VALIDITY, SEND_NEAR_RISK,
+  SEND_CHANGE, SEND_HEARTBEAT, SEND_BACKLOG
+};
+
+static inline const char *sendReasonName(SendReason r) {
+  switch (r) {
+    case SEND_NONE:      return "none";
+    case SEND_FIRST:     return "first";
+    case SEND_RETRY:     return "retry";
+    case SEND_VALIDITY:  return "validity";
+    case SEND_NEAR_RISK: return "near_risk";
+    case SEND_CHANGE:    return "change";
+    case SEND_HEARTBEAT: return "heartbeat";
+    default:             return "backlog";
+  }
+}
+
+// k = 0 is the newest entry.
+static inline const HistoryEntry &historyAt(const ReadingHistory &h, uint8_t k) {
+  return h.e[(h.head + HISTORY_LEN - 1 - k) % HISTORY_LEN];
+}
+
+static inline void historyPush(ReadingHistory &h, uint32_t t_s, uint16_t mm, uint8_t flags) {
+  h.e[h.head] = HistoryEntry{t_s, mm, flags};
+  h.head = (uint8_t)((h.head + 1) % HISTORY_LEN);
+  if (h.count < HISTORY_LEN) h.count++;
+  if (h.unsent < HISTORY_LEN) h.unsent++;
+  if (h.wakesSinceTx < 0xFFFF) h.wakesSinceTx++;
+}
+
+static inline SendReason historyShouldSend(const ReadingHistory &h, const SendPolicy &p) {
+  if (!h.count) return SEND_NONE;
+  const HistoryEntry &cur = historyAt(h, 0);
+  const bool curValid  = cur.flags & 0x01;
+  const bool lastValid = h.lastSentFlags & 0x01;
+
+  if (!h.everSent)                          return SEND_FIRST;
+  if (h.retry)                              return SEND_RETRY;
+  if (curValid != lastValid)                return SEND_VALIDITY;
+  if (curValid && cur.mm <= p.nearRiskMm)   return SEND_NEAR_RISK;
+  if (curValid && h.lastSentMm <= p.nearRiskMm) return SEND_NEAR_RISK;  // leaving the zone
+  if (curValid) {
+    const int d = (int)cur.mm - (int)h.lastSentMm;
+    if (d > p.deltaMm || -d > p.deltaMm)    return SEND_CHANGE;
+  }
+  if (cur.t_s - h.lastSentT >= p.heartbeatS) return SEND_HEARTBEAT;
+  if (h.unsent >= HISTORY_LEN)              return SEND_BACKLOG;
+  return SEND_NONE;
+}
+
+static inline void historyMarkSent(ReadingHistory &h) {
+  const HistoryEntry &cur = historyAt(h, 0);
+  h.unsent        = 0;
+  h.everSent      = true;
+  h.retry         = false;
+  h.lastSentMm    = cur.mm;
+  h.lastSentFlags = cur.flags;
+  h.wakesSinceTx  = 0;
+  h.lastSentT     = cur.t_s;
+}
+
+static inline void historyMarkFailed(ReadingHistory &h) { h.retry = true; }
+
+// Fill rate in mm/min (positive = level rising, i.e. distance shrinking) between the
+// newest valid reading and the oldest valid one at most windowS older. False when
+// there is no pair at least a minute apart.
+static inline bool historyFillRate(const ReadingHistory &h, uint32_t windowS, float &mmPerMin) {
+  if (!h.count || !(historyAt(h, 0).flags & 0x01)) return false;
+  const HistoryEntry &cur = historyAt(h, 0);
+  const HistoryEntry *old = nullptr;
+  for (uint8_t k = 1; k < h.count; ++k) {
+    const HistoryEntry &e = historyAt(h, k);
+    if (cur.t_s - e.t_s > windowS) break;
+    if (e.flags & 0x01) old = &e;
+  }
+  if (!old || cur.t_s - old->t_s < 60) return false;
+  mmPerMin = ((float)old->mm - (float)cur.mm) * 60.0f / (float)(cur.t_s - old->t_s);
+  return true;
+}
+
+// ---- Batch payload: entries 1..n-1 (older), each relative to the next-newer one ----
+//   varint(age_delta_s)  zigzag-varint(distance_delta_mm)
+static inline size_t putVarint(uint8_t *out, size_t cap, size_t pos, uint32_t v) {
+  do {
+    if (pos >= cap) return 0;
+    uint8_t b = v & 0x7F;
+    v >>= 7;
+    out[pos++] = v ? (uint8_t)(b | 0x80) : b;
+  } while (v);
+  return pos;
+}
+
+// False if the payload ends mid-varint (or runs past five bytes).
+static inline bool getVarint(const uint8_t *d, size_t n, size_t &pos, uint32_t &v) {
+  v = 0;
+  for (int shift = 0; pos < n && shift < 35; shift += 7) {
+    uint8_t b = d[pos++];
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+static inline uint32_t zigzag(int32_t v)   { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t  unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// Encodes the older `n - 1` of the newest `n` entries into `out`. Returns false if
+// `cap` is too small.
+static inline bool historyEncodeDeltas(const ReadingHistory &h, uint8_t n, uint8_t *out, size_t cap,
+                                       size_t &len) {
+  size_t pos = 0;
+  for (uint8_t k = 1; k < n && k < h.count; ++k) {
+    const HistoryEntry &newer = historyAt(h, k - 1);
+    const HistoryEntry &older = historyAt(h, k);
+    pos = putVarint(out, cap, pos, newer.t_s - older.t_s);
+    if (!pos) return false;
+    pos = putVarint(out, cap, pos, zigzag((int32_t)older.mm - (int32_t)newer.mm));
+    if (!pos) return false;
+  }
+  len = pos;
+  return true;
+}
+
+// ---- Webserver side ----
+struct HistoryDelta {
+  uint32_t ageS;    // seconds before the batch's newest reading
+  uint16_t mm;      // 0 if invalid (or decoded out of range)
+};
+
+// Decodes the older readings of a batch payload, newest first, into out[0..max).
+// newestMm is the header's distance, which the first delta is relative to. Returns
+// how many were decoded; truncated says the payload ended before `count - 1` of them.
+// trailer is where a block after the deltas (the power budget) starts, or n when
+// there is none or the deltas weren't all read (truncated, or more than max).
+static inline uint8_t historyDecodeDeltas(const uint8_t *d, size_t n, uint8_t count, uint16_t newestMm,
+                                          HistoryDelta *out, uint8_t max, bool &truncated, size_t &trailer) {
+  uint8_t k = 0;
+  uint32_t age = 0;
+  int32_t  mm  = newestMm;
+  size_t   pos = 0;
+  truncated = false;
+  while (k + 1 < count && k < max) {
+    uint32_t dt, zz;
+    if (!getVarint(d, n, pos, dt) || !getVarint(d, n, pos, zz)) { truncated = true; break; }
+    age += dt;
+    mm  += unzigzag(zz);
+    out[k++] = HistoryDelta{age, (mm > 0 && mm < 0xFFFF) ? (uint16_t)mm : (uint16_t)0};
+  }
+  trailer = (!truncated && k + 1 >= count) ? pos : n;
+  return k;
+}
@@ -0,0 +1,71 @@
+// running_stats.h — Sensor MCU: incremental order statistics over one sampling window
+// Each A02YYUW reading is inserted into a sorted array of integer millimetres as it
+// arrives, so min/median/max/percentiles are ready the moment the last frame lands
+// (no copy + sort after the window closes). Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef RUNNING_STATS_CAP
+#define RUNNING_STATS_CAP 100   // matches the sampling window's MAX_SAMPLES
+#endif
+
+struct RunningStats {
+  uint16_t mm[RUNNING_STATS_CAP];   // ascending
+  uint16_t n;
+
+  void reset() { n = 0; }
+  bool full() const { return n >= RUNNING_STATS_CAP; }
+
+  // Binary search for the insertion point, then shift the tail up by one.
+  // O(log n) compares + one memmove of at most 2*CAP bytes per sample.
+  bool add(uint16_t v) {
+    if (full()) return false;
+    uint16_t lo = 0, hi = n;
+    while (lo < hi) {
+      uint16_t mid = (uint16_t)((lo + hi) >> 1);
+      if (mm[mid] <= v) lo = (uint16_t)(mid + 1); else hi = mid;
+    }
+    memmove(&mm[lo + 1], &mm[lo], (size_t)(n - lo) * sizeof(mm[0]));
+    mm[lo] = v;
+    ++n;
+    return true;
+  }
+
+  uint16_t minimum() const { return n ? mm[0] : 0; }
+  uint16_t maximum() const { return n ? mm[n - 1] : 0; }
+
+  // Even counts average the two middle values (rounded), like the old float path.
+  uint16_t median() const {
+    if (!n) return 0;
+    if (n & 1) return mm[n / 2];
+    return (uint16_t)(((uint32_t)mm[n / 2 - 1] + mm[n / 2] + 1) / 2);
+  }
+
+  // Nearest-rank percentile, pct in 0..100.
+  uint16_t percentile(uint8_t pct) const {
+    if (!n) return 0;
+    if (pct > 100) pct = 100;
+    uint32_t rank = ((uint32_t)pct * n + 99) / 100;   // ceil(pct/100 * n)
+    if (rank == 0) rank = 1;
+    return mm[rank - 1];
+  }
+
+  // Width (mm) of a ~95% distribution-free confidence band for the median: the
+  // order statistics at n/2 -/+ 0.98*sqrt(n) (normal approximation to the binomial).
+  uint16_t medianBand() const {
+    if (n < 2) return 0xFFFF;
+    const float h = 0.98f * sqrtf((float)n);
+    int lo = (int)floorf(n * 0.5f - h);
+    int hi = (int)ceilf(n * 0.5f + h);
+    if (lo < 0) lo = 0;
+    if (hi > n - 1) hi = n - 1;
+    return (uint16_t)(mm[hi] - mm[lo]);
+  }
+
+  // Early-exit test for the sampling loop.
+  bool converged(uint16_t minSamples, uint16_t tolMm) const {
+    return n >= minSamples && medianBand() <= tolMm;
+  }
+};
@@ -0,0 +1,62 @@
+// sampling_window.h — Sensor MCU: one wake's A02YYUW sampling window, minus the UART
+// The caller drains the UART into `parser` (bulk, see a02yyuw_parser.h) and calls
+// poll() with the time; poll() moves every complete frame into `stats` and says when
+// the window is over: the median converged (adaptive), the buffer is full, or capMs
+// went by. Kept apart from the UART so recorded captures can be replayed through it
+// on a host (utilities/host_tests/test_sampling_replay.cpp). Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include "a02yyuw_parser.h"
+#include "running_stats.h"
+
+struct SamplingConfig {
+  uint32_t capMs;          // hard cap (SCAN_MS)
+  bool     adaptive;       // stop once converged (SCAN_ADAPTIVE)
+  uint16_t tolMm;          // median band that counts as converged (SCAN_TOL_MM)
+  uint16_t minSamples;     // never converge on fewer (SCAN_MIN_SAMPLES)
+};
+
+enum WindowEnd : uint8_t { WIN_OPEN, WIN_CONVERGED, WIN_FULL, WIN_TIMEOUT };
+
+struct SamplingWindow {
+  A02yyuwParser parser;
+  RunningStats  stats;
+  SamplingConfig cfg;
+  uint32_t startMs, endMs;
+  uint8_t  end;            // WindowEnd
+
+  void begin(const SamplingConfig &c, uint32_t nowMs) {
+    parser.reset();
+    stats.reset();
+    cfg = c;
+    startMs = endMs = nowMs;
+    end = WIN_OPEN;
+  }
+
+  // Returns true once the window is closed.
+  bool poll(uint32_t nowMs) {
+    if (end != WIN_OPEN) return true;
+    uint16_t mm;
+    while (!stats.full() && parser.next(mm)) {
+      stats.add(mm);
+      if (cfg.adaptive && stats.converged(cfg.minSamples, cfg.tolMm)) return close(WIN_CONVERGED, nowMs);
+    }
+    if (stats.full()) return close(WIN_FULL, nowMs);
+    if (nowMs - startMs >= cfg.capMs) return close(WIN_TIMEOUT, nowMs);
+    return false;
+  }
+
+  bool     earlyExit() const { return end == WIN_CONVERGED; }
+  uint32_t scanMs() const { return endMs - startMs; }
+
+private:
+  bool close(uint8_t why, uint32_t nowMs) {
+    end = why;
+    endMs = nowMs;
+    return true;
+  }
+};
+
+static inline const char *windowEndName(uint8_t e) {
+  return e == WIN_CONVERGED ? "converged" : e == WIN_FULL ? "full" : e == WIN_TIMEOUT ? "cap" : "open";
+}
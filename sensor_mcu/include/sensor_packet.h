@@ -0,0 +1,315 @@
+// sensor_packet.h — the frames sensors, siren and webserver exchange, and per-sender
+// sequence tracking
+// Shared verbatim by sensor_mcu, siren_mcu and webserver_mcu (keep the copies equal).
+//
+// v1 (8 bytes) carries only the reading. v2 (17 bytes) adds a sequence number that
+// the sensor keeps in RTC memory and bumps once per transmitting wake (retries reuse
+// it), how long ago the sample finished, how many samples it took, the scan time and
+// how long it will sleep before the next reading. v3 (19 bytes) adds a boot nonce:
+// random per power-up, kept in RTC memory across deep sleep. txSeq restarts at power
+// loss, and without the nonce the new seqs read as duplicates or a huge loss.
+// Receivers tell the versions apart by length and decode all three into SensorReading.
+//
+// A history batch (HistoryHeader + deltas) carries the same reading plus the older
+// ones not yet delivered. With a single broadcast per wake, siren and webserver both
+// take the batch and each answers with an AppAck (the webserver's SlotReply counts as
+// its ack). The webserver broadcasts a ChannelAnnounce so the siren can find and
+// follow its channel. Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// CRC-8-ATM (poly 0x07, init 0x00)
+static inline uint8_t crc8(const uint8_t *d, size_t n) {
+  uint8_t c = 0;
+  for (size_t i = 0; i < n; i++) { c ^= d[i]; for (int b = 0; b < 8; b++) c = (c & 0x80) ? (uint8_t)((c << 1) ^ 0x07) : (uint8_t)(c << 1); }
+  return c;
+}
+
+#pragma pack(push,1)
+struct SensorPacketV1 {
+  uint8_t  ver;          // 1
+  uint8_t  tank_id;      // 0/1/2
+  uint16_t distance_mm;  // median (0 if invalid)
+  uint16_t battery_mV;   // 0 if unused
+  uint8_t  flags;        // bit0: valid_median, bit1: at_risk_le_6cm, bit2: early_exit
+  uint8_t  crc8;         // CRC-8 over [ver..flags]
+};
+
+struct SensorPacketV2 {
+  uint8_t  ver;          // 2
+  uint8_t  tank_id;
+  uint16_t seq;          // per transmitting wake, RTC-persisted; same for retries
+  uint16_t distance_mm;
+  uint16_t battery_mV;
+  uint8_t  flags;        // as v1
+  uint8_t  samples;      // readings behind the median
+  uint16_t scan_ms;      // sampling time
+  uint16_t age_ms;       // sample end -> this frame sent (saturates)
+  uint16_t interval_s;   // sleep chosen after this wake (adaptive)
+  uint8_t  crc8;         // CRC-8 over [ver..interval_s]
+};
+
+struct SensorPacketV3 {
+  uint8_t  ver;          // 3
+  uint8_t  tank_id;
+  uint16_t seq;
+  uint16_t boot;         // random per sensor power-up, never 0
+  uint16_t distance_mm;
+  uint16_t battery_mV;
+  uint8_t  flags;
+  uint8_t  samples;
+  uint16_t scan_ms;
+  uint16_t age_ms;
+  uint16_t interval_s;
+  uint8_t  crc8;         // CRC-8 over [ver..interval_s]
+};
+#pragma pack(pop)
+
+#pragma pack(push,1)
+// Sensor -> webserver (and siren, when broadcast): the newest reading in full, then
+// `count - 1` older readings as varint deltas (newer.t - older.t seconds, zigzag
+// older.mm - newer.mm), optionally a PowerBlock (power_budget.h), then crc8 over
+// everything.
+struct HistoryHeader {
+  uint8_t  ver;          // 3 (v2 lacked boot, v1 seq..age_ms)
+  uint8_t  type;         // 0xB1 (byte 1 is tank_id in a SensorPacket; receivers tell them apart by length)
+  uint8_t  tank_id;
+  uint8_t  count;        // readings in batch, newest first (>= 1)
+  uint16_t seq;          // same as the SensorPacketV3 of this wake
+  uint16_t boot;
+  uint16_t distance_mm;  // newest median (0 if invalid)
+  uint16_t battery_mV;
+  uint8_t  flags;        // as SensorPacket
+  uint8_t  samples;
+  uint16_t scan_ms;
+  uint16_t age_ms;       // newest sample end -> this frame sent
+  uint16_t interval_s;   // sleep chosen after this wake
+  uint16_t next_tx_s;    // latest the next frame is due; receivers size offline timeouts by it
+};
+
+struct HistoryHeaderV2 { // still accepted from sensors on older firmware
+  uint8_t  ver;          // 2
+  uint8_t  type;         // 0xB1
+  uint8_t  tank_id;
+  uint8_t  count;
+  uint16_t seq;
+  uint16_t distance_mm;  // newest median (0 if invalid)
+  uint16_t battery_mV;
+  uint8_t  flags;        // as SensorPacket
+  uint8_t  samples;
+  uint16_t scan_ms;
+  uint16_t age_ms;       // newest sample end -> this frame sent
+  uint16_t interval_s;   // sleep chosen after this wake
+  uint16_t next_tx_s;    // latest the next frame is due; receivers size offline timeouts by it
+};
+
+struct HistoryHeaderV1 { // likewise
+  uint8_t  ver;          // 1
+  uint8_t  type;         // 0xB1
+  uint8_t  tank_id;
+  uint8_t  count;
+  uint16_t distance_mm;
+  uint16_t battery_mV;
+  uint8_t  flags;
+  uint16_t next_tx_s;
+};
+
+// Siren or webserver -> sensor: "got batch seq". Sent for duplicates too, since a
+// retry means the sensor missed the first ack.
+#define ACK_TYPE 0xA2
+enum AckFrom : uint8_t { ACK_FROM_SIREN = 1, ACK_FROM_WEBSERVER = 2 };
+struct AppAck {
+  uint8_t  ver;          // 1
+  uint8_t  type;         // 0xA2
+  uint8_t  tank_id;
+  uint16_t seq;
+  uint8_t  from;         // AckFrom
+  uint8_t  crc8;         // CRC-8 over [ver..from]
+};
+
+// Webserver broadcast, every ANNOUNCE_MS, on the channel it operates on.
+#define ANNOUNCE_TYPE 0xA1
+struct ChannelAnnounce {
+  uint8_t  ver;          // 1
+  uint8_t  type;         // 0xA1
+  uint8_t  channel;      // 1..14
+  uint8_t  crc8;
+};
+#pragma pack(pop)
+
+struct SensorReading {
+  uint8_t  ver;
+  uint8_t  tank_id;
+  uint16_t seq;          // v2+
+  uint16_t boot;         // v3 only; 0 = unknown
+  uint16_t distance_mm;
+  uint16_t battery_mV;
+  uint8_t  flags;
+  uint8_t  samples;      // v2+
+  uint16_t scan_ms;      // v2+
+  uint16_t age_ms;       // v2+
+  uint16_t interval_s;   // v2+; 0 = unknown
+};
+
+enum PacketStatus { PKT_OK, PKT_BAD_SIZE, PKT_BAD_CRC, PKT_BAD_VERSION };
+
+static inline size_t encodeSensorPacket(const SensorReading &r, uint8_t *out) {
+  SensorPacketV3 p{3, r.tank_id, r.seq, r.boot, r.distance_mm, r.battery_mV, r.flags, r.samples, r.scan_ms, r.age_ms, r.interval_s, 0};
+  p.crc8 = crc8((const uint8_t *)&p, sizeof(p) - 1);
+  memcpy(out, &p, sizeof(p));
+  return sizeof(p);
+}
+
+static inline PacketStatus decodeSensorPacket(const uint8_t *data, int len, SensorReading &r) {
+  if (len == (int)sizeof(SensorPacketV1)) {
+    SensorPacketV1 p;
+    memcpy(&p, data, sizeof(p));
+    if (p.crc8 != crc8(data, sizeof(p) - 1)) return PKT_BAD_CRC;
+    if (p.ver != 1) return PKT_BAD_VERSION;
+    r = SensorReading{1, p.tank_id, 0, 0, p.distance_mm, p.battery_mV, p.flags, 0, 0, 0, 0};
+    return PKT_OK;
+  }
+  if (len == (int)sizeof(SensorPacketV2)) {
+    SensorPacketV2 p;
+    memcpy(&p, data, sizeof(p));
+    if (p.crc8 != crc8(data, sizeof(p) - 1)) return PKT_BAD_CRC;
+    if (p.ver != 2) return PKT_BAD_VERSION;
+    r = SensorReading{2, p.tank_id, p.seq, 0, p.distance_mm, p.battery_mV, p.flags, p.samples, p.scan_ms, p.age_ms, p.interval_s};
+    return PKT_OK;
+  }
+  if (len == (int)sizeof(SensorPacketV3)) {
+    SensorPacketV3 p;
+    memcpy(&p, data, sizeof(p));
+    if (p.crc8 != crc8(data, sizeof(p) - 1)) return PKT_BAD_CRC;
+    if (p.ver != 3) return PKT_BAD_VERSION;
+    r = SensorReading{3, p.tank_id, p.seq, p.boot, p.distance_mm, p.battery_mV, p.flags, p.samples, p.scan_ms, p.age_ms, p.interval_s};
+    return PKT_OK;
+  }
+  return PKT_BAD_SIZE;
+}
+
+// Byte 1 is the tank_id in a SensorPacket, so with 178+ tanks it can read 0xB1 too;
+// a 17-byte frame starting with 2 is always a SensorPacketV2 and a 19-byte one starting
+// with 3 a SensorPacketV3 (v2 and v3 batches are longer).
+static inline bool isHistoryBatch(const uint8_t *data, int len) {
+  const bool singleV2 = len == (int)sizeof(SensorPacketV2) && data[0] == 2;
+  const bool singleV3 = len == (int)sizeof(SensorPacketV3) && data[0] == 3;
+  return len > (int)sizeof(HistoryHeaderV1) && data[1] == 0xB1 && !singleV2 && !singleV3;
+}
+
+// Newest reading of a batch (CRC over the whole frame checked here). hdrLen is where
+// the deltas start.
+static inline PacketStatus decodeHistoryHeader(const uint8_t *data, int len, SensorReading &r,
+                                               uint8_t &count, uint16_t &next_tx_s, size_t &hdrLen) {
+  if (len < 2) return PKT_BAD_SIZE;
+  if (data[len - 1] != crc8(data, len - 1)) return PKT_BAD_CRC;
+  if (data[0] == 3 && len > (int)sizeof(HistoryHeader)) {
+    HistoryHeader h;
+    memcpy(&h, data, sizeof(h));
+    r = SensorReading{3, h.tank_id, h.seq, h.boot, h.distance_mm, h.battery_mV, h.flags, h.samples, h.scan_ms, h.age_ms, h.interval_s};
+    count = h.count; next_tx_s = h.next_tx_s; hdrLen = sizeof(h);
+  } else if (data[0] == 2 && len > (int)sizeof(HistoryHeaderV2)) {
+    HistoryHeaderV2 h;
+    memcpy(&h, data, sizeof(h));
+    r = SensorReading{2, h.tank_id, h.seq, 0, h.distance_mm, h.battery_mV, h.flags, h.samples, h.scan_ms, h.age_ms, h.interval_s};
+    count = h.count; next_tx_s = h.next_tx_s; hdrLen = sizeof(h);
+  } else if (data[0] == 1 && len > (int)sizeof(HistoryHeaderV1)) {
+    HistoryHeaderV1 h;
+    memcpy(&h, data, sizeof(h));
+    r = SensorReading{1, h.tank_id, 0, 0, h.distance_mm, h.battery_mV, h.flags, 0, 0, 0, 0};
+    count = h.count; next_tx_s = h.next_tx_s; hdrLen = sizeof(h);
+  } else {
+    return PKT_BAD_VERSION;
+  }
+  return count ? PKT_OK : PKT_BAD_VERSION;
+}
+
+static inline AppAck makeAppAck(uint8_t tank_id, uint16_t seq, AckFrom from) {
+  AppAck a{1, ACK_TYPE, tank_id, seq, (uint8_t)from, 0};
+  a.crc8 = crc8((const uint8_t *)&a, sizeof(a) - 1);
+  return a;
+}
+
+static inline bool decodeAppAck(const uint8_t *data, int len, AppAck &a) {
+  if (len != (int)sizeof(AppAck)) return false;
+  memcpy(&a, data, sizeof(a));
+  return a.ver == 1 && a.type == ACK_TYPE && a.crc8 == crc8(data, sizeof(a) - 1);
+}
+
+static inline ChannelAnnounce makeAnnounce(uint8_t channel) {
+  ChannelAnnounce a{1, ANNOUNCE_TYPE, channel, 0};
+  a.crc8 = crc8((const uint8_t *)&a, sizeof(a) - 1);
+  return a;
+}
+
+static inline bool decodeAnnounce(const uint8_t *data, int len, ChannelAnnounce &a) {
+  if (len != (int)sizeof(ChannelAnnounce)) return false;
+  memcpy(&a, data, sizeof(a));
+  return a.ver == 1 && a.type == ANNOUNCE_TYPE && a.crc8 == crc8(data, sizeof(a) - 1)
+      && a.channel >= 1 && a.channel <= 14;
+}
+
+// ---- Per-sender duplicate suppression + loss / latency stats ----
+// Sliding window over the last 32 sequence numbers (bit k = newest - k seen).
+// A new boot nonce means the sender lost its RTC memory (power cut, reflash) and
+// restarted counting: the window resyncs. Within one boot, a seq behind the window is
+// an old frame (SEQ_STALE), not a restart. Senders without a nonce (boot 0) can't
+// say, so there a seq behind the window, or more than SEQ_MAX_GAP ahead of it, is
+// taken as a restart rather than a replay or a huge loss.
+#define SEQ_WINDOW  32
+#define SEQ_MAX_GAP 1024
+
+enum SeqVerdict { SEQ_NEW, SEQ_DUPLICATE, SEQ_RESTART, SEQ_STALE };
+
+struct LinkStats {
+  bool     synced = false;
+  uint16_t boot   = 0;         // the sender's nonce the window belongs to
+  uint16_t newest = 0;
+  uint32_t seen   = 0;         // window bitmap
+  uint32_t received = 0, duplicates = 0, lost = 0, restarts = 0, stale = 0;
+  uint32_t latSumMs = 0, latCount = 0, latMaxMs = 0;
+
+  SeqVerdict accept(uint16_t seq, uint16_t bootNonce = 0) {
+    if (!synced) { synced = true; boot = bootNonce; newest = seq; seen = 1; received++; return SEQ_NEW; }
+    if (bootNonce != boot) return restart(seq, bootNonce);
+    const int16_t d = (int16_t)(uint16_t)(seq - newest);
+    if (d > 0) {
+      if (!boot && d > SEQ_MAX_GAP) return restart(seq, 0);
+      lost  += (uint32_t)(d - 1);
+      seen   = d >= SEQ_WINDOW ? 1 : (seen << d) | 1;
+      newest = seq;
+      received++;
+      return SEQ_NEW;
+    }
+    if (-d < SEQ_WINDOW) {
+      const uint32_t bit = 1UL << -d;
+      if (seen & bit) { duplicates++; return SEQ_DUPLICATE; }
+      seen |= bit;             // late arrival: it was counted lost when we skipped it
+      if (lost) lost--;
+      received++;
+      return SEQ_NEW;
+    }
+    if (boot) { stale++; return SEQ_STALE; }
+    return restart(seq, 0);
+  }
+
+  SeqVerdict restart(uint16_t seq, uint16_t bootNonce) {
+    restarts++;
+    boot   = bootNonce;
+    newest = seq;
+    seen   = 1;
+    received++;
+    return SEQ_RESTART;
+  }
+
+  void latency(uint32_t ms) {
+    latSumMs += ms;
+    latCount++;
+    if (ms > latMaxMs) latMaxMs = ms;
+  }
+
+  uint32_t latAvgMs() const { return latCount ? latSumMs / latCount : 0; }
+  float lossRate() const { return (received + lost) ? (float)lost / (float)(received + lost) : 0.0f; }
+};
@@ -0,0 +1,68 @@
+// sleep_policy.h — Sensor MCU: pick the next deep-sleep length from level, fill rate and battery
+// Pure function, no state: the caller passes the current median, the fill rate from
+// the RTC history (historyFillRate) and the battery voltage. Close to the alarm
+// threshold or filling fast the sensor wakes often; far below it, it sleeps long.
+// Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+
+struct SleepPolicyConfig {
+  uint16_t minS, baseS, maxS;  // clamp; baseS = no information (invalid reading)
+  uint16_t nearRiskMm;         // at or below: minS
+  uint16_t farMm;              // at or beyond: maxS (linear baseS..maxS in between)
+  uint16_t atRiskMm;           // alarm threshold the fill rate is projected onto
+  uint8_t  wakesBeforeRisk;    // wake at least this often before a projected crossing
+  uint16_t lowBattery_mV;      // below: double the interval (not near risk)
+  uint16_t critBattery_mV;     // below: maxS (not near risk)
+};
+
+enum SleepReason : uint8_t { SLEEP_BASE, SLEEP_NEAR_RISK, SLEEP_LEVEL, SLEEP_FILL_RATE, SLEEP_LOW_BATTERY, SLEEP_HEARTBEAT };
+
+static inline const char *sleepReasonName(SleepReason r) {
+  switch (r) {
+    case SLEEP_NEAR_RISK:   return "near_risk";
+    case SLEEP_LEVEL:       return "level";
+    case SLEEP_FILL_RATE:   return "fill_rate";
+    case SLEEP_LOW_BATTERY: return "low_battery";
+    case SLEEP_HEARTBEAT:   return "heartbeat";
+    default:                return "base";
+  }
+}
+
+// mm: current median (ignored unless valid). fillMmPerMin: > 0 while filling, only
+// used if haveRate. battery_mV: 0 = not measured. untilHeartbeatS: wake no later than
+// this so a heartbeat is never late (0 = no limit).
+static inline uint16_t sleepIntervalS(const SleepPolicyConfig &c, bool valid, uint16_t mm,
+                                      bool haveRate, float fillMmPerMin, uint16_t battery_mV,
+                                      uint32_t untilHeartbeatS, SleepReason &why) {
+  uint32_t s = c.baseS;
+  why = SLEEP_BASE;
+  const bool near = valid && mm <= c.nearRiskMm;
+
+  if (near) {
+    s = c.minS;
+    why = SLEEP_NEAR_RISK;
+  } else if (valid) {
+    s = mm >= c.farMm ? c.maxS
+                      : c.baseS + (uint32_t)(c.maxS - c.baseS) * (mm - c.nearRiskMm) / (c.farMm - c.nearRiskMm);
+    why = SLEEP_LEVEL;
+    if (haveRate && fillMmPerMin > 0) {
+      const float toRiskS = (float)(mm - c.atRiskMm) * 60.0f / fillMmPerMin;
+      const float capS    = toRiskS / (c.wakesBeforeRisk ? c.wakesBeforeRisk : 1);
+      if (capS < s) { s = capS < c.minS ? c.minS : (uint32_t)capS; why = SLEEP_FILL_RATE; }
+    }
+  }
+
+  // Battery saving never stretches a near-risk or fill-rate interval.
+  if ((why == SLEEP_LEVEL || why == SLEEP_BASE) && battery_mV) {
+    if (battery_mV < c.critBattery_mV)     { s = c.maxS; why = SLEEP_LOW_BATTERY; }
+    else if (battery_mV < c.lowBattery_mV) { s = s * 2;  why = SLEEP_LOW_BATTERY; }
+  }
+
+  if (s > c.maxS) s = c.maxS;
+  if (untilHeartbeatS && s > untilHeartbeatS) {
+    s = untilHeartbeatS < c.minS ? c.minS : untilHeartbeatS;
+    why = SLEEP_HEARTBEAT;
+  }
+  return (uint16_t)s;
+}
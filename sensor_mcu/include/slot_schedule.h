@@ -0,0 +1,162 @@
+// slot_schedule.h — TDMA transmit slots handed out by the webserver
+// Shared verbatim by sensor_mcu and webserver_mcu (keep the copies equal).
+//
+// Time is cut into frames of SLOT_FRAME_MS, and every tank owns one slot per frame
+// (slot = tank_id, width = frame / tanks). After each history batch the webserver
+// answers with a SlotReply saying how long until the centre of that tank's next slot.
+// The sensor keeps the result in RTC memory, wakes early enough to finish sampling
+// by a slot centre and transmits there instead of after a random jitter.
+//
+// The sensor's RTC clock (the 150 kHz RC oscillator) runs a few hundred ppm to a
+// few percent off the webserver's crystal, and the error moves with temperature.
+// Every reply is a fresh observation of where the slot really is. The gap between
+// that and where the sensor predicted it updates a drift estimate, and the next
+// sleep is stretched or shrunk by it. Without a schedule (first boot, a lost reply
+// after a fleet change, a wake that overran its slot) the sensor falls back to the
+// random jitter. Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "sensor_packet.h"
+
+#ifndef SLOT_FRAME_MS
+#define SLOT_FRAME_MS 30000        // every tank gets one slot this often
+#endif
+#define SLOT_REPLY_TYPE    0xD1
+#define SLOT_DRIFT_MAX_PPM 50000   // beyond this the RTC is broken, not drifting
+
+#pragma pack(push,1)
+struct SlotReply {                 // Webserver -> Sensor, right after a history batch
+  uint8_t  ver;                    // 1
+  uint8_t  type;                   // 0xD1
+  uint8_t  tank_id;
+  uint16_t seq;                    // the batch's seq; stale replies are ignored
+  uint8_t  slot;
+  uint8_t  slots;                  // tanks sharing the frame
+  uint16_t frame_ms;
+  uint16_t until_ms;               // from sending this reply to the centre of the tank's next slot
+  uint8_t  crc8;                   // CRC-8 over [ver..until_ms]
+};
+#pragma pack(pop)
+
+// ---- Webserver side ----
+// nowMs: any monotonic millisecond clock that doesn't wrap (esp_timer_get_time() / 1000).
+static inline SlotReply slotAssign(uint8_t tank_id, uint16_t seq, uint16_t tanks, uint64_t nowMs,
+                                   uint16_t frameMs = SLOT_FRAME_MS) {
+  if (!tanks) tanks = 1;
+  SlotReply r{};
+  r.ver      = 1;
+  r.type     = SLOT_REPLY_TYPE;
+  r.tank_id  = tank_id;
+  r.seq      = seq;
+  r.slot     = tank_id;
+  r.slots    = (uint8_t)(tanks > 255 ? 255 : tanks);
+  r.frame_ms = frameMs;
+  const uint32_t width  = frameMs / tanks;
+  const uint32_t centre = (tank_id % tanks) * width + width / 2;
+  const uint32_t phase  = (uint32_t)(nowMs % frameMs);
+  r.until_ms = (uint16_t)((centre + frameMs - phase) % frameMs);
+  r.crc8     = crc8((const uint8_t *)&r, sizeof(r) - 1);
+  return r;
+}
+
+// ---- Sensor side ----
+// Place in RTC_DATA_ATTR; all-zero (cold boot) means "no schedule, use jitter".
+// All times are the sensor's own RTC clock in microseconds.
+struct SlotSchedule {
+  int64_t  anchorUs;               // a slot centre
+  uint16_t frameMs;                // 0 = no schedule
+  uint8_t  slot, slots;
+  int32_t  driftPpm;               // sensor clock rate vs the webserver's (+ = sensor fast)
+  int32_t  lastErrUs;              // predicted minus reported slot centre, last reply
+  uint32_t fixes;                  // replies applied
+  uint32_t resets;                 // replies that replaced the schedule outright
+  uint16_t leadMs;                 // wake -> ready to transmit, last wake (+ margin)
+  int64_t  wakeUs;                 // when the last sleep was set to end
+};
+
+static inline bool decodeSlotReply(const uint8_t *data, int len, SlotReply &r) {
+  if (len != (int)sizeof(SlotReply)) return false;
+  memcpy(&r, data, sizeof(r));
+  return r.ver == 1 && r.type == SLOT_REPLY_TYPE && r.crc8 == crc8(data, sizeof(r) - 1) && r.frame_ms && r.slots;
+}
+
+// Wake -> ready to transmit, measured this wake. Held at the recent peak (decaying an
+// eighth of the way down per wake) plus marginMs, so a sampling run a little longer
+// than last time still finishes before the slot instead of missing it.
+static inline void slotNoteLead(SlotSchedule &s, uint32_t measuredMs, uint32_t marginMs) {
+  uint32_t held = s.leadMs > marginMs ? s.leadMs - marginMs : 0;
+  held = measuredMs >= held ? measuredMs : held - (held - measuredMs) / 8;
+  held += marginMs;
+  s.leadMs = held > 0xFFFF ? 0xFFFF : (uint16_t)held;
+}
+
+// Floor division that also rounds negative numerators down.
+static inline int64_t slotFloorDiv(int64_t a, int64_t b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+
+// Frame length on the sensor's clock.
+static inline int64_t slotFrameUs(const SlotSchedule &s) {
+  return (int64_t)s.frameMs * 1000 + (int64_t)s.frameMs * s.driftPpm / 1000;
+}
+
+// Apply a reply that arrived at rxUs. Returns false if it replaced the schedule
+// (first reply, fleet size or frame changed, or an implausible drift).
+static inline bool slotOnReply(SlotSchedule &s, const SlotReply &r, int64_t rxUs) {
+  const int64_t observed = rxUs + (int64_t)r.until_ms * 1000 + (int64_t)r.until_ms * s.driftPpm / 1000;
+  s.fixes++;
+  if (s.frameMs == r.frame_ms && s.slot == r.slot && s.slots == r.slots) {
+    const int64_t F = slotFrameUs(s);
+    const int64_t k = slotFloorDiv(observed - s.anchorUs + F / 2, F);
+    const int64_t err = observed - (s.anchorUs + k * F);
+    // k is the nearest whole number of frames, which is right while the clock error
+    // between two replies stays under half a frame (1.6 % over a 15-minute heartbeat).
+    // err built up over k frames: correct half of the implied rate error per reply,
+    // which settles in a few replies and doesn't chase one noisy measurement.
+    const int64_t ppm = k > 0 ? s.driftPpm + err * 1000000 / (k * F) / 2 : 0;
+    if (k > 0 && ppm <= SLOT_DRIFT_MAX_PPM && ppm >= -SLOT_DRIFT_MAX_PPM) {
+      s.driftPpm  = (int32_t)ppm;
+      s.lastErrUs = (int32_t)-err;
+      s.anchorUs  = observed;
+      return true;
+    }
+  }
+  if (s.frameMs) s.resets++;
+  s.frameMs   = r.frame_ms;
+  s.slot      = r.slot;
+  s.slots     = r.slots;
+  s.lastErrUs = 0;
+  s.anchorUs  = observed;
+  return false;
+}
+
+// How long to wait from nowUs until the slot centre, if it is at most maxWaitMs
+// away. A wake that is only slightly late (a quarter slot) transmits at once.
+static inline bool slotWaitMs(const SlotSchedule &s, int64_t nowUs, uint32_t maxWaitMs, uint32_t &waitMs) {
+  if (!s.frameMs) return false;
+  const int64_t F = slotFrameUs(s);
+  const int64_t next = s.anchorUs + (slotFloorDiv(nowUs - s.anchorUs - 1, F) + 1) * F;
+  const int64_t late = nowUs - (next - F);
+  if (late < F / s.slots / 4) { waitMs = 0; return true; }
+  const int64_t wait = next - nowUs;
+  if (wait > (int64_t)maxWaitMs * 1000) return false;
+  waitMs = (uint32_t)(wait / 1000);
+  return true;
+}
+
+// Sleep that ends leadMs before the last slot centre at or before nowUs + wantS, so
+// the aligned sleep never exceeds wantS (the sleep policy's heartbeat and near-risk
+// caps rely on that). False when there is no schedule or aligning would cut the
+// sleep below half of wantS (wanted interval shorter than a frame); sleep wantS
+// unaligned then.
+static inline bool slotSleepUs(const SlotSchedule &s, int64_t nowUs, uint32_t wantS, uint32_t leadMs,
+                               int64_t &sleepUs) {
+  if (!s.frameMs) return false;
+  const int64_t F = slotFrameUs(s);
+  const int64_t want = (int64_t)wantS * 1000000;
+  const int64_t target = s.anchorUs + slotFloorDiv(nowUs + want - s.anchorUs, F) * F;
+  const int64_t sleep = target - (int64_t)leadMs * 1000 - nowUs;
+  if (sleep < want / 2) return false;
+  sleepUs = sleep;
+  return true;
+}
@@ -0,0 +1,201 @@
+// wake_cycle.h — Sensor MCU: the per-wake decisions and transmit sequence of setup()
+// planWake() turns the reading just pushed into the RTC history into "send or not"
+// and "sleep how long". TxMachine is transmitPhase() as a step machine: it hands out
+// one action at a time (wait, bring the radio up, find the webserver channel, start
+// ESP-NOW, switch channel, send, listen for the slot reply or the receivers' acks) and
+// takes the action's result back. main.cpp runs
+// the actions on the hardware; utilities/fleet_sim runs the same machine for many
+// sensors against a modelled shared channel. Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include "reading_history.h"
+#include "sleep_policy.h"
+#include "channel_cache.h"
+#include "sensor_packet.h"
+
+// ---- Send / sleep decision ----
+struct WakeConfig {
+  bool     sendOnChange;         // false: transmit every wake
+  bool     adaptiveSleep;        // false: always fixedSleepS
+  uint16_t fixedSleepS;
+  uint32_t rateWindowS;          // fill-rate lookback
+  SendPolicy        send;
+  SleepPolicyConfig sleep;
+};
+
+struct WakePlan {
+  SendReason  send;
+  uint16_t    sleepS;
+  SleepReason sleepWhy;
+  bool        haveRate;
+  float       fillMmPerMin;
+};
+
+// Call after historyPush() of this wake's reading. The sleep is chosen before
+// transmitting so both packets can carry it: if this wake sends, the heartbeat clock
+// restarts now, otherwise it runs from the last delivery.
+static inline WakePlan planWake(const ReadingHistory &h, const WakeConfig &c,
+                                bool valid, uint16_t mm, uint16_t battery_mV) {
+  WakePlan p{};
+  p.send     = c.sendOnChange ? historyShouldSend(h, c.send) : SEND_HEARTBEAT;
+  p.sleepS   = c.fixedSleepS;
+  p.sleepWhy = SLEEP_BASE;
+  if (!c.adaptiveSleep) return p;
+
+  p.haveRate = historyFillRate(h, c.rateWindowS, p.fillMmPerMin);
+  const uint32_t now_s = historyAt(h, 0).t_s;
+  int32_t untilHb = (p.send != SEND_NONE || !h.everSent) ? (int32_t)c.send.heartbeatS
+                                                         : (int32_t)(h.lastSentT + c.send.heartbeatS - now_s);
+  // A heartbeat due sooner than the shortest sleep goes out now rather than costing
+  // an extra wake a few seconds later (slot-aligned sleeps end just short of it).
+  if (c.sendOnChange && p.send == SEND_NONE && untilHb < (int32_t)c.sleep.minS) {
+    p.send  = SEND_HEARTBEAT;
+    untilHb = (int32_t)c.send.heartbeatS;
+  }
+  if (!c.sendOnChange) untilHb = 0;
+  else if (untilHb < 1) untilHb = 1;
+  p.sleepS = sleepIntervalS(c.sleep, valid, mm, p.haveRate, p.fillMmPerMin, battery_mV, untilHb, p.sleepWhy);
+  return p;
+}
+
+// ---- Transmit sequence ----
+struct TxTiming {
+  uint16_t radioUpMs;            // after WiFi STA init
+  uint16_t peerSettleMs;         // after adding peers
+  uint16_t channelSettleMs;      // after esp_wifi_set_channel()
+  uint16_t retryGapMs;           // before the second attempt to the same peer
+  uint8_t  sirenChannel;         // the siren listens on a fixed channel; 0 = don't send to it
+                                 // (the webserver relays)
+  uint16_t replyWaitMs;          // listen this long for a SlotReply after the webserver acks; 0 = don't
+  uint16_t ackWaitMs;            // > 0: one broadcast on the webserver channel for siren and
+                                 // webserver alike, then listen this long for their AppAcks
+};
+
+enum TxActionKind : uint8_t {
+  TXA_WAIT,            // ms
+  TXA_RADIO_UP,        // WiFi STA on, not associated
+  TXA_FIND_CHANNEL,    // result: webserver channel (channelSelect())
+  TXA_START_ESPNOW,    // init + peers (webserver on `channel`); result: 1 = ok
+  TXA_SET_CHANNEL,     // channel
+  TXA_SEND,            // dest; result: 1 = acked
+  TXA_RECV_REPLY,      // listen up to ms; result: 1 = slot reply applied
+  TXA_RECV_ACKS,       // listen up to ms for both acks; result: AckFrom bits received
+  TXA_DONE
+};
+enum TxDest : uint8_t { TX_TO_SIREN, TX_TO_WEBSERVER, TX_TO_ALL };
+
+struct TxAction {
+  TxActionKind kind;
+  uint32_t     ms;
+  uint8_t      channel;
+  TxDest       dest;
+};
+
+// Two unicasts: siren first (two attempts, skipped without a siren channel), then the
+// webserver batch (two attempts, each reported to the channel cache), then the
+// webserver's slot reply if it acked.
+// With ackWaitMs: the batch once as a broadcast on the webserver channel, then the
+// acks; a second broadcast if either is missing. Broadcasts get no MAC-level ack, so
+// the AppAcks are the only delivery signal. One machine per transmitting wake.
+struct TxMachine {
+  enum Step : uint8_t { S_JITTER, S_RADIO_UP, S_FIND, S_STARTED, S_SETTLED, S_SET, S_SETTLE, S_SENT, S_RESULT, S_REPLY, S_ACKS, S_DONE };
+
+  TxTiming t{};
+  Step     step = S_DONE;
+  TxDest   dest = TX_TO_SIREN;
+  uint8_t  attempt = 0;          // 0/1 for the current peer
+  uint8_t  webChannel = 0;
+  uint8_t  sends = 0;            // esp_now_send() calls this wake
+  bool     started = false;      // ESP-NOW came up
+  bool     sirenOk = false, webOk = false;
+  bool     gotReply = false;
+  uint8_t  acks = 0;             // AckFrom bits, broadcast mode
+
+  TxAction begin(const TxTiming &timing, uint32_t jitterMs) {
+    *this = TxMachine{};
+    t = timing;
+    if (t.ackWaitMs)            dest = TX_TO_ALL;
+    else if (!t.sirenChannel)   dest = TX_TO_WEBSERVER;
+    step = S_JITTER;
+    return act(TXA_WAIT, jitterMs);
+  }
+
+  // `result` is the outcome of the action last returned (see TxActionKind).
+  TxAction next(uint32_t result, ChannelCache &cc) {
+    switch (step) {
+      case S_JITTER:  step = S_RADIO_UP; return act(TXA_RADIO_UP);
+      case S_RADIO_UP: step = S_FIND;    return act(TXA_WAIT, t.radioUpMs);
+      case S_FIND:    step = S_STARTED;  return act(TXA_FIND_CHANNEL);
+      case S_STARTED:
+        webChannel = (uint8_t)result;
+        step = S_SETTLED;
+        return act(TXA_START_ESPNOW, 0, webChannel);
+      case S_SETTLED:
+        started = result != 0;
+        if (!started) return done();
+        step = S_SET;
+        return act(TXA_WAIT, t.peerSettleMs);
+      case S_SET:
+        step = S_SETTLE;
+        return act(TXA_SET_CHANNEL, 0, channel());
+      case S_SETTLE:
+        step = S_SENT;
+        return act(TXA_WAIT, t.channelSettleMs);
+      case S_SENT:
+        step = S_RESULT;
+        sends++;
+        return act(TXA_SEND, 0, channel());
+      case S_RESULT: {
+        const bool ok = result != 0;
+        if (dest == TX_TO_ALL) {
+          // The send callback only says the frame left; a failed send gets no acks.
+          if (!ok) return onAcks(0, cc);
+          step = S_ACKS;
+          return act(TXA_RECV_ACKS, t.ackWaitMs, webChannel);
+        }
+        if (dest == TX_TO_WEBSERVER) { webOk = ok; channelReport(cc, ok); }
+        else                         sirenOk = ok;
+        if (!ok && attempt == 0) {
+          attempt = 1;
+          step = S_SET;
+          return act(TXA_WAIT, t.retryGapMs);
+        }
+        if (dest == TX_TO_WEBSERVER) {
+          if (!ok || !t.replyWaitMs) return done();
+          step = S_REPLY;
+          return act(TXA_RECV_REPLY, t.replyWaitMs, webChannel);
+        }
+        dest = TX_TO_WEBSERVER;
+        attempt = 0;
+        step = S_SETTLE;
+        return act(TXA_SET_CHANNEL, 0, channel());
+      }
+      case S_REPLY:
+        gotReply = result != 0;
+        return done();
+      case S_ACKS:
+        return onAcks(result, cc);
+      case S_DONE: break;
+    }
+    return done();
+  }
+
+  uint8_t channel() const { return dest == TX_TO_SIREN ? t.sirenChannel : webChannel; }
+
+  // Acks of one broadcast are in (the webserver's also carries the slot reply).
+  TxAction onAcks(uint32_t got, ChannelCache &cc) {
+    acks |= (uint8_t)got;
+    sirenOk  = acks & ACK_FROM_SIREN;
+    webOk    = acks & ACK_FROM_WEBSERVER;
+    channelReport(cc, (got & ACK_FROM_WEBSERVER) != 0);
+    if (acks != (ACK_FROM_SIREN | ACK_FROM_WEBSERVER) && attempt == 0) {
+      attempt = 1;
+      step = S_SENT;
+      return act(TXA_WAIT, t.retryGapMs);
+    }
+    return done();
+  }
+
+  TxAction act(TxActionKind k, uint32_t ms = 0, uint8_t ch = 0) { return TxAction{k, ms, ch, dest}; }
+  TxAction done() { step = S_DONE; return act(TXA_DONE); }
+};
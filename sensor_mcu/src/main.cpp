@@ -1,18 +1,50 @@
 // main.cpp — Sensor MCU (battery) - Robust Version
-// Role: scan 5 s -> median -> send to Siren + Webserver via ESP-NOW -> deep sleep 120 s
+// Role: scan 5 s (running median) -> send to Siren + Webserver via ESP-NOW -> deep sleep 30-900 s
 
 #include <Arduino.h>
 #include <WiFi.h>
 #include <esp_sleep.h>
 #include <esp_now.h>
 #include <esp_wifi.h>
+#include <esp_timer.h>
+#include <sys/time.h>
+#include "sampling_window.h"
+#include "channel_cache.h"
+#include "power_budget.h"
+#include "reading_history.h"
+#include "sensor_packet.h"
+#include "sleep_policy.h"
+#include "slot_schedule.h"
+#include "wake_cycle.h"
 extern "C" {
   #include "esp_bt.h"
 }
 
+// ================== Build profile ==================
+// -DFAST_WAKE=1 is the production profile: serial logging compiled out, no fixed
+// delays at boot or around the radio (each step polls for readiness instead), and the
+// Wi-Fi station brought up once per wake without the stop/erase cycle. The default
+// keeps the bench behaviour and its log. -DSENSOR_LOG=0/1 overrides the logging alone.
+#ifndef FAST_WAKE
+#define FAST_WAKE 0
+#endif
+#ifndef SENSOR_LOG
+#define SENSOR_LOG (!FAST_WAKE)
+#endif
+#if SENSOR_LOG
+#define LOGF(...)  Serial.printf(__VA_ARGS__)
+#define LOGLN(...) Serial.println(__VA_ARGS__)
+#else   // arguments still type-checked, but dead code: no strings, no calls
+#define LOGF(...)  do { if (0) Serial.printf(__VA_ARGS__); } while (0)
+#define LOGLN(...) do { if (0) Serial.println(__VA_ARGS__); } while (0)
+#endif
+
 // ================== Hardware: A02YYUW ==================
 #define A02YYUW_TX 18
 #define A02YYUW_RX 5
+#ifndef A02YYUW_PWR
+#define A02YYUW_PWR -1   // GPIO switching the sensor's supply (high = on); -1 = always powered
+#endif
 HardwareSerial sensorSerial(2);
 
 // ================== Identity ==================
@@ -23,75 +55,191 @@ HardwareSerial sensorSerial(2);
 // ================== Peers (use STA MACs you provided) ==================
 static const uint8_t MAC_SIREN[6]     = {0x00,0x00,0x00,0x00,0x00,0x00}; // Replace with actual MAC
 static const uint8_t MAC_WEBSERVER[6] = {0x00,0x00,0x00,0x00,0x00,0x00}; // Replace with actual MAC
+static const uint8_t MAC_BROADCAST[6] = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
+
+// Network the webserver joins; its channel is where the webserver listens.
+static const char* WIFI_SSID = "YOUR_WIFI_SSID";
 
 // ================== Timing ==================
 static const uint32_t SCAN_MS     = 5000;
 static const uint32_t JITTER_MS   = 2000;
-static const uint64_t SLEEP_US    = 120ULL * 1000ULL * 1000ULL;
+static const uint64_t SLEEP_US    = 120ULL * 1000ULL * 1000ULL;   // fixed interval when SLEEP_ADAPTIVE=0
+
+// ================== Adaptive sleep ==================
+// The next sleep comes from sleepIntervalS() (sleep_policy.h): SLEEP_MIN_S near the
+// alarm threshold or when the fill rate would reach it within a few wakes, up to
+// SLEEP_MAX_S for a low level, doubled on a weak battery. -DSLEEP_ADAPTIVE=0 keeps 120 s.
+#ifndef SLEEP_ADAPTIVE
+#define SLEEP_ADAPTIVE 1
+#endif
+#ifndef SLEEP_MIN_S
+#define SLEEP_MIN_S 30
+#endif
+#ifndef SLEEP_MAX_S
+#define SLEEP_MAX_S 900
+#endif
 
-// ================== Packet format ==================
-#pragma pack(push,1)
-struct SensorPacket {
-  uint8_t  ver;
-  uint8_t  tank_id;
-  uint16_t distance_mm;
-  uint16_t battery_mV;
-  uint8_t  flags;
-  uint8_t  crc8;
+// ================== Adaptive sampling ==================
+// Stop listening as soon as the running median's ~95% band is within SCAN_TOL_MM.
+// SCAN_MS stays the hard cap; -DSCAN_ADAPTIVE=0 restores the fixed window.
+#ifndef SCAN_ADAPTIVE
+#define SCAN_ADAPTIVE 1
+#endif
+#ifndef SCAN_TOL_MM
+#define SCAN_TOL_MM 5
+#endif
+#ifndef SCAN_MIN_SAMPLES
+#define SCAN_MIN_SAMPLES 15
+#endif
+static const SamplingConfig SAMPLING = { SCAN_MS, SCAN_ADAPTIVE, SCAN_TOL_MM, SCAN_MIN_SAMPLES };
+
+// -DUART_CAPTURE=1 logs every chunk read from the A02YYUW as "U <ms> <hex bytes>", ms
+// from the start of sampling. Paste those lines into a file under
+// utilities/host_tests/fixtures/ to replay the wake on a host.
+#ifndef UART_CAPTURE
+#define UART_CAPTURE 0
+#endif
+
+// ================== Send-on-change ==================
+// Medians are buffered in RTC memory; the radio only comes up when the level moved
+// more than SEND_DELTA_MM, is near the alarm threshold, or HEARTBEAT_S passed.
+// -DSEND_ON_CHANGE=0 transmits every wake.
+#ifndef SEND_ON_CHANGE
+#define SEND_ON_CHANGE 1
+#endif
+#ifndef SEND_DELTA_MM
+#define SEND_DELTA_MM 10
+#endif
+#ifndef HEARTBEAT_S
+#define HEARTBEAT_S 900
+#endif
+static const uint16_t AT_RISK_MM      = 60;             // matches the 6 cm alarm threshold
+static const uint16_t NEAR_RISK_MM    = AT_RISK_MM + 100;
+static const SendPolicy SEND_POLICY   = { SEND_DELTA_MM, NEAR_RISK_MM, HEARTBEAT_S };
+static const SleepPolicyConfig SLEEP_POLICY = {
+  SLEEP_MIN_S, (uint16_t)(SLEEP_US / 1000000ULL), SLEEP_MAX_S,
+  NEAR_RISK_MM,
+  600,                  // level this far below the top (mm) or more: SLEEP_MAX_S
+  AT_RISK_MM,
+  4,                    // wake at least 4 times before a projected crossing
+  3500, 3300            // low / critical battery (mV)
+};
+static const WakeConfig WAKE_CONFIG = {
+  SEND_ON_CHANGE, SLEEP_ADAPTIVE, (uint16_t)(SLEEP_US / 1000000ULL),
+  15 * 60,              // fill-rate lookback (s)
+  SEND_POLICY, SLEEP_POLICY
 };
-#pragma pack(pop)
-
-static uint8_t crc8(const uint8_t* data, size_t len) {
-  uint8_t c = 0x00;
-  for (size_t i = 0; i < len; ++i) {
-    c ^= data[i];
-    for (int b = 0; b < 8; ++b) {
-      c = (c & 0x80) ? (uint8_t)((c << 1) ^ 0x07) : (uint8_t)(c << 1);
-    }
-  }
-  return c;
-}
 
-// ================== Sampling ==================
-static const int MAX_SAMPLES = 100;
-static float samples[MAX_SAMPLES];
-static int   sampleCount = 0;
+// ================== Transmit slots ==================
+// The webserver answers each batch with this tank's TDMA slot (slot_schedule.h). The
+// sensor then sleeps so that it is ready to transmit at the slot centre and sends
+// there instead of after the random jitter. -DSLOT_SCHEDULE=0 always uses the jitter
+// and doesn't listen for replies.
+#ifndef SLOT_SCHEDULE
+#define SLOT_SCHEDULE 1
+#endif
+static const uint32_t SLOT_LEAD_MARGIN_MS = 200;   // wake this much earlier than last wake needed
+
+// ================== One frame per wake ==================
+// The siren follows the webserver's channel (it listens for the webserver's
+// ChannelAnnounce), so one broadcast of the history batch reaches both. Each answers
+// with an app-level ack (sensor_packet.h AppAck; the webserver's SlotReply with slots
+// on); a second broadcast goes out if either is missing. -DONE_FRAME=0 sends the
+// SensorPacketV3 to the siren on its fixed channel and the batch to the webserver as
+// two unicasts, for a siren that doesn't follow the webserver's channel.
+#ifndef ONE_FRAME
+#define ONE_FRAME 1
+#endif
 
-static bool readA02YYUW(float &distance_cm) {
-  while (sensorSerial.available() >= 4) {
-    uint8_t b0 = sensorSerial.read();
-    if (b0 != 0xFF) continue;
+// ================== Siren via the webserver ==================
+// 1 = send the batch to the webserver only (unicast, MAC-acked, one channel) and let
+// it relay the reading to the siren (webserver SIREN_RELAY 1). The siren's alarm
+// then waits on the webserver. Overrides ONE_FRAME.
+#ifndef SIREN_RELAY
+#define SIREN_RELAY 0
+#endif
+#if SIREN_RELAY
+#undef  ONE_FRAME
+#define ONE_FRAME 0
+#endif
 
-    if (sensorSerial.available() < 3) return false;
-    uint8_t b1 = sensorSerial.read();
-    uint8_t b2 = sensorSerial.read();
-    uint8_t b3 = sensorSerial.read();
+// transmitPhase() settle times (wake_cycle.h TxMachine). FAST_WAKE waits for the STA
+// start event and reads the channel back instead; adding a peer takes effect at once.
+static const TxTiming TX_TIMING = {
+  FAST_WAKE ? 0 : 100,  // let WiFi stabilize after STA init
+  FAST_WAKE ? 0 : 50,   // after adding peers
+  FAST_WAKE ? 0 : 20,   // after each channel switch
+  100,                  // before the second attempt to a peer
+  SIREN_RELAY ? 0 : 1,  // siren channel (fixed, ONE_FRAME=0 only); 0 = relayed, no direct send
+  (SLOT_SCHEDULE && !ONE_FRAME) ? 60 : 0,  // wait for the webserver's slot reply
+  ONE_FRAME ? 100 : 0   // wait for both acks (ends as soon as both are in)
+};
+static const uint32_t READY_TIMEOUT_MS = 100;    // FAST_WAKE: longest poll for a radio step
 
-    if (((uint8_t)(b0 + b1 + b2)) != b3) continue;
+// ================== Power budget ==================
+// Every wake is split into phases (power_budget.h) timed with esp_timer; the totals
+// build up in RTC memory and ride along in the first webserver batch after
+// POWER_REPORT_WAKES wakes (-DPOWER_REPORT_WAKES=0: never). The webserver turns them
+// into mAh/day per phase (/api/power).
+static PhaseClock phases;
+RTC_DATA_ATTR static PowerBudget power;
 
-    int raw_mm = (b1 << 8) | b2;
-    if (raw_mm < 30 || raw_mm > 4500) continue;
+static inline void phase(PowerPhase p) { phases.enter(p, esp_timer_get_time()); }
 
-    distance_cm = raw_mm / 10.0f;
-    return true;
-  }
-  return false;
+// ================== Packet format ==================
+// The siren gets a SensorPacketV3 and the webserver a history batch (HistoryHeader,
+// deltas, optional PowerBlock, crc8; all in sensor_packet.h). With ONE_FRAME both get
+// the batch as a single broadcast.
+
+// Sequence number of the last transmitting wake; retries within a wake reuse it.
+RTC_DATA_ATTR static uint16_t txSeq = 0;
+// Random per power-up (RTC memory is lost with txSeq), so receivers can tell a
+// restarted count from duplicates of the old one. 0 = not drawn yet.
+RTC_DATA_ATTR static uint16_t bootNonce = 0;
+
+static uint16_t ageSince(uint32_t ms) {
+  const uint32_t age = millis() - ms;
+  return age > 0xFFFF ? 0xFFFF : (uint16_t)age;
 }
 
-static void sortSmall(float *arr, int n) {
-  for (int i = 0; i < n - 1; ++i) {
-    int m = i;
-    for (int j = i + 1; j < n; ++j) if (arr[j] < arr[m]) m = j;
-    if (m != i) { float t = arr[i]; arr[i] = arr[m]; arr[m] = t; }
+// ================== Sampling ==================
+// With A02YYUW_PWR wired the sensor is only powered from the start of sampling to its
+// end, and held off through deep sleep. It needs no settle time: sampling already
+// waits for frames.
+static void sensorPower(bool on) {
+#if (A02YYUW_PWR >= 0)
+  gpio_hold_dis((gpio_num_t)A02YYUW_PWR);
+  pinMode(A02YYUW_PWR, OUTPUT);
+  digitalWrite(A02YYUW_PWR, on ? HIGH : LOW);
+  if (!on) {
+    gpio_hold_en((gpio_num_t)A02YYUW_PWR);
+    gpio_deep_sleep_hold_en();
   }
+#else
+  (void)on;
+#endif
 }
 
-static float computeMedian(const float *arr, int n) {
-  if (n <= 0) return NAN;
-  static float tmp[MAX_SAMPLES];
-  for (int i = 0; i < n; ++i) tmp[i] = arr[i];
-  sortSmall(tmp, n);
-  return (n & 1) ? tmp[n/2] : 0.5f * (tmp[n/2 - 1] + tmp[n/2]);
+static SamplingWindow sampling;   // UART ring, frame parser and sorted integer-mm window
+
+// Drain whatever the UART holds into the parser's ring in bulk.
+static void drainA02YYUW(A02yyuwParser &parser) {
+  int avail = sensorSerial.available();
+  while (avail > 0) {
+    size_t span;
+    uint8_t *dst = parser.writeSpan(span);
+    if (!span) break;
+    size_t want = min((size_t)avail, span);
+    size_t got  = sensorSerial.readBytes(dst, want);
+#if UART_CAPTURE
+    Serial.printf("U %u", (unsigned)(millis() - sampling.startMs));
+    for (size_t i = 0; i < got; i++) Serial.printf(" %02X", dst[i]);
+    Serial.println();
+#endif
+    parser.produce(got);
+    if (got < want) break;
+    avail -= (int)got;
+  }
 }
 
 // ================== Battery ==================
@@ -121,30 +269,54 @@ static void onDataSent(const uint8_t *mac_addr, esp_now_send_status_t status) {
   g_sendDone = true;
 }
 
+// Slot reply or ack from the webserver, ack from the siren: copied here, checked by
+// awaitSlotReply() / awaitAcks().
+volatile bool    g_replyGot = false;
+volatile int64_t g_replyAtUs = 0;
+volatile int     g_replyLen = 0;
+static uint8_t   g_reply[sizeof(SlotReply)];
+volatile bool    g_sirenAckGot = false;
+static uint8_t   g_sirenAck[sizeof(AppAck)];
+
+// RTC clock in microseconds; keeps counting through deep sleep.
+static int64_t rtcNowUs() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+static void onDataRecv(const uint8_t *mac, const uint8_t *data, int len) {
+  if (memcmp(mac, MAC_WEBSERVER, 6) == 0) {
+    if (g_replyGot || (len != (int)sizeof(SlotReply) && len != (int)sizeof(AppAck))) return;
+    memcpy(g_reply, data, len);
+    g_replyLen  = len;
+    g_replyAtUs = rtcNowUs();
+    g_replyGot  = true;
+  } else if (ONE_FRAME && memcmp(mac, MAC_SIREN, 6) == 0) {
+    if (g_sirenAckGot || len != (int)sizeof(AppAck)) return;
+    memcpy(g_sirenAck, data, len);
+    g_sirenAckGot = true;
+  }
+}
+
 static bool addPeer(const uint8_t mac[6], uint8_t channel) {
   esp_now_peer_info_t peer{};
   memcpy(peer.peer_addr, mac, 6);
   peer.channel = channel;
   peer.encrypt = false;
   esp_err_t result = esp_now_add_peer(&peer);
-  Serial.printf("addPeer CH%d: %s\n", channel, (result == ESP_OK) ? "OK" : "FAILED");
+  LOGF("addPeer CH%d: %s\n", channel, (result == ESP_OK) ? "OK" : "FAILED");
   return (result == ESP_OK);
 }
 
-static bool sendPacketTo(const uint8_t mac[6], const SensorPacket &pkt, uint8_t target_channel) {
-  // Try to set channel - don't crash if it fails
-  esp_err_t ch_result = esp_wifi_set_channel(target_channel, WIFI_SECOND_CHAN_NONE);
-  Serial.printf("Channel %d: %s\n", target_channel, (ch_result == ESP_OK) ? "OK" : "FAILED");
-  
-  // Brief settle time
-  delay(20);
-  
+// Channel switch and settle are separate TxMachine steps; this sends on the current one.
+static bool sendPacketTo(const uint8_t mac[6], const uint8_t *data, size_t len) {
   g_sendDone = false; 
   g_sendOk = false;
   
-  esp_err_t send_result = esp_now_send(mac, (const uint8_t*)&pkt, sizeof(pkt));
+  esp_err_t send_result = esp_now_send(mac, data, len);
   if (send_result != ESP_OK) {
-    Serial.printf("Send failed: %d\n", send_result);
+    LOGF("Send failed: %d\n", send_result);
     return false;
   }
 
@@ -154,168 +326,432 @@ static bool sendPacketTo(const uint8_t mac[6], const SensorPacket &pkt, uint8_t
     delay(1);
   }
   
-  Serial.printf("Result: %s (%dms)\n", g_sendOk ? "OK" : "FAILED", millis() - start);
+  LOGF("Result: %s (%dms)\n", g_sendOk ? "OK" : "FAILED", millis() - start);
   return g_sendOk;
 }
 
-// Simple channel discovery - don't crash on failure
-static uint8_t findWebserverChannel() {
-  Serial.println("Scanning networks...");
-  
-  // Default fallback
-  uint8_t channel = 1;
-  
-  // Try scanning - catch any failures
-  int n = WiFi.scanNetworks(false, false, false, 200);
-  
+// ================== Webserver channel (RTC cached) ==================
+RTC_DATA_ATTR static ChannelCache chCache;
+
+// Scan backend for channelSelect(): channel 0 = all channels.
+static uint8_t scanForWebserverAp(uint8_t channel, void *) {
+  uint8_t found = 0;
+  int n = WiFi.scanNetworks(false, false, false, 200, channel, WIFI_SSID);
   if (n > 0) {
-    Serial.printf("Found %d networks\n", n);
     for (int i = 0; i < n; i++) {
-      if (WiFi.SSID(i) == "SpectrumSetup-B5") {
-        channel = WiFi.channel(i);
-        Serial.printf("Target network on CH%d\n", channel);
-        break;
-      }
+      if (WiFi.SSID(i) == WIFI_SSID) { found = WiFi.channel(i); break; }
     }
-    WiFi.scanDelete();
-  } else {
-    Serial.printf("Scan failed or no networks, using CH%d\n", channel);
   }
-  
+  WiFi.scanDelete();
+  LOGF("Scan %s: %s\n", channel ? "probe" : "all", found ? "found" : "not found");
+  return found;
+}
+
+static uint8_t findWebserverChannel() {
+  ChannelSource src;
+  uint32_t t0 = millis();
+  uint8_t channel = channelSelect(chCache, scanForWebserverAp, nullptr, src);
+  LOGF("Webserver CH%d (%s, %dms) | cache hits=%u misses=%u probe_hits=%u\n",
+    channel, channelSourceName(src), millis() - t0,
+    chCache.hits, chCache.misses, chCache.probeHits);
   return channel;
 }
 
+// ================== Slot schedule (RTC) ==================
+RTC_DATA_ATTR static SlotSchedule slotSched;
+
+// Wake -> ready to transmit on this wake; the next sleep ends that much (held at the
+// recent peak, plus a margin) before the slot. Measured on the RTC clock from when
+// the last sleep was set to end, so boot time counts too; after a reset only millis().
+static void measureSlotLead(bool timerWake) {
+  const int64_t now = rtcNowUs();
+  uint32_t ms = millis();
+  if (timerWake && slotSched.wakeUs && now > slotSched.wakeUs && now - slotSched.wakeUs < 60000000LL) {
+    ms = (uint32_t)((now - slotSched.wakeUs) / 1000);
+  }
+  slotNoteLead(slotSched, ms, SLOT_LEAD_MARGIN_MS);
+}
+
+// The webserver's reply to batch seq, if g_reply holds one; updates the schedule.
+static bool applySlotReply(uint16_t seq) {
+  SlotReply rep;
+  if (!g_replyGot || !decodeSlotReply(g_reply, g_replyLen, rep) || rep.tank_id != TANK_ID || rep.seq != seq) return false;
+  const bool tracked = slotOnReply(slotSched, rep, g_replyAtUs);
+  LOGF("Slot reply: slot %u/%u of %ums, centre in %ums, %s, drift %dppm (err %dus, fixes=%u resets=%u)\n",
+    rep.slot, rep.slots, rep.frame_ms, rep.until_ms, tracked ? "tracked" : "new schedule",
+    slotSched.driftPpm, slotSched.lastErrUs, slotSched.fixes, slotSched.resets);
+  return true;
+}
+
+static bool awaitSlotReply(uint16_t seq, uint32_t waitMs) {
+  const uint32_t start = millis();
+  while (!g_replyGot && (millis() - start) < waitMs) {
+    delay(1);
+  }
+  if (!applySlotReply(seq)) {
+    LOGF("Slot reply: none (%dms)\n", millis() - start);
+    return false;
+  }
+  return true;
+}
+
+static bool ackMatches(const uint8_t *data, int len, uint16_t seq, AckFrom from) {
+  AppAck a;
+  return decodeAppAck(data, len, a) && a.tank_id == TANK_ID && a.seq == seq && a.from == from;
+}
+
+// ONE_FRAME: both receivers' acks for batch seq, or whatever arrived within waitMs.
+// Returns AckFrom bits.
+static uint32_t awaitAcks(uint16_t seq, uint32_t waitMs) {
+  const uint32_t start = millis();
+  while (!(g_replyGot && g_sirenAckGot) && (millis() - start) < waitMs) {
+    delay(1);
+  }
+  uint32_t got = 0;
+  if (g_sirenAckGot && ackMatches(g_sirenAck, sizeof(g_sirenAck), seq, ACK_FROM_SIREN)) got |= ACK_FROM_SIREN;
+  if (g_replyGot && (ackMatches(g_reply, g_replyLen, seq, ACK_FROM_WEBSERVER) || applySlotReply(seq))) got |= ACK_FROM_WEBSERVER;
+  LOGF("Acks: siren=%s webserver=%s (%dms)\n", (got & ACK_FROM_SIREN) ? "OK" : "none",
+    (got & ACK_FROM_WEBSERVER) ? "OK" : "none", millis() - start);
+  return got;
+}
+
+// ================== Reading history (RTC) ==================
+RTC_DATA_ATTR static ReadingHistory history;
+
+// Builds the webserver batch from the readings not yet delivered, with the power
+// budget once it is due (withPower). Returns length.
+static size_t buildHistoryBatch(uint8_t *out, size_t cap, const SensorReading &r, bool &withPower) {
+  HistoryHeader h{};
+  const HistoryEntry &cur = historyAt(history, 0);
+  h.ver         = 3;
+  h.type        = 0xB1;
+  h.tank_id     = (uint8_t)TANK_ID;
+  h.count       = history.unsent ? history.unsent : 1;
+  h.seq         = r.seq;
+  h.boot        = r.boot;
+  h.distance_mm = cur.mm;
+  h.battery_mV  = r.battery_mV;
+  h.flags       = cur.flags;
+  h.samples     = r.samples;
+  h.scan_ms     = r.scan_ms;
+  h.interval_s  = r.interval_s;
+  // Near risk every wake transmits; otherwise only the heartbeat is guaranteed (the
+  // sleep is clamped so the wake that owes it is never late).
+  const bool everyWake = !SEND_ON_CHANGE || ((cur.flags & 0x01) && cur.mm <= NEAR_RISK_MM);
+  h.next_tx_s   = (uint16_t)((everyWake ? r.interval_s : HEARTBEAT_S) + (SCAN_MS + JITTER_MS) / 1000);
+
+  size_t deltas = 0;
+  if (!historyEncodeDeltas(history, h.count, out + sizeof(h), cap - sizeof(h) - 1, deltas)) {
+    h.count = 1;   // can't happen with HISTORY_LEN 16; degrade to newest only
+    deltas = 0;
+  }
+  memcpy(out, &h, sizeof(h));
+  size_t len = sizeof(h) + deltas;
+  size_t block = 0;
+  if (POWER_REPORT_WAKES && power.wakes >= POWER_REPORT_WAKES)
+    block = powerEncode(power, cur.t_s, out + len, cap - len - 1);
+  withPower = block != 0;
+  len += block;
+  out[len] = crc8(out, len);
+  return len + 1;
+}
+
+// age_ms is only known right before each send attempt; patch it and re-seal.
+static void stampBatchAge(uint8_t *batch, size_t len, uint16_t age_ms) {
+  memcpy(batch + offsetof(HistoryHeader, age_ms), &age_ms, sizeof(age_ms));
+  batch[len - 1] = crc8(batch, len - 1);
+}
+
 static void safeRadiosOff() {
-  Serial.println("Disabling radios...");
+  LOGLN("Disabling radios...");
   esp_now_deinit();
   WiFi.mode(WIFI_OFF);
   btStop();
 }
 
+// ================== Transmission ==================
+// Polls cond every millisecond for up to timeoutMs; true once it holds.
+template <typename F>
+static bool waitReady(F cond, uint32_t timeoutMs) {
+  const uint32_t start = millis();
+  while (!cond()) {
+    if (millis() - start >= timeoutMs) return false;
+    delay(1);
+  }
+  return true;
+}
+
+// WiFi STA on, not associated. Nothing is stored or auto-connected, so FAST_WAKE
+// skips the disconnect/erase (with wifioff it stops the station it just started) and
+// returns once the driver reports the station started. The PHY calibration the core
+// keeps in NVS is reused as is after a deep-sleep wake.
+static void radioUp() {
+#if FAST_WAKE
+  WiFi.persistent(false);           // RAM-only Wi-Fi config: no NVS writes
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(false);
+  if (!waitReady([]{ return (WiFi.getStatusBits() & STA_STARTED_BIT) != 0; }, READY_TIMEOUT_MS))
+    LOGLN("STA start: timeout");
+#else
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoConnect(false);
+  WiFi.setAutoReconnect(false);
+  WiFi.persistent(false);
+  WiFi.disconnect(true, true);
+#endif
+}
+
+static void setChannel(uint8_t channel) {
+  // Try to set channel - don't crash if it fails
+  esp_err_t ch_result = esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+#if FAST_WAKE
+  // Proceed once the radio reports the new channel rather than after a fixed settle.
+  if (ch_result == ESP_OK && !waitReady([channel]{
+        uint8_t cur = 0;
+        wifi_second_chan_t sec;
+        return esp_wifi_get_channel(&cur, &sec) == ESP_OK && cur == channel;
+      }, READY_TIMEOUT_MS)) ch_result = ESP_ERR_TIMEOUT;
+#endif
+  LOGF("Channel %d: %s\n", channel, (ch_result == ESP_OK) ? "OK" : "FAILED");
+}
+static bool startEspNow(uint8_t webserver_channel) {
+  if (esp_now_init() != ESP_OK) {
+    LOGLN("ESP-NOW init failed!");
+    return false;
+  }
+  LOGLN("ESP-NOW OK");
+  esp_now_register_send_cb(onDataSent);
+  if (SLOT_SCHEDULE || ONE_FRAME) esp_now_register_recv_cb(onDataRecv);
+
+  bool peers_ok = true;
+  if (ONE_FRAME) {
+    peers_ok &= addPeer(MAC_BROADCAST, webserver_channel);
+  } else {
+    if (!SIREN_RELAY) peers_ok &= addPeer(MAC_SIREN, TX_TIMING.sirenChannel);
+    peers_ok &= addPeer(MAC_WEBSERVER, webserver_channel);
+  }
+  if (!peers_ok) LOGLN("Peer setup failed");
+  return peers_ok;
+}
+
+// Which power_budget.h phase an action of the transmit sequence is billed to.
+static PowerPhase txPhase(const TxMachine &tx, const TxAction &a) {
+  switch (a.kind) {
+    case TXA_WAIT:         return tx.step == TxMachine::S_JITTER ? PH_WAIT : PH_RADIO;
+    case TXA_FIND_CHANNEL: return PH_SCAN;
+    case TXA_SEND:         return PH_SEND;
+    case TXA_RECV_REPLY:
+    case TXA_RECV_ACKS:    return PH_REPLY;
+    default:               return PH_RADIO;
+  }
+}
+
+// ONE_FRAME: the history batch goes out once as a broadcast for siren and webserver.
+// SIREN_RELAY: the webserver alone gets the batch. Otherwise the siren gets the plain
+// SensorPacket (it only needs the latest level) and the webserver the batch. Both carry r.seq and the age of the sample at send time.
+// The order, retries and settle times come from TxMachine; this only runs its steps.
+// Returns true if the webserver acked.
+static bool transmitPhase(SensorReading r, uint32_t sampledAtMs, uint8_t *batch, size_t batchLen) {
+  LOGLN("\n=== TRANSMISSION ===");
+
+  // Own slot if the schedule puts it close; random jitter otherwise.
+  uint32_t wait;
+  if (SLOT_SCHEDULE && slotWaitMs(slotSched, rtcNowUs(), JITTER_MS, wait)) {
+    LOGF("Slot %u/%u: wait %dms (lead %ums, drift %dppm)\n",
+      slotSched.slot, slotSched.slots, wait, slotSched.leadMs, slotSched.driftPpm);
+  } else {
+    wait = esp_random() % (JITTER_MS + 1);
+    LOGF("Jitter: %dms\n", wait);
+  }
+
+  TxMachine tx;
+  uint8_t pkt[sizeof(SensorPacketV3)];
+  for (TxAction a = tx.begin(TX_TIMING, wait); a.kind != TXA_DONE; ) {
+    uint32_t result = 0;
+    phase(txPhase(tx, a));
+    switch (a.kind) {
+      case TXA_WAIT:
+        delay(a.ms);
+        break;
+      case TXA_RADIO_UP:
+        radioUp();
+        break;
+      case TXA_FIND_CHANNEL:
+        // Webserver channel: RTC cache, rescanning only after repeated send failures
+        result = findWebserverChannel();
+        break;
+      case TXA_START_ESPNOW:
+        result = startEspNow(a.channel);
+        break;
+      case TXA_SET_CHANNEL:
+        setChannel(a.channel);
+        break;
+      case TXA_SEND:
+        if (a.dest == TX_TO_SIREN) {
+          LOGF("\n--- SIREN (seq %u, attempt %d) ---\n", r.seq, tx.attempt + 1);
+          r.age_ms = ageSince(sampledAtMs);
+          result = sendPacketTo(MAC_SIREN, pkt, encodeSensorPacket(r, pkt));
+        } else if (a.dest == TX_TO_ALL) {
+          LOGF("\n--- BROADCAST (%d readings, attempt %d) ---\n", batch[3], tx.attempt + 1);
+          stampBatchAge(batch, batchLen, ageSince(sampledAtMs));
+          g_replyGot = g_sirenAckGot = false;   // acks can land before the send callback
+          result = sendPacketTo(MAC_BROADCAST, batch, batchLen);
+        } else {
+          LOGF("\n--- WEBSERVER (%d readings, attempt %d) ---\n", batch[3], tx.attempt + 1);
+          stampBatchAge(batch, batchLen, ageSince(sampledAtMs));
+          g_replyGot = false;   // the reply can land before the send callback
+          result = sendPacketTo(MAC_WEBSERVER, batch, batchLen);
+        }
+        break;
+      case TXA_RECV_REPLY:
+        result = awaitSlotReply(r.seq, a.ms);
+        break;
+      case TXA_RECV_ACKS:
+        result = awaitAcks(r.seq, a.ms);
+        break;
+      default:
+        break;
+    }
+    a = tx.next(result, chCache);
+  }
+
+  if (tx.started) {
+    LOGF("\nSUMMARY: Siren=%s Web=%s (%d sends)\n",
+      SIREN_RELAY ? "relayed" : tx.sirenOk ? "OK" : "FAIL", tx.webOk ? "OK" : "FAIL", tx.sends);
+  }
+  return tx.webOk;
+}
+
 // ================== Main App ==================
 void setup() {
+#if SENSOR_LOG
   Serial.begin(115200);
   delay(500);  // Give serial time to initialize
+#endif
 
+#if !FAST_WAKE
   // Start with radios off
   WiFi.mode(WIFI_OFF);
   btStop();
   delay(100);
+#endif
+  // FAST_WAKE: neither radio has been started since reset or deep sleep.
 
   esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
-  Serial.printf("\n=== SENSOR %d START ===\n", TANK_ID);
-  Serial.printf("Wake: %s\n", (cause == ESP_SLEEP_WAKEUP_TIMER) ? "timer" : "reset");
+  LOGF("\n=== SENSOR %d START ===\n", TANK_ID);
+  LOGF("Wake: %s\n", (cause == ESP_SLEEP_WAKEUP_TIMER) ? "timer" : "reset");
 
   // === SAMPLING PHASE ===
-  Serial.println("Starting sensor sampling...");
+  phase(PH_SAMPLE);
+  LOGLN("Starting sensor sampling...");
+  sensorPower(true);
   sensorSerial.begin(9600, SERIAL_8N1, A02YYUW_RX, A02YYUW_TX);
   
-  sampleCount = 0;
-  uint32_t startTime = millis();
-  
-  while ((millis() - startTime) < SCAN_MS && sampleCount < MAX_SAMPLES) {
-    float dcm;
-    if (readA02YYUW(dcm)) {
-      samples[sampleCount++] = dcm;
-      if (sampleCount % 10 == 0) {
-        Serial.printf("Samples: %d\n", sampleCount);
-      }
-    } else {
-      delay(10);
+  sampling.begin(SAMPLING, millis());
+  const RunningStats &stats = sampling.stats;
+  const A02yyuwParser &parser = sampling.parser;
+
+  for (;;) {
+    drainA02YYUW(sampling.parser);
+    const uint16_t before = stats.n;
+    if (sampling.poll(millis())) break;
+    if (stats.n / 10 != before / 10) {
+      LOGF("Samples: %d\n", stats.n);
     }
-    
+    if (stats.n == before) delay(10);   // nothing new: the next frame is ~100 ms out
+
     // Watchdog yield
     yield();
   }
 
-  float median_cm = NAN;
-  if (sampleCount > 0) {
-    median_cm = computeMedian(samples, sampleCount);
-  }
-
-  Serial.printf("Samples=%d, median=%.1fcm\n", sampleCount, median_cm);
-
-  // Jitter delay
-  uint32_t jitter = esp_random() % (JITTER_MS + 1);
-  Serial.printf("Jitter: %dms\n", jitter);
-  delay(jitter);
-
-  // Prepare packet
-  SensorPacket pkt{};
-  pkt.ver         = 1;
+  const uint32_t sampledAt = millis();
+  sensorSerial.end();
+  sensorPower(false);
+  const bool earlyExit = sampling.earlyExit();
+  const uint32_t scanMs  = sampling.scanMs();
+  const int sampleCount = stats.n;
+  const uint16_t median_mm = stats.median();
+  const float median_cm = (sampleCount > 0) ? median_mm / 10.0f : NAN;
+
+  LOGF("Samples=%d in %dms%s, median=%.1fcm (min=%.1f p90=%.1f max=%.1f)\n",
+    sampleCount, scanMs, earlyExit ? " (converged)" : "", median_cm,
+    stats.minimum() / 10.0f, stats.percentile(90) / 10.0f, stats.maximum() / 10.0f);
+  LOGF("UART: frames=%u csum_err=%u out_of_range=%u skipped=%u\n",
+    parser.goodFrames, parser.checksumErrors, parser.outOfRange, parser.skippedBytes);
+
+  // Prepare reading (seq, boot and age are filled in if this wake transmits)
+  SensorReading pkt{};
+  pkt.ver         = 3;
   pkt.tank_id     = (uint8_t)TANK_ID;
-  bool valid      = (sampleCount > 0) && isfinite(median_cm);
-  uint16_t distmm = valid ? (uint16_t)max(0, min(65535, (int)(median_cm * 10 + 0.5f))) : 0;
-  pkt.distance_mm = distmm;
+  bool valid      = (sampleCount > 0);
+  pkt.distance_mm = valid ? median_mm : 0;
   pkt.battery_mV  = readBatteryMilliVolts();
   pkt.flags       = 0;
   if (valid) pkt.flags |= 0x01;
-  if (valid && (median_cm <= 6.0f)) pkt.flags |= 0x02;
-  pkt.crc8        = crc8((uint8_t*)&pkt, sizeof(pkt) - 1);
-
-  Serial.printf("Packet ready: dist=%dmm flags=0x%02X\n", pkt.distance_mm, pkt.flags);
-
-  // === TRANSMISSION PHASE ===
-  Serial.println("\n=== TRANSMISSION ===");
-  
-  // Initialize WiFi
-  WiFi.mode(WIFI_STA);
-  WiFi.setAutoConnect(false);
-  WiFi.setAutoReconnect(false);
-  WiFi.persistent(false);
-  WiFi.disconnect(true, true);
-  
-  delay(100);  // Let WiFi stabilize
-
-  // Find webserver channel (with error protection)
-  uint8_t webserver_channel = findWebserverChannel();
-  
-  // Initialize ESP-NOW
-  if (esp_now_init() != ESP_OK) {
-    Serial.println("ESP-NOW init failed!");
-  } else {
-    Serial.println("ESP-NOW OK");
-    esp_now_register_send_cb(onDataSent);
-    
-    // Add peers
-    bool peers_ok = true;
-    peers_ok &= addPeer(MAC_SIREN, 1);
-    peers_ok &= addPeer(MAC_WEBSERVER, webserver_channel);
-    
-    if (peers_ok) {
-      delay(50);  // Brief settle time
-      
-      // Send to siren first
-      Serial.println("\n--- SIREN ---");
-      bool siren_ok = sendPacketTo(MAC_SIREN, pkt, 1);
-      if (!siren_ok) {
-        delay(100);
-        siren_ok = sendPacketTo(MAC_SIREN, pkt, 1);
-      }
-      
-      // Send to webserver
-      Serial.println("\n--- WEBSERVER ---");
-      bool web_ok = sendPacketTo(MAC_WEBSERVER, pkt, webserver_channel);
-      if (!web_ok) {
-        delay(100);
-        web_ok = sendPacketTo(MAC_WEBSERVER, pkt, webserver_channel);
-      }
-      
-      Serial.printf("\nSUMMARY: Siren=%s Web=%s\n", 
-        siren_ok ? "OK" : "FAIL", web_ok ? "OK" : "FAIL");
-    } else {
-      Serial.println("Peer setup failed");
-    }
+  if (valid && (median_mm <= AT_RISK_MM)) pkt.flags |= 0x02;
+  if (earlyExit) pkt.flags |= 0x04;
+  pkt.samples     = sampleCount > 255 ? 255 : (uint8_t)sampleCount;
+  pkt.scan_ms     = scanMs > 0xFFFF ? 0xFFFF : (uint16_t)scanMs;
+
+  LOGF("Packet ready: dist=%dmm flags=0x%02X\n", pkt.distance_mm, pkt.flags);
+
+  // === SEND-ON-CHANGE ===
+  historyPush(history, (uint32_t)time(nullptr), pkt.distance_mm, pkt.flags);
+  // === SEND DECISION + NEXT SLEEP (wake_cycle.h) ===
+  const WakePlan plan = planWake(history, WAKE_CONFIG, valid, pkt.distance_mm, pkt.battery_mV);
+  const SendReason why = plan.send;
+  const uint32_t sleepS = plan.sleepS;
+  LOGF("Send decision: %s (unsent=%d, wakes since tx=%d)\n",
+    sendReasonName(why), history.unsent, history.wakesSinceTx);
+  LOGF("Next sleep: %us (%s, fill=%s%.1fmm/min, battery=%umV)\n", (unsigned)sleepS,
+    sleepReasonName(plan.sleepWhy), plan.haveRate ? "" : "~", plan.fillMmPerMin, pkt.battery_mV);
+  pkt.interval_s = (uint16_t)sleepS;
+  measureSlotLead(cause == ESP_SLEEP_WAKEUP_TIMER);
+
+  bool powerSent = false;
+  if (why != SEND_NONE) {
+    while (!bootNonce) bootNonce = (uint16_t)esp_random();
+    pkt.seq  = ++txSeq;
+    pkt.boot = bootNonce;
+    uint8_t batch[ESP_NOW_MAX_DATA_LEN];
+    size_t batchLen = buildHistoryBatch(batch, sizeof(batch), pkt, powerSent);
+    if (powerSent) LOGF("Power budget attached (%u wakes)\n", power.wakes);
+    if (transmitPhase(pkt, sampledAt, batch, batchLen)) historyMarkSent(history);
+    else { historyMarkFailed(history); powerSent = false; }
   }
 
   // === SLEEP ===
-  Serial.println("\n=== SLEEP ===");
+  phase(PH_SHUTDOWN);
+  LOGLN("\n=== SLEEP ===");
   safeRadiosOff();
+
+#if SENSOR_LOG
+  Serial.print("Awake ms:");
+  for (uint8_t i = 0; i < PH_COUNT; ++i) {
+    if (phases.us[i]) Serial.printf(" %s=%u", POWER_PHASE_NAMES[i], (unsigned)((phases.us[i] + 500) / 1000));
+  }
+  Serial.println();
+#endif
   
-  Serial.println("Sleeping 120s...");
+  // Cut the sleep short to the latest slot within it (the announced interval_s stays
+  // an upper bound); without a schedule sleep the plain interval.
+  const int64_t now = rtcNowUs();
+  int64_t sleepUs = (int64_t)sleepS * 1000000LL;
+  if (SLOT_SCHEDULE && slotSleepUs(slotSched, now, sleepS, slotSched.leadMs, sleepUs)) {
+    LOGF("Sleeping %.1fs (slot-aligned, %us wanted)...\n", sleepUs / 1e6, (unsigned)sleepS);
+  } else {
+    LOGF("Sleeping %us...\n", (unsigned)sleepS);
+  }
+  slotSched.wakeUs = now + sleepUs;
+#if SENSOR_LOG
   Serial.flush();
+#endif
+
+  // The delivered window is closed; this wake opens the next one.
+  if (powerSent) powerReset(power);
+  powerAddWake(power, phases, esp_timer_get_time(), historyAt(history, 0).t_s, why != SEND_NONE);
   
-  esp_sleep_enable_timer_wakeup(SLEEP_US);
+  esp_sleep_enable_timer_wakeup((uint64_t)sleepUs);
   esp_deep_sleep_start();
 }
 
@@ -0,0 +1,69 @@
+// channel_follow.h — keep the siren on whatever channel the webserver operates on
+//
+// The webserver's channel is its router's, so it can change on any reboot or AP
+// channel switch. The webserver broadcasts a ChannelAnnounce (sensor_packet.h) every
+// ANNOUNCE_MS. The siren stays put while it hears those (or any other frame from the
+// webserver). When lostMs goes by with nothing heard it hunts: one step to the next
+// channel right away, then another every dwellMs, wrapping after maxChannel. dwellMs
+// just over ANNOUNCE_MS means each channel is listened on for one full announce
+// period. The first announce heard locks the siren to the channel it names (which
+// is where it is, unless the webserver is about to move).
+// Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+
+struct FollowConfig {
+  uint32_t lostMs;       // nothing from the webserver for this long: start hunting
+  uint32_t dwellMs;      // time on each channel while hunting
+  uint8_t  maxChannel;   // 11 (US), 13 (EU), 14 (JP)
+};
+
+struct ChannelFollower {
+  uint8_t  channel = 1;  // the radio's channel
+  bool     locked  = false;
+  uint32_t heardMs = 0;  // last frame from the webserver (or begin / last hop)
+  uint32_t hops = 0, locks = 0, losses = 0;
+};
+
+static inline void followBegin(ChannelFollower &f, uint8_t channel, uint32_t nowMs) {
+  f = ChannelFollower{};
+  f.channel = channel;
+  f.heardMs = nowMs;
+}
+
+// Any frame from the webserver. announcedCh is the channel of a ChannelAnnounce, 0 for
+// other frames (they only prove the channel is right). Returns the channel to switch
+// the radio to, or 0 to stay.
+static inline uint8_t followHeard(ChannelFollower &f, uint8_t announcedCh, uint32_t nowMs) {
+  f.heardMs = nowMs;
+  if (!f.locked) { f.locked = true; f.locks++; }
+  if (!announcedCh || announcedCh == f.channel) return 0;
+  f.channel = announcedCh;
+  f.hops++;
+  return announcedCh;
+}
+
+// How long followTick() has nothing to do: the caller can sleep this long (unless a
+// frame comes in first, which moves heardMs). 0 = call it now.
+static inline uint32_t followDueMs(const ChannelFollower &f, uint32_t nowMs, const FollowConfig &cfg) {
+  const uint32_t quiet = nowMs - f.heardMs;
+  const uint32_t limit = f.locked ? cfg.lostMs : cfg.dwellMs;
+  return quiet >= limit ? 0 : limit - quiet;
+}
+
+// Call when followDueMs() runs out (or any time). Returns the channel to switch to,
+// or 0 to stay.
+static inline uint8_t followTick(ChannelFollower &f, uint32_t nowMs, const FollowConfig &cfg) {
+  const uint32_t quiet = nowMs - f.heardMs;
+  if (f.locked) {
+    if (quiet < cfg.lostMs) return 0;
+    f.locked = false;
+    f.losses++;
+  } else if (quiet < cfg.dwellMs) {
+    return 0;
+  }
+  f.channel = f.channel >= cfg.maxChannel ? 1 : f.channel + 1;
+  f.heardMs = nowMs;
+  f.hops++;
+  return f.channel;
+}
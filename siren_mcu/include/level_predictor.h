@@ -0,0 +1,82 @@
+// level_predictor.h — Siren MCU: per-tank fill-rate estimate and predictive at-risk class
+// A constant-velocity Kalman filter over the reported distance-to-top (cm) gives the
+// level and its rate of change. A tank is PREDICTED at risk when the level, carried
+// forward to the next report the sensor is due to send, crosses the trigger — but only
+// if it is clearly filling (rate below -minRate, and 2 sigma from zero). Once raised, the
+// predicted class holds until the projection is back above trigger + hysteresis.
+// ACTUAL is the old rule (distance <= trigger) and always wins. Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <math.h>
+
+enum AlarmClass : uint8_t { ALARM_NONE, ALARM_PREDICTED, ALARM_ACTUAL };
+
+static inline const char *alarmClassName(AlarmClass c) {
+  return c == ALARM_ACTUAL ? "ACTUAL" : c == ALARM_PREDICTED ? "PREDICTED" : "none";
+}
+
+struct PredictorConfig {
+  float triggerCm;             // at risk at or below this distance
+  float hysteresisCm;          // predicted class clears above trigger + this
+  float horizonS;              // time until the next report is due
+  float minRateCmS;            // slower fills never predict (cm/s, positive)
+  float measVarCm2;            // reading noise variance
+  float accelVar;              // process noise: rate drift, (cm/s)^2 per second
+  uint32_t resetAfterMs;       // longer gaps restart the filter
+};
+
+struct LevelPredictor {
+  bool     ready = false;
+  bool     predicted = false;  // latched predicted class
+  float    d = 0, v = 0;       // distance (cm), rate (cm/s; negative = filling)
+  float    p00 = 0, p01 = 0, p11 = 0;
+  uint32_t lastMs = 0;
+  uint16_t updates = 0;
+
+  void reset(float z) {
+    ready = true;
+    d = z; v = 0;
+    p00 = 1.0f; p01 = 0; p11 = 0.01f;          // rate unknown: +-0.1 cm/s
+    updates = 1;
+  }
+
+  void update(float z, uint32_t nowMs, const PredictorConfig &c) {
+    const uint32_t gap = nowMs - lastMs;
+    lastMs = nowMs;
+    if (!ready || gap > c.resetAfterMs) { reset(z); return; }
+    const float dt = gap / 1000.0f;
+
+    // Predict
+    d += v * dt;
+    const float q = c.accelVar * dt;
+    p00 += dt * (2 * p01 + dt * p11) + q * dt * dt / 3;
+    p01 += dt * p11 + q * dt / 2;
+    p11 += q;
+
+    // Correct
+    const float s  = p00 + c.measVarCm2;
+    const float k0 = p00 / s, k1 = p01 / s;
+    const float y  = z - d;
+    d += k0 * y;
+    v += k1 * y;
+    p11 -= k1 * p01;
+    p01 -= k0 * p01;
+    p00 -= k0 * p00;
+    if (updates < 0xFFFF) updates++;
+  }
+
+  float project(float horizonS) const { return d + v * horizonS; }
+  float rateSigma() const { return sqrtf(p11 > 0 ? p11 : 0); }
+
+  // Feed one valid reading; returns its alarm class.
+  AlarmClass classify(float z, uint32_t nowMs, const PredictorConfig &c) {
+    update(z, nowMs, c);
+    if (z <= c.triggerCm) { predicted = false; return ALARM_ACTUAL; }
+
+    const float ahead   = project(c.horizonS);
+    const bool  filling = updates >= 2 && v < -c.minRateCmS && v + 2 * rateSigma() < 0;
+    if (predicted) predicted = filling && ahead <= c.triggerCm + c.hysteresisCm;
+    else           predicted = filling && ahead <= c.triggerCm;
+    return predicted ? ALARM_PREDICTED : ALARM_NONE;
+  }
+};
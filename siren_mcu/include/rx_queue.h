@@ -0,0 +1,68 @@
+// rx_queue.h — bounded single-producer/single-consumer ESP-NOW receive queue
+// The ESP-NOW receive callback runs in the Wi-Fi driver task. It should only copy
+// the raw frame (+ MAC and arrival time) in here and return; parsing, CRC checks,
+// logging and state updates happen on the consumer side in loop(). Lock-free: the
+// producer only writes `head`, the consumer only writes `tail`. Plain C++, no
+// Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+#ifndef RX_QUEUE_DEPTH
+#define RX_QUEUE_DEPTH 16      // power of two
+#endif
+#ifndef RX_FRAME_MAX
+#define RX_FRAME_MAX 250       // ESP_NOW_MAX_DATA_LEN
+#endif
+
+struct RxFrame {
+  uint8_t  mac[6];
+  uint8_t  len;
+  uint32_t rxMs;               // millis() when the callback ran
+  uint8_t  data[RX_FRAME_MAX];
+};
+
+struct RxQueue {
+  RxFrame slots[RX_QUEUE_DEPTH];
+  std::atomic<uint32_t> head{0};   // next slot to fill (producer)
+  std::atomic<uint32_t> tail{0};   // next slot to drain (consumer)
+
+  // Producer-side stats (only the callback writes them)
+  uint32_t pushed = 0;
+  uint32_t dropped = 0;            // queue full
+  uint32_t oversize = 0;           // len > RX_FRAME_MAX
+  uint32_t highWater = 0;          // max frames waiting at once
+  uint32_t cbMaxUs = 0;            // slowest callback, set by the caller
+
+  // Producer (Wi-Fi task). Never blocks.
+  bool push(const uint8_t *mac, const uint8_t *data, int len, uint32_t nowMs) {
+    if (len < 0 || len > RX_FRAME_MAX) { oversize++; return false; }
+    const uint32_t h = head.load(std::memory_order_relaxed);
+    const uint32_t t = tail.load(std::memory_order_acquire);
+    if (h - t >= RX_QUEUE_DEPTH) { dropped++; return false; }
+
+    RxFrame &f = slots[h & (RX_QUEUE_DEPTH - 1)];
+    memcpy(f.mac, mac, 6);
+    memcpy(f.data, data, len);
+    f.len  = (uint8_t)len;
+    f.rxMs = nowMs;
+    head.store(h + 1, std::memory_order_release);
+
+    pushed++;
+    if (h + 1 - t > highWater) highWater = h + 1 - t;
+    return true;
+  }
+
+  // Consumer (loop). front() stays valid until pop().
+  const RxFrame *front() const {
+    const uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return nullptr;
+    return &slots[t & (RX_QUEUE_DEPTH - 1)];
+  }
+  void pop() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  uint32_t size() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+};
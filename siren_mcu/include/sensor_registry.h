@@ -0,0 +1,79 @@
+// sensor_registry.h — sensor table and O(1) MAC -> tank_id lookup for any number of tanks
+// Shared verbatim by siren_mcu and webserver_mcu (keep the copies equal).
+//
+// The table is one SensorInfo row per tank (tank_id = row) and stays in flash.
+// begin() builds an open-addressing index over it: a power-of-two array of one-byte
+// slots, at most half full, probed linearly from a multiplicative hash of the MAC's
+// low bytes. A lookup costs one hash and about one probe however many tanks there
+// are, and the index is 2-4 bytes per tank. All-zero (placeholder) MACs are skipped.
+// Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define REGISTRY_MAX_TANKS 255   // tank_id is one byte and 255 means "all tanks" in commands
+#define REGISTRY_EMPTY     0xFF
+
+#pragma pack(push,1)
+struct SensorInfo {
+  uint8_t mac[6];          // sensor STA MAC
+  uint8_t height_cm;       // tank depth for fill %; 0 = unknown (dashboard default)
+};
+#pragma pack(pop)
+
+struct SensorRegistry {
+  const SensorInfo *rows = nullptr;
+  uint16_t count = 0;          // tanks = rows in the table
+  uint16_t indexed = 0;        // rows with a usable MAC
+  uint16_t duplicates = 0;     // rows whose MAC an earlier row already claimed
+  uint8_t  shift = 32;         // 32 - log2(slots)
+  uint16_t mask = 0;
+  uint8_t *slots = nullptr;    // tank_id or REGISTRY_EMPTY
+
+  uint32_t slot(const uint8_t *mac) const {
+    // OUIs repeat across a fleet, so only the low four bytes are hashed.
+    const uint32_t k = (uint32_t)mac[2] << 24 | (uint32_t)mac[3] << 16 | (uint32_t)mac[4] << 8 | mac[5];
+    return (uint32_t)(k * 2654435761u) >> shift;
+  }
+
+  // False if the table is too large or the index can't be allocated.
+  bool begin(const SensorInfo *table, uint16_t n) {
+    if (n > REGISTRY_MAX_TANKS) return false;
+    uint32_t size = 4;
+    shift = 30;
+    while (size < 2u * n) { size <<= 1; shift--; }
+    free(slots);
+    slots = (uint8_t *)malloc(size);
+    if (!slots) { count = 0; return false; }
+    memset(slots, REGISTRY_EMPTY, size);
+    rows = table;
+    count = n;
+    mask = (uint16_t)(size - 1);
+    indexed = duplicates = 0;
+
+    static const uint8_t ZERO[6] = {0};
+    for (uint16_t i = 0; i < n; ++i) {
+      const uint8_t *mac = table[i].mac;
+      if (memcmp(mac, ZERO, 6) == 0) continue;
+      if (find(mac) >= 0) { duplicates++; continue; }
+      uint32_t s = slot(mac);
+      while (slots[s] != REGISTRY_EMPTY) s = (s + 1) & mask;
+      slots[s] = (uint8_t)i;
+      indexed++;
+    }
+    return true;
+  }
+
+  // tank_id of the sensor with this MAC, or -1.
+  int find(const uint8_t *mac) const {
+    if (!slots) return -1;
+    for (uint32_t s = slot(mac);; s = (s + 1) & mask) {
+      const uint8_t t = slots[s];
+      if (t == REGISTRY_EMPTY) return -1;
+      if (memcmp(rows[t].mac, mac, 6) == 0) return t;
+    }
+  }
+
+  bool valid(uint8_t tank_id) const { return tank_id < count; }
+};
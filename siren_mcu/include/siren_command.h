@@ -0,0 +1,223 @@
+// siren_command.h — webserver -> siren commands, their acks, and the webserver's send queue
+// Shared verbatim by siren_mcu and webserver_mcu (keep the copies equal).
+//
+// A command used to be one unacknowledged esp_now_send(). Now each one gets an id and
+// waits in a CommandQueue until the siren answers with a CommandAck. The siren sends
+// that after applying the command, and again for any retry of one it already
+// applied. The queue keeps one command on the air at a time. A command the siren
+// hasn't acked is resent after a backoff (CMD_RETRY_MS, doubling) until CMD_MAX_TRIES.
+// A new command replaces any still-unfinished one that it makes pointless: same kind
+// (alarm on/off, snooze, predictive) and same tank, or any tank if it's for all.
+// The replaced one ends SUPERSEDED. Callers poll by id, or take the result from
+// onDone.
+//
+// v2 frames widen ms to 32 bits (v1's 16 bits capped snoozes at 65 s) and carry
+// (boot, id). boot is random per webserver boot, so the siren resets its duplicate
+// window when the webserver restarts and ids count from 1 again.
+// Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "sensor_packet.h"
+
+#define CMD_TYPE     0xC1
+#define CMD_ACK_TYPE 0xC2
+
+// cmd: 1=FORCE_ON (ms), 2=FORCE_OFF, 3=SNOOZE_5MIN, 4=CLEAR_SNOOZE, 5=SNOOZE_CUSTOM_MS,
+//      6=SET_PREDICTIVE (ms: 0=off, 1=on)
+enum SirenCmd : uint8_t {
+  CMD_FORCE_ON = 1, CMD_FORCE_OFF, CMD_SNOOZE_5MIN, CMD_CLEAR_SNOOZE, CMD_SNOOZE_MS, CMD_SET_PREDICTIVE
+};
+
+#pragma pack(push,1)
+struct CommandPacket {   // v1, unacked; still accepted by the siren
+  uint8_t  ver;          // 1
+  uint8_t  type;         // 0xC1
+  uint8_t  cmd;
+  uint8_t  tank_id;      // tank or 255 for ALL
+  uint16_t ms;
+  uint8_t  crc8;         // CRC-8 over [ver..ms]
+};
+
+struct CommandPacketV2 {
+  uint8_t  ver;          // 2
+  uint8_t  type;         // 0xC1
+  uint8_t  cmd;
+  uint8_t  tank_id;      // tank or 255 for ALL
+  uint16_t boot;         // random per webserver boot
+  uint16_t id;           // per command from 1; retries reuse it
+  uint32_t ms;           // FORCE_ON duration, custom snooze length, predictive on/off
+  uint8_t  crc8;         // CRC-8 over [ver..ms]
+};
+
+enum CmdAckStatus : uint8_t { CMD_ACK_APPLIED, CMD_ACK_UNKNOWN };
+
+struct CommandAck {      // Siren -> Webserver
+  uint8_t  ver;          // 1
+  uint8_t  type;         // 0xC2
+  uint16_t boot, id;     // echoed
+  uint8_t  status;       // CmdAckStatus
+  uint8_t  crc8;
+};
+#pragma pack(pop)
+
+static inline CommandPacketV2 makeCommand(uint8_t cmd, uint8_t tank_id, uint32_t ms, uint16_t boot, uint16_t id) {
+  CommandPacketV2 c{2, CMD_TYPE, cmd, tank_id, boot, id, ms, 0};
+  c.crc8 = crc8((const uint8_t *)&c, sizeof(c) - 1);
+  return c;
+}
+
+// v1 or v2 into v2 form (v1: boot = id = 0, no ack expected). Type and CRC checked.
+static inline bool decodeCommand(const uint8_t *data, int len, CommandPacketV2 &c) {
+  if (len < 2 || data[1] != CMD_TYPE || data[len - 1] != crc8(data, len - 1)) return false;
+  if (len == (int)sizeof(CommandPacket) && data[0] == 1) {
+    CommandPacket v1;
+    memcpy(&v1, data, sizeof(v1));
+    c = CommandPacketV2{1, CMD_TYPE, v1.cmd, v1.tank_id, 0, 0, v1.ms, v1.crc8};
+    return true;
+  }
+  if (len == (int)sizeof(CommandPacketV2) && data[0] == 2) {
+    memcpy(&c, data, sizeof(c));
+    return true;
+  }
+  return false;
+}
+
+static inline CommandAck makeCommandAck(uint16_t boot, uint16_t id, CmdAckStatus status) {
+  CommandAck a{1, CMD_ACK_TYPE, boot, id, (uint8_t)status, 0};
+  a.crc8 = crc8((const uint8_t *)&a, sizeof(a) - 1);
+  return a;
+}
+
+static inline bool decodeCommandAck(const uint8_t *data, int len, CommandAck &a) {
+  if (len != (int)sizeof(CommandAck)) return false;
+  memcpy(&a, data, sizeof(a));
+  return a.ver == 1 && a.type == CMD_ACK_TYPE && a.crc8 == crc8(data, sizeof(a) - 1);
+}
+
+// ---- Webserver side ----
+#ifndef CMDQ_DEPTH
+#define CMDQ_DEPTH 8           // commands remembered, pending or finished
+#endif
+#define CMD_MAX_TRIES 5
+#define CMD_RETRY_MS  150      // first resend; doubles per try, so a command fails 4.65 s after its first send
+
+enum CmdState : uint8_t { CMD_FREE, CMD_QUEUED, CMD_SENT, CMD_APPLIED, CMD_REJECTED, CMD_FAILED, CMD_SUPERSEDED };
+
+static inline const char *cmdStateName(uint8_t s) {
+  static const char *const names[] = {"free", "queued", "sent", "applied", "rejected", "failed", "superseded"};
+  return s < sizeof(names) / sizeof(names[0]) ? names[s] : "?";
+}
+
+static inline bool cmdFinished(uint8_t s) { return s >= CMD_APPLIED; }
+
+// Commands of one kind overwrite each other's effect on the siren.
+static inline uint8_t cmdKind(uint8_t cmd) {
+  switch (cmd) {
+    case CMD_FORCE_ON: case CMD_FORCE_OFF: return 1;
+    case CMD_SNOOZE_5MIN: case CMD_CLEAR_SNOOZE: case CMD_SNOOZE_MS: return 2;
+    case CMD_SET_PREDICTIVE: return 3;
+    default: return 0;       // unknown: never coalesced
+  }
+}
+
+struct CmdSlot {
+  CommandPacketV2 pkt;
+  uint8_t  state;
+  uint8_t  tries;
+  uint16_t supersededBy;
+  uint32_t queuedMs, firstSentMs, nextMs, doneMs;
+};
+
+typedef void (*CmdDoneFn)(const CmdSlot &s, void *ctx);
+
+struct CommandQueue {
+  CmdSlot  slot[CMDQ_DEPTH] = {};
+  uint16_t boot = 0, lastId = 0;
+  uint16_t inFlight = 0;                 // id on the air, 0 = none
+  uint32_t submitted = 0, coalesced = 0, dropped = 0, sends = 0, resends = 0;
+  uint32_t applied = 0, rejected = 0, failed = 0;
+  CmdDoneFn onDone = nullptr;
+  void     *ctx = nullptr;
+
+  void begin(uint16_t bootNonce) { *this = CommandQueue{}; boot = bootNonce ? bootNonce : 1; }
+
+  CmdSlot *find(uint16_t id) {
+    for (CmdSlot &s : slot) if (s.state != CMD_FREE && s.pkt.id == id) return &s;
+    return nullptr;
+  }
+
+  // A new `kind` command for `tank_id` (255: all tanks) replaces s while s is pending.
+  static bool replaces(const CmdSlot &s, uint8_t kind, uint8_t tank_id) {
+    if (s.state != CMD_QUEUED && s.state != CMD_SENT) return false;
+    return kind && cmdKind(s.pkt.cmd) == kind && (tank_id == 255 || s.pkt.tank_id == tank_id);
+  }
+
+  // Returns the command's id, 0 when every slot holds an unfinished command it doesn't
+  // replace. Replaced commands are finished first, so their slots count as room.
+  uint16_t submit(uint8_t cmd, uint8_t tank_id, uint32_t ms, uint32_t now) {
+    const uint8_t kind = cmdKind(cmd);
+    bool room = false;
+    for (const CmdSlot &s : slot) room |= s.state == CMD_FREE || cmdFinished(s.state) || replaces(s, kind, tank_id);
+    if (!room) { dropped++; return 0; }
+    const uint16_t id = ++lastId ? lastId : ++lastId;  // 0 means "none"
+    for (CmdSlot &s : slot) {
+      if (!replaces(s, kind, tank_id)) continue;
+      s.supersededBy = id;
+      coalesced++;
+      finish(s, CMD_SUPERSEDED, now);
+    }
+    CmdSlot *use = nullptr;
+    for (CmdSlot &s : slot) {                          // free slot, else the oldest finished one
+      if (s.state == CMD_FREE) { use = &s; break; }
+      if (cmdFinished(s.state) && (!use || (int32_t)(s.doneMs - use->doneMs) < 0)) use = &s;
+    }
+    *use = CmdSlot{};
+    use->pkt      = makeCommand(cmd, tank_id, ms, boot, id);
+    use->state    = CMD_QUEUED;
+    use->queuedMs = now;
+    use->nextMs   = now;
+    submitted++;
+    return id;
+  }
+
+  // The frame to put on the air now, if any: the oldest queued command, or a resend of
+  // the one in flight once its backoff is up. The caller sends it right away.
+  const CommandPacketV2 *due(uint32_t now) {
+    CmdSlot *s = inFlight ? find(inFlight) : nullptr;
+    if (!s) {
+      inFlight = 0;
+      for (CmdSlot &c : slot)
+        if (c.state == CMD_QUEUED && (!s || (int32_t)(c.queuedMs - s->queuedMs) < 0)) s = &c;
+      if (!s) return nullptr;
+    }
+    if ((int32_t)(now - s->nextMs) < 0) return nullptr;
+    if (s->tries >= CMD_MAX_TRIES) { finish(*s, CMD_FAILED, now); return nullptr; }
+    if (s->tries) resends++;
+    else          s->firstSentMs = now;
+    s->state  = CMD_SENT;
+    s->nextMs = now + (CMD_RETRY_MS << s->tries);
+    s->tries++;
+    sends++;
+    inFlight = s->pkt.id;
+    return &s->pkt;
+  }
+
+  void onAck(const CommandAck &a, uint32_t now) {
+    if (a.boot != boot) return;
+    CmdSlot *s = find(a.id);
+    if (!s || cmdFinished(s->state)) return;            // late ack of a retry, or superseded
+    finish(*s, a.status == CMD_ACK_APPLIED ? CMD_APPLIED : CMD_REJECTED, now);
+  }
+
+  void finish(CmdSlot &s, uint8_t state, uint32_t now) {
+    s.state  = state;
+    s.doneMs = now;
+    if (inFlight == s.pkt.id) inFlight = 0;
+    if (state == CMD_APPLIED)  applied++;
+    if (state == CMD_REJECTED) rejected++;
+    if (state == CMD_FAILED)   failed++;
+    if (onDone) onDone(s, ctx);
+  }
+};
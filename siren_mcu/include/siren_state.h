@@ -0,0 +1,93 @@
+// siren_state.h — Siren MCU: pulse/snooze state machine on a caller-supplied clock
+// Owns the alarm decisions only; main.cpp maps its results onto the GPIO, the
+// one-shot esp_timer and the serial log. Every method takes `now` (ms) instead of
+// reading millis(), so the same code runs against a virtual clock on the host.
+// Time comparisons are wrap-safe. Per-tank snoozes are allocated by begin() for
+// however many tanks the sensor table has. Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stdlib.h>
+#include "level_predictor.h"   // AlarmClass
+
+static inline bool timeReached(uint32_t now, uint32_t at) { return (int32_t)(now - at) >= 0; }
+
+enum ReadingVerdict {
+  RV_INVALID,      // unknown tank
+  RV_SAFE,         // no alarm class
+  RV_TRIGGERED,    // at risk: siren pulsed, tank snoozed
+  RV_PIGGYBACK,    // at risk while another tank's pulse runs: tank snoozed only
+  RV_SNOOZED       // at risk but snoozed
+};
+
+struct TankSnooze {
+  uint32_t   until;
+  bool       on;
+  AlarmClass cls;              // what set the snooze
+};
+
+struct SirenState {
+  uint32_t pulseMs;            // ACTUAL alarm pulse length
+  uint32_t predictPulseMs;     // PREDICTED alarm pulse length
+  uint32_t snoozeMs;           // default per-tank snooze
+
+  bool     active = false;
+  uint32_t offAt  = 0;
+  uint16_t   tanks = 0;
+  TankSnooze *snoozes = nullptr;
+
+  SirenState(uint32_t pulse, uint32_t predictPulse, uint32_t snooze)
+    : pulseMs(pulse), predictPulseMs(predictPulse), snoozeMs(snooze) {}
+
+  bool begin(uint16_t n) {
+    snoozes = (TankSnooze *)calloc(n, sizeof(TankSnooze));
+    tanks = snoozes ? n : 0;
+    return snoozes != nullptr;
+  }
+
+  uint32_t pulseFor(AlarmClass c) const { return c == ALARM_ACTUAL ? pulseMs : predictPulseMs; }
+
+  void pulse(uint32_t ms, uint32_t now) {
+    active = true;
+    offAt  = now + ms;
+  }
+  void off() { active = false; }
+
+  // Turns the siren off once its pulse has run out; true on that transition.
+  bool expire(uint32_t now) {
+    if (!active || !timeReached(now, offAt)) return false;
+    active = false;
+    return true;
+  }
+  uint32_t pulseLeft(uint32_t now) const { return active && !timeReached(now, offAt) ? offAt - now : 0; }
+
+  // tid 255 = all tanks. A snooze set by a PREDICTED alarm still lets the ACTUAL
+  // alarm through once; manual snoozes (commands) count as ACTUAL and hold both.
+  void snooze(uint8_t tid, uint32_t now, uint32_t ms, AlarmClass cls = ALARM_ACTUAL) {
+    for (uint16_t i = 0; i < tanks; i++) {
+      if (tid != 255 && tid != i) continue;
+      snoozes[i] = TankSnooze{now + ms, true, cls};
+    }
+  }
+  void clearSnooze(uint8_t tid) {
+    for (uint16_t i = 0; i < tanks; i++) if (tid == 255 || tid == i) snoozes[i].on = false;
+  }
+  uint32_t snoozeLeft(uint8_t tid, uint32_t now) {
+    if (tid >= tanks) return 0;
+    TankSnooze &z = snoozes[tid];
+    if (z.on && timeReached(now, z.until)) z.on = false;
+    return z.on ? z.until - now : 0;
+  }
+
+  // cls comes from LevelPredictor::classify() for the tank's latest valid reading.
+  ReadingVerdict reading(uint8_t tid, AlarmClass cls, uint32_t now) {
+    if (tid >= tanks) return RV_INVALID;
+    if (cls == ALARM_NONE) return RV_SAFE;
+    const bool escalate = cls == ALARM_ACTUAL && snoozes[tid].cls == ALARM_PREDICTED;
+    if (snoozeLeft(tid, now) && !escalate) return RV_SNOOZED;
+    // If the siren is already sounding for another tank, piggyback: just snooze this one.
+    const ReadingVerdict v = active ? RV_PIGGYBACK : RV_TRIGGERED;
+    if (!active) pulse(pulseFor(cls), now);
+    snooze(tid, now, snoozeMs, cls);
+    return v;
+  }
+};
@@ -13,7 +13,7 @@ Important Security & Publishing Notes
         static const char* WIFI_PASS = "…";
         static const uint8_t PMK[16] = { // 16 bytes  };
         static const uint8_t MAC_SIREN[6]   = { // STA MAC  };
-        static const uint8_t MAC_SENSORS[3][6] = { // STA MACs };
+        static const SensorInfo SENSORS[] = { // STA MAC + depth per tank };
     .gitignore:
         secrets.h
 
@@ -46,6 +46,17 @@ Important Security & Publishing Notes
 #include <esp_now.h>
 #include <esp_wifi.h>  // Added for channel control
 #include <string.h> // memcmp
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#define RX_QUEUE_DEPTH 8
+#include "rx_queue.h"
+#include "sensor_packet.h"    // SensorPacketV1/V2/V3, crc8, LinkStats
+#include "sensor_registry.h"  // SensorInfo table + MAC hash
+#include "siren_state.h"
+#include "channel_follow.h"
+#include "relay_frame.h"      // readings relayed by the webserver
+#include "siren_command.h"    // commands from the webserver and their acks
 
 // ====== Hardware ======
 static const int SIREN_PIN = 25;      // IRLZ44N gate, low-side. HIGH=ON.
@@ -54,118 +65,209 @@ static const uint32_t SNOOZE_MS   = 5UL * 60UL * 1000UL; // 5 min per tank
 static const uint32_t STALE_MS    = 7UL * 60UL * 1000UL; // ignore >7 min old tanks
 static const float    TRIGGER_CM  = 6.0f;       // alarm threshold
 
+// ====== Predictive alarm (level_predictor.h) ======
+// Fires a shorter PREDICTED pulse when a filling tank will cross TRIGGER_CM before its
+// sensor's next report. Toggle at runtime with command 6 (SET_PREDICTIVE).
+static const uint32_t PREDICT_PULSE_MS = 2000;
+static const PredictorConfig PREDICT = {
+  TRIGGER_CM,
+  2.0f,                 // hysteresis (cm)
+  130.0f,               // next report due when the sensor doesn't say (v1: fixed 120 s sleep + scan/jitter)
+  0.002f,               // ignore fills slower than ~0.1 cm/min
+  0.09f,                // reading noise: 0.3 cm sigma
+  1e-6f,                // rate drift
+  20UL * 60UL * 1000UL  // restart the filter after a 20 min gap (longest adaptive sleep is 15 min)
+};
+static bool predictiveEnabled = true;
+
+// ====== Channel (channel_follow.h) ======
+// No fixed channel: the siren follows the webserver's ChannelAnnounce (sent every
+// second), so sensors reach both with one broadcast wherever the router puts it.
+static const uint8_t START_CHANNEL = 1;
+static const FollowConfig FOLLOW = {
+  3500,                 // three announces missed: hunt
+  1100,                 // one announce period per channel while hunting
+  13                    // highest channel to try
+};
+static ChannelFollower follow;
+
 // ====== IDs / MACs (STA MACs you provided) ======
 static const uint8_t MAC_WEBSERVER[6] = {0x00,0x00,0x00,0x00,0x00,0x00};
-static const uint8_t MAC_SENSORS[3][6] = {
-  {0x00,0x00,0x00,0x00,0x00,0x00}, // Tank 0
-  {0x00,0x00,0x00,0x00,0x00,0x00}, // Tank 1
-  {0x00,0x00,0x00,0x00,0x00,0x00}  // Tank 2
+static const uint8_t MAC_BROADCAST[6] = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
+// SipHash key for the webserver's relay frames (its SIREN_RELAY); same 16 bytes there.
+static const uint8_t RELAY_KEY[16] = {0};
+// One row per tank, tank_id = row (up to 255); keep it in step with the webserver's.
+// The depth column is only used by the webserver's dashboard.
+static const SensorInfo SENSORS[] = {
+  {{0x00,0x00,0x00,0x00,0x00,0x00}, 0}, // Tank 0
+  {{0x00,0x00,0x00,0x00,0x00,0x00}, 0}, // Tank 1
+  {{0x00,0x00,0x00,0x00,0x00,0x00}, 0}  // Tank 2
 };
+static const uint16_t SENSOR_COUNT = sizeof(SENSORS) / sizeof(SENSORS[0]);
 
 // ====== Packet formats (match sensor/webserver) ======
-#pragma pack(push,1)
-struct SensorPacket {
-  uint8_t  ver;          // 1
-  uint8_t  tank_id;      // 0/1/2
-  uint16_t distance_mm;  // median over 5 s (0 if invalid)
-  uint16_t battery_mV;   // may be 0
-  uint8_t  flags;        // bit0: valid_median, bit1: at_risk_le_6cm
-  uint8_t  crc8;         // CRC-8 over [ver..flags]
-};
-
-// Optional control from Webserver -> Siren
-// type = 0xC1 marks command packet
-// cmd: 1=FORCE_ON (ms), 2=FORCE_OFF, 3=SNOOZE_5MIN, 4=CLEAR_SNOOZE, 5=SNOOZE_CUSTOM_MS
-struct CommandPacket {
-  uint8_t  ver;       // 1
-  uint8_t  type;      // 0xC1
-  uint8_t  cmd;       // 1..5
-  uint8_t  tank_id;   // 0/1/2 or 255 for ALL
-  uint16_t ms;        // duration for FORCE_ON or custom snooze duration
-  uint8_t  crc8;      // CRC-8 over [ver..ms]
-};
-#pragma pack(pop)
+// Sensor packets (v1 and v2) are in sensor_packet.h, webserver commands (v1, and v2
+// with acks) in siren_command.h.
 
-// CRC-8-ATM (poly 0x07, init 0x00)
-static uint8_t crc8(const uint8_t* d, size_t n) {
-  uint8_t c = 0;
-  for (size_t i=0;i<n;i++){ c ^= d[i]; for(int b=0;b<8;b++) c = (c&0x80)? (uint8_t)((c<<1)^0x07):(uint8_t)(c<<1); }
-  return c;
-}
+// ====== Event queue ======
+// loop() blocks on this queue. onDataRecv() posts EV_RX after queueing the frame, and
+// the one-shot pulse timer posts EV_TIMER, so the main task only runs when there is
+// work (or a diagnostics line is due).
+enum SirenEvent : uint8_t { EV_RX, EV_TIMER };
+static QueueHandle_t eventQueue = nullptr;
+static esp_timer_handle_t pulseTimer = nullptr;
 
 // ====== Siren control (non-blocking) ======
-static bool sirenActive = false;
-static uint32_t sirenOffAt = 0;
+static SirenState siren(SIREN_ON_MS, PREDICT_PULSE_MS, SNOOZE_MS);   // decisions live in siren_state.h
 
 inline void sirenOn()  { digitalWrite(SIREN_PIN, HIGH); }
 inline void sirenOff() { digitalWrite(SIREN_PIN, LOW);  }
 
+// Pulse accuracy: measured GPIO on-time vs the requested length.
+static int64_t  pulseOnUs = 0;
+static uint32_t pulseReqMs = 0;
+static int32_t  pulseErrLastUs = 0, pulseErrMaxUs = 0;
+static uint32_t pulses = 0;
+
+static void onPulseTimer(void *) {
+  const SirenEvent ev = EV_TIMER;
+  xQueueSend(eventQueue, &ev, 0);
+}
+
 static void sirenPulse(uint32_t on_ms) {
   Serial.printf("SIREN ON for %dms\n", on_ms);
   sirenOn();
-  sirenActive = true;
-  sirenOffAt = millis() + on_ms;
+  siren.pulse(on_ms, millis());
+  pulseOnUs  = esp_timer_get_time();
+  pulseReqMs = on_ms;
+  esp_timer_stop(pulseTimer);               // a new pulse replaces a running one
+  esp_timer_start_once(pulseTimer, (uint64_t)on_ms * 1000ULL);
+}
+
+static void sirenStop() {
+  esp_timer_stop(pulseTimer);
+  sirenOff();
+  siren.off();
+}
+
+// EV_TIMER: end the pulse if it is due (a later pulse may have pushed it out).
+static void servicePulse() {
+  if (!siren.expire(millis())) return;
+  sirenOff();
+  const int32_t err = (int32_t)(esp_timer_get_time() - pulseOnUs - (int64_t)pulseReqMs * 1000);
+  pulseErrLastUs = err;
+  if (abs(err) > abs(pulseErrMaxUs)) pulseErrMaxUs = err;
+  pulses++;
+  Serial.printf("SIREN OFF (timeout, %+dus vs %ums)\n", err, pulseReqMs);
 }
 
 // ====== Per-tank state ======
-static const int MAX_TANKS = 3;
-static float    lastDistanceCm[MAX_TANKS] = {NAN,NAN,NAN};
-static uint32_t lastRxMs[MAX_TANKS]       = {0,0,0};
-static uint32_t snoozeUntilMs[MAX_TANKS]  = {0,0,0};
+// One entry per SENSORS row, allocated in setup().
+struct SirenTank {
+  float    lastDistanceCm = NAN;
+  uint32_t lastRxMs = 0;
+  uint32_t alarmsActual = 0, alarmsPredicted = 0;
+  LevelPredictor predictor;     // fill-rate filter
+  LinkStats      link;          // v2 seq dedupe, loss and latency
+  PathStats      path[PATH_COUNT];  // direct vs relayed copies
+};
+static SensorRegistry registry;  // MAC -> tank_id
+static uint16_t   tankCount = 0;
+static SirenTank *tanks = nullptr;
+static RelayLink relayLink;      // the webserver's relay_seq per boot: replays and lost relays
+static uint32_t  relayBadTag = 0;
 
 // ====== Helpers ======
 static bool macEquals(const uint8_t *a, const uint8_t *b) { return memcmp(a,b,6)==0; }
 static bool isFromKnownSensor(const uint8_t *mac, int &tankIdOut) {
-  for (int i=0;i<MAX_TANKS;i++){ if (macEquals(mac, MAC_SENSORS[i])) { tankIdOut = i; return true; } }
-  return false;
+  tankIdOut = registry.find(mac);
+  return tankIdOut >= 0;
 }
 static bool isFromWebserver(const uint8_t *mac) { return macEquals(mac, MAC_WEBSERVER); }
 
+static void setChannel(uint8_t ch, const char *why) {
+  if (!ch) return;
+  const esp_err_t r = esp_wifi_set_channel(ch, WIFI_SECOND_CHAN_NONE);
+  Serial.printf("WiFi channel -> %d (%s): %s\n", ch, why, r == ESP_OK ? "OK" : "FAILED");
+}
+
+// Sensor peers take ESP_NOW_MAX_TOTAL_PEER_NUM minus the webserver and broadcast
+// entries; acks to the rest go out by broadcast (the sensor matches them on tank id
+// and seq).
+static const int MAX_SENSOR_PEERS = ESP_NOW_MAX_TOTAL_PEER_NUM - 2;
+static uint32_t acksSent = 0, ackFails = 0;
+
+static bool addPeer(const uint8_t mac[6]) {
+  esp_now_peer_info_t peer{};
+  memcpy(peer.peer_addr, mac, 6);
+  peer.channel = 0;    // whatever channel the radio is on, so peers follow the hops
+  peer.encrypt = false;
+  const esp_err_t result = esp_now_add_peer(&peer);
+  Serial.printf("Added peer %02X:%02X:%02X:%02X:%02X:%02X: %s\n",
+    mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], (result == ESP_OK) ? "OK" : "FAILED");
+  return result == ESP_OK;
+}
+
+static void sendAck(const uint8_t *mac, uint8_t tank_id, uint16_t seq) {
+  const AppAck a = makeAppAck(tank_id, seq, ACK_FROM_SIREN);
+  const uint8_t *to = tank_id < MAX_SENSOR_PEERS ? mac : MAC_BROADCAST;
+  (esp_now_send(to, (const uint8_t *)&a, sizeof(a)) == ESP_OK ? acksSent : ackFails)++;
+}
+
 static void applySnooze(int tankId, uint32_t nowMs, uint32_t addMs=SNOOZE_MS) {
-  if (tankId>=0 && tankId<MAX_TANKS) {
-    snoozeUntilMs[tankId] = nowMs + addMs;
+  if (tankId>=0 && tankId<tankCount) {
+    siren.snooze(tankId, nowMs, addMs);
     Serial.printf("Tank %d snoozed for %d minutes\n", tankId, addMs / (60 * 1000));
   }
 }
 static void clearSnooze(int tankId) {
   if (tankId==255) { 
-    for(int i=0;i<MAX_TANKS;i++) {
-      snoozeUntilMs[i]=0;
+    for(int i=0;i<tankCount;i++) {
+      siren.clearSnooze(i);
       Serial.printf("Tank %d snooze cleared\n", i);
     }
   }
-  else if (tankId>=0 && tankId<MAX_TANKS) {
-    snoozeUntilMs[tankId]=0;
+  else if (tankId>=0 && tankId<tankCount) {
+    siren.clearSnooze(tankId);
     Serial.printf("Tank %d snooze cleared\n", tankId);
   }
 }
 
 // ====== Core decision: handle a sensor update ======
-static void handleSensorPacket(const SensorPacket &p) {
-  if (p.ver != 1) {
-    Serial.printf("Wrong packet version: %d\n", p.ver);
-    return;
-  }
-  
-  // verify crc
-  uint8_t calc_crc = crc8((const uint8_t*)&p, sizeof(p)-1);
-  if (p.crc8 != calc_crc) {
-    Serial.printf("CRC mismatch: expected %02X got %02X\n", calc_crc, p.crc8);
-    return;
-  }
-
+// p is already CRC/version checked by decodeSensorPacket(); rxMs is when it arrived,
+// heldMs how long the webserver sat on it first (relayed copies).
+static void handleSensorPacket(const SensorReading &p, uint32_t rxMs, DeliveryPath path, uint32_t heldMs = 0) {
   const uint8_t tid = p.tank_id;
-  if (tid >= MAX_TANKS) {
+  if (tid >= tankCount) {
     Serial.printf("Invalid tank ID: %d\n", tid);
     return;
   }
+  SirenTank &t = tanks[tid];
+
+  // A retry after a lost ack, or the other path's copy, re-delivers the same seq: the
+  // predictor sees it only once. The threshold check still runs, so a window that
+  // wrongly calls a new reading a duplicate can't hold back the alarm.
+  bool dup = false;
+  if (p.ver >= 2) {
+    const uint32_t latencyMs = p.age_ms + heldMs + (millis() - rxMs);
+    const SeqVerdict v = t.link.accept(p.seq, p.boot);
+    dup = v == SEQ_DUPLICATE;
+    t.path[path].copy(latencyMs, v == SEQ_NEW || v == SEQ_RESTART);
+    if (v == SEQ_STALE) {
+      Serial.printf("Tank %d: stale seq %u ignored (newest %u)\n", tid, p.seq, t.link.newest);
+      return;
+    }
+    if (dup) Serial.printf("Tank %d: duplicate seq %u (%s), threshold check only\n", tid, p.seq, path == PATH_RELAY ? "relayed" : "direct");
+    if (v == SEQ_RESTART) Serial.printf("Tank %d: sensor restarted (seq %u, boot %04X)\n", tid, p.seq, p.boot);
+    if (!dup) t.link.latency(latencyMs);
+  }
 
   const bool valid = (p.flags & 0x01) && p.distance_mm>0;
   const float d_cm = valid ? (p.distance_mm / 10.0f) : NAN;
 
   const uint32_t now = millis();
-  lastRxMs[tid] = now;
-  lastDistanceCm[tid] = d_cm;
+  t.lastRxMs = now;
+  t.lastDistanceCm = d_cm;
 
   Serial.printf("Tank %d: distance=%.1fcm battery=%dmV valid=%s ", 
     tid, d_cm, p.battery_mV, valid ? "YES" : "NO");
@@ -175,45 +277,44 @@ static void handleSensorPacket(const SensorPacket &p) {
     return;
   }
 
-  const bool atRisk = (d_cm <= TRIGGER_CM);
-  Serial.printf("at_risk=%s ", atRisk ? "YES" : "NO");
+  // v2 sensors pick their own sleep; project to the report they actually promised.
+  PredictorConfig pc = PREDICT;
+  if (p.interval_s) pc.horizonS = p.interval_s + 10.0f;
+  AlarmClass cls = dup ? (d_cm <= TRIGGER_CM ? ALARM_ACTUAL : ALARM_NONE) : t.predictor.classify(d_cm, now, pc);
+  if (cls == ALARM_PREDICTED && !predictiveEnabled) cls = ALARM_NONE;
+  Serial.printf("at_risk=%s rate=%.2fcm/min ", alarmClassName(cls), t.predictor.v * 60.0f);
+  if (cls == ALARM_PREDICTED) {
+    Serial.printf("(projected %.1fcm in %.0fs) ", t.predictor.project(pc.horizonS), pc.horizonS);
+  }
 
-  if (atRisk) {
-    // Check per-tank snooze
-    if (now >= snoozeUntilMs[tid]) {
-      Serial.println("-> TRIGGERING SIREN");
-      
-      // If siren already active (due to another tank), piggyback: set snooze for this tank too.
-      if (!sirenActive) {
-        sirenPulse(SIREN_ON_MS);
-      } else {
-        Serial.println("(siren already active, applying snooze)");
-      }
-      applySnooze(tid, now, SNOOZE_MS);
-    } else {
-      uint32_t snooze_remaining = snoozeUntilMs[tid] - now;
-      Serial.printf("(snoozed for %d more seconds)\n", snooze_remaining / 1000);
-    }
-  } else {
-    Serial.println("(safe level)");
+  const ReadingVerdict verdict = siren.reading(tid, cls, now);
+  if (verdict == RV_TRIGGERED || verdict == RV_PIGGYBACK) {
+    (cls == ALARM_ACTUAL ? t.alarmsActual : t.alarmsPredicted)++;
+  }
+  switch (verdict) {
+    case RV_TRIGGERED:
+      Serial.printf("-> TRIGGERING SIREN (%s)\n", alarmClassName(cls));
+      sirenPulse(siren.pulseFor(cls));  // state already has the pulse; drive GPIO + timer
+      Serial.printf("Tank %d snoozed for %d minutes\n", tid, SNOOZE_MS / (60 * 1000));
+      break;
+    case RV_PIGGYBACK:
+      Serial.printf("-> TRIGGERING SIREN (%s)\n", alarmClassName(cls));
+      Serial.println("(siren already active, applying snooze)");
+      Serial.printf("Tank %d snoozed for %d minutes\n", tid, SNOOZE_MS / (60 * 1000));
+      break;
+    case RV_SNOOZED:
+      Serial.printf("(snoozed for %d more seconds)\n", siren.snoozeLeft(tid, now) / 1000);
+      break;
+    default:
+      Serial.println("(safe level)");
+      break;
   }
 }
 
 // ====== Handle a command from the webserver (optional) ======
-static void handleCommandPacket(const CommandPacket &c) {
-  Serial.printf("Command received: ver=%d type=0x%02X cmd=%d tank=%d ms=%d\n",
-    c.ver, c.type, c.cmd, c.tank_id, c.ms);
-    
-  if (c.ver != 1 || c.type != 0xC1) {
-    Serial.println("Invalid command header");
-    return;
-  }
-  
-  uint8_t calc_crc = crc8((const uint8_t*)&c, sizeof(c)-1);
-  if (c.crc8 != calc_crc) {
-    Serial.printf("Command CRC mismatch: expected %02X got %02X\n", calc_crc, c.crc8);
-    return;
-  }
+// c is already CRC/version checked by decodeCommand(). Returns false for an unknown cmd.
+static bool handleCommandPacket(const CommandPacketV2 &c) {
+  Serial.printf("Command received: ver=%d cmd=%d tank=%d ms=%u\n", c.ver, c.cmd, c.tank_id, c.ms);
 
   const uint8_t cmd = c.cmd;
   const uint8_t tid = c.tank_id;
@@ -227,7 +328,7 @@ static void handleCommandPacket(const CommandPacket &c) {
       sirenPulse(dur);
       // Optional: set snooze for target/all tanks so it doesn't immediately retrigger
       if (tid==255) {
-        for(int i=0;i<MAX_TANKS;i++) applySnooze(i, now);
+        for(int i=0;i<tankCount;i++) applySnooze(i, now);
       } else {
         applySnooze(tid, now);
       }
@@ -235,11 +336,10 @@ static void handleCommandPacket(const CommandPacket &c) {
     
     case 2: { // FORCE_OFF immediately
       Serial.println("Force OFF");
-      sirenOff();
-      sirenActive = false;
+      sirenStop();
       // Optionally also snooze to avoid immediate re-alarm if still at risk:
       if (tid==255) {
-        for(int i=0;i<MAX_TANKS;i++) applySnooze(i, now);
+        for(int i=0;i<tankCount;i++) applySnooze(i, now);
       } else {
         applySnooze(tid, now);
       }
@@ -248,7 +348,7 @@ static void handleCommandPacket(const CommandPacket &c) {
     case 3: { // SNOOZE_5MIN
       Serial.println("Snooze 5 minutes");
       if (tid==255) {
-        for(int i=0;i<MAX_TANKS;i++) applySnooze(i, now);
+        for(int i=0;i<tankCount;i++) applySnooze(i, now);
       } else {
         applySnooze(tid, now);
       }
@@ -266,20 +366,56 @@ static void handleCommandPacket(const CommandPacket &c) {
       Serial.printf("Custom snooze for %d minutes\n", customMs / (60 * 1000));
       
       if (tid==255) {
-        for(int i=0;i<MAX_TANKS;i++) applySnooze(i, now, customMs);
+        for(int i=0;i<tankCount;i++) applySnooze(i, now, customMs);
       } else {
         applySnooze(tid, now, customMs);
       }
     } break;
     
+    case 6: { // SET_PREDICTIVE - ms=0 disables PREDICTED alarms, anything else enables
+      predictiveEnabled = c.ms != 0;
+      Serial.printf("Predictive alarm %s\n", predictiveEnabled ? "enabled" : "disabled");
+    } break;
+
     default:
       Serial.printf("Unknown command: %d\n", cmd);
-      break;
+      return false;
   }
+  return true;
 }
 
-// ====== ESP-NOW receive callback ======
-static void onDataRecv(const uint8_t *mac, const uint8_t *data, int len) {
+// v2 commands get a CommandAck once applied. The webserver resends until it has one,
+// so a repeat (same boot and id) is acked again but not applied twice.
+static uint16_t  cmdBoot = 0;
+static LinkStats cmdLink;
+static uint32_t  cmdApplied = 0, cmdRepeats = 0, cmdAckFails = 0;
+
+static void onCommand(const CommandPacketV2 &c) {
+  if (c.ver < 2) { handleCommandPacket(c); return; }
+  if (c.boot != cmdBoot) { cmdBoot = c.boot; cmdLink = LinkStats{}; }   // webserver rebooted
+  bool known = cmdKind(c.cmd) != 0;
+  if (cmdLink.accept(c.id) == SEQ_DUPLICATE) {
+    cmdRepeats++;
+    Serial.printf("Command #%u repeated (our ack was lost), not applied again\n", c.id);
+  } else {
+    known = handleCommandPacket(c);
+    cmdApplied++;
+  }
+  const CommandAck a = makeCommandAck(c.boot, c.id, known ? CMD_ACK_APPLIED : CMD_ACK_UNKNOWN);
+  if (esp_now_send(MAC_WEBSERVER, (const uint8_t *)&a, sizeof(a)) != ESP_OK) cmdAckFails++;
+}
+
+// ====== Frame dispatch (loop context) ======
+static void handleFrame(const uint8_t *mac, const uint8_t *data, int len, uint32_t rxMs) {
+  // Announces come every second: follow them quietly. Any other frame from the
+  // webserver also proves we're on its channel.
+  ChannelAnnounce a;
+  if (isFromWebserver(mac)) {
+    const bool announce = decodeAnnounce(data, len, a);
+    setChannel(followHeard(follow, announce ? a.channel : 0, rxMs), "announced");
+    if (announce) return;
+  }
+
   Serial.printf("ESP-NOW RX from %02X:%02X:%02X:%02X:%02X:%02X len=%d: ",
     mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], len);
   
@@ -299,25 +435,83 @@ static void onDataRecv(const uint8_t *mac, const uint8_t *data, int len) {
     Serial.print("WEBSERVER ");
   }
 
-  if (len == (int)sizeof(SensorPacket)) {
-    Serial.println("(SensorPacket)");
-    SensorPacket p;
-    memcpy(&p, data, sizeof(p));
+  if (fromSensor && isHistoryBatch(data, len)) {
+    // The single broadcast a sensor sends per wake. The siren acts on the newest
+    // reading only; the older ones are for the webserver's history.
+    SensorReading p;
+    uint8_t  count = 0;
+    uint16_t next_tx_s = 0;
+    size_t   hdrLen = 0;
+    const PacketStatus st = decodeHistoryHeader(data, len, p, count, next_tx_s, hdrLen);
+    Serial.printf("(HistoryBatch v%d, %d readings)\n", data[0], st == PKT_OK ? count : 0);
+    if (st == PKT_BAD_CRC) { Serial.println("CRC mismatch"); return; }
+    if (st != PKT_OK)      { Serial.printf("Wrong batch version: %d\n", data[0]); return; }
+    if (p.tank_id != (uint8_t)sensorTid) {
+      Serial.printf("Tank ID mismatch: MAC suggests %d but packet claims %d\n", sensorTid, p.tank_id);
+      return;
+    }
+    // Before the duplicate check: a retry means the sensor missed our ack.
+    if (p.ver >= 2) sendAck(mac, p.tank_id, p.seq);
+    handleSensorPacket(p, rxMs, PATH_DIRECT);
+  }
+  else if (len == (int)sizeof(SensorPacketV1) || len == (int)sizeof(SensorPacketV2) || len == (int)sizeof(SensorPacketV3)) {
+    SensorReading p;
+    const PacketStatus st = decodeSensorPacket(data, len, p);
+    Serial.printf("(SensorPacket v%d)\n", len == (int)sizeof(SensorPacketV1) ? 1 : len == (int)sizeof(SensorPacketV2) ? 2 : 3);
+    if (st == PKT_BAD_CRC)     { Serial.println("CRC mismatch"); return; }
+    if (st == PKT_BAD_VERSION) { Serial.printf("Wrong packet version: %d\n", data[0]); return; }
     // If it claims a tank id, also ensure it matches the sender we expect:
     if (fromSensor && p.tank_id != (uint8_t)sensorTid) {
       Serial.printf("Tank ID mismatch: MAC suggests %d but packet claims %d\n", sensorTid, p.tank_id);
       return;
     }
-    handleSensorPacket(p);
+    handleSensorPacket(p, rxMs, PATH_DIRECT);
+  }
+  else if (fromWeb && len == (int)sizeof(RelayFrame) && data[1] == RELAY_TYPE) {
+    SensorReading p;
+    uint32_t boot = 0;
+    uint16_t relaySeq = 0, heldMs = 0;
+    const RelayStatus st = decodeRelay(data, len, RELAY_KEY, p, boot, relaySeq, heldMs);
+    Serial.printf("(Relay #%u)\n", relaySeq);
+    if (st == RELAY_BAD_TAG) { relayBadTag++; Serial.println("Relay tag mismatch (RELAY_KEY differs?)"); return; }
+    if (st != RELAY_OK)      { Serial.println("Bad relayed packet"); return; }
+    const SeqVerdict v = relayLink.accept(relaySeq, boot);
+    if (v == SEQ_DUPLICATE || v == SEQ_STALE) { Serial.printf("Relay #%u (boot %08x) replayed, ignored\n", relaySeq, (unsigned)boot); return; }
+    if (v == SEQ_RESTART) Serial.printf("Webserver restarted (relay boot %08x)\n", (unsigned)boot);
+    handleSensorPacket(p, rxMs, PATH_RELAY, heldMs);
   }
-  else if (len == (int)sizeof(CommandPacket) && fromWeb) {
-    Serial.println("(CommandPacket)");
-    CommandPacket c;
-    memcpy(&c, data, sizeof(c));
-    handleCommandPacket(c);
+  else if (fromWeb && len >= 2 && data[1] == CMD_TYPE) {
+    CommandPacketV2 c;
+    if (!decodeCommand(data, len, c)) { Serial.println("(CommandPacket) bad size, version or CRC"); return; }
+    Serial.printf("(CommandPacket v%d #%u)\n", c.ver, c.id);
+    onCommand(c);
   }
   else {
-    Serial.printf("REJECTED (wrong size: expected %d or %d)\n", sizeof(SensorPacket), sizeof(CommandPacket));
+    Serial.printf("REJECTED (wrong size or type: expected %d, %d, %d, a batch, a command or %d)\n",
+      sizeof(SensorPacketV1), sizeof(SensorPacketV2), sizeof(SensorPacketV3), sizeof(RelayFrame));
+  }
+}
+
+// ====== ESP-NOW receive callback ======
+// Runs in the Wi-Fi driver task: copy the frame into the SPSC queue, wake loop() and
+// return. Decisions, logging and state updates happen in loop() via processRx().
+// A full event queue is fine: any pending EV_RX drains every queued frame.
+static RxQueue rxQueue;
+
+static void onDataRecv(const uint8_t *mac, const uint8_t *data, int len) {
+  const uint32_t t0 = micros();
+  if (rxQueue.push(mac, data, len, millis())) {
+    const SirenEvent ev = EV_RX;
+    xQueueSend(eventQueue, &ev, 0);
+  }
+  const uint32_t us = micros() - t0;
+  if (us > rxQueue.cbMaxUs) rxQueue.cbMaxUs = us;
+}
+
+static void processRx() {
+  while (const RxFrame *f = rxQueue.front()) {
+    handleFrame(f->mac, f->data, f->len, f->rxMs);
+    rxQueue.pop();
   }
 }
 
@@ -326,17 +520,32 @@ void setup() {
   pinMode(SIREN_PIN, OUTPUT);
   sirenOff();
 
+  eventQueue = xQueueCreate(8, sizeof(SirenEvent));
+  esp_timer_create_args_t targs{};
+  targs.callback = onPulseTimer;
+  targs.name     = "siren_pulse";
+  esp_timer_create(&targs, &pulseTimer);
+
   Serial.begin(115200);
   delay(200);
   Serial.println("\n=== SIREN MCU STARTING ===");
 
-  // Initialize WiFi in STA mode and set to channel 1
+  // Per-tank state, sized from the SENSORS table
+  if (!registry.begin(SENSORS, SENSOR_COUNT) || !siren.begin(SENSOR_COUNT)) {
+    Serial.printf("Out of memory for %u tanks; halting.\n", (unsigned)SENSOR_COUNT);
+    while (true) delay(1000);
+  }
+  tanks = new SirenTank[SENSOR_COUNT];
+  tankCount = SENSOR_COUNT;
+  Serial.printf("Registry: %u tanks, %u MACs indexed, %u duplicate MACs ignored\n",
+    (unsigned)tankCount, (unsigned)registry.indexed, (unsigned)registry.duplicates);
+
+  // Initialize WiFi in STA mode; the channel follows the webserver from here on
   WiFi.mode(WIFI_STA);
   WiFi.disconnect(false, true);  // Don't erase stored credentials, but disconnect
   
-  // Set to fixed channel 1 (same as webserver network)
-  esp_err_t ch_result = esp_wifi_set_channel(1, WIFI_SECOND_CHAN_NONE);
-  Serial.printf("Set WiFi channel to 1: %s\n", (ch_result == ESP_OK) ? "OK" : "FAILED");
+  followBegin(follow, START_CHANNEL, millis());
+  setChannel(START_CHANNEL, "start");
   
   // Verify channel
   uint8_t actual_channel;
@@ -350,6 +559,10 @@ void setup() {
   } else {
     esp_err_t cb_result = esp_now_register_recv_cb(onDataRecv);
     Serial.printf("ESP-NOW callback registered: %s\n", (cb_result == ESP_OK) ? "OK" : "FAILED");
+    // Peers for the acks
+    addPeer(MAC_WEBSERVER);
+    for (int i = 0; i < tankCount && i < MAX_SENSOR_PEERS; i++) addPeer(SENSORS[i].mac);
+    addPeer(MAC_BROADCAST);
     Serial.println("ESP-NOW ready - listening for packets");
   }
   
@@ -357,32 +570,85 @@ void setup() {
   Serial.println("Ready to receive sensor data and webserver commands");
 }
 
-void loop() {
-  const uint32_t now = millis();
-
-  // Non-blocking siren auto-off after pulse
-  if (sirenActive && (int32_t)(now - sirenOffAt) >= 0) {
-    Serial.println("SIREN OFF (timeout)");
-    sirenOff();
-    sirenActive = false;
-  }
+// Idle accounting: time spent blocked in xQueueReceive() per diagnostics window, and
+// how often it returned (timeouts: with nothing queued).
+static const uint32_t DIAG_MS = 30000;
+static uint32_t wakeups = 0, timeouts = 0;
+static uint64_t idleUs  = 0;
 
-  // Optional diagnostic output every 30 seconds
+void loop() {
   static uint32_t lastDiag = 0;
-  if (now - lastDiag > 30000) {
+  static int64_t  windowStartUs = esp_timer_get_time();
+
+  // Sleep until a frame or the pulse timer needs us, the next diagnostics line, or
+  // the channel follower's next deadline (a frame from the webserver pushes it out, so
+  // while locked the announces are the only wake-ups). Rounded up to whole ticks so
+  // the wait never ends a tick early.
+  const uint32_t start     = millis();
+  const uint32_t sinceDiag = start - lastDiag;
+  const uint32_t tillDiag  = sinceDiag >= DIAG_MS ? 0 : DIAG_MS - sinceDiag;
+  const uint32_t tillHop   = followDueMs(follow, start, FOLLOW);
+  const uint32_t waitMs    = tillDiag < tillHop ? tillDiag : tillHop;
+  const TickType_t wait = pdMS_TO_TICKS(waitMs + portTICK_PERIOD_MS - 1);
+  SirenEvent ev;
+  const int64_t t0 = esp_timer_get_time();
+  const bool woke = xQueueReceive(eventQueue, &ev, wait) == pdTRUE;
+  idleUs += esp_timer_get_time() - t0;
+  wakeups++;
+  if (!woke) timeouts++;
+
+  processRx();
+  servicePulse();
+
+  const uint32_t now = millis();
+  setChannel(followTick(follow, now, FOLLOW), "hunting");
+  if (now - lastDiag >= DIAG_MS) {
     lastDiag = now;
-    Serial.printf("[DIAG] Siren: %s | ", sirenActive ? "ACTIVE" : "off");
-    for (int i = 0; i < MAX_TANKS; i++) {
-      if (lastRxMs[i] == 0) {
+    Serial.printf("[DIAG] Siren: %s | ", siren.active ? "ACTIVE" : "off");
+    for (int i = 0; i < tankCount; i++) {
+      if (tanks[i].lastRxMs == 0) {
         Serial.printf("T%d:never ", i);
       } else {
-        uint32_t age_s = (now - lastRxMs[i]) / 1000;
-        uint32_t snooze_remain = (snoozeUntilMs[i] > now) ? (snoozeUntilMs[i] - now) / 1000 : 0;
-        Serial.printf("T%d:%.1fcm(%ds ago,snz:%ds) ", i, lastDistanceCm[i], age_s, snooze_remain);
+        uint32_t age_s = (now - tanks[i].lastRxMs) / 1000;
+        uint32_t snooze_remain = siren.snoozeLeft(i, now) / 1000;
+        Serial.printf("T%d:%.1fcm(%ds ago,snz:%ds) ", i, tanks[i].lastDistanceCm, age_s, snooze_remain);
       }
     }
     Serial.println();
+    Serial.printf("[DIAG] channel %d %s | locks=%u hops=%u losses=%u | acks sent=%u failed=%u\n",
+      follow.channel, follow.locked ? "locked" : "hunting", follow.locks, follow.hops, follow.losses,
+      acksSent, ackFails);
+    Serial.printf("[DIAG] commands applied=%u repeated=%u ack_fail=%u\n", cmdApplied, cmdRepeats, cmdAckFails);
+    Serial.printf("[DIAG] RX queue pushed=%u dropped=%u oversize=%u high_water=%u/%d cb_max=%uus\n",
+      rxQueue.pushed, rxQueue.dropped, rxQueue.oversize, rxQueue.highWater, RX_QUEUE_DEPTH, rxQueue.cbMaxUs);
+    for (int i = 0; i < tankCount; i++) {
+      const LinkStats &l = tanks[i].link;
+      if (!l.synced) continue;
+      Serial.printf("[DIAG] T%d link seq=%u rx=%u dup=%u stale=%u lost=%u (%.1f%%) restarts=%u latency avg=%ums max=%ums\n",
+        i, l.newest, l.received, l.duplicates, l.stale, l.lost, 100.0f * l.lossRate(), l.restarts, l.latAvgMs(), l.latMaxMs);
+      const PathStats &d = tanks[i].path[PATH_DIRECT], &r = tanks[i].path[PATH_RELAY];
+      if (r.copies) {
+        Serial.printf("[DIAG] T%d paths direct: %u copies, %u first, %u/%ums | relayed: %u copies, %u first, %u/%ums (avg/max)\n",
+          i, d.copies, d.first, d.latAvgMs(), d.latMaxMs, r.copies, r.first, r.latAvgMs(), r.latMaxMs);
+      }
+    }
+    if (relayLink.synced() || relayBadTag) {
+      Serial.printf("[DIAG] relay boot=%08x seq=%u rx=%u replayed=%u stale=%u lost=%u boots=%u bad_tag=%u\n",
+        (unsigned)relayLink.currentBoot(), relayLink.current().newest, relayLink.received, relayLink.duplicates,
+        relayLink.stale, relayLink.current().lost, relayLink.boots, relayBadTag);
+    }
+    const int64_t windowUs = esp_timer_get_time() - windowStartUs;
+    Serial.printf("[DIAG] alarms (actual/predicted, predictive %s):", predictiveEnabled ? "on" : "off");
+    for (int i = 0; i < tankCount; i++) {
+      const SirenTank &t = tanks[i];
+      Serial.printf(" T%d:%u/%u rate=%.2fcm/min", i, t.alarmsActual, t.alarmsPredicted, t.predictor.v * 60.0f);
+    }
+    Serial.println();
+    Serial.printf("[DIAG] main task busy=%.3f%% wakeups=%u (timeouts %u) | pulses=%u err last=%+dus max=%+dus\n",
+      windowUs > 0 ? 100.0 * (1.0 - (double)idleUs / (double)windowUs) : 0.0,
+      wakeups, timeouts, pulses, pulseErrLastUs, pulseErrMaxUs);
+    windowStartUs = esp_timer_get_time();
+    idleUs  = 0;
+    wakeups = timeouts = 0;
   }
-
-  delay(10); // small yield
 }
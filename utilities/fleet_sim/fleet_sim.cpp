@@ -0,0 +1,658 @@
+// fleet_sim.cpp — discrete-event radio/airtime simulator for a fleet of sensor MCUs
+// Runs the sensor's own wake logic (planWake(), TxMachine, ChannelCache and the RTC
+// reading history from sensor_mcu/include) for N sensors against a modelled shared
+// medium, and reports how delivery, retries and energy per delivered reading change
+// with fleet size, jitter window and sleep policy. Host tool, not firmware:
+//
+//   g++ -O2 -std=c++17 -I../../sensor_mcu/include fleet_sim.cpp -o fleet_sim
+//   ./fleet_sim                        # sweep N x jitter x sleep mode
+//   ./fleet_sim --n 100 --jitter 2000 --mode fixed --sync --bg 0.3
+//   ./fleet_sim --tdma                 # same sweep with webserver-assigned slots
+//   ./fleet_sim --fast                 # FAST_WAKE build profile instead of the bench one
+//   ./fleet_sim --one-frame            # one broadcast per wake, siren on the webserver channel
+//   ./fleet_sim --relay                # sensors reach the webserver only; it relays to the siren
+//
+// Model (1 Mbps DSSS, which is what ESP-NOW uses by default):
+// - Frame airtime 192 us preamble + (43 + payload) bytes; ACK 304 us after SIFS.
+// - CSMA/CA: DIFS + backoff from CW 31..1023 (doubling per MAC retry). A
+//   transmission is only sensed one slot after it starts, so two starts within a
+//   slot collide and both frames are lost. Detected frames defer others until their
+//   ACK slot ends (NAV). No capture and no adjacent-channel interference.
+// - MAC retries: --mac-retries (ESP-IDF does not document the count for ESP-NOW;
+//   4 is an assumption). Independent frame and ACK loss on top of collisions.
+//   A receiver counts a frame even when its ACK is lost; the sensor then retries
+//   with the same seq and the receiver drops the duplicate.
+// - Siren on --siren-ch, webserver on --web-ch, with optional background Wi-Fi
+//   traffic on the webserver channel (--bg utilization, 1 ms frames).
+// - Current at 3.3 V: sampling 40 mA, CPU only 30 mA, radio listening 100 mA,
+//   transmitting 190 mA, deep sleep 10 uA. Channel probe 150 ms, full sweep 13x.
+// - Tanks: --fill of them fill at 1..5 mm/min towards the alarm threshold and are
+//   emptied there; the rest sit still with +-3 mm sensor noise. RTC clocks run off
+//   by up to --drift percent plus a daily (temperature) swing of --wander ppm.
+//   --sync wakes every sensor at t=0 (power restored); --spread is how much the
+//   sampling time varies between sensors.
+// - --tdma: the webserver answers each batch with a SlotReply (slot_schedule.h),
+//   sent 2 ms after the batch and lost like any frame (its airtime is not put on
+//   the channel). The webserver's clock is the reference.
+// - Boot: BOOT_MS from reset to setup(), then the bench profile's fixed setup()
+//   delays and settle times and the time its serial log blocks at 115200 baud.
+//   --fast models -DFAST_WAKE=1: no log, no fixed delays, radio steps as long as the
+//   driver takes (STA_START_MS, channel switch 1 ms).
+// - --one-frame models ONE_FRAME=1: the siren follows the webserver's channel, the
+//   batch goes out once as a broadcast (no MAC ACK, no MAC retries) and each receiver
+//   gets it or not on its own. The siren answers with an AppAck 1 ms later, the
+//   webserver with its AppAck (or SlotReply) 2 ms later, lost like any frame and,
+//   like the slot reply, not put on the channel. Without it the sensor sends two
+//   unicasts on two channels.
+// - --relay models SIREN_RELAY=1 on both ends: one unicast to the webserver, which
+//   forwards each new reading to the siren (on its channel) as a RelayFrame. The relay
+//   is lost only if all its MAC tries are; its airtime counts, its timing is ignored.
+// - hops/tx counts channel switches after the scan; air_us/tx is the airtime one
+//   transmitting wake costs: the sensor's frames, the receivers' MAC ACKs and the
+//   modelled app acks / slot replies (with the sensor's MAC ACK of those).
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <queue>
+#include <random>
+#include <vector>
+#include "sensor_packet.h"
+#include "slot_schedule.h"
+#include "wake_cycle.h"
+
+// ====== Sensor defaults (mirror sensor_mcu/src/main.cpp) ======
+static const uint16_t AT_RISK_MM   = 60;
+static const uint16_t NEAR_RISK_MM = AT_RISK_MM + 100;
+static const SendPolicy SEND_POLICY = { 10, NEAR_RISK_MM, 900 };
+static const SleepPolicyConfig SLEEP_POLICY = { 30, 120, 900, NEAR_RISK_MM, 600, AT_RISK_MM, 4, 3500, 3300 };
+static const WakeConfig WAKE_ADAPTIVE = { true,  true,  120, 15 * 60, SEND_POLICY, SLEEP_POLICY };
+static const WakeConfig WAKE_FIXED    = { false, false, 120, 15 * 60, SEND_POLICY, SLEEP_POLICY };
+static const TxTiming TX_TIMING      = { 100, 50, 20, 100, 1, 0, 0 };
+static const TxTiming TX_TIMING_TDMA = { 100, 50, 20, 100, 1, 60, 0 };
+static const TxTiming TX_TIMING_FAST      = { 0, 0, 0, 100, 1, 0, 0 };    // FAST_WAKE
+static const TxTiming TX_TIMING_FAST_TDMA = { 0, 0, 0, 100, 1, 60, 0 };
+static const uint16_t ONE_FRAME_ACK_WAIT_MS = 100; // --one-frame: replaces replyWaitMs
+static const size_t   RELAY_FRAME_LEN = 37;       // siren/webserver relay_frame.h RelayFrame
+static const uint32_t BENCH_SETUP_MS  = 600;      // delay(500) for Serial, delay(100) radios off
+static const uint32_t LOG_SAMPLE_MS   = 60;       // ~700 bytes of log per wake at 11.5 bytes/ms
+static const uint32_t LOG_TX_MS       = 90;       // ~1000 more when the wake transmits
+static const uint32_t JITTER_MS       = 2000;     // also the longest wait for a slot
+static const uint32_t SLOT_LEAD_MARGIN_MS = 200;
+static const uint32_t SEND_TIMEOUT_US = 300000;   // sendPacketTo() wait for the send callback
+static const size_t   SENSOR_PKT_LEN  = sizeof(SensorPacketV3);
+static const size_t   BATCH_HDR_LEN   = sizeof(HistoryHeader);
+
+// ====== Radio / energy model ======
+struct Params {
+  uint32_t n = 30, jitterMs = 2000;
+  bool     fixed = false, sync = false;
+  double   hours = 24;
+  uint32_t seed = 1;
+  uint8_t  sirenCh = 1, webCh = 6;
+  double   bgUtil = 0.0;
+  int      macRetries = 4;
+  double   frameLoss = 0.02, ackLoss = 0.02;
+  double   fillFrac = 0.2;
+  uint32_t sampleMs = 1500, sampleSpreadMs = 500;   // adaptive sampling stops at 1.5..2 s
+  bool     tdma = false;
+  double   driftPct = 1.0, wanderPpm = 200;
+  bool     fast = false;
+  bool     oneFrame = false;
+  bool     relay = false;
+};
+
+static const int64_t SLOT_US = 20, SIFS_US = 10, DIFS_US = 50, ACK_US = 304, BG_FRAME_US = 1000;
+static const int     CW_MIN = 31, CW_MAX = 1023;
+static const uint32_t PROBE_MS = 150;
+static const uint32_t BOOT_MS = 150, STA_START_MS = 40;   // reset -> setup(); esp_wifi_start()
+static const double  MA_SAMPLE = 40, MA_CPU = 30, MA_RX = 100, MA_TX = 190, MA_SLEEP = 0.010, VOLTS = 3.3;
+
+static int64_t airtimeUs(size_t len) { return 192 + (int64_t)(43 + len) * 8; }
+// A unicast reply to the sensor (app ack, slot reply) and the sensor's MAC ACK of it.
+static int64_t replyAirUs(size_t len) { return airtimeUs(len) + SIFS_US + ACK_US; }
+
+// ====== Events ======
+enum EvKind : uint8_t { EV_WAKE, EV_BOOTED, EV_SAMPLED, EV_SLEEP, EV_STEP, EV_MAC_TRY, EV_TX_END, EV_ACK_START, EV_ACK_END, EV_ACK_TIMEOUT, EV_SEND_TIMEOUT, EV_BG };
+
+struct Event {
+  int64_t  t;
+  uint64_t order;
+  EvKind   kind;
+  int      node;
+  uint32_t arg;       // EV_STEP: action result; MAC events: frame token (stale ones are dropped)
+};
+struct EventLater {
+  bool operator()(const Event &a, const Event &b) const { return a.t != b.t ? a.t > b.t : a.order > b.order; }
+};
+
+// One transmission on a channel (data, ACK or background).
+struct Tx {
+  int64_t start, end, navEnd;
+  bool    corrupt;
+};
+
+struct Channel {
+  std::vector<Tx> air;    // recent transmissions; pruned as time moves on
+  uint64_t frames = 0, collided = 0;
+
+  void prune(int64_t now) {
+    size_t k = 0;
+    for (size_t i = 0; i < air.size(); ++i) if (air[i].navEnd + SLOT_US > now) air[k++] = air[i];
+    air.resize(k);
+  }
+  // End of the medium-busy period a station sensing at `now` sees, or 0 if idle.
+  int64_t busyUntil(int64_t now) const {
+    int64_t until = 0;
+    for (const Tx &x : air)
+      if (x.start <= now - SLOT_US && x.navEnd > now && x.navEnd > until) until = x.navEnd;
+    return until;
+  }
+  size_t start(int64_t now, int64_t dur, int64_t nav) {
+    Tx x{now, now + dur, now + dur + nav, false};
+    for (Tx &o : air)
+      if (o.end > now) { if (!o.corrupt) collided++; o.corrupt = true; x.corrupt = true; }
+    if (x.corrupt) collided++;
+    frames++;
+    air.push_back(x);
+    return air.size() - 1;
+  }
+};
+
+// A frame in flight through the MAC (one esp_now_send()).
+struct MacFrame {
+  uint8_t  channel = 0;
+  size_t   len = 0;
+  TxDest   dest = TX_TO_SIREN;
+  uint16_t seq = 0;
+  int      tries = 0, cw = CW_MIN, backoff = 0;
+  int64_t  txStart = 0;
+  uint32_t token = 0;        // stale-event guard
+  bool     active = false;
+};
+
+struct Sensor {
+  ReadingHistory h{};
+  ChannelCache   cc{};
+  TxMachine      tx;
+  WakePlan       plan{};
+  MacFrame       mac;
+  uint16_t       seq = 0;
+  double         drift = 0;         // RTC rate error
+  double         wanderPhase = 0;
+  SlotSchedule   sched{};
+  bool           replyPending = false;
+  int64_t        replyAt = 0;       // true time the slot reply reaches the sensor
+  int64_t        sirenAckAt = INT64_MAX, webAckAt = INT64_MAX;   // --one-frame, this send
+  SlotReply      reply{};
+  uint64_t       slotWakes = 0, waitMsSum = 0;
+  int64_t        wokeAt = 0;
+  double         levelMm = 0, fillMmPerMin = 0;
+  bool           filling = false, radioOn = false;
+  uint8_t        curCh = 0;
+  uint16_t       lastSirenSeq = 0, lastWebSeq = 0;
+  bool           sirenSeen = false, webSeen = false;
+  // energy
+  double         mA = MA_SLEEP;
+  int64_t        since = 0;
+  double         mAus = 0;          // charge, mA * us
+};
+
+struct Stats {
+  uint64_t wakes = 0, txWakes = 0, webDelivered = 0, sirenDelivered = 0, sensorWebOk = 0;
+  uint64_t appSends = 0, macAttempts = 0, macDrops = 0, sendTimeouts = 0, scans = 0, hops = 0;
+  int64_t  awakeUs = 0, airUs = 0;
+};
+
+struct Sim {
+  Params p;
+  std::mt19937_64 rng;
+  std::priority_queue<Event, std::vector<Event>, EventLater> q;
+  uint64_t order = 0;
+  int64_t  now = 0, endUs = 0;
+  std::vector<Sensor> s;
+  Channel  ch[15];
+  Stats    st;
+
+  double uni() { return std::uniform_real_distribution<double>(0, 1)(rng); }
+  int    irand(int lo, int hi) { return std::uniform_int_distribution<int>(lo, hi)(rng); }
+  void   at(int64_t t, EvKind k, int node, uint32_t arg = 0) { q.push(Event{t, order++, k, node, arg}); }
+
+  void current(Sensor &x, double mA) {
+    x.mAus += x.mA * (double)(now - x.since);
+    x.since = now;
+    x.mA = mA;
+  }
+  // Sensor RTC: rate 1 + drift + wander * sin(day phase), integrated.
+  static constexpr double DAY_US = 86400e6, TWO_PI = 6.283185307179586;
+  double rate(const Sensor &x, int64_t t) const {
+    return 1.0 + x.drift + p.wanderPpm * 1e-6 * sin(TWO_PI * (double)t / DAY_US + x.wanderPhase);
+  }
+  int64_t localUs(const Sensor &x, int64_t t) const {
+    const double w = p.wanderPpm * 1e-6 * DAY_US / TWO_PI;
+    return (int64_t)((double)t * (1.0 + x.drift) + w * (cos(x.wanderPhase) - cos(TWO_PI * (double)t / DAY_US + x.wanderPhase)));
+  }
+  uint32_t rtcS(const Sensor &x) const { return (uint32_t)(localUs(x, now) / 1000000); }
+
+  // ---- sensor wake ----
+  void wake(int i) {
+    Sensor &x = s[i];
+    st.wakes++;
+    x.wokeAt = now;
+    current(x, MA_CPU);
+    at(now + (int64_t)(BOOT_MS + (p.fast ? 0 : BENCH_SETUP_MS)) * 1000, EV_BOOTED, i);
+  }
+
+  void booted(int i) {
+    current(s[i], MA_SAMPLE);
+    at(now + (int64_t)(p.sampleMs + irand(0, (int)p.sampleSpreadMs)) * 1000, EV_SAMPLED, i);
+  }
+
+  // Radios off; the bench profile's log drains before it can sleep.
+  void finish(int i, bool transmitted) {
+    Sensor &x = s[i];
+    x.radioOn = false;
+    current(x, MA_CPU);
+    const uint32_t logMs = p.fast ? 0 : LOG_SAMPLE_MS + (transmitted ? LOG_TX_MS : 0);
+    at(now + (int64_t)logMs * 1000, EV_SLEEP, i);
+  }
+
+  void sampled(int i) {
+    Sensor &x = s[i];
+    uint16_t mm = (uint16_t)lround(x.levelMm + std::normal_distribution<double>(0, 1.5)(rng));
+    uint8_t flags = 0x01 | (mm <= AT_RISK_MM ? 0x02 : 0);
+    historyPush(x.h, rtcS(x), mm, flags);
+    x.plan = planWake(x.h, p.fixed ? WAKE_FIXED : WAKE_ADAPTIVE, true, mm, 3900);
+    // measureSlotLead()
+    const int64_t local = localUs(x, now);
+    uint32_t leadMs = p.sampleMs + p.sampleSpreadMs;
+    if (x.sched.wakeUs && local > x.sched.wakeUs) leadMs = (uint32_t)((local - x.sched.wakeUs) / 1000);
+    slotNoteLead(x.sched, leadMs, SLOT_LEAD_MARGIN_MS);
+    if (x.plan.send == SEND_NONE) { finish(i, false); return; }
+    st.txWakes++;
+    x.seq++;
+    current(x, MA_CPU);
+    uint32_t wait;
+    if (p.tdma && slotWaitMs(x.sched, local, JITTER_MS, wait)) { x.slotWakes++; x.waitMsSum += wait; }
+    else { wait = (uint32_t)irand(0, (int)p.jitterMs); x.waitMsSum += wait; }
+    TxTiming t = p.fast ? (p.tdma ? TX_TIMING_FAST_TDMA : TX_TIMING_FAST) : (p.tdma ? TX_TIMING_TDMA : TX_TIMING);
+    if (p.relay)         t.sirenChannel = 0;
+    else if (p.oneFrame) { t.replyWaitMs = 0; t.ackWaitMs = ONE_FRAME_ACK_WAIT_MS; }
+    act(i, x.tx.begin(t, wait));
+  }
+
+  void sleep(int i) {
+    Sensor &x = s[i];
+    st.awakeUs += now - x.wokeAt;
+    current(x, MA_SLEEP);
+    // Level moves while asleep; a filling tank is emptied once it reaches the alarm.
+    const double sleepS = (double)x.plan.sleepS;
+    if (x.filling) {
+      x.levelMm -= x.fillMmPerMin * sleepS / 60.0;
+      if (x.levelMm < AT_RISK_MM - 20) x.levelMm = 850;
+    }
+    const int64_t local = localUs(x, now);
+    int64_t sleepUs = (int64_t)(sleepS * 1e6);
+    if (p.tdma) slotSleepUs(x.sched, local, x.plan.sleepS, x.sched.leadMs, sleepUs);
+    x.sched.wakeUs = local + sleepUs;
+    at(now + (int64_t)((double)sleepUs / rate(x, now)), EV_WAKE, i);
+  }
+
+  // ---- TxMachine actions ----
+  static uint8_t scanCb(uint8_t channel, void *ctx) {
+    Sim *sim = (Sim *)ctx;
+    sim->st.scans++;
+    sim->scanAcc += channel ? PROBE_MS : 13 * PROBE_MS;
+    return (channel == 0 || channel == sim->p.webCh) ? sim->p.webCh : 0;
+  }
+  uint32_t scanAcc = 0;
+
+  void act(int i, TxAction a) {
+    Sensor &x = s[i];
+    switch (a.kind) {
+      case TXA_WAIT:
+        at(now + (int64_t)a.ms * 1000, EV_STEP, i);
+        break;
+      case TXA_RADIO_UP:
+        x.radioOn = true;
+        current(x, MA_RX);
+        at(now + (int64_t)STA_START_MS * 1000, EV_STEP, i);
+        break;
+      case TXA_FIND_CHANNEL: {
+        ChannelSource src;
+        scanAcc = 0;
+        const uint8_t c = channelSelect(x.cc, scanCb, this, src);
+        x.curCh = c;      // the radio stays where the webserver was found
+        at(now + (int64_t)scanAcc * 1000, EV_STEP, i, c);
+      } break;
+      case TXA_START_ESPNOW:
+        at(now + 5000, EV_STEP, i, 1);
+        break;
+      case TXA_SET_CHANNEL:
+        if (a.channel != x.curCh) st.hops++;
+        x.curCh = a.channel;
+        at(now + 1000, EV_STEP, i);
+        break;
+      case TXA_SEND: {
+        st.appSends++;
+        MacFrame &f = x.mac;
+        f = MacFrame{};
+        f.active  = true;
+        f.channel = x.curCh;
+        f.dest    = a.dest;
+        f.seq     = x.seq;
+        f.token   = (uint32_t)order;
+        if (a.dest == TX_TO_SIREN) f.len = SENSOR_PKT_LEN;
+        else {
+          uint8_t buf[250];
+          size_t deltas = 0;
+          historyEncodeDeltas(x.h, x.h.unsent ? x.h.unsent : 1, buf, sizeof(buf), deltas);
+          f.len = BATCH_HDR_LEN + deltas + 1;
+        }
+        if (a.dest != TX_TO_SIREN) x.replyPending = false;
+        x.sirenAckAt = x.webAckAt = INT64_MAX;
+        macAttempt(i);
+        at(now + SEND_TIMEOUT_US, EV_SEND_TIMEOUT, i, f.token);
+      } break;
+      case TXA_RECV_REPLY: {
+        const int64_t arrive = x.replyPending ? (x.replyAt > now ? x.replyAt : now) : INT64_MAX;
+        if (arrive - now > (int64_t)a.ms * 1000) { at(now + (int64_t)a.ms * 1000, EV_STEP, i, 0); break; }
+        slotOnReply(x.sched, x.reply, localUs(x, arrive));
+        at(arrive, EV_STEP, i, 1);
+      } break;
+      case TXA_RECV_ACKS: {
+        // awaitAcks(): returns as soon as both are in, else at the timeout.
+        const int64_t until = now + (int64_t)a.ms * 1000;
+        const int64_t both  = x.sirenAckAt > x.webAckAt ? x.sirenAckAt : x.webAckAt;
+        const int64_t end   = both <= until ? (both > now ? both : now) : until;
+        uint32_t got = 0;
+        if (x.sirenAckAt <= end) got |= ACK_FROM_SIREN;
+        if (x.webAckAt <= end) {
+          got |= ACK_FROM_WEBSERVER;
+          if (p.tdma) slotOnReply(x.sched, x.reply, localUs(x, x.webAckAt > now ? x.webAckAt : now));
+        }
+        at(end, EV_STEP, i, got);
+      } break;
+      case TXA_DONE:
+        if (x.tx.started) {
+          if (x.tx.webOk) { st.sensorWebOk++; historyMarkSent(x.h); }
+          else historyMarkFailed(x.h);
+        } else historyMarkFailed(x.h);
+        finish(i, true);
+        break;
+    }
+  }
+
+  void sendDone(int i, bool ok) {
+    Sensor &x = s[i];
+    x.mac.active = false;
+    x.mac.token++;
+    current(x, MA_RX);
+    act(i, x.tx.next(ok ? 1 : 0, x.cc));
+  }
+
+  // ---- MAC ----
+  void macAttempt(int i) {
+    MacFrame &f = s[i].mac;
+    f.backoff = irand(0, f.cw);
+    at(now + DIFS_US + f.backoff * SLOT_US, EV_MAC_TRY, i, f.token);
+  }
+
+  void macTry(int i) {
+    Sensor &x = s[i];
+    MacFrame &f = x.mac;
+    Channel &c = ch[f.channel];
+    c.prune(now);
+    const int64_t busy = c.busyUntil(now);
+    if (busy) { at(busy + DIFS_US + f.backoff * SLOT_US, EV_MAC_TRY, i, f.token); return; }
+    st.macAttempts++;
+    const int64_t dur = airtimeUs(f.len);
+    f.txStart = now;
+    st.airUs += dur;
+    c.start(now, dur, f.dest == TX_TO_ALL ? 0 : SIFS_US + ACK_US);   // broadcasts reserve no ACK
+    current(x, MA_TX);
+    at(now + dur, EV_TX_END, i, f.token);
+  }
+
+  bool corruptAt(Channel &c, int64_t start) {
+    for (const Tx &t : c.air) if (t.start == start) return t.corrupt;
+    return true;
+  }
+
+  void txEnd(int i) {
+    Sensor &x = s[i];
+    MacFrame &f = x.mac;
+    Channel &c = ch[f.channel];
+    current(x, MA_RX);
+    if (f.dest == TX_TO_ALL) { broadcastEnd(i); return; }
+    // The receiver listens on its own channel only.
+    const uint8_t rxCh = f.dest == TX_TO_SIREN ? sirenCh() : p.webCh;
+    const bool received = f.channel == rxCh && !corruptAt(c, f.txStart) && uni() >= p.frameLoss;
+    if (!received) { at(now + SIFS_US + ACK_US + SLOT_US, EV_ACK_TIMEOUT, i, f.token); return; }
+    if (f.dest == TX_TO_SIREN) {
+      if (!x.sirenSeen || x.lastSirenSeq != f.seq) { st.sirenDelivered++; x.sirenSeen = true; x.lastSirenSeq = f.seq; }
+    } else {
+      if (!x.webSeen || x.lastWebSeq != f.seq) {
+        st.webDelivered++; x.webSeen = true; x.lastWebSeq = f.seq;
+        if (p.relay) relay(x, f.seq);
+      }
+      // sendSlotReply(): answered for every copy, duplicates included.
+      if (p.tdma && uni() >= p.frameLoss) {
+        const int64_t sentAt = now + 2000;
+        x.reply        = slotAssign((uint8_t)i, f.seq, (uint16_t)p.n, (uint64_t)(sentAt / 1000));
+        x.replyAt      = sentAt + airtimeUs(sizeof(SlotReply));
+        x.replyPending = true;
+        st.airUs += replyAirUs(sizeof(SlotReply));
+      }
+    }
+    // Receiver ACK: not carrier-sensed (SIFS), but it can collide like anything else.
+    c.prune(now);
+    f.txStart = now + SIFS_US;
+    at(now + SIFS_US, EV_ACK_START, i, f.token);
+  }
+
+  // One broadcast, two receivers: each hears it (or not) and acks on its own. The
+  // send callback reports success as soon as the frame is out.
+  void broadcastEnd(int i) {
+    Sensor &x = s[i];
+    MacFrame &f = x.mac;
+    const bool clean = f.channel == p.webCh && !corruptAt(ch[f.channel], f.txStart);
+    if (clean && sirenCh() == p.webCh && uni() >= p.frameLoss) {
+      if (!x.sirenSeen || x.lastSirenSeq != f.seq) { st.sirenDelivered++; x.sirenSeen = true; x.lastSirenSeq = f.seq; }
+      st.airUs += replyAirUs(sizeof(AppAck));
+      if (uni() >= p.frameLoss) x.sirenAckAt = now + 1000 + airtimeUs(sizeof(AppAck));
+    }
+    if (clean && uni() >= p.frameLoss) {
+      if (!x.webSeen || x.lastWebSeq != f.seq) { st.webDelivered++; x.webSeen = true; x.lastWebSeq = f.seq; }
+      const size_t len = p.tdma ? sizeof(SlotReply) : sizeof(AppAck);
+      st.airUs += replyAirUs(len);
+      if (uni() >= p.frameLoss) {
+        const int64_t sentAt = now + 2000;
+        if (p.tdma) x.reply = slotAssign((uint8_t)i, f.seq, (uint16_t)p.n, (uint64_t)(sentAt / 1000));
+        x.webAckAt = sentAt + airtimeUs(len);
+      }
+    }
+    sendDone(i, true);
+  }
+
+  uint8_t sirenCh() const { return p.oneFrame || p.relay ? p.webCh : p.sirenCh; }
+
+  // relayToSiren(): new readings only, unicast with MAC retries.
+  void relay(Sensor &x, uint16_t seq) {
+    st.airUs += airtimeUs(RELAY_FRAME_LEN) + SIFS_US + ACK_US;
+    if (uni() < pow(p.frameLoss, p.macRetries + 1)) return;
+    if (!x.sirenSeen || x.lastSirenSeq != seq) { st.sirenDelivered++; x.sirenSeen = true; x.lastSirenSeq = seq; }
+  }
+
+  void ackStart(int i) {
+    MacFrame &f = s[i].mac;
+    st.airUs += ACK_US;
+    ch[f.channel].start(now, ACK_US, 0);
+    f.txStart = now;
+    at(now + ACK_US, EV_ACK_END, i, f.token);
+  }
+
+  void ackEnd(int i) {
+    MacFrame &f = s[i].mac;
+    const bool ok = !corruptAt(ch[f.channel], f.txStart) && uni() >= p.ackLoss;
+    if (ok) { sendDone(i, true); return; }
+    macRetry(i);
+  }
+
+  void macRetry(int i) {
+    MacFrame &f = s[i].mac;
+    if (++f.tries > p.macRetries) { st.macDrops++; sendDone(i, false); return; }
+    f.cw = f.cw * 2 + 1 > CW_MAX ? CW_MAX : f.cw * 2 + 1;
+    macAttempt(i);
+  }
+
+  // ---- background Wi-Fi on the webserver channel ----
+  void bg() {
+    Channel &c = ch[p.webCh];
+    c.prune(now);
+    const int64_t busy = c.busyUntil(now);
+    if (busy) at(busy + DIFS_US + irand(0, CW_MIN) * SLOT_US, EV_BG, -1);
+    else {
+      c.start(now, BG_FRAME_US, SIFS_US + ACK_US);
+      const double meanGapUs = BG_FRAME_US / p.bgUtil;
+      at(now + BG_FRAME_US + (int64_t)std::exponential_distribution<double>(1.0 / meanGapUs)(rng), EV_BG, -1);
+    }
+  }
+
+  void run() {
+    rng.seed(p.seed);
+    endUs = (int64_t)(p.hours * 3600e6);
+    s.assign(p.n, Sensor{});
+    for (uint32_t i = 0; i < p.n; ++i) {
+      Sensor &x = s[i];
+      x.drift   = (uni() * 2 - 1) * p.driftPct / 100;
+      x.wanderPhase = uni() * TWO_PI;
+      x.filling = uni() < p.fillFrac;
+      x.fillMmPerMin = 1 + 4 * uni();
+      x.levelMm = x.filling ? 200 + 650 * uni() : 300 + 550 * uni();
+      at(p.sync ? 0 : (int64_t)(uni() * 120e6), EV_WAKE, (int)i);
+    }
+    if (p.bgUtil > 0) at(0, EV_BG, -1);
+
+    while (!q.empty()) {
+      const Event e = q.top();
+      if (e.t > endUs) break;
+      q.pop();
+      now = e.t;
+      if (e.kind == EV_BG) { bg(); continue; }
+      Sensor &x = s[e.node];
+      const uint32_t tok = e.arg;
+      switch (e.kind) {
+        case EV_WAKE:    wake(e.node); break;
+        case EV_BOOTED:  booted(e.node); break;
+        case EV_SLEEP:   sleep(e.node); break;
+        case EV_SAMPLED: sampled(e.node); break;
+        case EV_STEP:    current(x, x.radioOn ? MA_RX : MA_CPU); act(e.node, x.tx.next(e.arg, x.cc)); break;
+        case EV_MAC_TRY: if (x.mac.active && tok == x.mac.token) macTry(e.node); break;
+        case EV_TX_END:  if (x.mac.active && tok == x.mac.token) txEnd(e.node); break;
+        case EV_ACK_START: if (x.mac.active && tok == x.mac.token) ackStart(e.node); break;
+        case EV_ACK_END:   if (x.mac.active && tok == x.mac.token) ackEnd(e.node); break;
+        case EV_ACK_TIMEOUT: if (x.mac.active && tok == x.mac.token) macRetry(e.node); break;
+        case EV_SEND_TIMEOUT:
+          if (x.mac.active && tok == x.mac.token) { st.sendTimeouts++; sendDone(e.node, false); }
+          break;
+        default: break;
+      }
+    }
+    now = endUs;
+    for (Sensor &x : s) current(x, x.mA);
+  }
+};
+
+// ====== Report ======
+static void header() {
+  printf("%5s %6s %-8s %6s %7s %7s %7s %7s %7s %6s %7s %6s %7s %7s %9s %8s %8s %8s\n",
+    "N", "jit_ms", "sleep", "wake/d", "tx/day", "web%", "sensor%", "siren%", "sends/w", "mac/tx", "coll%", "slot%", "wait_ms",
+    "hops/tx", "air_us/tx", "awake_ms", "mJ/deliv", "mAh/day");
+}
+
+static void report(const Sim &sim) {
+  const Params &p = sim.p;
+  const Stats &st = sim.st;
+  double mAus = 0;
+  for (const Sensor &x : sim.s) mAus += x.mAus;
+  const double days = p.hours / 24.0;
+  const double mAhDay = mAus / 3600e6 / days / p.n;
+  const double mJ = mAus / 1e6 * VOLTS;           // mA*s*V = mJ
+  uint64_t frames = 0, coll = 0;
+  for (const Channel &c : sim.ch) { frames += c.frames; coll += c.collided; }
+  const double tx = st.txWakes ? (double)st.txWakes : 1;
+  uint64_t slotWakes = 0, waitMs = 0;
+  for (const Sensor &x : sim.s) { slotWakes += x.slotWakes; waitMs += x.waitMsSum; }
+  printf("%5u %6u %-8s %6.1f %7.1f %7.2f %7.2f %7.2f %7.2f %6.2f %7.2f %6.1f %7.0f %7.2f %9.0f %8.0f %8.1f %8.2f\n",
+    p.n, p.jitterMs, p.fixed ? "every120" : "adaptive",
+    st.wakes / days / p.n, st.txWakes / days / p.n,
+    100.0 * st.webDelivered / tx, 100.0 * st.sensorWebOk / tx, 100.0 * st.sirenDelivered / tx,
+    st.appSends / tx, st.appSends ? (double)st.macAttempts / st.appSends : 0,
+    frames ? 100.0 * coll / frames : 0, 100.0 * slotWakes / tx, waitMs / tx,
+    st.hops / tx, st.airUs / tx,
+    st.wakes ? st.awakeUs / 1e3 / st.wakes : 0,
+    st.webDelivered ? mJ / st.webDelivered : 0, mAhDay);
+}
+
+int main(int argc, char **argv) {
+  Params base;
+  bool single = false;
+  for (int i = 1; i < argc; ++i) {
+    const char *a = argv[i];
+    const char *v = i + 1 < argc ? argv[i + 1] : "0";
+    if      (!strcmp(a, "--n"))           { base.n = (uint32_t)atoi(v); single = true; i++; }
+    else if (!strcmp(a, "--jitter"))      { base.jitterMs = (uint32_t)atoi(v); single = true; i++; }
+    else if (!strcmp(a, "--mode"))        { base.fixed = !strcmp(v, "fixed"); single = true; i++; }
+    else if (!strcmp(a, "--sync"))        base.sync = true;
+    else if (!strcmp(a, "--hours"))       { base.hours = atof(v); i++; }
+    else if (!strcmp(a, "--seed"))        { base.seed = (uint32_t)atoi(v); i++; }
+    else if (!strcmp(a, "--bg"))          { base.bgUtil = atof(v); i++; }
+    else if (!strcmp(a, "--web-ch"))      { base.webCh = (uint8_t)atoi(v); i++; }
+    else if (!strcmp(a, "--siren-ch"))    { base.sirenCh = (uint8_t)atoi(v); i++; }
+    else if (!strcmp(a, "--mac-retries")) { base.macRetries = atoi(v); i++; }
+    else if (!strcmp(a, "--loss"))        { base.frameLoss = base.ackLoss = atof(v); i++; }
+    else if (!strcmp(a, "--spread"))      { base.sampleSpreadMs = (uint32_t)atoi(v); i++; }
+    else if (!strcmp(a, "--tdma"))        base.tdma = true;
+    else if (!strcmp(a, "--fast"))        base.fast = true;
+    else if (!strcmp(a, "--one-frame"))   base.oneFrame = true;
+    else if (!strcmp(a, "--relay"))       base.relay = true;
+    else if (!strcmp(a, "--drift"))       { base.driftPct = atof(v); i++; }
+    else if (!strcmp(a, "--wander"))      { base.wanderPpm = atof(v); i++; }
+    else if (!strcmp(a, "--fill"))        { base.fillFrac = atof(v); i++; }
+    else { fprintf(stderr, "unknown option %s\n", a); return 2; }
+  }
+  if (base.webCh < 1 || base.webCh > 14 || base.sirenCh < 1 || base.sirenCh > 14) {
+    fprintf(stderr, "channels are 1..14\n");
+    return 2;
+  }
+
+  printf("%.0f h, seed %u, siren CH%u, webserver CH%u, bg %.0f%%, loss %.0f%%, MAC retries %d, "
+         "drift %.2f%% + %.0f ppm/day%s%s%s%s\n",
+    base.hours, base.seed, base.oneFrame || base.relay ? base.webCh : base.sirenCh, base.webCh, base.bgUtil * 100, base.frameLoss * 100,
+    base.macRetries, base.driftPct, base.wanderPpm, base.sync ? ", simultaneous boot" : "",
+    base.tdma ? ", TDMA slots" : "", base.fast ? ", FAST_WAKE" : "", base.relay ? ", relayed" : base.oneFrame ? ", one frame" : "");
+  header();
+  if (single) {
+    Sim sim;
+    sim.p = base;
+    sim.run();
+    report(sim);
+    return 0;
+  }
+  static const uint32_t NS[]      = {3, 10, 30, 100, 255};   // 255: the registry's limit
+  static const uint32_t JITTERS[] = {0, 500, 2000, 5000};
+  for (int fixed = 0; fixed < 2; ++fixed)
+    for (uint32_t n : NS)
+      for (uint32_t j : JITTERS) {
+        Sim sim;
+        sim.p = base;
+        sim.p.n = n;
+        sim.p.jitterMs = j;
+        sim.p.fixed = fixed;
+        sim.run();
+        report(sim);
+      }
+  return 0;
+}
@@ -0,0 +1,49 @@
+// host_test.h — checks and timing for the host tests in this directory
+// Each test_*.cpp is its own program: it runs its checks, then (unless --quick) its
+// benchmark or simulation, and exits non-zero if any check failed. run_all.sh builds
+// and runs them all. Host timings are for comparing two approaches on the same
+// machine, not a prediction of ESP32 cycles.
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+static int g_checks = 0, g_failed = 0;
+
+#define CHECK(cond) do {                                                     \
+    g_checks++;                                                              \
+    if (!(cond)) {                                                           \
+      g_failed++;                                                            \
+      fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+    }                                                                        \
+  } while (0)
+
+#define CHECK_EQ(a, b) do {                                                  \
+    g_checks++;                                                              \
+    const long long va_ = (long long)(a), vb_ = (long long)(b);              \
+    if (va_ != vb_) {                                                        \
+      g_failed++;                                                            \
+      fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %s (%lld vs %lld)\n",   \
+              __FILE__, __LINE__, #a, #b, va_, vb_);                         \
+    }                                                                        \
+  } while (0)
+
+// --quick: checks only, for a fast pass over every test.
+static inline bool benchEnabled(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) if (strcmp(argv[i], "--quick") == 0) return false;
+  return true;
+}
+
+static inline uint64_t nowNs() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Keeps a benchmarked result alive without the optimiser seeing through it.
+static volatile uint32_t g_sink;
+
+static inline int testResult(const char *name) {
+  printf("%s: %d checks, %d failed\n", name, g_checks, g_failed);
+  return g_failed ? 1 : 0;
+}
@@ -0,0 +1,20 @@
+#!/bin/sh
+# Builds and runs every host test in this directory; exits non-zero if any fails.
+#   ./run_all.sh            # checks, then each test's benchmark or simulation
+#   ./run_all.sh --quick    # checks only
+# CXX picks the compiler (default g++); binaries go to ./build.
+cd "$(dirname "$0")" || exit 1
+CXX=${CXX:-g++}
+INC="-I../../sensor_mcu/include -I../../siren_mcu/include -I../../webserver_mcu/include"
+mkdir -p build
+fail=0
+for src in test_*.cpp; do
+  bin="build/${src%.cpp}"
+  if ! $CXX -O2 -std=c++17 -Wall -Wextra -pthread $INC "$src" -o "$bin"; then
+    echo "BUILD FAILED: $src"
+    fail=1
+    continue
+  fi
+  "./$bin" "$@" || { echo "FAILED: $src"; fail=1; }
+done
+exit $fail
@@ -0,0 +1,225 @@
+// test_a02yyuw_parser.cpp — A02yyuwParser (sensor_mcu/include/a02yyuw_parser.h)
+// Unit checks for resync, split reads, ring wrap and the counters, then a fuzz run:
+// synthetic byte streams with flipped bits and stray bytes (0xFF included) at rising
+// rates, fed in random-sized chunks. Recovery is the share of intact frames that come
+// out; false frames are noise that happened to pass the checksum. The old
+// read-four-and-drop parser runs on the same streams for comparison, followed by
+// throughput on a clean stream.
+#include "a02yyuw_parser.h"
+#include "host_test.h"
+#include <deque>
+#include <random>
+#include <vector>
+
+static A02yyuwParser parser;
+
+static void pushFrame(std::vector<uint8_t> &s, uint16_t mm) {
+  const uint8_t hi = (uint8_t)(mm >> 8), lo = (uint8_t)mm;
+  s.insert(s.end(), {0xFF, hi, lo, (uint8_t)(0xFF + hi + lo)});
+}
+
+static std::vector<uint16_t> parseAll(const std::vector<uint8_t> &s, size_t chunk = 64) {
+  std::vector<uint16_t> out;
+  uint16_t mm;
+  for (size_t i = 0; i < s.size(); i += chunk) {
+    const size_t n = s.size() - i < chunk ? s.size() - i : chunk;
+    parser.feed(s.data() + i, n);
+    while (parser.next(mm)) out.push_back(mm);
+  }
+  return out;
+}
+
+static void testUnits() {
+  std::vector<uint8_t> s;
+  parser.reset();
+  pushFrame(s, 1234);
+  pushFrame(s, 30);
+  pushFrame(s, 4500);
+  std::vector<uint16_t> got = parseAll(s);
+  CHECK(got == (std::vector<uint16_t>{1234, 30, 4500}));
+  CHECK_EQ(parser.goodFrames, 3);
+
+  // Out of range on both sides: counted, not returned.
+  s.clear(); parser.reset();
+  pushFrame(s, 29); pushFrame(s, 4501); pushFrame(s, 0); pushFrame(s, 800);
+  got = parseAll(s);
+  CHECK(got == (std::vector<uint16_t>{800}));
+  CHECK_EQ(parser.outOfRange, 3);
+
+  // A bad checksum costs only that frame: the next one is found.
+  s.clear(); parser.reset();
+  pushFrame(s, 1000); s.back() ^= 0x10;
+  pushFrame(s, 1001);
+  got = parseAll(s);
+  CHECK(got == (std::vector<uint16_t>{1001}));
+  CHECK_EQ(parser.checksumErrors, 1);
+
+  // A truncated frame (header + 1 byte) swallows nothing after it: resync on the
+  // 0xFF inside the failed window.
+  s.clear(); parser.reset();
+  s.insert(s.end(), {0xFF, 0x05});
+  pushFrame(s, 2000);
+  got = parseAll(s);
+  CHECK(got == (std::vector<uint16_t>{2000}));
+  CHECK_EQ(parser.checksumErrors, 1);
+
+  // Stray bytes before a header are skipped and counted.
+  s.clear(); parser.reset();
+  s.insert(s.end(), {0x00, 0x12, 0x34});
+  pushFrame(s, 700);
+  got = parseAll(s);
+  CHECK(got == (std::vector<uint16_t>{700}));
+  CHECK_EQ(parser.skippedBytes, 3);
+
+  // Byte-at-a-time reads assemble the same frames.
+  s.clear(); parser.reset();
+  for (int i = 0; i < 50; i++) pushFrame(s, (uint16_t)(100 + i));
+  got = parseAll(s, 1);
+  CHECK_EQ(got.size(), 50);
+  CHECK(got.size() == 50 && got.front() == 100 && got.back() == 149);
+
+  // writeSpan() never crosses the ring's end; wrap-around keeps frames whole.
+  parser.reset();
+  s.clear();
+  for (int i = 0; i < 200; i++) pushFrame(s, (uint16_t)(1000 + i));
+  size_t off = 0, frames = 0;
+  uint16_t mm;
+  while (off < s.size()) {
+    size_t span;
+    uint8_t *dst = parser.writeSpan(span);
+    CHECK(span > 0 && span <= A02_RING_SIZE);
+    const size_t n = s.size() - off < span ? s.size() - off : (span > 7 ? 7 : span);
+    memcpy(dst, s.data() + off, n);
+    parser.produce(n);
+    off += n;
+    while (parser.next(mm)) CHECK_EQ(mm, 1000 + frames++);
+  }
+  CHECK_EQ(frames, 200);
+
+  // More than the ring holds: the excess is counted as an overrun, not written.
+  parser.reset();
+  std::vector<uint8_t> big(A02_RING_SIZE + 10, 0x00);
+  CHECK_EQ(parser.feed(big.data(), big.size()), A02_RING_SIZE);
+  CHECK_EQ(parser.overruns, 10);
+}
+
+// ---- The parser before the ring buffer: read four bytes, drop all four on a bad sum ----
+struct OldParser {
+  std::deque<uint8_t> uart;
+  bool next(uint16_t &mm) {
+    while (uart.size() >= 4) {
+      const uint8_t b0 = pop();
+      if (b0 != 0xFF) continue;
+      if (uart.size() < 3) return false;   // header already consumed: lost
+      const uint8_t b1 = pop(), b2 = pop(), b3 = pop();
+      if ((uint8_t)(b0 + b1 + b2) != b3) continue;
+      const int raw = (b1 << 8) | b2;
+      if (raw < 30 || raw > 4500) continue;
+      mm = (uint16_t)raw;
+      return true;
+    }
+    return false;
+  }
+  uint8_t pop() { const uint8_t b = uart.front(); uart.pop_front(); return b; }
+};
+
+struct Stream {
+  std::vector<uint8_t> bytes;
+  std::vector<bool>    intact;    // by frame index k (value 500 + k)
+  size_t intactCount = 0;
+};
+
+// Frames carry 500 + k so every value out of the parser names its source frame.
+static Stream makeStream(std::mt19937 &rng, int frames, double pFlip, double pStray) {
+  std::uniform_real_distribution<double> u(0, 1);
+  Stream st;
+  st.intact.assign(frames, false);
+  for (int k = 0; k < frames; k++) {
+    if (u(rng) < pStray) {
+      const int n = 1 + (int)(rng() % 4);
+      for (int i = 0; i < n; i++) st.bytes.push_back(u(rng) < 0.25 ? 0xFF : (uint8_t)rng());
+    }
+    const size_t at = st.bytes.size();
+    pushFrame(st.bytes, (uint16_t)(500 + k));
+    if (u(rng) < pFlip) st.bytes[at + 1 + rng() % 3] ^= (uint8_t)(1u << (rng() % 8));
+    else { st.intact[k] = true; st.intactCount++; }
+  }
+  return st;
+}
+
+struct Score { size_t recovered = 0, falseFrames = 0; };
+
+static Score score(const Stream &st, const std::vector<uint16_t> &got) {
+  Score sc;
+  std::vector<bool> used(st.intact.size(), false);
+  for (uint16_t v : got) {
+    const int k = (int)v - 500;
+    if (k >= 0 && k < (int)st.intact.size() && st.intact[k] && !used[k]) { used[k] = true; sc.recovered++; }
+    else sc.falseFrames++;
+  }
+  return sc;
+}
+
+static void fuzz(bool verbose) {
+  std::mt19937 rng(3);
+  if (verbose) printf("\n%6s %6s  %10s %10s  %10s %10s\n", "flip", "stray", "recovery", "false", "old recov", "old false");
+  for (double p : {0.0, 0.01, 0.05, 0.15, 0.30}) {
+    const Stream st = makeStream(rng, 4000, p, p);
+    std::vector<uint16_t> got, old;
+    parser.reset();
+    OldParser op;
+    uint16_t mm;
+    for (size_t i = 0; i < st.bytes.size(); ) {   // random read sizes, as the UART hands them out
+      const size_t n = 1 + rng() % 24;
+      const size_t m = st.bytes.size() - i < n ? st.bytes.size() - i : n;
+      parser.feed(st.bytes.data() + i, m);
+      op.uart.insert(op.uart.end(), st.bytes.begin() + i, st.bytes.begin() + i + m);
+      i += m;
+      while (parser.next(mm)) got.push_back(mm);
+      while (op.next(mm)) old.push_back(mm);
+    }
+    const Score a = score(st, got), b = score(st, old);
+    const double rec = (double)a.recovered / st.intactCount, oldRec = (double)b.recovered / st.intactCount;
+    if (verbose) {
+      printf("%5.0f%% %5.0f%%  %9.2f%% %10zu  %9.2f%% %10zu\n", p * 100, p * 100, rec * 100, a.falseFrames,
+             oldRec * 100, b.falseFrames);
+    }
+    CHECK(parser.overruns == 0);
+    CHECK(rec >= oldRec);
+    CHECK(a.falseFrames * 100 <= st.intactCount);        // under 1% noise let through
+    if (p == 0.0) CHECK_EQ(a.recovered, st.intactCount);
+    if (p <= 0.05) CHECK(rec > 0.99);
+    CHECK(rec > 0.95);
+  }
+}
+
+static void throughput() {
+  std::vector<uint8_t> s;
+  for (int i = 0; i < 250000; i++) pushFrame(s, (uint16_t)(30 + i % 4000));   // 1 MB
+  const int reps = 10;
+  uint64_t t0 = nowNs();
+  size_t frames = 0;
+  for (int r = 0; r < reps; r++) { parser.reset(); frames += parseAll(s).size(); }
+  const double ns = (double)(nowNs() - t0);
+  OldParser op;
+  uint64_t t1 = nowNs();
+  size_t oldFrames = 0;
+  uint16_t mm;
+  for (int r = 0; r < reps; r++) {
+    op.uart.assign(s.begin(), s.end());
+    while (op.next(mm)) oldFrames++;
+  }
+  const double oldNs = (double)(nowNs() - t1);
+  CHECK_EQ(frames, oldFrames);
+  printf("\nclean stream: %.1f Mframes/s (%.0f MB/s) ring parser; old parser %.1f Mframes/s\n",
+         frames / ns * 1e3, s.size() * reps / ns * 1e3, oldFrames / oldNs * 1e3);
+  printf("(the sensor sees 10 frames/s; this is headroom, not a bottleneck)\n");
+}
+
+int main(int argc, char **argv) {
+  const bool verbose = benchEnabled(argc, argv);
+  testUnits();
+  fuzz(verbose);
+  if (verbose) throughput();
+  return testResult("a02yyuw_parser");
+}
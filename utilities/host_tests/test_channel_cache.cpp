@@ -0,0 +1,127 @@
+// test_channel_cache.cpp — channelSelect()/channelReport() (sensor_mcu/include/channel_cache.h)
+// against a simulated scan backend. Unit checks walk the cache through a cold boot,
+// hits, the rescan threshold, the cached-channel probe, a moved AP and an AP that is
+// gone. The simulation then runs a week of 120 s wakes while the router changes
+// channel every couple of days and 2% of sends are lost anyway. It reports scans per
+// day, radio time spent scanning and wakes that failed to deliver, against the old
+// full sweep every wake. Scan costs follow fleet_sim: 150 ms per channel probed,
+// 13 channels per sweep.
+#include "channel_cache.h"
+#include "host_test.h"
+#include <random>
+
+struct FakeAir {
+  uint8_t  apChannel = 6;      // 0 = AP off
+  uint32_t probes = 0, sweeps = 0;
+};
+
+static uint8_t fakeScan(uint8_t channel, void *ctx) {
+  FakeAir &a = *(FakeAir *)ctx;
+  if (channel) { a.probes++; return a.apChannel == channel ? channel : 0; }
+  a.sweeps++;
+  return a.apChannel;
+}
+
+static void testUnits() {
+  ChannelCache c{};
+  FakeAir air;
+  ChannelSource src;
+
+  // Cold boot: nothing cached, full sweep.
+  CHECK_EQ(channelSelect(c, fakeScan, &air, src), 6);
+  CHECK_EQ(src, CH_SCANNED);
+  CHECK_EQ(air.sweeps, 1);
+  CHECK_EQ(air.probes, 0);
+
+  // Cached while sends work, and while failures stay under the threshold.
+  for (int i = 0; i < 5; i++) {
+    CHECK_EQ(channelSelect(c, fakeScan, &air, src), 6);
+    CHECK_EQ(src, CH_CACHED);
+    channelReport(c, i % 2 == 0);
+  }
+  for (int i = 0; i < CHANNEL_RESCAN_AFTER - 1; i++) channelReport(c, false);
+  CHECK_EQ(channelSelect(c, fakeScan, &air, src), 6);
+  CHECK_EQ(src, CH_CACHED);
+  CHECK_EQ(air.sweeps + air.probes, 1);
+
+  // Threshold reached, AP still there: the probe of the cached channel settles it.
+  channelReport(c, false);
+  CHECK_EQ(channelSelect(c, fakeScan, &air, src), 6);
+  CHECK_EQ(src, CH_PROBED);
+  CHECK_EQ(air.probes, 1);
+  CHECK_EQ(air.sweeps, 1);
+  CHECK_EQ(c.failStreak, 0);
+  CHECK_EQ(c.probeHits, 1);
+
+  // AP moved: probe misses, sweep finds the new channel.
+  air.apChannel = 11;
+  for (int i = 0; i < CHANNEL_RESCAN_AFTER; i++) channelReport(c, false);
+  CHECK_EQ(channelSelect(c, fakeScan, &air, src), 11);
+  CHECK_EQ(src, CH_SCANNED);
+  CHECK_EQ(c.channel, 11);
+  CHECK_EQ(air.probes, 2);
+  CHECK_EQ(air.sweeps, 2);
+
+  // AP gone: keep the last channel, and don't sweep again for another round of sends.
+  air.apChannel = 0;
+  for (int i = 0; i < CHANNEL_RESCAN_AFTER; i++) channelReport(c, false);
+  CHECK_EQ(channelSelect(c, fakeScan, &air, src), 11);
+  CHECK_EQ(src, CH_FALLBACK);
+  CHECK_EQ(c.failStreak, 0);
+  CHECK_EQ(channelSelect(c, fakeScan, &air, src), 11);
+  CHECK_EQ(src, CH_CACHED);
+
+  // Never found at all: the caller's fallback channel.
+  ChannelCache cold{};
+  CHECK_EQ(channelSelect(cold, fakeScan, &air, src, 3), 3);
+  CHECK_EQ(src, CH_FALLBACK);
+  CHECK_EQ(cold.channel, 0);
+
+  // The failure streak saturates instead of wrapping.
+  for (int i = 0; i < 300; i++) channelReport(c, false);
+  CHECK_EQ(c.failStreak, 0xFF);
+
+  CHECK_EQ(cold.hits + cold.misses, 1);
+  CHECK(c.hits + c.misses >= 9);
+}
+
+static void simulate() {
+  const uint32_t PROBE_MS = 150, SWEEP_MS = 13 * PROBE_MS;
+  const int WAKES = 7 * 24 * 30;                     // a week at 120 s
+  std::mt19937 rng(4);
+  std::uniform_real_distribution<double> u(0, 1);
+  FakeAir air;
+  ChannelCache c{};
+  uint32_t failedWakes = 0, moves = 0;
+  static const uint8_t CHANNELS[] = {1, 6, 11};
+  for (int w = 0; w < WAKES; w++) {
+    if (u(rng) < 1.0 / (2 * 24 * 30)) {              // about every two days
+      uint8_t next;
+      do next = CHANNELS[rng() % 3]; while (next == air.apChannel);
+      air.apChannel = next;
+      moves++;
+    }
+    ChannelSource src;
+    const uint8_t ch = channelSelect(c, fakeScan, &air, src);
+    bool delivered = false;
+    for (int attempt = 0; attempt < 2 && !delivered; attempt++) {   // sendPacketTo() retries once
+      delivered = ch == air.apChannel && u(rng) > 0.02;
+      channelReport(c, delivered);
+    }
+    if (!delivered) failedWakes++;
+  }
+  const double days = WAKES / 720.0;
+  const double scanMs = (double)air.probes * PROBE_MS + (double)air.sweeps * SWEEP_MS;
+  printf("\n%d wakes, AP moved %u times\n", WAKES, (unsigned)moves);
+  printf("cached: %u hits, %u misses (%u settled by the probe), %.1f scans/day, %.1f ms scanning per wake, %u wakes undelivered\n",
+         (unsigned)c.hits, (unsigned)c.misses, (unsigned)c.probeHits, c.misses / days, scanMs / WAKES, (unsigned)failedWakes);
+  printf("old:    %d sweeps, %.0f ms scanning per wake\n", WAKES, (double)SWEEP_MS);
+  CHECK(c.misses < (uint32_t)WAKES / 50);
+  CHECK(failedWakes < (uint32_t)WAKES / 100);
+}
+
+int main(int argc, char **argv) {
+  testUnits();
+  if (benchEnabled(argc, argv)) simulate();
+  return testResult("channel_cache");
+}
@@ -0,0 +1,148 @@
+// test_channel_follow.cpp — ChannelFollower (siren_mcu/include/channel_follow.h)
+// Units: locking on the first frame, following an announce to another channel,
+// losing lock after lostMs, hunting one channel per dwellMs with the wrap after
+// maxChannel, and millis() wrapping mid-hunt. The simulation runs the siren's
+// follower against a webserver announcing every ANNOUNCE_MS for 30 days while its
+// router changes channel a few times a day (and the webserver reboots onto it),
+// with announce loss from 0 to 50 %. Reported per loss rate: share of time the siren
+// sits on the webserver's channel, time to relock after a move (p50/p99/max, against
+// the lostMs + maxChannel * dwellMs bound), and locks lost while the webserver had
+// not moved.
+#include "channel_follow.h"
+#include "host_test.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const FollowConfig FOLLOW = { 3500, 1100, 13 };     // as the siren's
+static const uint32_t ANNOUNCE_MS = 1000;                   // as the webserver's
+
+static void testUnits() {
+  ChannelFollower f;
+  followBegin(f, 1, 0);
+  CHECK(!f.locked);
+  CHECK_EQ(followHeard(f, 0, 10), 0);                       // any webserver frame locks
+  CHECK(f.locked);
+  CHECK_EQ(f.locks, 1);
+  CHECK_EQ(followHeard(f, 1, 20), 0);                       // announce for where we are
+  CHECK_EQ(followHeard(f, 6, 30), 6);                       // webserver moved: follow
+  CHECK_EQ(f.channel, 6);
+  CHECK_EQ(f.hops, 1);
+  CHECK_EQ(f.locks, 1);
+
+  CHECK_EQ(followTick(f, 30 + FOLLOW.lostMs - 1, FOLLOW), 0);
+  CHECK_EQ(followTick(f, 30 + FOLLOW.lostMs, FOLLOW), 7);   // lost: first step at once
+  CHECK(!f.locked);
+  CHECK_EQ(f.losses, 1);
+  uint32_t t = 30 + FOLLOW.lostMs;
+  CHECK_EQ(followTick(f, t + FOLLOW.dwellMs - 1, FOLLOW), 0);
+  for (uint8_t want : {8, 9, 10, 11, 12, 13, 1, 2}) {       // wraps after maxChannel
+    t += FOLLOW.dwellMs;
+    CHECK_EQ(followTick(f, t, FOLLOW), want);
+  }
+  CHECK_EQ(followHeard(f, 2, t + 500), 0);
+  CHECK(f.locked);
+  CHECK_EQ(f.locks, 2);
+
+  // US plan ending at 11, and a channel beyond it wraps to 1.
+  const FollowConfig us = { 3500, 1100, 11 };
+  followBegin(f, 11, 0);
+  CHECK_EQ(followTick(f, 1100, us), 1);
+  followBegin(f, 13, 0);
+  CHECK_EQ(followTick(f, 1100, us), 1);
+
+  // millis() wraps: quiet time is still measured right.
+  followBegin(f, 5, 0xFFFFFF00u);
+  followHeard(f, 0, 0xFFFFFF00u);
+  CHECK_EQ(followDueMs(f, 0x100u, FOLLOW), FOLLOW.lostMs - 0x200u);
+  CHECK_EQ(followTick(f, 0x100u, FOLLOW), 0);
+  CHECK_EQ(followTick(f, 0xFFFFFF00u + FOLLOW.lostMs, FOLLOW), 6);
+}
+
+struct FollowResult {
+  uint64_t alignedMs = 0, totalMs = 0;
+  uint32_t moves = 0, falseLosses = 0;
+  std::vector<uint32_t> relockMs;
+};
+
+static FollowResult run(double loss, uint32_t days, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> u(0, 1);
+  FollowResult r;
+  ChannelFollower f;
+  uint32_t now = 0;
+  followBegin(f, 1, now);
+  uint8_t webCh = 6;
+  uint32_t nextAnnounce = 400, nextMove = 3600000 + rng() % 21600000, movedAt = 0, lossesAtMove = 0;
+  bool waiting = true;                                      // power-up counts as a move
+  const uint64_t end = (uint64_t)days * 86400000u;
+  uint64_t elapsed = 0;
+  while (elapsed < end) {
+    uint32_t step = std::min(nextAnnounce - now, nextMove - now);
+    const uint32_t due = followDueMs(f, now, FOLLOW);
+    step = std::min(step, due);
+    if (f.channel == webCh) r.alignedMs += step;
+    now += step;
+    elapsed += step;
+
+    if (now == nextMove) {
+      // A router channel change; the webserver reboots onto it and its announces
+      // pause for the few seconds that takes.
+      uint8_t ch;
+      do ch = (uint8_t)(1 + rng() % FOLLOW.maxChannel); while (ch == webCh);
+      webCh = ch;
+      movedAt = now;
+      waiting = true;
+      lossesAtMove = f.losses;
+      r.moves++;
+      nextAnnounce = now + 3000 + rng() % 5000;
+      nextMove = now + 3600000 + rng() % 21600000;          // every 1..7 hours
+    }
+    if (now == nextAnnounce) {
+      nextAnnounce += ANNOUNCE_MS;
+      if (f.channel == webCh && u(rng) >= loss) {
+        followHeard(f, webCh, now);
+        if (waiting) { r.relockMs.push_back(now - movedAt); waiting = false; }
+      }
+    }
+    const uint32_t lossesBefore = f.losses;
+    followTick(f, now, FOLLOW);
+    if (f.losses != lossesBefore && !waiting && f.losses > lossesAtMove) r.falseLosses++;
+  }
+  r.totalMs = elapsed;
+  return r;
+}
+
+int main(int argc, char **argv) {
+  testUnits();
+  const uint32_t days = benchEnabled(argc, argv) ? 30 : 3;
+  const uint32_t bound = FOLLOW.lostMs + FOLLOW.maxChannel * FOLLOW.dwellMs;
+  const double losses[] = { 0.0, 0.1, 0.3, 0.5 };
+  FollowResult out[4];
+  for (int i = 0; i < 4; i++) {
+    out[i] = run(losses[i], days, 230 + i);
+    std::sort(out[i].relockMs.begin(), out[i].relockMs.end());
+  }
+  CHECK(out[0].moves > 5);
+  // Without loss every move relocks within one sweep (plus the reboot pause) and the
+  // siren never drops a lock it had.
+  CHECK_EQ(out[0].falseLosses, 0);
+  CHECK_EQ(out[0].relockMs.size(), out[0].moves + 1);
+  CHECK(out[0].relockMs.back() <= 8000 + bound);
+  // Up to 10 % loss the siren is on the right channel at least 98 % of the time. At
+  // 30 % and beyond, three missed announces in a row (lostMs) are common enough to
+  // start a hunt several times an hour; that is reported, not asserted.
+  for (int i = 0; i < 2; i++) CHECK(out[i].alignedMs * 100 >= out[i].totalMs * 98);
+
+  if (benchEnabled(argc, argv)) {
+    printf("\n%u days, webserver moves every 1..7 h (%u moves), announce every %u ms; one sweep bound %u ms + reboot pause\n",
+           days, out[0].moves, ANNOUNCE_MS, bound);
+    printf("%14s %12s %28s %14s\n", "announce loss", "on channel", "relock ms p50/p99/max", "false losses");
+    for (int i = 0; i < 4; i++) {
+      const std::vector<uint32_t> &v = out[i].relockMs;
+      printf("%13.0f%% %11.3f%% %10u / %6u / %6u %14u\n", losses[i] * 100, 100.0 * out[i].alignedMs / out[i].totalMs,
+             v[v.size() / 2], v[v.size() * 99 / 100], v.back(), out[i].falseLosses);
+    }
+  }
+  return testResult("channel_follow");
+}
@@ -0,0 +1,212 @@
+// test_dashboard_asset.cpp — GET / (webserver_mcu/include/dashboard_asset.h) against
+// the handler it replaced, over loopback HTTP. A server thread answers each request
+// the way handleRoot() does now (302 to /?v=<hash>, gzip + ETag + a year of
+// Cache-Control, 304 on a matching If-None-Match) or the way it did before (send_P of
+// the raw web/index.html, no caching headers). The client walks what a browser does
+// on a first visit, a later visit with the page cached, and a reload. Reported: bytes
+// on the wire per visit and loopback time, plus the time the same requests take on a
+// weak farm link (RTT plus bytes at the link rate; TCP slow start left out, which
+// only flatters the larger transfer).
+#define PROGMEM
+#include "dashboard_asset.h"
+#include "host_test.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static std::string g_rawHtml;         // web/index.html as the old handler sent it
+static std::atomic<bool> g_oldHandler{false};
+
+static std::string headerValue(const std::string &req, const char *name) {
+  const size_t at = req.find(std::string("\r\n") + name + ": ");
+  if (at == std::string::npos) return "";
+  const size_t from = at + 4 + strlen(name);
+  return req.substr(from, req.find("\r\n", from) - from);
+}
+
+// The WebServer library's framing: status line, our headers, Content-Length, body.
+static std::string response(const std::string &req) {
+  std::string path = req.substr(4, req.find(' ', 4) - 4);
+  if (g_oldHandler) {
+    return "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: " + std::to_string(g_rawHtml.size()) +
+           "\r\nConnection: keep-alive\r\n\r\n" + g_rawHtml;
+  }
+  const size_t q = path.find("?v=");
+  const std::string v = q == std::string::npos ? "" : path.substr(q + 3);
+  const DashboardReply r = dashboardReply(v.c_str(), headerValue(req, "If-None-Match").c_str());
+  if (r.code == 302) {
+    return "HTTP/1.1 302 Found\r\nLocation: " DASHBOARD_URL "\r\nCache-Control: no-cache\r\n"
+           "Content-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+  }
+  std::string h = std::string("HTTP/1.1 ") + (r.code == 304 ? "304 Not Modified" : "200 OK") +
+                  "\r\nETag: " INDEX_HTML_ETAG "\r\nCache-Control: " DASHBOARD_CACHE_CONTROL "\r\n";
+  if (r.code == 304) return h + "Content-Length: 0\r\nConnection: keep-alive\r\n\r\n";
+  return h + "Content-Encoding: gzip\r\nContent-Type: text/html\r\nContent-Length: " + std::to_string(r.len) +
+         "\r\nConnection: keep-alive\r\n\r\n" + std::string((const char*)r.body, r.len);
+}
+
+static void serve(int listenFd) {
+  for (;;) {
+    const int fd = accept(listenFd, nullptr, nullptr);
+    if (fd < 0) return;
+    std::string buf;
+    char chunk[2048];
+    ssize_t n;
+    while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+      buf.append(chunk, (size_t)n);
+      size_t end;
+      while ((end = buf.find("\r\n\r\n")) != std::string::npos) {
+        const std::string resp = response(buf.substr(0, end + 4));
+        buf.erase(0, end + 4);
+        send(fd, resp.data(), resp.size(), MSG_NOSIGNAL);
+      }
+    }
+    close(fd);
+  }
+}
+
+struct Visit {
+  int    requests = 0, lastCode = 0;
+  size_t bytesUp = 0, bytesDown = 0, bodyBytes = 0;
+  uint64_t ns = 0;
+};
+
+// One request on the visit's keep-alive connection; reads exactly one response.
+static void request(int fd, const std::string &path, const char *ifNoneMatch, Visit &v) {
+  std::string req = "GET " + path + " HTTP/1.1\r\nHost: tank\r\nAccept-Encoding: gzip, deflate\r\n";
+  if (ifNoneMatch) req += std::string("If-None-Match: ") + ifNoneMatch + "\r\n";
+  req += "\r\n";
+  send(fd, req.data(), req.size(), MSG_NOSIGNAL);
+  std::string buf;
+  char chunk[8192];
+  size_t want = 0;
+  while (!want || buf.size() < want) {
+    const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) break;
+    buf.append(chunk, (size_t)n);
+    const size_t end = buf.find("\r\n\r\n");
+    if (!want && end != std::string::npos) want = end + 4 + atoi(headerValue(buf, "Content-Length").c_str());
+  }
+  v.requests++;
+  v.lastCode = atoi(buf.c_str() + 9);
+  v.bytesUp += req.size();
+  v.bytesDown += buf.size();
+  v.bodyBytes += want ? buf.size() - (buf.find("\r\n\r\n") + 4) : 0;
+}
+
+static uint16_t g_port;
+
+static int dial() {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a{};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(g_port);
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  connect(fd, (sockaddr*)&a, sizeof(a));
+  return fd;
+}
+
+enum Kind { FIRST_VISIT, CACHED_VISIT, RELOAD };
+
+// What the browser sends for each kind of visit. The old page had no validators, so
+// every visit is the same full download.
+static Visit visit(Kind k) {
+  Visit v;
+  const int fd = dial();
+  const uint64_t t0 = nowNs();
+  if (g_oldHandler) request(fd, "/", nullptr, v);
+  else if (k == FIRST_VISIT) { request(fd, "/", nullptr, v); request(fd, DASHBOARD_URL, nullptr, v); }
+  else if (k == CACHED_VISIT) request(fd, "/", nullptr, v);          // the immutable page comes from cache
+  else request(fd, DASHBOARD_URL, INDEX_HTML_ETAG, v);
+  v.ns = nowNs() - t0;
+  close(fd);
+  return v;
+}
+
+static void testReplies() {
+  CHECK_EQ(dashboardReply("", "").code, 302);
+  CHECK_EQ(dashboardReply("0123456789abcdef", "").code, 302);                   // stale hash
+  CHECK_EQ(dashboardReply(INDEX_HTML_HASH, "").code, 200);
+  CHECK_EQ(dashboardReply(INDEX_HTML_HASH, INDEX_HTML_ETAG).code, 304);
+  CHECK_EQ(dashboardReply(INDEX_HTML_HASH, "\"0123456789abcdef\"").code, 200);
+  CHECK_EQ(dashboardReply(INDEX_HTML_HASH, "W/" INDEX_HTML_ETAG).code, 200);    // strong match only
+  CHECK_EQ(dashboardReply("", INDEX_HTML_ETAG).code, 302);
+
+  // The body is a gzip member whose trailer size is the minified page.
+  const DashboardReply r = dashboardReply(INDEX_HTML_HASH, "");
+  CHECK(r.len == INDEX_HTML_GZ_LEN && r.len > 18);
+  CHECK(r.body[0] == 0x1f && r.body[1] == 0x8b && r.body[2] == 8);
+  const uint8_t *t = r.body + r.len - 4;
+  const uint32_t isize = t[0] | t[1] << 8 | t[2] << 16 | (uint32_t)t[3] << 24;
+  CHECK(isize > r.len && isize <= g_rawHtml.size());
+  CHECK_EQ(strlen(INDEX_HTML_HASH), 16);
+}
+
+int main(int argc, char **argv) {
+  FILE *f = fopen("../../webserver_mcu/web/index.html", "rb");
+  CHECK(f != nullptr);
+  if (!f) return testResult("dashboard_asset");
+  char b[4096];
+  size_t n;
+  while ((n = fread(b, 1, sizeof(b), f)) > 0) g_rawHtml.append(b, n);
+  fclose(f);
+  testReplies();
+
+  const int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in a{};
+  a.sin_family = AF_INET;
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t alen = sizeof(a);
+  CHECK(bind(listenFd, (sockaddr*)&a, sizeof(a)) == 0);
+  CHECK(listen(listenFd, 4) == 0);
+  getsockname(listenFd, (sockaddr*)&a, &alen);
+  g_port = ntohs(a.sin_port);
+  std::thread server(serve, listenFd);
+
+  const Kind kinds[] = { FIRST_VISIT, CACHED_VISIT, RELOAD };
+  const char *names[] = { "first visit", "cached visit", "reload" };
+  const int reps = benchEnabled(argc, argv) ? 200 : 3;
+  Visit now[3], old[3];
+  for (int k = 0; k < 3; k++) {
+    for (int r = 0; r < reps; r++) {
+      g_oldHandler = false;
+      const Visit vn = visit(kinds[k]);
+      g_oldHandler = true;
+      const Visit vo = visit(kinds[k]);
+      if (r == 0 || vn.ns < now[k].ns) now[k] = vn;     // best of reps: loopback noise
+      if (r == 0 || vo.ns < old[k].ns) old[k] = vo;
+    }
+  }
+  shutdown(listenFd, SHUT_RDWR);
+  close(listenFd);
+  server.join();
+
+  CHECK_EQ(now[FIRST_VISIT].lastCode, 200);
+  CHECK_EQ(now[FIRST_VISIT].bodyBytes, INDEX_HTML_GZ_LEN);
+  CHECK_EQ(now[CACHED_VISIT].lastCode, 302);
+  CHECK_EQ(now[CACHED_VISIT].bodyBytes, 0);
+  CHECK_EQ(now[RELOAD].lastCode, 304);
+  CHECK_EQ(old[FIRST_VISIT].bodyBytes, g_rawHtml.size());
+  for (int k = 0; k < 3; k++) CHECK(now[k].bytesDown < old[k].bytesDown);
+
+  if (benchEnabled(argc, argv)) {
+    printf("\npage: raw %zu B (old body), gzip %zu B\n", g_rawHtml.size(), (size_t)INDEX_HTML_GZ_LEN);
+    printf("%-13s %22s %22s %16s %16s\n", "", "bytes down (old/new)", "requests (old/new)",
+           "loopback us", "ms at 250k/1M bit/s: old -> new");
+    for (int k = 0; k < 3; k++) {
+      // Weak link: one RTT for the connection, one per request, plus bytes at the rate.
+      auto link = [](const Visit &v, double bps) {
+        return (1 + v.requests) * 40.0 + (v.bytesUp + v.bytesDown) * 8 / bps * 1000;   // ms, 40 ms RTT
+      };
+      printf("%-13s %10zu / %-9zu %10d / %-9d %7.0f / %-6.0f %4.0f/%-4.0f -> %4.0f/%-4.0f\n",
+             names[k], old[k].bytesDown, now[k].bytesDown, old[k].requests, now[k].requests,
+             old[k].ns / 1e3, now[k].ns / 1e3, link(old[k], 250e3), link(old[k], 1e6),
+             link(now[k], 250e3), link(now[k], 1e6));
+    }
+  }
+  return testResult("dashboard_asset");
+}
@@ -0,0 +1,147 @@
+// test_history_ring.cpp — TankHistory (webserver_mcu/include/history_ring.h)
+// Round trips against a plain copy of what was appended: random gaps and distances
+// (including the varint edges), duplicates and out-of-order timestamps, eviction
+// once the ring wraps, and rings of several sizes. The benchmark feeds realistic
+// 120 s readings (a slow drain, refills, sensor jitter and the odd missed wake) to
+// report bytes per sample, how many days a 4 KB ring holds against a plain
+// {uint32 t, uint16 mm} array, and encode/decode throughput.
+#include "history_ring.h"
+#include "host_test.h"
+#include <deque>
+#include <random>
+#include <vector>
+
+struct Sample { uint32_t t; uint16_t mm; };
+
+// Everything the ring holds must decode to the newest `samples` reference entries.
+static bool matches(const TankHistory &h, const std::deque<Sample> &ref) {
+  if (h.samples > ref.size()) return false;
+  TankHistory::Cursor c = h.begin();
+  uint32_t t;
+  uint16_t mm;
+  size_t i = ref.size() - h.samples, n = 0;
+  while (c.next(t, mm)) {
+    if (i >= ref.size() || ref[i].t != t || ref[i].mm != mm) return false;
+    i++, n++;
+  }
+  return n == h.samples && i == ref.size() && (!h.samples || h.oldestT() == ref[ref.size() - h.samples].t);
+}
+
+static void testUnits() {
+  static uint8_t mem[64];
+  TankHistory h;
+  h.init(mem, sizeof(mem));
+  uint32_t t;
+  uint16_t mm;
+  TankHistory::Cursor c0 = h.begin();
+  CHECK(!c0.next(t, mm));
+  CHECK_EQ(h.oldestT(), 0);
+
+  std::deque<Sample> ref;
+  CHECK(h.append(1000, 1500)); ref.push_back({1000, 1500});
+  CHECK_EQ(h.used(), 2);                                  // dt 0, d 0
+  CHECK(!h.append(1000, 1400));                           // same second: duplicate
+  CHECK(!h.append(999, 1400));                            // older: ignored
+  CHECK(h.append(1120, 1490)); ref.push_back({1120, 1490});
+  CHECK_EQ(h.used(), 4);                                  // 120 s and -10 mm: one byte each
+  CHECK(h.append(1120 + 200000, 4500)); ref.push_back({1120 + 200000, 4500});   // 3-byte dt, 2-byte d
+  CHECK(matches(h, ref));
+
+  // Fill past the 64 bytes: the oldest go, what's left still decodes.
+  for (uint32_t i = 1; i <= 40; i++) {
+    const Sample s = { 201120 + i * 300, (uint16_t)(100 + i * 97) };
+    CHECK(h.append(s.t, s.mm));
+    ref.push_back(s);
+  }
+  CHECK(matches(h, ref));
+  CHECK(h.evicted > 0);
+  CHECK_EQ(h.samples + h.evicted, ref.size());
+  CHECK(h.used() <= sizeof(mem));
+
+  CHECK(h.append(0xFFFFFFF0u, 30)); ref.push_back({0xFFFFFFF0u, 30});           // 5-byte dt
+  CHECK(matches(h, ref));
+
+  h.reset();
+  CHECK_EQ(h.samples, 0);
+  CHECK(h.append(5, 0));
+  CHECK(h.append(6, 65535));                              // the full uint16 swing both ways
+  CHECK(h.append(7, 0));
+  ref = {{5, 0}, {6, 65535}, {7, 0}};
+  CHECK(matches(h, ref));
+}
+
+static void testRandom() {
+  std::mt19937 rng(10);
+  for (uint32_t bytes : {16u, 64u, 256u, 4096u}) {
+    std::vector<uint8_t> mem(bytes);
+    TankHistory h;
+    h.init(mem.data(), bytes);
+    std::deque<Sample> ref;
+    uint32_t t = rng() % 100000;
+    bool ok = true;
+    for (int i = 0; i < 20000; i++) {
+      const uint32_t r = rng() % 100;
+      const uint32_t dt = r < 70 ? 120 + rng() % 3 : r < 90 ? rng() % 5000 : r < 97 ? 0 : rng() % 3000000;
+      const uint16_t mm = r < 80 ? (uint16_t)(1500 + rng() % 20) : (uint16_t)rng();
+      t += dt;
+      const bool expectNew = ref.empty() || t > ref.back().t;
+      if (h.append(t, mm) != expectNew) ok = false;
+      if (expectNew) ref.push_back({t, mm});
+      if (ref.size() > 4096) ref.pop_front();
+      if (i % 97 == 0 && !matches(h, ref)) ok = false;
+    }
+    CHECK(ok);
+    CHECK(matches(h, ref));
+    CHECK(h.used() <= bytes);
+    CHECK(h.samples <= ref.size());
+  }
+}
+
+static void bench() {
+  std::mt19937 rng(11);
+  std::normal_distribution<float> jitter(0, 2.0f);
+  static uint8_t mem[HISTORY_RING_BYTES];
+  TankHistory h;
+  h.init(mem, sizeof(mem));
+  std::vector<Sample> feed;
+  uint32_t t = 1760000000;
+  float level = 600;                                      // mm from sensor to honey
+  for (int i = 0; i < 200000; i++) {
+    t += (rng() % 50 == 0) ? 240 : 120 + rng() % 2;       // the odd missed wake, RTC drift
+    level += (i % 2000 < 1900) ? 0.05f : -2.0f;           // slow drain, then a refill
+    if (level > 2500) level = 600;
+    feed.push_back({t, (uint16_t)(level + jitter(rng))});
+  }
+
+  uint64_t t0 = nowNs();
+  for (const Sample &s : feed) h.append(s.t, s.mm);
+  const double encNs = (double)(nowNs() - t0) / feed.size();
+  const double bytesPer = (double)h.used() / h.samples;
+  const double days = (double)(feed.back().t - h.oldestT()) / 86400;
+
+  const int reps = 200;
+  uint64_t t1 = nowNs();
+  uint32_t sum = 0, tt;
+  uint16_t mm;
+  for (int r = 0; r < reps; r++) {
+    TankHistory::Cursor c = h.begin();
+    while (c.next(tt, mm)) sum += mm;
+  }
+  g_sink = sum;
+  const double decNs = (double)(nowNs() - t1) / ((double)reps * h.samples);
+
+  printf("\n120 s readings with jitter, drift and refills, %u B ring:\n", (unsigned)sizeof(mem));
+  printf("%.2f B/sample, %u samples held = %.1f days (plain {uint32,uint16} array: %zu B/sample, %.1f days)\n",
+         bytesPer, (unsigned)h.samples, days, sizeof(Sample), sizeof(mem) / sizeof(Sample) * 120.0 / 86400);
+  printf("append %.1f ns/sample (with eviction), decode %.2f ns/sample = %.0f Msamples/s\n",
+         encNs, decNs, 1e3 / decNs);
+  CHECK(bytesPer < 3.0);
+  CHECK(days > 2.0);
+}
+
+int main(int argc, char **argv) {
+  testUnits();
+  testRandom();
+  if (benchEnabled(argc, argv)) bench();
+  return testResult("history_ring");
+}
@@ -0,0 +1,215 @@
+// test_metrics.cpp — /metrics output (webserver_mcu/include/metrics.h) streamed through
+// ChunkedOut (webserver_mcu/include/chunked_out.h) into a capturing sink. The body is
+// parsed back as Prometheus text format: every family's HELP and TYPE line whole and
+// in order, every sample line well formed, histogram buckets cumulative and ending in
+// +Inf with _count equal to it, and _sum the scaled total of what was observed.
+// ChunkedOut on its own: pieces that end exactly at, straddle, or exceed the 512-byte
+// buffer come out byte for byte. The benchmark reports observe() and a full render,
+// and how many lines the old 64-byte printf path would have cut.
+#include "chunked_out.h"
+#include "metrics.h"
+#include "host_test.h"
+#include <string>
+#include <vector>
+
+static std::string g_body;
+static std::vector<size_t> g_chunks;
+
+static void capture(const char *s, size_t n) {
+  g_body.append(s, n);
+  g_chunks.push_back(n);
+}
+
+static const uint32_t AGE_MS[] = {100, 1000, 10000};
+
+// The families the webserver registers, in shape: plain, labelled, vector, and help
+// strings long enough that "# HELP ...\n# TYPE ...\n" is well past 64 bytes.
+static Counter   cRx     ("honey_frames_received_total", "ESP-NOW frames accepted from sensors and the siren relay, all tanks");
+static Gauge     gHeap   ("honey_heap_free_bytes", "Free heap after the last loop() pass, sampled once a second");
+static Histogram hAge    ("honey_reading_age_seconds", "Age of each reading when it reached the webserver, sensor wake to queue pop",
+                          nullptr, AGE_MS, 3, 1e-3f);
+static Histogram hRoute0 ("honey_http_request_seconds", "HTTP handler time by route", "route=\"/api/state\"",
+                          METRICS_LATENCY_US, METRICS_LATENCY_N);
+static Histogram hRoute1 ("honey_http_request_seconds", "HTTP handler time by route", "route=\"/api/history\"",
+                          METRICS_LATENCY_US, METRICS_LATENCY_N);
+static MetricVec vLost   ("honey_packets_lost_total", "Sequence gaps per tank", "tank", METRIC_COUNTER_VEC);
+static uint32_t  lost[3];
+
+static std::vector<std::string> lines(const std::string &s) {
+  std::vector<std::string> out;
+  size_t at = 0, nl;
+  while ((nl = s.find('\n', at)) != std::string::npos) { out.push_back(s.substr(at, nl - at)); at = nl + 1; }
+  if (at < s.size()) out.push_back(s.substr(at));        // unterminated tail: a cut line
+  return out;
+}
+
+static bool startsWith(const std::string &s, const std::string &p) { return s.compare(0, p.size(), p) == 0; }
+
+static void testChunkedOut() {
+  g_body.clear(); g_chunks.clear();
+  std::string want;
+  {
+    ChunkedOut out(capture);
+    std::string a(500, 'a'), b(11, 'b'), c(40, 'c'), d(1500, 'd');
+    out.printf("%s", a.c_str()); want += a;
+    out.printf("%s", b.c_str()); want += b;                // 511 B: the buffer's last byte is the NUL
+    out.printf("%s", c.c_str()); want += c;                // straddles: flush, reformat whole
+    out.printf("%s|%d", d.c_str(), 7); want += d + "|7";   // bigger than the buffer: heap
+    out.write(a.data(), a.size()); want += a;
+    out.printf("%s", "");                                  // nothing
+    out.printf("x%u\n", 42u); want += "x42\n";
+    CHECK_EQ(out.heapPieces, 1);
+    CHECK_EQ(out.lostPieces, 0);
+    out.flush();
+  }
+  CHECK(g_body == want);
+  for (size_t n : g_chunks) CHECK(n > 0);
+  CHECK_EQ(g_chunks.size(), 4);                            // a+b | c | d on its own | a+x42
+}
+
+static void fill() {
+  vLost.bind(lost, 3);
+  cRx.inc(1234);
+  gHeap.set(-5);                                           // signed on purpose
+  lost[1] = 9;
+  const uint32_t ages[] = {50, 100, 101, 999, 5000, 10000, 10001, 90000};
+  for (uint32_t a : ages) hAge.observe(a);
+  for (uint32_t i = 0; i < 1000; i++) hRoute0.observe(i * 997 % 2000000);
+  hRoute1.observe(3000000);                                // past the last bound: +Inf only
+}
+
+static void testRender() {
+  fill();
+  g_body.clear(); g_chunks.clear();
+  {
+    ChunkedOut out(capture);
+    metricsRender(out);
+    out.flush();
+    CHECK_EQ(out.heapPieces, 0);
+  }
+  for (size_t n : g_chunks) CHECK(n <= 512);
+  CHECK(!g_body.empty() && g_body.back() == '\n');
+
+  const std::vector<std::string> ls = lines(g_body);
+  std::vector<std::string> families;
+  std::string family, type;
+  bool ok = true;
+  for (size_t i = 0; i < ls.size(); i++) {
+    const std::string &l = ls[i];
+    if (startsWith(l, "# HELP ")) {
+      const size_t sp = l.find(' ', 7);
+      family = l.substr(7, sp - 7);
+      const std::string help = l.substr(sp + 1);
+      for (const Metric *m = Metric::head(); m; m = m->next) if (family == m->name && help != m->help) ok = false;
+      if (i + 1 >= ls.size() || !startsWith(ls[i + 1], "# TYPE " + family + " ")) { ok = false; continue; }
+      type = ls[++i].substr(8 + family.size());
+      if (type != "counter" && type != "gauge" && type != "histogram") ok = false;
+      families.push_back(family);
+      continue;
+    }
+    // name{labels} value, the name in the current family.
+    const size_t sp = l.rfind(' ');
+    if (sp == std::string::npos || !startsWith(l, family)) { ok = false; continue; }
+    char *end;
+    strtod(l.c_str() + sp + 1, &end);
+    if (*end || end == l.c_str() + sp + 1) ok = false;
+    const std::string name = l.substr(0, l.find_first_of("{ "));
+    if (type == "histogram" ? name != family + "_bucket" && name != family + "_sum" && name != family + "_count"
+                            : name != family) ok = false;
+  }
+  CHECK(ok);
+  const std::vector<std::string> wantFamilies = {"honey_frames_received_total", "honey_heap_free_bytes",
+      "honey_reading_age_seconds", "honey_http_request_seconds", "honey_packets_lost_total"};
+  CHECK(families == wantFamilies);                         // each once, the shared name too
+
+  auto has = [&](const std::string &line) {
+    for (const std::string &l : ls) if (l == line) return true;
+    return false;
+  };
+  CHECK(has("honey_frames_received_total 1234"));
+  CHECK(has("honey_heap_free_bytes -5"));
+  CHECK(has("honey_packets_lost_total{tank=\"1\"} 9"));
+  CHECK(has("honey_reading_age_seconds_bucket{le=\"0.1\"} 2"));
+  CHECK(has("honey_reading_age_seconds_bucket{le=\"1\"} 4"));
+  CHECK(has("honey_reading_age_seconds_bucket{le=\"10\"} 6"));
+  CHECK(has("honey_reading_age_seconds_bucket{le=\"+Inf\"} 8"));
+  CHECK(has("honey_reading_age_seconds_sum 116.251"));
+  CHECK(has("honey_reading_age_seconds_count 8"));
+  CHECK(has("honey_http_request_seconds_bucket{route=\"/api/history\",le=\"1\"} 0"));
+  CHECK(has("honey_http_request_seconds_bucket{route=\"/api/history\",le=\"+Inf\"} 1"));
+  CHECK(has("honey_http_request_seconds_sum{route=\"/api/history\"} 3"));
+
+  // Buckets never decrease and end at _count.
+  unsigned long prev = 0, inf = 0;
+  bool cumulative = true;
+  for (const std::string &l : ls) {
+    if (!startsWith(l, "honey_http_request_seconds_bucket{route=\"/api/state\"")) continue;
+    const unsigned long v = strtoul(l.c_str() + l.rfind(' ') + 1, nullptr, 10);
+    if (v < prev) cumulative = false;
+    prev = inf = v;
+  }
+  CHECK(cumulative);
+  CHECK_EQ(inf, 1000);
+  CHECK(has("honey_http_request_seconds_count{route=\"/api/state\"} 1000"));
+  CHECK(std::atomic<uint32_t>::is_always_lock_free);
+}
+
+// The printf it replaced: everything through a 64-byte tmp, cut to 63.
+struct OldChunkedOut {
+  char buf[512];
+  size_t len = 0;
+  void printf(const char *fmt, ...) {
+    char tmp[64];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(tmp, sizeof(tmp), fmt, ap);
+    va_end(ap);
+    if (n <= 0) return;
+    if ((size_t)n >= sizeof(tmp)) n = sizeof(tmp) - 1;
+    if (len + n > sizeof(buf)) flush();
+    memcpy(buf + len, tmp, n);
+    len += n;
+  }
+  void flush() { if (len) capture(buf, len); len = 0; }
+};
+
+static void bench() {
+  const int n = 10000000;
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < n; i++) hRoute0.observe((uint32_t)i & 0xFFFFF);
+  const double obsNs = (double)(nowNs() - t0) / n;
+
+  const int reps = 20000;
+  size_t bytes = 0, chunks = 0;
+  uint64_t t1 = nowNs();
+  for (int r = 0; r < reps; r++) {
+    g_body.clear(); g_chunks.clear();
+    ChunkedOut out(capture);
+    metricsRender(out);
+    out.flush();
+    bytes = g_body.size(); chunks = g_chunks.size();
+  }
+  const double renderUs = (double)(nowNs() - t1) / reps / 1e3;
+
+  g_body.clear();
+  OldChunkedOut old;
+  metricsRender(old);
+  old.flush();
+  const size_t oldBytes = g_body.size();
+  const std::vector<std::string> ls = lines(g_body);
+  int badTypes = 0;
+  for (size_t i = 0; i < ls.size(); i++) {
+    if (startsWith(ls[i], "# HELP ") && (i + 1 >= ls.size() || !startsWith(ls[i + 1], "# TYPE "))) badTypes++;
+  }
+  printf("\nobserve(): %.1f ns; render of %zu families: %zu B in %zu chunks, %.1f us\n",
+         obsNs, (size_t)5, bytes, chunks, renderUs);
+  printf("old 64-byte printf: %zu B, %d of 5 HELP/TYPE pairs cut (TYPE line lost or merged)\n",
+         oldBytes, badTypes);
+}
+
+int main(int argc, char **argv) {
+  testChunkedOut();
+  testRender();
+  if (benchEnabled(argc, argv)) bench();
+  return testResult("metrics");
+}
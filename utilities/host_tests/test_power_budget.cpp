@@ -0,0 +1,261 @@
+// test_power_budget.cpp — the sensor's power budget and its wire block
+// (sensor_mcu/ and webserver_mcu/include/power_budget.h)
+// Units: PhaseClock and powerAddWake() rounding, powerEncode() -> powerDecode()
+// round trips, the 0xFFFF clamp on a phase's average, blocks with more phases than
+// PH_COUNT (extras skipped) and fewer (missing ones 0), rejection of wakes 0,
+// windowS 0, a wrong tag and short blocks, and powerMahPerDay() against a hand-worked
+// case. Then whole batch frames built as the sensor's buildBatch() does and read back
+// as onHistoryBatch() does: the block behind a full set of deltas is found, and not
+// when the deltas are truncated, more than the receiver keeps, or absent. Reported:
+// the block's size and the estimate for a cached-channel wake, a wake that rescans,
+// and one whose acks time out.
+#include "sensor_packet.h"
+#include "reading_history.h"
+#include "power_budget.h"
+#include "host_test.h"
+#include <math.h>
+#include <vector>
+
+static bool near(float a, float b, float eps) { return fabsf(a - b) <= eps; }
+
+static void testClock() {
+  PhaseClock c;
+  c.enter(PH_SAMPLE, 1500);                                  // boot took 1.5 ms
+  c.enter(PH_SAMPLE, 2000);                                  // same phase: no-op
+  c.enter(PH_SEND, 801500);
+  PowerBudget b{};
+  powerAddWake(b, c, 900000, 40, true);
+  CHECK_EQ(b.ms[PH_BOOT], 2);                                // 1500 us rounds to 2 ms
+  CHECK_EQ(b.ms[PH_SAMPLE], 800);
+  CHECK_EQ(b.ms[PH_SEND], 99);                               // 98.5 ms
+  CHECK_EQ(b.wakes, 1);
+  CHECK_EQ(b.txWakes, 1);
+  CHECK_EQ(b.startT, 40);
+  PhaseClock c2;
+  powerAddWake(b, c2, 400, 160, false);
+  CHECK_EQ(b.startT, 40);                                    // window start kept
+  CHECK_EQ(b.wakes, 2);
+  CHECK_EQ(b.txWakes, 1);
+  powerReset(b);
+  CHECK_EQ(b.wakes, 0);
+}
+
+static void testWire() {
+  PowerBudget b{};
+  uint8_t out[64];
+  CHECK_EQ(powerEncode(b, 100, out, sizeof(out)), 0);        // nothing to report
+  for (uint8_t i = 0; i < PH_COUNT; i++) b.ms[i] = 16u * (10 + 100 * i) + i;
+  b.ms[PH_SCAN] = 16u * 70000;                               // 70 s a wake: past 16 bits
+  b.wakes = 16;
+  b.txWakes = 5;
+  b.startT = 1000;
+  const size_t len = powerEncode(b, 1000 + 1920, out, sizeof(out));
+  CHECK_EQ(len, sizeof(PowerBlock) + 2 * PH_COUNT);
+  CHECK_EQ(powerEncode(b, 2920, out, len - 1), 0);           // no room
+  PowerReport r;
+  CHECK(powerDecode(out, len, r));
+  CHECK_EQ(r.wakes, 16);
+  CHECK_EQ(r.txWakes, 5);
+  CHECK_EQ(r.windowS, 1920);
+  bool ok = true;
+  for (uint8_t i = 0; i < PH_COUNT; i++) {
+    if (i != PH_SCAN && r.avgMs[i] != 10 + 100 * i) ok = false;   // the +i rounds away
+  }
+  CHECK(ok);
+  CHECK_EQ(r.avgMs[PH_SCAN], 0xFFFF);                        // clamped
+  CHECK(!powerDecode(out, len - 1, r));                      // last phase cut off
+  CHECK(!powerDecode(out, sizeof(PowerBlock) - 1, r));
+
+  // endT at or before the window's start: encodes windowS 0, which a receiver drops.
+  const size_t l0 = powerEncode(b, 1000, out, sizeof(out));
+  CHECK(l0 != 0);
+  CHECK(!powerDecode(out, l0, r));
+
+  PowerBlock h{POWER_BLOCK_TAG, PH_COUNT, 0, 0, 600};       // wakes 0
+  uint8_t raw[64] = {};
+  memcpy(raw, &h, sizeof(h));
+  CHECK(!powerDecode(raw, sizeof(h) + 2 * PH_COUNT, r));
+  h.wakes = 4;
+  memcpy(raw, &h, sizeof(h));
+  CHECK(powerDecode(raw, sizeof(h) + 2 * PH_COUNT, r));
+  raw[0] = 0xE2;                                             // not our tag
+  CHECK(!powerDecode(raw, sizeof(h) + 2 * PH_COUNT, r));
+
+  // A newer sensor with two more phases: the known ones are read, the rest skipped.
+  PowerBlock more{POWER_BLOCK_TAG, PH_COUNT + 2, 8, 8, 960};
+  memcpy(raw, &more, sizeof(more));
+  for (uint8_t i = 0; i < PH_COUNT + 2; i++) { const uint16_t v = (uint16_t)(7 + i); memcpy(raw + sizeof(more) + 2 * i, &v, 2); }
+  CHECK(powerDecode(raw, sizeof(more) + 2 * (PH_COUNT + 2), r));
+  CHECK_EQ(r.avgMs[0], 7);
+  CHECK_EQ(r.avgMs[PH_COUNT - 1], 7 + PH_COUNT - 1);
+  CHECK(!powerDecode(raw, sizeof(more) + 2 * (PH_COUNT + 1), r));   // its extras must be there too
+
+  // An older one with only five: the later phases read 0.
+  PowerBlock fewer{POWER_BLOCK_TAG, 5, 8, 8, 960};
+  memcpy(raw, &fewer, sizeof(fewer));
+  for (uint8_t i = 0; i < 5; i++) { const uint16_t v = 100; memcpy(raw + sizeof(fewer) + 2 * i, &v, 2); }
+  memset(raw + sizeof(fewer) + 10, 0xAB, 16);                // whatever follows isn't read
+  CHECK(powerDecode(raw, sizeof(fewer) + 10, r));
+  CHECK_EQ(r.avgMs[4], 100);
+  CHECK_EQ(r.avgMs[5], 0);
+  CHECK_EQ(r.avgMs[PH_COUNT - 1], 0);
+}
+
+static void testMah() {
+  // 720 wakes a day (one every 120 s): boot 100 ms at 30 mA, sample 1000 ms at 40 mA,
+  // radio 200 ms at 100 mA.
+  //   boot   100 / 3.6e6 h *  30 mA * 720 = 0.6 mAh
+  //   sample 1000 / 3.6e6 h * 40 mA * 720 = 8.0 mAh
+  //   radio  200 / 3.6e6 h * 100 mA * 720 = 4.0 mAh
+  //   sleep  (86400 - 1.3 s * 720) s * 0.010 mA / 3600 = 0.23740 mAh
+  PowerReport r{};
+  r.avgMs[PH_BOOT] = 100;
+  r.avgMs[PH_SAMPLE] = 1000;
+  r.avgMs[PH_RADIO] = 200;
+  r.wakes = 16;
+  r.windowS = 1920;
+  float per[PH_COUNT], sleep;
+  const float total = powerMahPerDay(r, per, &sleep);
+  CHECK(near(per[PH_BOOT], 0.6f, 1e-4f));
+  CHECK(near(per[PH_SAMPLE], 8.0f, 1e-4f));
+  CHECK(near(per[PH_RADIO], 4.0f, 1e-4f));
+  CHECK(near(per[PH_SEND], 0.0f, 1e-6f));
+  CHECK(near(sleep, 0.2374f, 1e-4f));
+  CHECK(near(total, 12.8374f, 1e-3f));
+  CHECK(near(powerMahPerDay(r, nullptr, nullptr), total, 1e-6f));
+
+  // Awake longer than the day has: no negative sleep.
+  r.avgMs[PH_SAMPLE] = 60000;
+  r.windowS = 16;                                            // one wake a second
+  powerMahPerDay(r, nullptr, &sleep);
+  CHECK_EQ(sleep, 0);
+}
+
+// ---- Whole batches, sensor to webserver ----
+// As the sensor's buildBatch(): header, the older readings' deltas, the block, crc8.
+static size_t buildBatch(const ReadingHistory &h, uint8_t count, const PowerBudget *p, uint8_t *out, size_t cap) {
+  HistoryHeader hd{};
+  hd.ver = 3;
+  hd.type = 0xB1;
+  hd.tank_id = 2;
+  hd.count = count;
+  hd.seq = 77;
+  hd.distance_mm = historyAt(h, 0).mm;
+  hd.flags = historyAt(h, 0).flags;
+  size_t deltas = 0;
+  if (!historyEncodeDeltas(h, count, out + sizeof(hd), cap - sizeof(hd) - 1, deltas)) return 0;
+  memcpy(out, &hd, sizeof(hd));
+  size_t len = sizeof(hd) + deltas;
+  if (p) len += powerEncode(*p, historyAt(h, 0).t_s, out + len, cap - len - 1);
+  out[len] = crc8(out, len);
+  return len + 1;
+}
+
+struct Received { PacketStatus st; uint8_t count, backfilled; bool truncated, power; PowerReport report; };
+
+// As onHistoryBatch(), with its MAX_BACKFILL of 32 unless told otherwise.
+static Received receive(const uint8_t *data, size_t len, uint8_t maxBackfill = 32) {
+  Received x{};
+  SensorReading r;
+  uint16_t next;
+  size_t hdrLen;
+  x.st = decodeHistoryHeader(data, (int)len, r, x.count, next, hdrLen);
+  if (x.st != PKT_OK) return x;
+  std::vector<HistoryDelta> bf(maxBackfill);
+  const uint8_t *payload = data + hdrLen;
+  const size_t plen = len - hdrLen - 1;
+  size_t trailer;
+  x.backfilled = historyDecodeDeltas(payload, plen, x.count, r.distance_mm, bf.data(), maxBackfill, x.truncated, trailer);
+  x.power = trailer < plen && powerDecode(payload + trailer, plen - trailer, x.report);
+  return x;
+}
+
+static void testBatch() {
+  ReadingHistory h{};
+  for (int i = 0; i < HISTORY_LEN; i++) historyPush(h, 1000 + 120 * i, (uint16_t)(800 - 3 * i), 0x01);
+  PowerBudget p{};
+  for (uint8_t i = 0; i < PH_COUNT; i++) p.ms[i] = 16u * (20 + 5 * i);
+  p.wakes = 16;
+  p.txWakes = 3;
+  p.startT = 1000;
+  uint8_t buf[256];
+
+  // A full set of deltas (HISTORY_LEN - 1) with the block behind them.
+  size_t len = buildBatch(h, HISTORY_LEN, &p, buf, sizeof(buf));
+  CHECK(isHistoryBatch(buf, (int)len));
+  Received x = receive(buf, len);
+  CHECK_EQ(x.st, PKT_OK);
+  CHECK_EQ(x.backfilled, HISTORY_LEN - 1);
+  CHECK(!x.truncated);
+  CHECK(x.power);
+  CHECK_EQ(x.report.wakes, 16);
+  CHECK_EQ(x.report.windowS, 120 * (HISTORY_LEN - 1));
+  CHECK_EQ(x.report.avgMs[PH_REPLY], 20 + 5 * PH_REPLY);
+
+  // Newest reading only: the block follows the header directly.
+  len = buildBatch(h, 1, &p, buf, sizeof(buf));
+  x = receive(buf, len);
+  CHECK_EQ(x.backfilled, 0);
+  CHECK(x.power);
+
+  // No block: nothing after the deltas.
+  len = buildBatch(h, HISTORY_LEN, nullptr, buf, sizeof(buf));
+  x = receive(buf, len);
+  CHECK_EQ(x.backfilled, HISTORY_LEN - 1);
+  CHECK(!x.power);
+
+  // The header promises more readings than were sent: the block's bytes are taken for
+  // deltas and run out, so it is not read as one.
+  len = buildBatch(h, 4, &p, buf, sizeof(buf));
+  buf[3] = 40;                                               // count
+  buf[len - 1] = crc8(buf, len - 1);
+  x = receive(buf, len);
+  CHECK(x.truncated);
+  CHECK(!x.power);
+
+  // A receiver keeping fewer than were sent can't tell where the deltas end.
+  len = buildBatch(h, HISTORY_LEN, &p, buf, sizeof(buf));
+  x = receive(buf, len, 8);
+  CHECK_EQ(x.backfilled, 8);
+  CHECK(!x.truncated);
+  CHECK(!x.power);
+
+  // A corrupted frame is dropped before any of this.
+  buf[sizeof(HistoryHeader) + 2] ^= 0x40;
+  CHECK_EQ(receive(buf, len).st, PKT_BAD_CRC);
+}
+
+static void report() {
+  // Average ms per wake by phase, wakes every 120 s.
+  struct Profile { const char *name; uint16_t ms[PH_COUNT]; };
+  const Profile profiles[] = {
+    { "cached channel", { 60, 900, 300, 90, 0, 15, 40, 5 } },
+    { "rescan every wake", { 60, 900, 300, 90, 1400, 15, 40, 5 } },
+    { "acks time out", { 60, 900, 300, 90, 0, 250, 300, 5 } },
+  };
+  printf("\npower block %zu B; mAh/day at 720 wakes/day:\n", sizeof(PowerBlock) + 2 * PH_COUNT);
+  printf("%-18s", "");
+  for (uint8_t i = 0; i < PH_COUNT; i++) printf(" %8s", POWER_PHASE_NAMES[i]);
+  printf(" %8s %9s\n", "sleep", "mAh/day");
+  for (const Profile &pf : profiles) {
+    PowerReport r{};
+    for (uint8_t i = 0; i < PH_COUNT; i++) r.avgMs[i] = pf.ms[i];
+    r.wakes = 16;
+    r.txWakes = 4;
+    r.windowS = 1920;
+    float per[PH_COUNT], sleep;
+    const float total = powerMahPerDay(r, per, &sleep);
+    printf("%-18s", pf.name);
+    for (uint8_t i = 0; i < PH_COUNT; i++) printf(" %8.2f", per[i]);
+    printf(" %8.2f %9.2f\n", sleep, total);
+  }
+}
+
+int main(int argc, char **argv) {
+  testClock();
+  testWire();
+  testMah();
+  testBatch();
+  if (benchEnabled(argc, argv)) report();
+  return testResult("power_budget");
+}
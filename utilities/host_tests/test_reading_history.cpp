@@ -0,0 +1,280 @@
+// test_reading_history.cpp — the sensor's reading history and the batch deltas
+// (sensor_mcu/ and webserver_mcu/include/reading_history.h)
+// Units: every send reason (first, retry, validity, change just past deltaMm in either
+// direction, entering, staying in and leaving near risk, heartbeat, backlog), the ring
+// wrapping at HISTORY_LEN, historyFillRate()'s window and minute floor, varint and
+// zigzag edges, historyEncodeDeltas() -> historyDecodeDeltas() round trips on random
+// histories with extreme ages and distances, every truncation of a payload, and
+// where a trailing block starts. The benchmark reports payload bytes per older
+// reading and encode/decode time for a full batch of realistic 120 s readings.
+#include "reading_history.h"
+#include "host_test.h"
+#include <random>
+#include <vector>
+
+static const SendPolicy POLICY = { 10, 100, 900 };
+
+static void testSendReasons() {
+  ReadingHistory h{};
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_NONE);         // nothing pushed yet
+  historyPush(h, 0, 500, 0x01);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_FIRST);
+  historyMarkSent(h);
+  CHECK_EQ(h.unsent, 0);
+  historyPush(h, 120, 505, 0x01);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_NONE);
+  historyMarkFailed(h);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_RETRY);
+  historyMarkSent(h);
+
+  historyPush(h, 240, 0, 0x00);                              // reading went invalid
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_VALIDITY);
+  historyMarkSent(h);
+  historyPush(h, 360, 0, 0x00);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_NONE);         // still invalid: no change
+  historyPush(h, 480, 505, 0x01);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_VALIDITY);
+  historyMarkSent(h);
+
+  historyPush(h, 600, 515, 0x01);                            // exactly deltaMm: not yet
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_NONE);
+  historyPush(h, 720, 516, 0x01);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_CHANGE);
+  historyPush(h, 720, 494, 0x01);                            // either direction
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_CHANGE);
+  historyMarkSent(h);
+
+  historyPush(h, 840, 100, 0x01);                            // entering near risk
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_NEAR_RISK);
+  historyMarkSent(h);
+  historyPush(h, 960, 100, 0x01);                            // unchanged, but near risk
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_NEAR_RISK);
+  historyMarkSent(h);
+  historyPush(h, 1080, 105, 0x01);                           // leaving it, under deltaMm
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_NEAR_RISK);
+  historyMarkSent(h);
+
+  historyPush(h, 1080 + 899, 105, 0x01);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_NONE);
+  historyPush(h, 1080 + 900, 105, 0x01);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_HEARTBEAT);
+  historyMarkSent(h);
+  CHECK_EQ(h.lastSentT, 1980);
+  CHECK_EQ(h.wakesSinceTx, 0);
+
+  // A full ring of unsent readings goes out before the oldest is overwritten.
+  for (int i = 1; i < HISTORY_LEN; i++) historyPush(h, 1980 + i, 105, 0x01);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_NONE);
+  historyPush(h, 1980 + HISTORY_LEN, 105, 0x01);
+  CHECK_EQ(h.unsent, HISTORY_LEN);
+  CHECK_EQ(historyShouldSend(h, POLICY), SEND_BACKLOG);
+  CHECK(strcmp(sendReasonName(SEND_BACKLOG), "backlog") == 0);
+}
+
+static void testRing() {
+  ReadingHistory h{};
+  for (int i = 0; i < HISTORY_LEN + 3; i++) historyPush(h, 100 * i, (uint16_t)(1000 + i), 0x01);
+  CHECK_EQ(h.count, HISTORY_LEN);
+  CHECK_EQ(h.unsent, HISTORY_LEN);
+  CHECK_EQ(h.head, 3);
+  CHECK_EQ(h.wakesSinceTx, HISTORY_LEN + 3);
+  CHECK_EQ(historyAt(h, 0).mm, 1000 + HISTORY_LEN + 2);
+  CHECK_EQ(historyAt(h, HISTORY_LEN - 1).mm, 1003);          // the first three are gone
+  bool ordered = true;
+  for (uint8_t k = 1; k < h.count; k++) ordered &= historyAt(h, k).t_s + 100 == historyAt(h, k - 1).t_s;
+  CHECK(ordered);
+}
+
+static void testFillRate() {
+  ReadingHistory h{};
+  float rate = 0;
+  CHECK(!historyFillRate(h, 3600, rate));
+  historyPush(h, 0, 900, 0x01);
+  historyPush(h, 59, 890, 0x01);
+  CHECK(!historyFillRate(h, 3600, rate));                    // under a minute apart
+  historyPush(h, 120, 0, 0x00);
+  CHECK(!historyFillRate(h, 3600, rate));                    // newest invalid
+  historyPush(h, 240, 780, 0x01);
+  CHECK(historyFillRate(h, 3600, rate));                     // 120 mm in 4 min, the invalid one skipped
+  CHECK(rate > 29.99f && rate < 30.01f);
+  CHECK(historyFillRate(h, 200, rate));                      // window reaches back to t=59 only
+  CHECK(rate > 36.45f && rate < 36.47f);                     // 110 mm in 181 s
+  historyPush(h, 360, 840, 0x01);                            // draining: negative
+  CHECK(historyFillRate(h, 130, rate));
+  CHECK(rate > -30.01f && rate < -29.99f);
+}
+
+static void testVarint() {
+  const uint32_t edges[] = { 0, 1, 127, 128, 16383, 16384, 2097151, 2097152, 268435455, 268435456, 0xFFFFFFFFu };
+  const size_t lens[]    = { 1, 1, 1,   2,   2,     3,     3,       4,       4,         5,         5 };
+  for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+    uint8_t b[8];
+    const size_t n = putVarint(b, sizeof(b), 0, edges[i]);
+    CHECK_EQ(n, lens[i]);
+    CHECK_EQ(putVarint(b, n - 1, 0, edges[i]), 0);           // one byte short
+    size_t pos = 0;
+    uint32_t v;
+    CHECK(getVarint(b, n, pos, v));
+    CHECK_EQ(v, edges[i]);
+    CHECK_EQ(pos, n);
+    pos = 0;
+    CHECK(!getVarint(b, n - 1, pos, v));                     // cut mid-varint
+  }
+  const uint8_t runaway[6] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x01 };
+  size_t pos = 0;
+  uint32_t v;
+  CHECK(!getVarint(runaway, sizeof(runaway), pos, v));       // more than five bytes
+
+  const int32_t z[] = { 0, -1, 1, -2, 65535, -65535, INT32_MAX, INT32_MIN };
+  const uint32_t zz[] = { 0, 1, 2, 3, 131070, 131069, 0xFFFFFFFEu, 0xFFFFFFFFu };
+  for (size_t i = 0; i < sizeof(z) / sizeof(z[0]); i++) {
+    CHECK_EQ(zigzag(z[i]), zz[i]);
+    CHECK_EQ(unzigzag(zz[i]), z[i]);
+  }
+}
+
+static void fill(ReadingHistory &h, int n, std::mt19937 &rng) {
+  h = ReadingHistory{};
+  const uint32_t ageEdges[] = { 0, 1, 127, 128, 16383, 16384, 0x0FFFFFFF };
+  const uint16_t mmEdges[]  = { 1, 0xFFFE, 0, 127, 128, 8191, 8192 };
+  uint32_t t = 0;
+  for (int i = 0; i < n; i++) {
+    t += rng() % 3 ? 60 + rng() % 900 : ageEdges[rng() % 7];
+    const uint16_t mm = rng() % 3 ? (uint16_t)(20 + rng() % 2000) : mmEdges[rng() % 7];
+    historyPush(h, t, mm, mm ? 0x01 : 0x00);
+  }
+}
+
+static void testRoundTrip() {
+  std::mt19937 rng(5);
+  bool ok = true;
+  for (int iter = 0; iter < 20000; iter++) {
+    ReadingHistory h;
+    fill(h, 1 + (int)(rng() % (HISTORY_LEN + 4)), rng);
+    const uint8_t count = h.count;
+    uint8_t buf[HISTORY_LEN * 8 + 8];
+    size_t len = 0;
+    if (!historyEncodeDeltas(h, count, buf, sizeof(buf), len)) { ok = false; continue; }
+    HistoryDelta out[HISTORY_LEN];
+    bool truncated;
+    size_t trailer;
+    const uint8_t n = historyDecodeDeltas(buf, len, count, historyAt(h, 0).mm, out, HISTORY_LEN, truncated, trailer);
+    if (n != count - 1 || truncated || trailer != len) ok = false;
+    for (uint8_t k = 0; k < n; k++) {
+      const HistoryEntry &e = historyAt(h, k + 1);
+      if (out[k].ageS != historyAt(h, 0).t_s - e.t_s || out[k].mm != e.mm) ok = false;
+    }
+  }
+  CHECK(ok);
+
+  // The extremes on their own: 0 -> 0xFFFE -> 1 mm, and a 5-byte age.
+  ReadingHistory h{};
+  historyPush(h, 0, 1, 0x01);
+  historyPush(h, 0xFFFFFFF0u, 0xFFFE, 0x01);
+  historyPush(h, 0xFFFFFFF0u, 0, 0x00);
+  uint8_t buf[32];
+  size_t len = 0;
+  CHECK(historyEncodeDeltas(h, 3, buf, sizeof(buf), len));
+  CHECK_EQ(len, 1 + 3 + 5 + 3);                              // dt 0; +65534 mm; dt 0xFFFFFFF0; -65533 mm
+  CHECK(!historyEncodeDeltas(h, 3, buf, len - 1, len));      // cap one short
+  HistoryDelta out[4];
+  bool truncated;
+  size_t trailer;
+  CHECK_EQ(historyDecodeDeltas(buf, 12, 3, 0, out, 4, truncated, trailer), 2);
+  CHECK_EQ(out[0].ageS, 0);
+  CHECK_EQ(out[0].mm, 0xFFFE);
+  CHECK_EQ(out[1].ageS, 0xFFFFFFF0u);
+  CHECK_EQ(out[1].mm, 1);
+  CHECK(!truncated);
+
+  // count 1 or 0: no deltas, anything after the header is the trailer.
+  CHECK_EQ(historyDecodeDeltas(buf, 5, 1, 100, out, 4, truncated, trailer), 0);
+  CHECK(!truncated && trailer == 0);
+  CHECK_EQ(historyDecodeDeltas(buf, 5, 0, 100, out, 4, truncated, trailer), 0);
+  CHECK(!truncated && trailer == 0);
+}
+
+static void testTruncated() {
+  std::mt19937 rng(6);
+  ReadingHistory h;
+  fill(h, HISTORY_LEN, rng);
+  uint8_t buf[HISTORY_LEN * 8 + 8];
+  size_t len = 0;
+  CHECK(historyEncodeDeltas(h, HISTORY_LEN, buf, sizeof(buf), len));
+  // Where each pair ends, to know how many a prefix holds.
+  std::vector<size_t> ends;
+  for (size_t pos = 0; pos < len;) {
+    uint32_t v;
+    getVarint(buf, len, pos, v);
+    getVarint(buf, len, pos, v);
+    ends.push_back(pos);
+  }
+  CHECK_EQ(ends.size(), HISTORY_LEN - 1);
+  bool ok = true;
+  for (size_t cut = 0; cut < len; cut++) {
+    HistoryDelta out[HISTORY_LEN];
+    bool truncated;
+    size_t trailer;
+    const uint8_t n = historyDecodeDeltas(buf, cut, HISTORY_LEN, historyAt(h, 0).mm, out, HISTORY_LEN, truncated, trailer);
+    size_t whole = 0;
+    while (whole < ends.size() && ends[whole] <= cut) whole++;
+    if (n != whole || !truncated || trailer != cut) ok = false;
+    for (uint8_t k = 0; k < n; k++) if (out[k].mm != historyAt(h, k + 1).mm) ok = false;
+  }
+  CHECK(ok);
+
+  // A block after the deltas is found; a count the receiver can't hold hides it.
+  buf[len] = 0xE1;
+  buf[len + 1] = 0x08;
+  HistoryDelta out[HISTORY_LEN];
+  bool truncated;
+  size_t trailer;
+  CHECK_EQ(historyDecodeDeltas(buf, len + 2, HISTORY_LEN, historyAt(h, 0).mm, out, HISTORY_LEN, truncated, trailer),
+           HISTORY_LEN - 1);
+  CHECK_EQ(trailer, len);
+  CHECK_EQ(historyDecodeDeltas(buf, len + 2, HISTORY_LEN, historyAt(h, 0).mm, out, 4, truncated, trailer), 4);
+  CHECK(!truncated);
+  CHECK_EQ(trailer, len + 2);
+}
+
+static void bench() {
+  // Realistic: 120 s wakes, a slowly falling level with +-3 mm of noise.
+  std::mt19937 rng(7);
+  ReadingHistory h{};
+  uint16_t mm = 900;
+  for (int i = 0; i < HISTORY_LEN; i++) {
+    mm = (uint16_t)(mm - 2 + (int)(rng() % 7) - 3);
+    historyPush(h, 120u * i + rng() % 3, mm, 0x01);
+  }
+  uint8_t buf[HISTORY_LEN * 8];
+  size_t len = 0;
+  const int reps = 1000000;
+  uint64_t t0 = nowNs();
+  for (int i = 0; i < reps; i++) {
+    historyEncodeDeltas(h, HISTORY_LEN, buf, sizeof(buf), len);
+    g_sink = g_sink + buf[i % len];
+  }
+  const double encNs = (double)(nowNs() - t0) / reps;
+  HistoryDelta out[HISTORY_LEN];
+  bool truncated;
+  size_t trailer;
+  t0 = nowNs();
+  for (int i = 0; i < reps; i++) {
+    buf[0] = (uint8_t)(buf[0] & 0x7F);                       // keep the decode from being hoisted
+    g_sink = g_sink + historyDecodeDeltas(buf, len, HISTORY_LEN, mm, out, HISTORY_LEN, truncated, trailer);
+  }
+  const double decNs = (double)(nowNs() - t0) / reps;
+  printf("\n%d-reading batch at 120 s: %zu B of deltas (%.2f B per older reading, 6 B raw), encode %.0f ns, decode %.0f ns\n",
+         HISTORY_LEN, len, (double)len / (HISTORY_LEN - 1), encNs, decNs);
+}
+
+int main(int argc, char **argv) {
+  testSendReasons();
+  testRing();
+  testFillRate();
+  testVarint();
+  testRoundTrip();
+  testTruncated();
+  if (benchEnabled(argc, argv)) bench();
+  return testResult("reading_history");
+}
@@ -0,0 +1,170 @@
+// test_relay_frame.cpp — RelayFrame and RelayLink (siren_mcu/ and webserver_mcu/include/relay_frame.h)
+// SipHash-2-4 against the reference vectors, the frame round trip, tag rejection of
+// any flipped bit (boot nonce included) and of the wrong key, and the siren's replay
+// rules: duplicates inside the window, frames from the same boot any distance behind
+// it, frames from the last RELAY_BOOTS - 1 boots, lone frames from forgotten boots
+// that must not push those out, and a reboot that starts at relay_seq 1 again. The
+// simulation plays a webserver that reboots every few hours for a month while an
+// attacker replays frames captured at random earlier times. Reported: genuine relays
+// dropped, and replays accepted from the running boot, the few before it and older
+// ones.
+#include "relay_frame.h"
+#include "host_test.h"
+#include <random>
+#include <vector>
+
+static const uint8_t KEY[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+static SensorReading reading(uint16_t seq) {
+  SensorReading r{};
+  r.ver = 3;
+  r.tank_id = 2;
+  r.seq = seq;
+  r.boot = 0x1234;
+  r.distance_mm = 1500;
+  r.battery_mV = 3700;
+  return r;
+}
+
+static void testSipHash() {
+  // The reference implementation's vectors: key 00..0f, message 00..(n-1).
+  uint8_t m[64];
+  for (int i = 0; i < 64; i++) m[i] = (uint8_t)i;
+  CHECK(siphash24(KEY, m, 0) == 0x726fdb47dd0e0e31ULL);
+  CHECK(siphash24(KEY, m, 1) == 0x74f839c593dc67fdULL);
+  CHECK(siphash24(KEY, m, 8) == 0x93f5f5799a932462ULL);
+  CHECK(siphash24(KEY, m, 15) == 0xa129ca6149be45e5ULL);
+}
+
+static void testFrame() {
+  CHECK_EQ(sizeof(RelayFrame), 37);
+  const RelayFrame f = makeRelay(reading(9), 0xCAFEF00Du, 41, 70000, KEY);
+  CHECK_EQ(f.held_ms, 0xFFFF);                               // saturates
+  SensorReading r{};
+  uint32_t boot;
+  uint16_t seq, held;
+  CHECK(decodeRelay((const uint8_t *)&f, sizeof(f), KEY, r, boot, seq, held) == RELAY_OK);
+  CHECK(boot == 0xCAFEF00Du);
+  CHECK_EQ(seq, 41);
+  CHECK_EQ(r.seq, 9);
+  CHECK_EQ(r.boot, 0x1234);
+  CHECK_EQ(r.distance_mm, 1500);
+
+  bool ok = true;
+  for (size_t bit = 0; bit < sizeof(f) * 8; bit++) {
+    uint8_t b[sizeof(f)];
+    memcpy(b, &f, sizeof(f));
+    b[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+    const RelayStatus st = decodeRelay(b, sizeof(b), KEY, r, boot, seq, held);
+    if (bit < 16 ? st != RELAY_NOT_RELAY : st != RELAY_BAD_TAG) ok = false;
+  }
+  CHECK(ok);
+  uint8_t other[16];
+  memcpy(other, KEY, 16);
+  other[15] ^= 1;
+  CHECK(decodeRelay((const uint8_t *)&f, sizeof(f), other, r, boot, seq, held) == RELAY_BAD_TAG);
+  CHECK(decodeRelay((const uint8_t *)&f, sizeof(f) - 4, KEY, r, boot, seq, held) == RELAY_NOT_RELAY);
+  RelayFrame v1 = f;
+  v1.ver = 1;
+  CHECK(decodeRelay((const uint8_t *)&v1, sizeof(v1), KEY, r, boot, seq, held) == RELAY_NOT_RELAY);
+}
+
+static void testLink() {
+  RelayLink l;
+  CHECK(!l.synced());
+  CHECK(l.accept(1, 0xA) == SEQ_NEW);                        // first boot heard
+  CHECK(l.accept(2, 0xA) == SEQ_NEW);
+  CHECK(l.accept(2, 0xA) == SEQ_DUPLICATE);
+  for (uint16_t s = 3; s <= 100; s++) l.accept(s, 0xA);
+  CHECK(l.accept(5, 0xA) == SEQ_STALE);                      // far behind, same boot: a replay
+  CHECK(l.accept(60, 0xA) == SEQ_STALE);
+  CHECK_EQ(l.stale, 2);
+
+  // Reboot: relay_seq starts over and is taken at once.
+  CHECK(l.accept(1, 0xB) == SEQ_RESTART);
+  CHECK(l.accept(2, 0xB) == SEQ_NEW);
+  CHECK(l.currentBoot() == 0xB);
+  CHECK_EQ(l.current().newest, 2);
+  CHECK(l.accept(100, 0xA) == SEQ_DUPLICATE);                // the old boot's frames are still refused
+  CHECK(l.accept(40, 0xA) == SEQ_STALE);
+  CHECK(l.accept(3, 0xB) == SEQ_NEW);
+  CHECK(l.currentBoot() == 0xB);
+
+  // A lone frame from an unknown boot sits in probation and can't push out a known
+  // boot; a second new frame from it moves it in over the least recently heard one.
+  for (uint32_t b = 0xC; b < 0xC + RELAY_BOOTS - 3; b++) {
+    CHECK(l.accept(1, b) == SEQ_RESTART);
+    CHECK(l.accept(2, b) == SEQ_NEW);
+  }                                                          // 0xA, 0xB and 5 more: 7 kept
+  for (uint32_t b = 0x100; b < 0x110; b++) CHECK(l.accept(7, b) == SEQ_RESTART);   // lone replays
+  CHECK(l.accept(100, 0xA) == SEQ_DUPLICATE);                // still known
+  CHECK(l.accept(3, 0xB) == SEQ_DUPLICATE);
+  CHECK(l.accept(1, 0x200) == SEQ_RESTART);
+  CHECK(l.accept(2, 0x200) == SEQ_NEW);                      // moves in over 0xB: few frames, heard longest ago
+  CHECK(l.accept(100, 0xA) == SEQ_DUPLICATE);                // 0xA, with 100 frames, is kept
+  CHECK(l.accept(3, 0xB) == SEQ_RESTART);                    // forgotten: reads as a new boot
+  CHECK(l.accept(300, 0xB) == SEQ_NEW);                      // far ahead: stays in probation
+  CHECK(l.accept(1, 0x300) == SEQ_RESTART);                  // and is replaced
+  CHECK(l.accept(100, 0xA) == SEQ_DUPLICATE);
+  CHECK_EQ(l.boots, 2 + (RELAY_BOOTS - 3) + 16 + 3);
+  CHECK_EQ(l.received, 100 + 3 + 2 * (RELAY_BOOTS - 3) + 16 + 2 + 3);
+}
+
+// ---- A month of reboots and replays ----
+struct Captured { uint32_t boot; uint16_t seq; uint32_t bootIndex; };
+
+static void simulate(bool verbose) {
+  std::mt19937 rng(24);
+  RelayLink l;
+  std::vector<Captured> tape;                                // everything an eavesdropper recorded
+  std::vector<uint32_t> nonces;
+  uint32_t genuine = 0, genuineDropped = 0;
+  uint32_t tried[3] = {0}, taken[3] = {0};                   // replays by age: this boot, recent, forgotten
+  const uint32_t minutes = verbose ? 30 * 1440 : 3 * 1440;
+  uint32_t boot = 0, seq = 0, nextReboot = 0;
+  for (uint32_t m = 0; m < minutes; m++) {
+    if (m == nextReboot) {
+      do boot = rng(); while (!boot);
+      nonces.push_back(boot);
+      seq = 0;
+      nextReboot = m + 60 + rng() % (12 * 60);               // every 1..13 hours
+    }
+    // Three tanks every two minutes, some relays lost on the air.
+    for (int k = 0; k < 3 && m % 2 == 0; k++) {
+      ++seq;
+      if (rng() % 20 == 0) continue;                       // lost on the air
+      genuine++;
+      const SeqVerdict v = l.accept((uint16_t)seq, boot);
+      if (v == SEQ_DUPLICATE || v == SEQ_STALE) genuineDropped++;
+      // What the siren took is what a replay must not get past again. (A frame it
+      // never got, replayed later, is just a late delivery inside the window.)
+      tape.push_back({boot, (uint16_t)seq, (uint32_t)nonces.size() - 1});
+    }
+    // Every ten minutes or so, a frame replayed from anywhere in the recording.
+    if (rng() % 10 == 0 && !tape.empty()) {
+      const Captured &c = tape[rng() % tape.size()];
+      const uint32_t age = (uint32_t)nonces.size() - 1 - c.bootIndex;
+      const int bucket = age == 0 ? 0 : age < RELAY_BOOTS - 1 ? 1 : 2;
+      tried[bucket]++;
+      const SeqVerdict v = l.accept(c.seq, c.boot);
+      if (v != SEQ_DUPLICATE && v != SEQ_STALE) taken[bucket]++;
+    }
+  }
+  CHECK_EQ(genuineDropped, 0);
+  CHECK_EQ(taken[0], 0);                                     // never from the running boot
+  CHECK(taken[1] * 50 <= tried[1]);                          // rarely from the last few
+  if (verbose) {
+    printf("\n%u days, %zu webserver boots: %u genuine relays, %u dropped\n", minutes / 1440, nonces.size(),
+           genuine, genuineDropped);
+    printf("replays accepted: running boot %u/%u, previous %d boots %u/%u, older boots %u/%u\n",
+           taken[0], tried[0], RELAY_BOOTS - 2, taken[1], tried[1], taken[2], tried[2]);
+  }
+}
+
+int main(int argc, char **argv) {
+  testSipHash();
+  testFrame();
+  testLink();
+  simulate(benchEnabled(argc, argv));
+  return testResult("relay_frame");
+}
@@ -0,0 +1,198 @@
+// test_rollups.cpp — TankRollups / rollupForEach (webserver_mcu/include/rollups.h)
+// Every tier is checked against buckets recomputed from the raw readings (count,
+// min, max, sum, first, last), with some readings arriving late and some invalid,
+// and every query range against a filter over those buckets, inverted and
+// out-of-range ones included. The benchmark measures the per-reading update cost and
+// a week view answered from the hour tier against decoding and bucketing a week of
+// raw 120 s samples from a history ring.
+#include "rollups.h"
+#include "history_ring.h"
+#include "host_test.h"
+#include <map>
+#include <random>
+#include <vector>
+
+struct Ref { uint16_t count = 0, min = 0, max = 0, first = 0, last = 0; uint32_t sum = 0; };
+
+// What one tier should hold: rollupAdd()'s rules applied to a map instead of a ring.
+struct RefTier {
+  uint16_t n;
+  uint32_t width, newest = 0;
+  std::map<uint32_t, Ref> b;
+
+  void add(uint32_t t, uint16_t mm) {
+    const uint32_t id = t / width + 1;
+    if (newest >= n && id <= newest - n) return;
+    Ref &r = b[id];
+    if (!r.count) r = Ref{0, mm, mm, mm, mm, 0};
+    r.count++;
+    r.sum += mm;
+    if (mm < r.min) r.min = mm;
+    if (mm > r.max) r.max = mm;
+    r.last = mm;
+    if (id > newest) newest = id;
+  }
+  std::vector<uint32_t> ids(uint32_t from, uint32_t to) const {
+    std::vector<uint32_t> out;
+    for (const auto &kv : b) {
+      const uint32_t id = kv.first;
+      if (newest >= n && id <= newest - n) continue;    // fell out of the ring
+      const uint32_t start = (id - 1) * width, end = start + width - 1;
+      if (from <= to && end >= from && start <= to) out.push_back(id);
+    }
+    return out;
+  }
+};
+
+static bool sameTier(const RollupTier &tier, const RefTier &ref, uint32_t from, uint32_t to) {
+  std::vector<uint32_t> got;
+  bool ok = true;
+  rollupForEach(tier, from, to, [&](const RollupBucket &k) {
+    got.push_back(k.id);
+    auto it = ref.b.find(k.id);
+    if (it == ref.b.end()) { ok = false; return; }
+    const Ref &r = it->second;
+    if (k.count != r.count || k.min != r.min || k.max != r.max || k.sum != r.sum ||
+        k.first != r.first || k.last != r.last) ok = false;
+  });
+  return ok && got == ref.ids(from, to);
+}
+
+static void testUnits() {
+  static RollupBucket pool[4 + 3 + 2];
+  TankRollups r;
+  r.init(pool, 4, 3, 2);
+  const RollupTier &m = r.tiers[TIER_MINUTE];
+  int calls = 0;
+  auto count = [&](const RollupBucket &) { calls++; };
+
+  rollupForEach(m, 0, 0xFFFFFFFFu, count);
+  CHECK_EQ(calls, 0);                                      // empty tier
+
+  r.add(60, 1000);
+  r.add(61, 1200);
+  r.add(119, 800);
+  r.add(90, 0);                                            // invalid: not rolled up
+  calls = 0;
+  rollupForEach(m, 0, 0xFFFFFFFFu, [&](const RollupBucket &k) {
+    calls++;
+    CHECK_EQ(k.start(60), 60);
+    CHECK_EQ(k.count, 3);
+    CHECK_EQ(k.min, 800);
+    CHECK_EQ(k.max, 1200);
+    CHECK_EQ(k.avg(), 1000);
+    CHECK_EQ(k.first, 1000);
+    CHECK_EQ(k.last, 800);
+  });
+  CHECK_EQ(calls, 1);
+
+  // Inverted ranges return nothing, even ones that straddle data.
+  calls = 0;
+  rollupForEach(m, 119, 60, count);
+  rollupForEach(m, 0xFFFFFFFFu, 0, count);
+  rollupForEach(m, 61, 60, count);
+  CHECK_EQ(calls, 0);
+  rollupForEach(m, 119, 119, count);                       // a single second inside the bucket
+  CHECK_EQ(calls, 1);
+
+  // Past the ring: four minutes later the first minute is gone, and late readings
+  // for it are ignored instead of landing in a reused slot.
+  r.add(300, 500);
+  r.add(70, 999);
+  calls = 0;
+  rollupForEach(m, 0, 0xFFFFFFFFu, count);
+  CHECK_EQ(calls, 1);
+  rollupForEach(m, 0, 239, count);                         // entirely before what's kept
+  CHECK_EQ(calls, 1);
+  rollupForEach(m, 360, 0xFFFFFFFFu, count);               // entirely after the newest
+  CHECK_EQ(calls, 1);
+}
+
+static void testRandom() {
+  std::mt19937 rng(12);
+  static RollupBucket pool[ROLLUP_MINUTES + ROLLUP_HOURS + ROLLUP_DAYS];
+  TankRollups r;
+  r.init(pool, ROLLUP_MINUTES, ROLLUP_HOURS, ROLLUP_DAYS);
+  RefTier ref[TIER_COUNT] = { {ROLLUP_MINUTES, 60, 0, {}}, {ROLLUP_HOURS, 3600, 0, {}}, {ROLLUP_DAYS, 86400, 0, {}} };
+  uint32_t t = 1000;
+  bool ok = true;
+  for (int i = 0; i < 100000; i++) {
+    t += 30 + rng() % 180;
+    uint32_t at = t;
+    if (rng() % 10 == 0) at = t > 7200 ? t - rng() % 7200 : t;   // late, up to two hours
+    const uint16_t mm = rng() % 20 == 0 ? 0 : (uint16_t)(30 + rng() % 4470);
+    r.add(at, mm);
+    if (mm) for (RefTier &x : ref) x.add(at, mm);
+    if (i % 1000 == 999) {
+      for (int k = 0; k < TIER_COUNT; k++) {
+        const uint32_t a = rng() % (t + 1), b = rng() % (t + 1);
+        if (!sameTier(r.tiers[k], ref[k], a, b)) ok = false;          // inverted half the time
+        if (!sameTier(r.tiers[k], ref[k], 0, 0xFFFFFFFFu)) ok = false;
+      }
+    }
+  }
+  CHECK(ok);
+}
+
+static void bench() {
+  std::mt19937 rng(13);
+  static RollupBucket pool[ROLLUP_MINUTES + ROLLUP_HOURS + ROLLUP_DAYS];
+  TankRollups r;
+  r.init(pool, ROLLUP_MINUTES, ROLLUP_HOURS, ROLLUP_DAYS);
+  static uint8_t ring[16384];                              // a week of 120 s raw samples fits
+  TankHistory h;
+  h.init(ring, sizeof(ring));
+  const int N = 7 * 720;
+  std::vector<uint16_t> mm(N);
+  for (int i = 0; i < N; i++) mm[i] = (uint16_t)(1500 + rng() % 40);
+
+  const int reps = 2000;
+  uint64_t t0 = nowNs();
+  for (int rep = 0; rep < reps; rep++) {
+    r.init(pool, ROLLUP_MINUTES, ROLLUP_HOURS, ROLLUP_DAYS);
+    for (int i = 0; i < N; i++) r.add((uint32_t)(i * 120), mm[i]);
+  }
+  const double addNs = (double)(nowNs() - t0) / ((double)reps * N);
+  for (int i = 0; i < N; i++) h.append((uint32_t)(i * 120), mm[i]);
+  CHECK_EQ(h.samples, N);
+
+  // Week view, one point per hour.
+  const uint32_t to = (uint32_t)(N * 120);
+  uint64_t t1 = nowNs();
+  uint32_t points = 0;
+  for (int rep = 0; rep < reps; rep++) {
+    rollupForEach(r.tiers[TIER_HOUR], 0, to, [&](const RollupBucket &k) { points++; g_sink = k.avg(); });
+  }
+  const double rollNs = (double)(nowNs() - t1) / reps;
+
+  uint64_t t2 = nowNs();
+  uint32_t rawPoints = 0;
+  for (int rep = 0; rep < reps; rep++) {
+    TankHistory::Cursor c = h.begin();
+    uint32_t t, bucket = 0xFFFFFFFFu, sum = 0, n = 0, lo = 0xFFFF, hi = 0;
+    uint16_t v;
+    while (c.next(t, v)) {
+      if (t / 3600 != bucket) {
+        if (n) { rawPoints++; g_sink = sum / n + lo + hi; }
+        bucket = t / 3600; sum = n = 0; lo = 0xFFFF; hi = 0;
+      }
+      sum += v; n++;
+      if (v < lo) lo = v;
+      if (v > hi) hi = v;
+    }
+    if (n) rawPoints++;
+  }
+  const double rawNs = (double)(nowNs() - t2) / reps;
+  CHECK_EQ(points, rawPoints);
+
+  printf("\nupdate: %.1f ns per reading (3 tiers); pool %zu B per tank\n", addNs, sizeof(pool));
+  printf("week view at 1 h: %u buckets from the hour tier %.0f ns, raw decode of %d samples %.0f ns (%.0fx)\n",
+         points / reps, rollNs, N, rawNs, rawNs / rollNs);
+}
+
+int main(int argc, char **argv) {
+  testUnits();
+  testRandom();
+  if (benchEnabled(argc, argv)) bench();
+  return testResult("rollups");
+}
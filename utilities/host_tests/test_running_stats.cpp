@@ -0,0 +1,129 @@
+// test_running_stats.cpp — RunningStats (sensor_mcu/include/running_stats.h)
+// Checks min/median/max/percentiles against a sorted copy for random windows, then
+// benchmarks the sampling window both ways for 10..1000 samples: the old path
+// (float samples[], copied and selection-sorted once the window closes) against
+// inserting each reading into RunningStats as it arrives. "after window" is the work
+// left once the last frame is in; that is what keeps the radio waiting.
+#define RUNNING_STATS_CAP 1000
+#include "running_stats.h"
+#include "host_test.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// ---- The old sensor path, as it was before RunningStats ----
+static void sortSmall(float *arr, int n) {
+  for (int i = 0; i < n - 1; ++i) {
+    int m = i;
+    for (int j = i + 1; j < n; ++j) if (arr[j] < arr[m]) m = j;
+    if (m != i) { float t = arr[i]; arr[i] = arr[m]; arr[m] = t; }
+  }
+}
+static float computeMedian(const float *arr, int n, float *tmp) {
+  for (int i = 0; i < n; ++i) tmp[i] = arr[i];
+  sortSmall(tmp, n);
+  return (n & 1) ? tmp[n / 2] : 0.5f * (tmp[n / 2 - 1] + tmp[n / 2]);
+}
+
+static RunningStats stats;
+
+static void checkAgainstSort(std::mt19937 &rng, int n, uint16_t lo, uint16_t hi) {
+  std::uniform_int_distribution<int> mm(lo, hi);
+  std::vector<uint16_t> ref;
+  stats.reset();
+  for (int i = 0; i < n; i++) {
+    const uint16_t v = (uint16_t)mm(rng);
+    ref.push_back(v);
+    CHECK(stats.add(v));
+  }
+  std::sort(ref.begin(), ref.end());
+  CHECK_EQ(stats.n, n);
+  CHECK_EQ(stats.minimum(), ref.front());
+  CHECK_EQ(stats.maximum(), ref.back());
+  const uint16_t med = (n & 1) ? ref[n / 2] : (uint16_t)((ref[n / 2 - 1] + ref[n / 2] + 1) / 2);
+  CHECK_EQ(stats.median(), med);
+  for (int pct : {1, 10, 50, 90, 100}) {
+    int rank = (pct * n + 99) / 100;
+    if (rank < 1) rank = 1;
+    CHECK_EQ(stats.percentile((uint8_t)pct), ref[rank - 1]);
+  }
+  CHECK(std::is_sorted(stats.mm, stats.mm + stats.n));
+}
+
+static void testOrderStatistics() {
+  std::mt19937 rng(1);
+  for (int n = 1; n <= 120; n++) checkAgainstSort(rng, n, 30, 4500);
+  for (int n : {2, 15, 64, 999, 1000}) checkAgainstSort(rng, n, 1000, 1003);   // many ties
+
+  stats.reset();
+  CHECK_EQ(stats.median(), 0);
+  CHECK_EQ(stats.percentile(50), 0);
+  for (int i = 0; i < RUNNING_STATS_CAP; i++) stats.add(500);
+  CHECK(stats.full());
+  CHECK(!stats.add(500));
+}
+
+// medianBand() narrows as agreeing readings pile up; converged() also needs the
+// minimum count.
+static void testConvergence() {
+  stats.reset();
+  for (int i = 0; i < 14; i++) stats.add((uint16_t)(1200 + (i % 3)));
+  CHECK(stats.medianBand() <= 2);
+  CHECK(!stats.converged(15, 5));
+  stats.add(1201);
+  CHECK(stats.converged(15, 5));
+
+  stats.reset();
+  for (int i = 0; i < 40; i++) stats.add((uint16_t)(1000 + (i % 2) * 300));   // two clusters
+  CHECK(stats.medianBand() >= 300);
+  CHECK(!stats.converged(15, 5));
+
+  stats.reset();
+  stats.add(1000);
+  CHECK_EQ(stats.medianBand(), 0xFFFF);
+}
+
+static void bench() {
+  printf("\n%6s  %14s %14s  %14s %14s  %10s %10s\n", "n", "old total ns", "new total ns",
+         "old after ns", "new after ns", "old RAM B", "new RAM B");
+  std::mt19937 rng(7);
+  std::normal_distribution<float> noise(0.0f, 4.0f);
+  static float samples[RUNNING_STATS_CAP], tmp[RUNNING_STATS_CAP];
+  static uint16_t raw[RUNNING_STATS_CAP];
+  for (int n : {10, 30, 100, 300, 1000}) {
+    const int reps = n <= 100 ? 20000 : n <= 300 ? 2000 : 200;
+    for (int i = 0; i < n; i++) raw[i] = (uint16_t)(1500 + noise(rng));
+
+    uint64_t oldAdd = 0, oldAfter = 0;
+    for (int r = 0; r < reps; r++) {
+      const uint64_t t0 = nowNs();
+      for (int i = 0; i < n; i++) samples[i] = raw[i] / 10.0f;
+      const uint64_t t1 = nowNs();
+      g_sink = (uint32_t)(computeMedian(samples, n, tmp) * 10);
+      oldAfter += nowNs() - t1;
+      oldAdd += t1 - t0;
+    }
+    uint64_t newAdd = 0, newAfter = 0;
+    for (int r = 0; r < reps; r++) {
+      const uint64_t t0 = nowNs();
+      stats.reset();
+      for (int i = 0; i < n; i++) stats.add(raw[i]);
+      const uint64_t t1 = nowNs();
+      g_sink = stats.median() + stats.percentile(90);
+      newAfter += nowNs() - t1;
+      newAdd += t1 - t0;
+    }
+    // RAM the sensor would need for a window of n: samples[] + tmp[] against mm[] + n.
+    printf("%6d  %14.0f %14.0f  %14.0f %14.0f  %10d %10d\n", n,
+           (double)(oldAdd + oldAfter) / reps, (double)(newAdd + newAfter) / reps,
+           (double)oldAfter / reps, (double)newAfter / reps,
+           (int)(2 * n * sizeof(float)), (int)(n * sizeof(uint16_t) + sizeof(uint16_t)));
+  }
+}
+
+int main(int argc, char **argv) {
+  testOrderStatistics();
+  testConvergence();
+  if (benchEnabled(argc, argv)) bench();
+  return testResult("running_stats");
+}
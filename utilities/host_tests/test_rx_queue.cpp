@@ -0,0 +1,160 @@
+// test_rx_queue.cpp — RxQueue (webserver_mcu/ and siren_mcu/include/rx_queue.h)
+// under two threads. The producer plays the ESP-NOW callback: bursts of frames whose
+// length, MAC, timestamp and every payload byte derive from a sequence number. The
+// consumer plays loop(), with pauses, and checks each frame it pops against its
+// number: a torn frame (half old, half new) would not match. Drops must be exactly
+// the gaps the consumer sees. The same threads then write the old way, straight into
+// a tank's fields while the other side reads them, to show what the queue replaced.
+// Callback time is push() as timed around each call.
+#include "rx_queue.h"
+#include "host_test.h"
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <vector>
+
+static RxQueue q;
+
+static int frameLen(uint32_t seq) { return 8 + (int)(seq % (RX_FRAME_MAX - 8 + 1)); }
+static uint8_t frameByte(uint32_t seq, int i) { return (uint8_t)(seq * 31u + (uint32_t)i * 7u); }
+
+static void makeFrame(uint32_t seq, uint8_t *mac, uint8_t *data) {
+  for (int i = 0; i < 6; i++) mac[i] = (uint8_t)(seq >> (i % 4 * 8)) ^ (uint8_t)i;
+  memcpy(data, &seq, 4);
+  for (int i = 4; i < frameLen(seq); i++) data[i] = frameByte(seq, i);
+}
+
+static bool intact(const RxFrame &f, uint32_t &seq) {
+  memcpy(&seq, f.data, 4);
+  if (f.len != frameLen(seq) || f.rxMs != seq) return false;
+  uint8_t mac[6], data[RX_FRAME_MAX];
+  makeFrame(seq, mac, data);
+  return memcmp(mac, f.mac, 6) == 0 && memcmp(data, f.data, f.len) == 0;
+}
+
+static void testSingleThread() {
+  uint8_t mac[6], data[RX_FRAME_MAX + 1];
+  CHECK(q.front() == nullptr);
+  for (uint32_t s = 0; s < RX_QUEUE_DEPTH; s++) { makeFrame(s, mac, data); CHECK(q.push(mac, data, frameLen(s), s)); }
+  makeFrame(99, mac, data);
+  CHECK(!q.push(mac, data, frameLen(99), 99));            // full
+  CHECK_EQ(q.dropped, 1);
+  CHECK_EQ(q.highWater, RX_QUEUE_DEPTH);
+  CHECK(!q.push(mac, data, RX_FRAME_MAX + 1, 0));
+  CHECK_EQ(q.oversize, 1);
+  for (uint32_t s = 0; s < RX_QUEUE_DEPTH; s++) {
+    const RxFrame *f = q.front();
+    uint32_t seq;
+    CHECK(f && intact(*f, seq) && seq == s);
+    q.pop();
+  }
+  CHECK(q.front() == nullptr);
+  CHECK_EQ(q.size(), 0);
+}
+
+struct StressResult { uint32_t attempted, consumed, torn, gaps, outOfOrder; std::vector<uint32_t> pushNs; };
+
+static StressResult stress(uint32_t frames) {
+  q.~RxQueue();
+  new (&q) RxQueue();
+  StressResult r{};
+  r.attempted = frames;
+  std::atomic<bool> done{false};
+  std::thread producer([&] {
+    uint8_t mac[6], data[RX_FRAME_MAX];
+    r.pushNs.reserve(frames);
+    for (uint32_t s = 0; s < frames; s++) {
+      makeFrame(s, mac, data);
+      const uint64_t t0 = nowNs();
+      q.push(mac, data, frameLen(s), s);
+      r.pushNs.push_back((uint32_t)(nowNs() - t0));
+      if (s % 32 == 31) std::this_thread::sleep_for(std::chrono::microseconds(100));   // bursts
+    }
+    done = true;
+  });
+  std::thread consumer([&] {
+    int64_t last = -1;
+    for (;;) {
+      const RxFrame *f = q.front();
+      if (!f) {
+        if (done && !q.front()) break;
+        std::this_thread::yield();
+        continue;
+      }
+      uint32_t seq;
+      if (!intact(*f, seq)) r.torn++;
+      else {
+        if ((int64_t)seq <= last) r.outOfOrder++;
+        else r.gaps += (uint32_t)(seq - last - 1);
+        last = seq;
+      }
+      r.consumed++;
+      q.pop();
+      if (r.consumed % 500 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));   // slow loop()
+    }
+    r.gaps += (uint32_t)(frames - 1 - last);               // dropped at the very end
+  });
+  producer.join();
+  consumer.join();
+  return r;
+}
+
+// ---- Before the queue: the callback wrote the tank's fields, loop() read them ----
+// Relaxed atomics per field keep this defined behaviour in C++; on the ESP32 the plain
+// float/uint32 stores were no safer as a set.
+struct OldTank { std::atomic<uint32_t> seq{0}, distanceX10{0}, lastRxMs{0}, battery{0}; };
+
+static uint32_t oldTornReads(uint32_t writes) {
+  OldTank t;
+  std::atomic<bool> done{false};
+  uint32_t torn = 0;
+  std::thread cb([&] {
+    for (uint32_t s = 1; s <= writes; s++) {
+      t.seq.store(s, std::memory_order_relaxed);
+      t.distanceX10.store(s * 3, std::memory_order_relaxed);
+      t.lastRxMs.store(s * 5, std::memory_order_relaxed);
+      t.battery.store(s * 7, std::memory_order_relaxed);
+    }
+    done = true;
+  });
+  std::thread loop([&] {
+    while (!done) {
+      const uint32_t s = t.seq.load(std::memory_order_relaxed);
+      const uint32_t d = t.distanceX10.load(std::memory_order_relaxed);
+      const uint32_t m = t.lastRxMs.load(std::memory_order_relaxed);
+      const uint32_t b = t.battery.load(std::memory_order_relaxed);
+      if (d != s * 3 || m != s * 5 || b != s * 7) torn++;
+    }
+  });
+  cb.join();
+  loop.join();
+  return torn;
+}
+
+int main(int argc, char **argv) {
+  const bool verbose = benchEnabled(argc, argv);
+  testSingleThread();
+
+  const uint32_t frames = verbose ? 500000 : 50000;
+  StressResult r = stress(frames);
+  CHECK_EQ(r.torn, 0);
+  CHECK_EQ(r.outOfOrder, 0);
+  CHECK_EQ(q.pushed + q.dropped, r.attempted);
+  CHECK_EQ(q.pushed, r.consumed);
+  CHECK_EQ(r.gaps, q.dropped);
+  CHECK(q.highWater <= RX_QUEUE_DEPTH);
+  CHECK_EQ(q.size(), 0);
+
+  if (verbose) {
+    std::vector<uint32_t> &ns = r.pushNs;
+    std::sort(ns.begin(), ns.end());
+    printf("\n%u frames (8..%d B) in bursts of 32: %u consumed, %u dropped (queue full), high water %u/%d, torn %u\n",
+           r.attempted, RX_FRAME_MAX, r.consumed, (unsigned)q.dropped, (unsigned)q.highWater, RX_QUEUE_DEPTH, r.torn);
+    printf("push() as the callback sees it: p50 %u ns, p99 %u ns, p99.99 %u ns\n",
+           ns[ns.size() / 2], ns[ns.size() * 99 / 100], ns[ns.size() * 9999 / 10000]);
+    const uint32_t torn = oldTornReads(20000000);
+    printf("old direct writes: %u torn reads of one tank's fields in 20M updates\n", torn);
+  }
+  return testResult("rx_queue");
+}
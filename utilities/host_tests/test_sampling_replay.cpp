@@ -0,0 +1,140 @@
+// test_sampling_replay.cpp — replays A02YYUW UART captures through the sensor's
+// sampling window (sampling_window.h) on a virtual clock
+// Each fixture is a list of "U <ms> <hex bytes>" lines: what one UART read returned
+// and when, as logged by a sensor built with -DUART_CAPTURE=1. The replay delivers
+// each chunk at its time and models the firmware loop (drain, poll, delay(10) when
+// nothing new). It checks how each window ends against the expectations below, that
+// the sample count and scan time travel in the packet, and prints the awake time
+// saved against the fixed 5 s window.
+//   ./test_sampling_replay                      # fixtures/*.uart with expectations
+//   ./test_sampling_replay my_capture.uart      # just report a new capture
+#include "sampling_window.h"
+#include "sensor_packet.h"
+#include "host_test.h"
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+struct Chunk { uint32_t ms; std::vector<uint8_t> bytes; };
+
+static bool loadCapture(const char *path, std::vector<Chunk> &out) {
+  FILE *f = fopen(path, "r");
+  if (!f) return false;
+  char line[1024];
+  while (fgets(line, sizeof(line), f)) {
+    if (line[0] != 'U' || line[1] != ' ') continue;
+    char *p = line + 2;
+    Chunk c;
+    c.ms = (uint32_t)strtoul(p, &p, 10);
+    for (;;) {
+      char *end;
+      const unsigned long b = strtoul(p, &end, 16);
+      if (end == p) break;
+      c.bytes.push_back((uint8_t)b);
+      p = end;
+    }
+    out.push_back(c);
+  }
+  fclose(f);
+  return true;
+}
+
+static const SamplingConfig ADAPTIVE = { 5000, true, 5, 15 };   // sensor defaults
+static const SamplingConfig FIXED    = { 5000, false, 5, 15 };  // -DSCAN_ADAPTIVE=0
+
+static SamplingWindow win;
+
+static void replay(const std::vector<Chunk> &cap, const SamplingConfig &cfg) {
+  uint32_t now = 0;
+  size_t next = 0;
+  win.begin(cfg, now);
+  for (;;) {
+    while (next < cap.size() && cap[next].ms <= now) {
+      win.parser.feed(cap[next].bytes.data(), cap[next].bytes.size());
+      next++;
+    }
+    const uint16_t before = win.stats.n;
+    if (win.poll(now)) break;
+    now += win.stats.n == before ? 10 : 1;
+  }
+}
+
+struct Expect {
+  const char *file;
+  uint8_t  end;
+  int      samplesMin, samplesMax;  // inclusive
+  uint16_t medianMm, medianTolMm;   // medianMm 0: no valid reading
+  uint32_t scanMsMax;               // the cap, plus one 10 ms poll step
+};
+
+static const Expect EXPECT[] = {
+  { "still_1500mm.uart",      WIN_CONVERGED, 15, 15, 1500, 1, 1700 },
+  { "ripple_800mm.uart",      WIN_TIMEOUT,   45, 52,  800, 4, 5010 },
+  { "line_noise_2200mm.uart", WIN_CONVERGED, 15, 15, 2200, 1, 2200 },
+  { "too_close.uart",         WIN_TIMEOUT,    0,  0,    0, 0, 5010 },
+  { "silent.uart",            WIN_TIMEOUT,    0,  0,    0, 0, 5010 },
+  { "foam_bimodal.uart",      WIN_TIMEOUT,   45, 52,  670, 35, 5010 },
+};
+
+static void report(const char *name) {
+  printf("%-24s end=%-9s samples=%3u scan=%4ums median=%4umm band=%5u frames=%u csum_err=%u out_of_range=%u skipped=%u\n",
+         name, windowEndName(win.end), win.stats.n, (unsigned)win.scanMs(), win.stats.median(),
+         win.stats.n >= 2 ? win.stats.medianBand() : 0, (unsigned)win.parser.goodFrames,
+         (unsigned)win.parser.checksumErrors, (unsigned)win.parser.outOfRange, (unsigned)win.parser.skippedBytes);
+}
+
+// What the sensor builds from the window has to survive the trip to the receivers.
+static void checkPacket() {
+  SensorReading r{};
+  r.ver = 3;
+  r.distance_mm = win.stats.median();
+  r.flags = (win.stats.n ? 0x01 : 0) | (win.earlyExit() ? 0x04 : 0);
+  r.samples = win.stats.n > 255 ? 255 : (uint8_t)win.stats.n;
+  r.scan_ms = (uint16_t)win.scanMs();
+  uint8_t buf[sizeof(SensorPacketV3)];
+  SensorReading back{};
+  CHECK(decodeSensorPacket(buf, (int)encodeSensorPacket(r, buf), back) == PKT_OK);
+  CHECK_EQ(back.samples, win.stats.n);
+  CHECK_EQ(back.scan_ms, win.scanMs());
+  CHECK_EQ((back.flags & 0x04) != 0, win.earlyExit());
+}
+
+int main(int argc, char **argv) {
+  bool custom = false;
+  for (int i = 1; i < argc; i++) {
+    if (argv[i][0] == '-') continue;
+    std::vector<Chunk> cap;
+    if (!loadCapture(argv[i], cap)) { fprintf(stderr, "can't read %s\n", argv[i]); return 2; }
+    replay(cap, ADAPTIVE);
+    report(argv[i]);
+    custom = true;
+  }
+  if (custom) return 0;
+
+  const bool verbose = benchEnabled(argc, argv);
+  uint32_t adaptiveMs = 0, fixedMs = 0;
+  for (const Expect &e : EXPECT) {
+    std::vector<Chunk> cap;
+    const std::string path = std::string("fixtures/") + e.file;
+    CHECK(loadCapture(path.c_str(), cap));
+
+    replay(cap, ADAPTIVE);
+    if (verbose) report(e.file);
+    CHECK_EQ(win.end, e.end);
+    CHECK(win.stats.n >= e.samplesMin && win.stats.n <= e.samplesMax);
+    CHECK(win.scanMs() <= e.scanMsMax);
+    if (e.medianMm) CHECK(abs((int)win.stats.median() - (int)e.medianMm) <= e.medianTolMm);
+    checkPacket();
+    adaptiveMs += win.scanMs();
+
+    replay(cap, FIXED);                  // same capture, fixed window: same answer, later
+    CHECK(win.end == WIN_TIMEOUT || win.end == WIN_FULL);
+    if (e.medianMm) CHECK(abs((int)win.stats.median() - (int)e.medianMm) <= e.medianTolMm);
+    fixedMs += win.scanMs();
+  }
+  if (verbose) {
+    printf("\nsampling time over all fixtures: adaptive %ums, fixed %ums (%.0f%% saved)\n",
+           (unsigned)adaptiveMs, (unsigned)fixedMs, 100.0 * (1.0 - (double)adaptiveMs / fixedMs));
+  }
+  return testResult("sampling_replay");
+}
@@ -0,0 +1,227 @@
+// test_sensor_packet.cpp — the sensor frames and LinkStats (sensor_packet.h, shared by
+// all three firmwares). Codec: v1/v2/v3 packets and v1/v2/v3 batch headers round trip,
+// a CRC or version error is caught, and single packets are never taken for batches
+// whatever their tank_id. LinkStats: duplicates, late arrivals, loss, the boot nonce
+// resetting the window, stale frames from the same boot, and the legacy (no nonce)
+// restart rules. The simulation runs sensors that power-cycle now and then through
+// the old window (seq only) and the new one, and counts new readings dropped as
+// duplicates and phantom losses. A power-up that draws the previous nonce again (1 in
+// 65535) is the one case the new window can still be fooled by.
+#include "sensor_packet.h"
+#include "host_test.h"
+#include <random>
+#include <vector>
+
+static SensorReading sample(uint8_t ver, uint16_t seq, uint16_t boot) {
+  return SensorReading{ver, 7, seq, boot, 1234, 3700, 0x05, 21, 640, 35, 120};
+}
+
+static bool same(const SensorReading &a, const SensorReading &b) {
+  return a.ver == b.ver && a.tank_id == b.tank_id && a.seq == b.seq && a.boot == b.boot &&
+         a.distance_mm == b.distance_mm && a.battery_mV == b.battery_mV && a.flags == b.flags &&
+         a.samples == b.samples && a.scan_ms == b.scan_ms && a.age_ms == b.age_ms && a.interval_s == b.interval_s;
+}
+
+static void testCodec() {
+  CHECK_EQ(sizeof(SensorPacketV1), 8);
+  CHECK_EQ(sizeof(SensorPacketV2), 17);
+  CHECK_EQ(sizeof(SensorPacketV3), 19);
+  CHECK_EQ(sizeof(HistoryHeader), 22);
+  CHECK_EQ(sizeof(HistoryHeaderV2), 20);
+
+  uint8_t buf[64];
+  SensorReading r = sample(3, 4242, 0xBEEF), back{};
+  const size_t n = encodeSensorPacket(r, buf);
+  CHECK_EQ(n, sizeof(SensorPacketV3));
+  CHECK(decodeSensorPacket(buf, (int)n, back) == PKT_OK && same(r, back));
+  CHECK(!isHistoryBatch(buf, (int)n));
+  buf[5] ^= 1;
+  CHECK(decodeSensorPacket(buf, (int)n, back) == PKT_BAD_CRC);
+  buf[5] ^= 1;
+  buf[0] = 4;
+  buf[n - 1] = crc8(buf, n - 1);
+  CHECK(decodeSensorPacket(buf, (int)n, back) == PKT_BAD_VERSION);
+  CHECK(decodeSensorPacket(buf, 18, back) == PKT_BAD_SIZE);
+
+  // Older senders decode with boot 0.
+  SensorPacketV2 v2{2, 7, 4242, 1234, 3700, 0x05, 21, 640, 35, 120, 0};
+  v2.crc8 = crc8((const uint8_t *)&v2, sizeof(v2) - 1);
+  CHECK(decodeSensorPacket((const uint8_t *)&v2, sizeof(v2), back) == PKT_OK && same(sample(2, 4242, 0), back));
+  SensorPacketV1 v1{1, 7, 1234, 3700, 0x05, 0};
+  v1.crc8 = crc8((const uint8_t *)&v1, sizeof(v1) - 1);
+  CHECK(decodeSensorPacket((const uint8_t *)&v1, sizeof(v1), back) == PKT_OK);
+  CHECK(back.ver == 1 && back.seq == 0 && back.boot == 0 && back.distance_mm == 1234);
+
+  // Tank 0xB1 puts 0xB1 in byte 1 of a single packet: still not a batch.
+  bool ok = true;
+  for (int tank = 0; tank < 256; tank++) {
+    SensorReading t = sample(3, 1, 1);
+    t.tank_id = (uint8_t)tank;
+    const size_t len = encodeSensorPacket(t, buf);
+    if (isHistoryBatch(buf, (int)len)) ok = false;
+    memcpy(buf, &v2, sizeof(v2));
+    buf[1] = (uint8_t)tank;
+    if (isHistoryBatch(buf, sizeof(v2))) ok = false;
+  }
+  CHECK(ok);
+
+  // Batch headers, one delta each, for every version.
+  uint8_t count = 0;
+  uint16_t nextTx = 0;
+  size_t hdrLen = 0;
+  HistoryHeader h3{3, 0xB1, 7, 2, 4242, 0xBEEF, 1234, 3700, 0x05, 21, 640, 35, 120, 900};
+  memcpy(buf, &h3, sizeof(h3));
+  buf[sizeof(h3)] = 120; buf[sizeof(h3) + 1] = 4;
+  buf[sizeof(h3) + 2] = crc8(buf, sizeof(h3) + 2);
+  CHECK(isHistoryBatch(buf, sizeof(h3) + 3));
+  CHECK(decodeHistoryHeader(buf, sizeof(h3) + 3, back, count, nextTx, hdrLen) == PKT_OK);
+  CHECK(same(sample(3, 4242, 0xBEEF), back) && count == 2 && nextTx == 900 && hdrLen == sizeof(h3));
+
+  HistoryHeaderV2 h2{2, 0xB1, 7, 2, 4242, 1234, 3700, 0x05, 21, 640, 35, 120, 900};
+  memcpy(buf, &h2, sizeof(h2));
+  buf[sizeof(h2)] = 120; buf[sizeof(h2) + 1] = 4;
+  buf[sizeof(h2) + 2] = crc8(buf, sizeof(h2) + 2);
+  CHECK(isHistoryBatch(buf, sizeof(h2) + 3));
+  CHECK(decodeHistoryHeader(buf, sizeof(h2) + 3, back, count, nextTx, hdrLen) == PKT_OK);
+  CHECK(same(sample(2, 4242, 0), back) && hdrLen == sizeof(h2));
+
+  HistoryHeaderV1 h1{1, 0xB1, 7, 1, 1234, 3700, 0x05, 900};
+  memcpy(buf, &h1, sizeof(h1));
+  buf[sizeof(h1)] = crc8(buf, sizeof(h1));
+  CHECK(isHistoryBatch(buf, sizeof(h1) + 1));
+  CHECK(decodeHistoryHeader(buf, sizeof(h1) + 1, back, count, nextTx, hdrLen) == PKT_OK);
+  CHECK(back.ver == 1 && back.boot == 0 && count == 1 && hdrLen == sizeof(h1));
+}
+
+static void testLinkStats() {
+  // The power-cycle case: seqs 1..20, then the sensor restarts at 1 with a new nonce.
+  LinkStats l;
+  for (uint16_t s = 1; s <= 20; s++) CHECK(l.accept(s, 0x1111) == SEQ_NEW);
+  CHECK(l.accept(20, 0x1111) == SEQ_DUPLICATE);
+  CHECK(l.accept(1, 0x2222) == SEQ_RESTART);
+  for (uint16_t s = 2; s <= 5; s++) CHECK(l.accept(s, 0x2222) == SEQ_NEW);
+  CHECK(l.accept(3, 0x2222) == SEQ_DUPLICATE);                 // a real retry is still caught
+  CHECK(l.accept(15, 0x1111) == SEQ_RESTART);                  // the old boot's frame arriving late
+  CHECK_EQ(l.lost, 0);
+  CHECK_EQ(l.restarts, 2);
+  CHECK_EQ(l.received, 26);
+
+  // Same boot: loss, a late arrival filling its gap, and a seq behind the window is
+  // stale, not a restart. The counter wraps without a fuss.
+  LinkStats m;
+  m.accept(65530, 7);
+  CHECK(m.accept(65533, 7) == SEQ_NEW);
+  CHECK_EQ(m.lost, 2);
+  CHECK(m.accept(65532, 7) == SEQ_NEW);
+  CHECK_EQ(m.lost, 1);
+  CHECK(m.accept(2, 7) == SEQ_NEW);                            // 65534, 65535, 0, 1 missing
+  CHECK_EQ(m.lost, 5);
+  CHECK(m.accept(2 - SEQ_WINDOW, 7) == SEQ_STALE);
+  CHECK(m.accept(40000, 7) == SEQ_STALE);
+  CHECK_EQ(m.stale, 2);
+  CHECK_EQ(m.restarts, 0);
+  CHECK_EQ(m.newest, 2);
+
+  // Legacy senders (boot 0): newest 40000 then seq 1 is a restart, not 25536 lost.
+  LinkStats o;
+  o.accept(40000);
+  CHECK(o.accept(40001) == SEQ_NEW);
+  CHECK(o.accept(1) == SEQ_RESTART);
+  CHECK_EQ(o.lost, 0);
+  CHECK(o.accept(1 + SEQ_MAX_GAP) == SEQ_NEW);                 // a long outage is still loss
+  CHECK_EQ(o.lost, SEQ_MAX_GAP - 1);
+  CHECK(o.accept(1 + SEQ_MAX_GAP - SEQ_WINDOW) == SEQ_RESTART);
+  CHECK_EQ(o.stale, 0);
+}
+
+// The window as it was: seq only, a seq behind the window is a restart.
+struct OldLinkStats {
+  bool synced = false;
+  uint16_t newest = 0;
+  uint32_t seen = 0, lost = 0;
+  SeqVerdict accept(uint16_t seq) {
+    if (!synced) { synced = true; newest = seq; seen = 1; return SEQ_NEW; }
+    const int16_t d = (int16_t)(uint16_t)(seq - newest);
+    if (d > 0) { lost += (uint32_t)(d - 1); seen = d >= SEQ_WINDOW ? 1 : (seen << d) | 1; newest = seq; return SEQ_NEW; }
+    if (-d < SEQ_WINDOW) {
+      const uint32_t bit = 1UL << -d;
+      if (seen & bit) return SEQ_DUPLICATE;
+      seen |= bit;
+      if (lost) lost--;
+      return SEQ_NEW;
+    }
+    newest = seq; seen = 1;
+    return SEQ_RESTART;
+  }
+};
+
+struct SimResult { uint32_t wakes = 0, powerCycles = 0, nonceRepeats = 0, trueLost = 0, retries = 0;
+                   uint32_t oldDropped = 0, newDropped = 0, oldLost = 0, newLost = 0, oldRetryPassed = 0, newRetryPassed = 0; };
+
+// One sensor over `wakes` transmitting wakes: each frame lost with pLoss, each
+// delivered frame sent again (same seq) with pRetry, and a power cut with 1/cycle.
+// The nonce is drawn as the sensor draws it, so now and then it repeats the last one.
+static SimResult simulate(uint32_t wakes, double pLoss, double pRetry, uint32_t cycle, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> u(0, 1);
+  SimResult r;
+  OldLinkStats o;
+  LinkStats n;
+  auto draw = [&] { uint16_t b = 0; while (!b) b = (uint16_t)rng(); return b; };
+  uint16_t seq = 0, boot = draw();
+  for (uint32_t w = 0; w < wakes; w++) {
+    if (rng() % cycle == 0) {
+      const uint16_t was = boot;
+      seq = 0; boot = draw(); r.powerCycles++;
+      if (boot == was) r.nonceRepeats++;
+    }
+    seq++;
+    r.wakes++;
+    if (u(rng) < pLoss) { r.trueLost++; continue; }
+    const int copies = u(rng) < pRetry ? 2 : 1;
+    for (int k = 0; k < copies; k++) {
+      const SeqVerdict ov = o.accept(seq), nv = n.accept(seq, boot);
+      if (k == 0) {
+        if (ov == SEQ_DUPLICATE) r.oldDropped++;
+        if (nv == SEQ_DUPLICATE || nv == SEQ_STALE) r.newDropped++;
+      } else {
+        r.retries++;
+        if (ov != SEQ_DUPLICATE) r.oldRetryPassed++;
+        if (nv != SEQ_DUPLICATE) r.newRetryPassed++;
+      }
+    }
+  }
+  r.oldLost = o.lost;
+  r.newLost = n.lost;
+  return r;
+}
+
+static void report(const char *name, const SimResult &r) {
+  printf("%-32s %7u wakes %5u power cuts (%u same nonce) %6u lost %6u retries | new readings dropped: old %6u new %u"
+         " | counted lost: old %9u new %6u | retries let through: old %u new %u\n",
+         name, r.wakes, r.powerCycles, r.nonceRepeats, r.trueLost, r.retries, r.oldDropped, r.newDropped,
+         r.oldLost, r.newLost, r.oldRetryPassed, r.newRetryPassed);
+}
+
+int main(int argc, char **argv) {
+  testCodec();
+  testLinkStats();
+
+  // Flaky supply: the sensor browns out every ~15 transmitting wakes.
+  const SimResult flaky = simulate(200000, 0.05, 0.03, 15, 21);
+  CHECK(flaky.newDropped <= flaky.nonceRepeats * SEQ_WINDOW);   // only a repeated nonce fools it
+  CHECK_EQ(flaky.newRetryPassed, 0);
+  CHECK(flaky.newLost <= flaky.trueLost);
+  CHECK(flaky.oldDropped > 0);
+  // Battery swaps every ~2 months at 120 s wakes: the old window sees int16 wraps.
+  const SimResult swaps = simulate(4000000, 0.05, 0.03, 45000, 22);
+  CHECK(swaps.newDropped <= swaps.nonceRepeats * SEQ_WINDOW);
+  CHECK(swaps.newLost <= swaps.trueLost);
+  CHECK(swaps.oldLost > swaps.trueLost);
+  if (benchEnabled(argc, argv)) {
+    printf("\n");
+    report("brown-out every ~15 wakes", flaky);
+    report("battery swap every ~45000 wakes", swaps);
+  }
+  return testResult("sensor_packet");
+}
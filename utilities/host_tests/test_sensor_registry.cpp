@@ -0,0 +1,178 @@
+// test_sensor_registry.cpp — SensorRegistry (webserver_mcu/ and siren_mcu/include/sensor_registry.h)
+// Lookups against a linear scan of the same table for fleets of 1..255 tanks sharing
+// one OUI, unknown MACs, all-zero placeholders and duplicate rows. The benchmark times
+// a lookup (hits and misses) through the index against the linear tankIdFromMac() scan
+// it replaced, and building /api/status the way rebuildStatus() does, at 3, 64 and 255
+// tanks (tank_id is one byte and 255 means "all tanks", so 255 is the ceiling rather
+// than 256), with every tank's values at their widest so the buffer size is checked too.
+#include "sensor_registry.h"
+#include "host_test.h"
+#include <math.h>
+#include <stdarg.h>
+#include <time.h>
+#include <random>
+#include <vector>
+
+static void makeFleet(std::vector<SensorInfo> &t, uint16_t n, std::mt19937 &rng) {
+  t.resize(n);
+  for (uint16_t i = 0; i < n; i++) {
+    const uint8_t oui[3] = { 0x24, 0x6F, 0x28 };            // one vendor for the whole fleet
+    memcpy(t[i].mac, oui, 3);
+    for (int b = 3; b < 6; b++) t[i].mac[b] = (uint8_t)rng();
+    t[i].height_cm = (uint8_t)(80 + rng() % 120);
+    for (uint16_t j = 0; j < i; j++) {
+      if (memcmp(t[j].mac, t[i].mac, 6) == 0) { i--; break; }   // redraw a repeat
+    }
+  }
+}
+
+// The lookup this replaced.
+static int linearFind(const std::vector<SensorInfo> &t, const uint8_t *mac) {
+  for (size_t i = 0; i < t.size(); i++) if (memcmp(t[i].mac, mac, 6) == 0) return (int)i;
+  return -1;
+}
+
+static void testUnits() {
+  SensorRegistry r;
+  const uint8_t any[6] = { 1, 2, 3, 4, 5, 6 };
+  CHECK_EQ(r.find(any), -1);                               // before begin()
+
+  SensorInfo rows[5] = {
+    { {0x24, 0x6F, 0x28, 0, 0, 1}, 120 },
+    { {0, 0, 0, 0, 0, 0}, 0 },                             // placeholder
+    { {0x24, 0x6F, 0x28, 0, 0, 2}, 150 },
+    { {0x24, 0x6F, 0x28, 0, 0, 1}, 90 },                   // duplicate of row 0
+    { {0x30, 0xAE, 0xA4, 0, 0, 2}, 100 },                  // same low bytes, other OUI
+  };
+  CHECK(r.begin(rows, 5));
+  CHECK_EQ(r.count, 5);
+  CHECK_EQ(r.indexed, 3);
+  CHECK_EQ(r.duplicates, 1);
+  CHECK_EQ(r.find(rows[0].mac), 0);
+  CHECK_EQ(r.find(rows[2].mac), 2);
+  CHECK_EQ(r.find(rows[4].mac), 4);
+  CHECK_EQ(r.find(rows[1].mac), -1);
+  CHECK_EQ(r.find(any), -1);
+  CHECK(r.valid(4) && !r.valid(5));
+
+  CHECK(r.begin(rows, 0));                                 // empty table: nothing found
+  CHECK_EQ(r.find(rows[0].mac), -1);
+  static SensorInfo big[REGISTRY_MAX_TANKS + 1];
+  CHECK(!r.begin(big, REGISTRY_MAX_TANKS + 1));
+}
+
+static void testRandom() {
+  std::mt19937 rng(18);
+  bool ok = true;
+  for (uint16_t n = 1; n <= REGISTRY_MAX_TANKS; n += (n < 16 ? 1 : 17)) {
+    std::vector<SensorInfo> t;
+    makeFleet(t, n, rng);
+    SensorRegistry r;
+    if (!r.begin(t.data(), n) || r.indexed != n || r.duplicates) ok = false;
+    if ((uint32_t)r.mask + 1 < 2u * n) ok = false;          // at most half full
+    for (uint16_t i = 0; i < n; i++) if (r.find(t[i].mac) != i) ok = false;
+    for (int k = 0; k < 1000; k++) {
+      uint8_t mac[6] = { 0x24, 0x6F, 0x28, (uint8_t)rng(), (uint8_t)rng(), (uint8_t)rng() };
+      if (r.find(mac) != linearFind(t, mac)) ok = false;
+    }
+  }
+  CHECK(ok);
+}
+
+// ---- /api/status as rebuildStatus() writes it ----
+struct Tank { float distanceCm; uint32_t lastRxMillis, lastRxEpoch; uint16_t battery_mV, reportIntervalS; bool offline; };
+static const size_t STATUS_TANK_BYTES = 208;               // as webserver_mcu/src/main.cpp
+
+static bool append(char *buf, size_t cap, size_t &pos, const char *fmt, ...) {
+  if (pos >= cap) return false;
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf + pos, cap - pos, fmt, ap);
+  va_end(ap);
+  if (n < 0 || (size_t)n >= cap - pos) { pos = cap; return false; }
+  pos += n;
+  return true;
+}
+
+static void iso8601(time_t t, char *buf, size_t n) {
+  struct tm tm{};
+  gmtime_r(&t, &tm);
+  strftime(buf, n, "%Y-%m-%dT%H:%M:%SZ", &tm);
+}
+
+static size_t buildStatus(char *buf, size_t cap, const SensorInfo *rows, const Tank *tanks, uint16_t n) {
+  char iso[24];
+  size_t pos = 0;
+  bool ok = true;
+  iso8601(1760000000, iso, sizeof(iso));
+  ok &= append(buf, cap, pos, "{\"updated_iso\":\"%s\",\"ntp_synced\":true,\"wifi_channel\":%d,\"tanks\":[", iso, 11);
+  for (uint16_t i = 0; i < n; i++) {
+    const Tank &t = tanks[i];
+    const bool have = !isnan(t.distanceCm);
+    ok &= append(buf, cap, pos, "%s{\"tank_id\":%u,\"height_cm\":%u,\"distance_cm\":", i ? "," : "",
+                 (unsigned)i, (unsigned)rows[i].height_cm);
+    ok &= have ? append(buf, cap, pos, "%.1f", t.distanceCm) : append(buf, cap, pos, "null");
+    ok &= append(buf, cap, pos, ",\"at_risk\":%s,\"last_update_iso\":", have && t.distanceCm <= 6.0f ? "true" : "false");
+    iso8601(t.lastRxEpoch, iso, sizeof(iso));
+    ok &= append(buf, cap, pos, "\"%s\"", iso);
+    ok &= append(buf, cap, pos, ",\"last_seen_uptime_s\":%u", (unsigned)(t.lastRxMillis / 1000UL));
+    ok &= append(buf, cap, pos, ",\"battery_mV\":%u,\"report_interval_s\":%u", (unsigned)t.battery_mV,
+                 (unsigned)t.reportIntervalS);
+    ok &= append(buf, cap, pos, ",\"offline\":%s}", t.offline ? "true" : "false");
+  }
+  ok &= append(buf, cap, pos, "]}");
+  return ok ? pos : 0;
+}
+
+static void bench() {
+  std::mt19937 rng(19);
+  printf("\n%6s %14s %14s %14s %14s %12s %12s\n", "tanks", "hit: index ns", "linear ns", "miss: index ns",
+         "linear ns", "status us", "status B");
+  for (uint16_t n : {3, 64, 255}) {
+    std::vector<SensorInfo> t;
+    makeFleet(t, n, rng);
+    SensorRegistry r;
+    CHECK(r.begin(t.data(), n));
+
+    // Packets arrive from the fleet in random order; misses are neighbours' sensors.
+    const int N = 1 << 16;
+    std::vector<SensorInfo> hits(N), misses(N);
+    for (int i = 0; i < N; i++) {
+      hits[i] = t[rng() % n];
+      misses[i] = hits[i];
+      misses[i].mac[5] ^= 0x80;
+    }
+    double ns[4];
+    for (int k = 0; k < 4; k++) {
+      const std::vector<SensorInfo> &in = k < 2 ? hits : misses;
+      uint32_t sum = 0;
+      const int reps = 40;
+      const uint64_t t0 = nowNs();
+      for (int rep = 0; rep < reps; rep++) {
+        for (int i = 0; i < N; i++) sum += (uint32_t)(k % 2 == 0 ? r.find(in[i].mac) : linearFind(t, in[i].mac));
+      }
+      ns[k] = (double)(nowNs() - t0) / ((double)reps * N);
+      g_sink = sum;
+    }
+
+    // Widest values: 5-digit distances and batteries, 10-digit uptimes.
+    std::vector<Tank> tanks(n);
+    for (Tank &x : tanks) x = { 1234.5f, 4294967295u, 1760000000u, 65535, 65535, true };
+    const size_t cap = 160 + (size_t)n * STATUS_TANK_BYTES;
+    std::vector<char> buf(cap);
+    const size_t len = buildStatus(buf.data(), cap, t.data(), tanks.data(), n);
+    CHECK(len > 0);                                         // fits the buffer allocTanks() sizes
+    const int reps = 2000;
+    const uint64_t t1 = nowNs();
+    for (int rep = 0; rep < reps; rep++) g_sink = (uint32_t)buildStatus(buf.data(), cap, t.data(), tanks.data(), n);
+    const double statusUs = (double)(nowNs() - t1) / reps / 1e3;
+    printf("%6u %14.1f %14.1f %14.1f %14.1f %12.1f %12zu\n", n, ns[0], ns[1], ns[2], ns[3], statusUs, len);
+  }
+}
+
+int main(int argc, char **argv) {
+  testUnits();
+  testRandom();
+  if (benchEnabled(argc, argv)) bench();
+  return testResult("sensor_registry");
+}
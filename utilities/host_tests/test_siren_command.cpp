@@ -0,0 +1,237 @@
+// test_siren_command.cpp — CommandQueue and the command frames (siren_mcu/ and
+// webserver_mcu/include/siren_command.h)
+// Units: v1/v2 frames and acks round trip and reject bad CRCs and sizes; the queue
+// keeps one command on the air, resends on the CMD_RETRY_MS doubling backoff and
+// gives up after CMD_MAX_TRIES, coalesces same-kind commands per tank (and for all
+// tanks), ignores acks from another boot and late acks, reuses the oldest finished
+// slot, refuses a command when every slot is busy with ones it doesn't replace (but
+// takes a slot freed by replacing), and never hands out id 0. The simulation plays
+// a day of dashboard commands (single taps and impatient bursts) over a link losing
+// 0-50 % of frames each way, against a siren that dedupes by (boot, id) as
+// onCommand() does. Reported per loss rate: commands applied, failed
+// and coalesced, frames per command, queued-to-acked latency, commands applied twice,
+// and how many the old single unacked send would have lost.
+#include "siren_command.h"
+#include "host_test.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static void testFrames() {
+  const CommandPacketV2 c = makeCommand(CMD_SNOOZE_MS, 2, 600000, 0xBEEF, 7);
+  CommandPacketV2 d;
+  CHECK(decodeCommand((const uint8_t *)&c, sizeof(c), d));
+  CHECK_EQ(d.ms, 600000);                                    // past v1's 16-bit cap
+  CHECK_EQ(d.boot, 0xBEEF);
+  CHECK_EQ(d.id, 7);
+  CommandPacketV2 bad = c;
+  bad.ms ^= 1;
+  CHECK(!decodeCommand((const uint8_t *)&bad, sizeof(bad), d));
+  CHECK(!decodeCommand((const uint8_t *)&c, sizeof(c) - 1, d));
+
+  CommandPacket v1{1, CMD_TYPE, CMD_FORCE_ON, 255, 5000, 0};
+  v1.crc8 = crc8((const uint8_t *)&v1, sizeof(v1) - 1);
+  CHECK(decodeCommand((const uint8_t *)&v1, sizeof(v1), d));
+  CHECK_EQ(d.ver, 1);
+  CHECK_EQ(d.id, 0);
+  CHECK_EQ(d.ms, 5000);
+  CHECK_EQ(d.tank_id, 255);
+
+  const CommandAck a = makeCommandAck(0xBEEF, 7, CMD_ACK_APPLIED);
+  CommandAck e;
+  CHECK(decodeCommandAck((const uint8_t *)&a, sizeof(a), e));
+  CHECK_EQ(e.id, 7);
+  CommandAck badAck = a;
+  badAck.id ^= 1;
+  CHECK(!decodeCommandAck((const uint8_t *)&badAck, sizeof(badAck), e));
+}
+
+static uint32_t g_doneCalls = 0;
+static void countDone(const CmdSlot &, void *) { g_doneCalls++; }
+
+static void testQueue() {
+  CommandQueue q;
+  q.begin(0);
+  CHECK_EQ(q.boot, 1);                                       // 0 would read as "no boot"
+  q.begin(0x1234);
+  q.onDone = countDone;
+  CHECK(q.due(0) == nullptr);
+
+  // One on the air at a time; backoff 150, 300, 600, 1200 ms; fails 4.65 s after the first send.
+  const uint16_t a = q.submit(CMD_FORCE_ON, 0, 5000, 0);
+  const uint16_t b = q.submit(CMD_SET_PREDICTIVE, 255, 1, 0);
+  CHECK(a == 1 && b == 2);
+  const CommandPacketV2 *p = q.due(0);
+  CHECK(p && p->id == a);
+  CHECK(q.due(1) == nullptr);                                // b waits behind a
+  uint32_t t = 0, sendsAt[CMD_MAX_TRIES] = {0};
+  int n = 1;
+  for (uint32_t now = 1; now <= 6000; now++) {
+    if ((p = q.due(now)) && p->id == a) sendsAt[n++] = now;
+    if (q.find(a)->state == CMD_FAILED) { t = now; break; }
+  }
+  CHECK_EQ(n, CMD_MAX_TRIES);
+  CHECK_EQ(sendsAt[1], 150);
+  CHECK_EQ(sendsAt[4], 150 + 300 + 600 + 1200);
+  CHECK_EQ(t, 4650);
+  CHECK_EQ(q.failed, 1);
+  p = q.due(t);
+  CHECK(p && p->id == b);                                    // next in line goes at once
+
+  CommandAck ack = makeCommandAck(0x9999, b, CMD_ACK_APPLIED);
+  q.onAck(ack, t + 5);                                       // another boot's ack
+  CHECK_EQ(q.find(b)->state, CMD_SENT);
+  ack = makeCommandAck(0x1234, b, CMD_ACK_APPLIED);
+  q.onAck(ack, t + 5);
+  CHECK_EQ(q.find(b)->state, CMD_APPLIED);
+  q.onAck(ack, t + 9);                                       // the ack of a retry: no change
+  CHECK_EQ(q.applied, 1);
+  CHECK_EQ(g_doneCalls, 2);
+  q.onAck(makeCommandAck(0x1234, 99, CMD_ACK_UNKNOWN), t + 9);
+
+  // Coalescing: same kind and tank, or a later command for all tanks.
+  const uint16_t s1 = q.submit(CMD_SNOOZE_5MIN, 1, 0, 10000);
+  const uint16_t s2 = q.submit(CMD_SNOOZE_5MIN, 2, 0, 10000);
+  const uint16_t f1 = q.submit(CMD_FORCE_OFF, 1, 0, 10000);
+  const uint16_t s3 = q.submit(CMD_CLEAR_SNOOZE, 1, 0, 10001);
+  CHECK_EQ(q.find(s1)->state, CMD_SUPERSEDED);
+  CHECK_EQ(q.find(s1)->supersededBy, s3);
+  CHECK_EQ(q.find(s2)->state, CMD_QUEUED);                   // other tank
+  CHECK_EQ(q.find(f1)->state, CMD_QUEUED);                   // other kind
+  const uint16_t s4 = q.submit(CMD_SNOOZE_MS, 255, 60000, 10002);
+  CHECK_EQ(q.find(s2)->state, CMD_SUPERSEDED);
+  CHECK_EQ(q.find(s3)->state, CMD_SUPERSEDED);
+  CHECK_EQ(q.find(s4)->state, CMD_QUEUED);
+  CHECK_EQ(q.coalesced, 3);
+  q.submit(CMD_SNOOZE_5MIN, 3, 0, 10003);                    // one tank doesn't replace "all"
+  CHECK_EQ(q.find(s4)->state, CMD_QUEUED);
+  p = q.due(10003);
+  CHECK(p && p->id == f1);                                   // oldest queued first
+
+  // Full: every slot unfinished. The oldest finished slot is reused otherwise.
+  CommandQueue f;
+  f.begin(7);
+  for (int i = 0; i < CMDQ_DEPTH; i++) CHECK(f.submit(CMD_FORCE_ON, (uint8_t)i, 1000, 0) != 0);
+  CHECK_EQ(f.submit(CMD_FORCE_ON, 200, 1000, 0), 0);
+  CHECK_EQ(f.dropped, 1);
+  p = f.due(0);
+  f.onAck(makeCommandAck(7, p->id, CMD_ACK_APPLIED), 10);
+  const uint16_t reuse = f.submit(CMD_FORCE_ON, 200, 1000, 20);
+  CHECK(reuse != 0);
+  CHECK(f.find(1) == nullptr);                               // id 1's slot went to it
+
+  // Full of per-tank snoozes the siren never acks: a clear for all tanks replaces them
+  // all and takes one of their slots. A refused submit doesn't use up an id.
+  CommandQueue z;
+  z.begin(9);
+  for (int i = 0; i < CMDQ_DEPTH; i++) CHECK(z.submit(CMD_SNOOZE_5MIN, (uint8_t)i, 0, 0) != 0);
+  CHECK(z.due(0) != nullptr);                                // one of them on the air
+  CHECK_EQ(z.submit(CMD_FORCE_OFF, 255, 0, 1), 0);           // other kind: still full
+  CHECK_EQ(z.submit(CMD_SNOOZE_5MIN, 200, 0, 1), 0);         // same kind, other tank
+  CHECK_EQ(z.dropped, 2);
+  const uint16_t clr = z.submit(CMD_CLEAR_SNOOZE, 255, 0, 2);
+  CHECK_EQ(clr, CMDQ_DEPTH + 1);
+  CHECK_EQ(z.coalesced, CMDQ_DEPTH);
+  int superseded = 0;
+  for (const CmdSlot &s : z.slot) superseded += s.state == CMD_SUPERSEDED && s.supersededBy == clr;
+  CHECK_EQ(superseded, CMDQ_DEPTH - 1);                      // the eighth slot now holds the clear
+  CHECK_EQ(z.find(clr)->state, CMD_QUEUED);
+  p = z.due(2);
+  CHECK(p && p->id == clr);                                  // the superseded one in flight gives way
+
+  // Ids skip 0 when they wrap.
+  f.lastId = 0xFFFF;
+  for (int i = 0; i < CMDQ_DEPTH; i++) if (f.slot[i].state != CMD_FREE) f.finish(f.slot[i], CMD_FAILED, 30);
+  CHECK_EQ(f.submit(CMD_FORCE_OFF, 0, 0, 40), 1);
+}
+
+// ---- A day of dashboard commands over a lossy link ----
+struct Frame { uint32_t at; bool toSiren; CommandPacketV2 cmd; CommandAck ack; };
+
+struct CmdResult {
+  uint32_t submitted = 0, applied = 0, failed = 0, coalesced = 0, sends = 0, appliedTwice = 0, oldLost = 0;
+  std::vector<uint32_t> latMs;
+};
+
+static CmdResult* g_res;
+static void noteDone(const CmdSlot &s, void *) {
+  if (s.state == CMD_APPLIED) g_res->latMs.push_back(s.doneMs - s.queuedMs);
+}
+
+static CmdResult runDay(double loss, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> u(0, 1);
+  CmdResult r;
+  g_res = &r;
+  CommandQueue q;
+  q.begin(0x4242);
+  q.onDone = noteDone;
+  LinkStats sirenSeen;                                        // the siren's onCommand() dedupe
+  std::vector<uint32_t> appliedCount(65536, 0);
+  std::vector<Frame> air;
+  const uint32_t AIR_MS = 3, DAY = 86400000;
+  uint32_t nextUser = 1000;
+  uint8_t cmd = 0, tank = 0;
+  int taps = 0;
+  for (uint32_t now = 0; now < DAY; now++) {
+    if (now == nextUser) {
+      // A tap, or an impatient burst of the same button 150 ms apart.
+      if (!taps) {
+        cmd  = (uint8_t)(1 + rng() % 6);
+        tank = (uint8_t)(rng() % 4 == 0 ? 255 : rng() % 3);
+        taps = rng() % 4 == 0 ? 2 + rng() % 3 : 1;
+      }
+      if (q.submit(cmd, tank, cmd == CMD_SET_PREDICTIVE ? 1 : 60000, now)) r.submitted++;
+      r.oldLost += u(rng) < loss;                            // one unacked send, as before
+      nextUser = --taps ? now + 150 : now + 5000 + rng() % 60000;
+    }
+    if (const CommandPacketV2 *p = q.due(now)) {
+      r.sends++;
+      if (u(rng) >= loss) air.push_back({now + AIR_MS, true, *p, {}});
+    }
+    for (size_t i = 0; i < air.size();) {
+      if (air[i].at != now) { i++; continue; }
+      const Frame f = air[i];
+      air.erase(air.begin() + (long)i);
+      if (f.toSiren) {
+        if (sirenSeen.accept(f.cmd.id) != SEQ_DUPLICATE && ++appliedCount[f.cmd.id] > 1) r.appliedTwice++;
+        if (u(rng) >= loss) air.push_back({now + AIR_MS, false, {}, makeCommandAck(f.cmd.boot, f.cmd.id, CMD_ACK_APPLIED)});
+      } else {
+        q.onAck(f.ack, now);
+      }
+    }
+  }
+  r.applied = q.applied;
+  r.failed = q.failed;
+  r.coalesced = q.coalesced;
+  std::sort(r.latMs.begin(), r.latMs.end());
+  return r;
+}
+
+int main(int argc, char **argv) {
+  testFrames();
+  testQueue();
+  const double losses[] = { 0.0, 0.1, 0.3, 0.5 };
+  const int n = benchEnabled(argc, argv) ? 4 : 2;
+  CmdResult out[4];
+  for (int i = 0; i < n; i++) {
+    out[i] = runDay(losses[i], 250 + i);
+    CHECK_EQ(out[i].appliedTwice, 0);
+    CHECK_EQ(out[i].applied + out[i].failed + out[i].coalesced, out[i].submitted);
+  }
+  CHECK_EQ(out[0].failed, 0);
+  CHECK(out[1].failed * 1000 <= out[1].submitted);           // 10 % loss: next to none give up
+
+  if (benchEnabled(argc, argv)) {
+    printf("\none day of dashboard commands, %u submitted at 0 %% loss:\n", out[0].submitted);
+    printf("%6s %9s %8s %10s %11s %24s %13s %16s\n", "loss", "applied", "failed", "coalesced", "frames/cmd",
+           "queued->acked ms p50/p99", "applied 2x", "old unacked lost");
+    for (int i = 0; i < n; i++) {
+      const CmdResult &r = out[i];
+      printf("%5.0f%% %9u %8u %10u %11.2f %12u / %-9u %13u %16u\n", losses[i] * 100, r.applied, r.failed, r.coalesced,
+             (double)r.sends / (r.applied + r.failed), r.latMs[r.latMs.size() / 2], r.latMs[r.latMs.size() * 99 / 100],
+             r.appliedTwice, r.oldLost);
+    }
+  }
+  return testResult("siren_command");
+}
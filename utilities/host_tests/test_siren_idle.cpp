@@ -0,0 +1,160 @@
+// test_siren_idle.cpp — the siren's loop() wait (siren_mcu/src/main.cpp) on a virtual
+// clock, with the channel follower (channel_follow.h) and pulse state (siren_state.h)
+// it drives. Event by event: the webserver's announce every second on its channel
+// (heard only while the siren is on the same one), three sensors every 120 s, a 5 s
+// pulse every 10 minutes ended by its one-shot timer, the 30 s diagnostics line, and
+// once an hour the webserver rebooting onto another channel after a 20 s outage.
+// The old loop woke at least every 250 ms for followTick(); the new one sleeps until
+// followDueMs() runs out. Reported per policy: loop wake-ups per hour (and how many
+// were timeouts), how late channel hops came against lostMs/dwellMs, time to re-lock
+// after the webserver moves, and pulse end error. On hardware the same figures are
+// on the [DIAG] line: busy share, wakeups (timeouts), pulse err.
+#include "channel_follow.h"
+#include "siren_state.h"
+#include "host_test.h"
+#include <algorithm>
+#include <vector>
+
+static const FollowConfig FOLLOW = { 3500, 1100, 13 };     // as the siren's
+static const uint32_t DIAG_MS = 30000, OLD_TICK_MS = 250;
+static const uint32_t ANNOUNCE_MS = 1000, SENSOR_MS = 120000, PULSE_EVERY_MS = 600000, PULSE_MS = 5000;
+static const uint32_t MOVE_EVERY_MS = 3600000, OUTAGE_MS = 20000;
+
+enum Policy { OLD_TICK, DUE_WAIT };
+
+struct Result {
+  uint32_t wakeups = 0, timeouts = 0, hops = 0, relocks = 0, pulses = 0;
+  uint32_t hopLateMax = 0, relockMax = 0;
+  uint64_t hopLateSum = 0, relockSum = 0;
+  int32_t  pulseErrMax = 0;
+};
+
+static Result run(Policy policy, uint32_t hours) {
+  Result r;
+  ChannelFollower f;
+  SirenState siren(PULSE_MS, 1500, 60000);
+  siren.begin(3);
+  uint32_t now = 0, lastDiag = 0;
+  followBegin(f, 1, now);
+  uint8_t  webCh = 6;
+  uint32_t nextAnnounce = 300, nextSensor = 1000, nextPulse = PULSE_EVERY_MS / 2, pulseEnd = 0;
+  uint32_t nextMove = MOVE_EVERY_MS / 3, outageEnd = 0, movedAt = 0;
+  bool     awaitingLock = false, pulseArmed = false;
+  const uint32_t end = hours * 3600000u;
+
+  while (now < end) {
+    // loop(): how long to block.
+    const uint32_t sinceDiag = now - lastDiag;
+    const uint32_t tillDiag  = sinceDiag >= DIAG_MS ? 0 : DIAG_MS - sinceDiag;
+    const uint32_t tillHop   = policy == OLD_TICK ? OLD_TICK_MS : followDueMs(f, now, FOLLOW);
+    const uint32_t deadline  = now + std::min(tillDiag, tillHop);
+
+    // The first thing that posts to the queue before the deadline. Announces and sensor
+    // frames only arrive on the webserver's channel, and announces not during an outage.
+    for (;;) {
+      uint32_t t = std::min({nextAnnounce, nextSensor, nextPulse, nextMove});
+      if (pulseArmed) t = std::min(t, pulseEnd);
+      if (t > deadline) { now = deadline; r.timeouts++; break; }
+      now = t;
+      if (t == nextMove) {                                   // webserver reboots elsewhere
+        webCh = (uint8_t)(webCh + 5 > 13 ? webCh + 5 - 13 : webCh + 5);
+        outageEnd = t + OUTAGE_MS;
+        nextAnnounce = outageEnd;
+        nextMove += MOVE_EVERY_MS;
+        movedAt = t;
+        awaitingLock = true;
+        continue;                                            // nothing on the air
+      }
+      if (t == nextPulse) {                                  // an alarm: sirenPulse()
+        siren.pulse(PULSE_MS, t);
+        pulseEnd = t + PULSE_MS;
+        pulseArmed = true;
+        nextPulse += PULSE_EVERY_MS;
+        continue;                                            // runs inside loop() already in real life
+      }
+      if (pulseArmed && t == pulseEnd) {                     // EV_TIMER
+        pulseArmed = false;
+        if (siren.expire(now)) {
+          r.pulses++;
+          r.pulseErrMax = std::max(r.pulseErrMax, (int32_t)(now - (pulseEnd - PULSE_MS) - PULSE_MS));
+        }
+        break;
+      }
+      if (t == nextSensor) {
+        nextSensor += SENSOR_MS / 3;
+        if (f.channel == webCh) break;                       // EV_RX
+        continue;
+      }
+      nextAnnounce += ANNOUNCE_MS;                           // an announce
+      if (f.channel == webCh) {
+        const bool wasLocked = f.locked;
+        followHeard(f, webCh, now);
+        if (!wasLocked && awaitingLock) {
+          const uint32_t took = now - movedAt - OUTAGE_MS;
+          r.relocks++; r.relockSum += took; r.relockMax = std::max(r.relockMax, took);
+          awaitingLock = false;
+        }
+        break;
+      }
+    }
+    r.wakeups++;
+
+    // followTick(), timing any hop against the moment it was due.
+    const uint32_t limit = f.locked ? FOLLOW.lostMs : FOLLOW.dwellMs;
+    const uint32_t due = f.heardMs + limit;
+    if (followTick(f, now, FOLLOW)) {
+      const uint32_t late = now - due;
+      r.hops++; r.hopLateSum += late; r.hopLateMax = std::max(r.hopLateMax, late);
+    }
+    if (now - lastDiag >= DIAG_MS) lastDiag = now;
+  }
+  return r;
+}
+
+static void testDue() {
+  ChannelFollower f;
+  followBegin(f, 3, 1000);
+  CHECK_EQ(followDueMs(f, 1000, FOLLOW), FOLLOW.dwellMs);    // not locked yet: hunting
+  CHECK_EQ(followDueMs(f, 1000 + FOLLOW.dwellMs - 1, FOLLOW), 1);
+  CHECK_EQ(followTick(f, 1000 + FOLLOW.dwellMs - 1, FOLLOW), 0);
+  CHECK_EQ(followDueMs(f, 1000 + FOLLOW.dwellMs, FOLLOW), 0);
+  CHECK_EQ(followTick(f, 1000 + FOLLOW.dwellMs, FOLLOW), 4);
+  followHeard(f, 0, 5000);
+  CHECK_EQ(followDueMs(f, 5000, FOLLOW), FOLLOW.lostMs);
+  CHECK_EQ(followDueMs(f, 5000 + FOLLOW.lostMs + 10, FOLLOW), 0);
+  CHECK_EQ(followTick(f, 5000 + FOLLOW.lostMs - 1, FOLLOW), 0);
+  CHECK_EQ(followTick(f, 5000 + FOLLOW.lostMs, FOLLOW), 5);
+  // Across the millis() wrap.
+  followBegin(f, 1, 0xFFFFFF00u);
+  followHeard(f, 0, 0xFFFFFF00u);
+  CHECK_EQ(followDueMs(f, 0x100, FOLLOW), FOLLOW.lostMs - 0x200);
+}
+
+int main(int argc, char **argv) {
+  testDue();
+  const uint32_t hours = benchEnabled(argc, argv) ? 24 : 4;
+  const Result o = run(OLD_TICK, hours), n = run(DUE_WAIT, hours);
+  CHECK_EQ(n.hopLateMax, 0);
+  CHECK(o.hopLateMax > 0 && o.hopLateMax < OLD_TICK_MS);
+  CHECK(n.wakeups * 3 < o.wakeups);
+  CHECK_EQ(n.relocks, o.relocks);
+  CHECK(n.relocks >= hours - 1);
+  CHECK(n.relockMax <= o.relockMax);
+  CHECK_EQ(n.pulses, o.pulses);
+  CHECK_EQ(n.pulseErrMax, 0);
+  CHECK_EQ(o.pulseErrMax, 0);
+
+  if (benchEnabled(argc, argv)) {
+    printf("\n%u h, announce 1 s, webserver moves channel hourly after a 20 s outage:\n", hours);
+    const char *names[] = {"250 ms tick", "wait till due"};
+    const Result *rs[] = {&o, &n};
+    for (int i = 0; i < 2; i++) {
+      const Result &r = *rs[i];
+      printf("%-14s wakeups %6.0f/h (timeouts %6.0f/h) | hops %u, late avg %.0f max %u ms | relock avg %.1f max %.1f s | "
+             "pulses %u, end err max %d ms\n", names[i], (double)r.wakeups / hours, (double)r.timeouts / hours,
+             r.hops, r.hops ? (double)r.hopLateSum / r.hops : 0.0, r.hopLateMax,
+             r.relocks ? r.relockSum / 1e3 / r.relocks : 0.0, r.relockMax / 1e3, r.pulses, r.pulseErrMax);
+    }
+  }
+  return testResult("siren_idle");
+}
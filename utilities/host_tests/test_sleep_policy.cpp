@@ -0,0 +1,200 @@
+// test_sleep_policy.cpp — sleepIntervalS() (sensor_mcu/include/sleep_policy.h) and
+// planWake() (wake_cycle.h) with the sensor's settings. Units: near risk is always the
+// shortest sleep, the level scale runs base..max, a fill rate caps the sleep to
+// wakesBeforeRisk wakes before the projected crossing, a weak battery stretches only
+// level-based sleeps, and the heartbeat caps everything. The simulator runs one tank
+// for 60 days of extraction sessions (fills at 0.2..3 cm/min from far below, some
+// stopping short of the alarm, some crossing it and then emptied) with +-3 mm noise,
+// through planWake() with a fixed 120 s sleep and with the adaptive policy, at a good
+// and a low battery. Reported: wakes and transmissions per day, mAh/day and days on a
+// 3000 mAh cell, and detection latency from the true crossing of AT_RISK_MM to the
+// first wake that reads it. Current model as in utilities/fleet_sim: a sampling wake
+// ~0.75 s at 40 mA (boot, sensor warm-up, median), a transmitting wake ~0.3 s more
+// at 100 mA, deep sleep 10 uA.
+#include "wake_cycle.h"
+#include "host_test.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const uint16_t AT_RISK_MM = 60, NEAR_RISK_MM = AT_RISK_MM + 100;   // as the sensor's
+static const SendPolicy SEND_POLICY = { 10, NEAR_RISK_MM, 900 };
+static const SleepPolicyConfig SLEEP_POLICY = { 30, 120, 900, NEAR_RISK_MM, 600, AT_RISK_MM, 4, 3500, 3300 };
+static const WakeConfig WAKE_ADAPTIVE = { true, true,  120, 15 * 60, SEND_POLICY, SLEEP_POLICY };
+static const WakeConfig WAKE_FIXED    = { true, false, 120, 15 * 60, SEND_POLICY, SLEEP_POLICY };
+
+static void testUnits() {
+  const SleepPolicyConfig &c = SLEEP_POLICY;
+  SleepReason why;
+  CHECK_EQ(sleepIntervalS(c, true, NEAR_RISK_MM, false, 0, 3700, 0, why), c.minS);
+  CHECK(why == SLEEP_NEAR_RISK);
+  CHECK_EQ(sleepIntervalS(c, true, 40, true, 50, 3000, 0, why), c.minS);        // weak battery: still min
+  CHECK_EQ(sleepIntervalS(c, true, 600, false, 0, 3700, 0, why), c.maxS);
+  CHECK(why == SLEEP_LEVEL);
+  CHECK_EQ(sleepIntervalS(c, true, 2000, false, 0, 3700, 0, why), c.maxS);
+  const uint16_t mid = sleepIntervalS(c, true, (NEAR_RISK_MM + 600) / 2, false, 0, 3700, 0, why);
+  CHECK(mid > c.baseS && mid < c.maxS);
+  CHECK_EQ(sleepIntervalS(c, false, 0, false, 0, 3700, 0, why), c.baseS);       // invalid: base
+  CHECK(why == SLEEP_BASE);
+
+  // 500 mm to go at 10 mm/min = 3000 s; four wakes before it: 750 s.
+  CHECK_EQ(sleepIntervalS(c, true, 560, true, 10, 3700, 0, why), 750);
+  CHECK(why == SLEEP_FILL_RATE);
+  CHECK_EQ(sleepIntervalS(c, true, 560, true, 1000, 3700, 0, why), c.minS);     // clamped to min
+  const uint16_t noRate = sleepIntervalS(c, true, 560, false, 0, 3700, 0, why);
+  CHECK_EQ(sleepIntervalS(c, true, 560, true, -10, 3700, 0, why), noRate);     // draining: level only
+
+  // Battery: low doubles a level sleep (clamped), critical goes to max, neither touches a fill-rate cap.
+  const uint16_t lvl = sleepIntervalS(c, true, 300, false, 0, 3700, 0, why);
+  CHECK_EQ(sleepIntervalS(c, true, 300, false, 0, 3400, 0, why), std::min<int>(lvl * 2, c.maxS));
+  CHECK(why == SLEEP_LOW_BATTERY);
+  CHECK_EQ(sleepIntervalS(c, true, 300, false, 0, 3200, 0, why), c.maxS);
+  CHECK_EQ(sleepIntervalS(c, true, 560, true, 10, 3200, 0, why), 750);
+  CHECK(why == SLEEP_FILL_RATE);
+  CHECK_EQ(sleepIntervalS(c, true, 300, false, 0, 0, 0, why), lvl);             // not measured
+
+  // Heartbeat cap, never below minS.
+  CHECK_EQ(sleepIntervalS(c, true, 2000, false, 0, 3700, 200, why), 200);
+  CHECK(why == SLEEP_HEARTBEAT);
+  CHECK_EQ(sleepIntervalS(c, true, 2000, false, 0, 3700, 5, why), c.minS);
+
+  // planWake: the first wake sends, a quiet one doesn't, a heartbeat due within minS is sent now.
+  ReadingHistory h{};
+  historyPush(h, 1000, 1500, 0x01);
+  WakePlan p = planWake(h, WAKE_ADAPTIVE, true, 1500, 3700);
+  CHECK(p.send == SEND_FIRST);
+  historyMarkSent(h);
+  historyPush(h, 1900, 1502, 0x01);
+  p = planWake(h, WAKE_ADAPTIVE, true, 1502, 3700);
+  CHECK(p.send == SEND_HEARTBEAT);                         // 900 s since the last send
+  historyMarkSent(h);
+  historyPush(h, 2000, 1501, 0x01);
+  p = planWake(h, WAKE_ADAPTIVE, true, 1501, 3700);
+  CHECK(p.send == SEND_NONE);
+  CHECK(p.sleepS <= 800);                                  // heartbeat due 800 s on
+  historyPush(h, 2790, 1501, 0x01);
+  p = planWake(h, WAKE_ADAPTIVE, true, 1501, 3700);
+  CHECK(p.send == SEND_HEARTBEAT);                         // 10 s left < minS: send now
+  CHECK(planWake(h, WAKE_FIXED, true, 1501, 3700).sleepS == 120);
+}
+
+// ---- 60-day simulator ----
+static const double MA_SAMPLE = 40, MA_RADIO = 100, MA_SLEEP = 0.010;
+static const double SAMPLE_S = 0.75, TX_S = 0.3;
+
+struct Session { double startS, rateMmS; uint16_t fromMm, stopMm; bool crosses; double drainAtS; };
+
+// One extraction session on most days: a fill from far below toward the top, then the
+// tank is emptied back down (right after the alarm if it crossed).
+static std::vector<Session> makeSessions(uint32_t days, std::mt19937 &rng) {
+  std::uniform_real_distribution<double> u(0, 1);
+  std::vector<Session> s;
+  for (uint32_t d = 0; d < days; d++) {
+    if (u(rng) < 0.3) continue;
+    Session x;
+    x.startS  = d * 86400.0 + 8 * 3600 + u(rng) * 6 * 3600;
+    x.rateMmS = (2 + u(rng) * 28) / 60.0;                    // 0.2..3 cm/min
+    x.fromMm  = (uint16_t)(900 + u(rng) * 600);
+    x.crosses = u(rng) < 0.4;
+    x.stopMm  = x.crosses ? 0 : (uint16_t)(AT_RISK_MM + 5 + u(rng) * 300);
+    s.push_back(x);
+  }
+  return s;
+}
+
+struct SimOut { uint32_t wakes = 0, sends = 0, crossings = 0, missed = 0; double mAh = 0; std::vector<double> latency; };
+
+static SimOut simulate(const WakeConfig &cfg, uint16_t battery_mV, const std::vector<Session> &sessions,
+                       uint32_t days, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<int> noise(-3, 3);
+  SimOut o;
+  ReadingHistory h{};
+  const double end = days * 86400.0;
+  size_t si = 0;
+  double t = 100;
+  // True distance to the top (mm) at time t.
+  auto level = [&](double at, size_t &idx, bool &crossedAt, double &crossS) {
+    crossedAt = false;
+    while (idx + 1 < sessions.size() && at >= sessions[idx + 1].startS) idx++;
+    const Session &x = sessions[idx];
+    if (at < x.startS) return 1500.0;
+    const double target = x.crosses ? 20.0 : x.stopMm;      // overfills stop at 2 cm (pump cut by hand)
+    const double filled = x.fromMm - (at - x.startS) * x.rateMmS;
+    const double tCross = x.startS + (x.fromMm - AT_RISK_MM) / x.rateMmS;
+    if (x.crosses) { crossedAt = true; crossS = tCross; }
+    const double drainAt = x.crosses ? tCross + 3600 : x.startS + (x.fromMm - x.stopMm) / x.rateMmS + 3 * 3600;
+    if (at >= drainAt) return 1500.0;
+    return std::max(filled, target);
+  };
+  double pendingCross = -1;
+  size_t lastCrossSession = (size_t)-1;
+  while (t < end) {
+    bool crosses = false; double crossS = 0;
+    const double mm = sessions.empty() ? 1500.0 : level(t, si, crosses, crossS);
+    if (crosses && si != lastCrossSession && t >= crossS) {
+      if (pendingCross < 0) { pendingCross = crossS; o.crossings++; }
+    }
+    const uint16_t read = (uint16_t)std::max(1.0, mm + noise(rng));
+    historyPush(h, (uint32_t)t, read, 0x01);
+    const WakePlan p = planWake(h, cfg, true, read, battery_mV);
+    o.wakes++;
+    double awake = SAMPLE_S;
+    o.mAh += MA_SAMPLE * SAMPLE_S / 3600;
+    if (p.send != SEND_NONE) {
+      o.sends++;
+      historyMarkSent(h);
+      awake += TX_S;
+      o.mAh += MA_RADIO * TX_S / 3600;
+    }
+    if (pendingCross >= 0 && read <= AT_RISK_MM) {
+      o.latency.push_back(t - pendingCross);
+      pendingCross = -1;
+      lastCrossSession = si;
+    } else if (pendingCross >= 0 && mm > AT_RISK_MM + 10) {  // emptied before any wake saw it
+      o.missed++;
+      pendingCross = -1;
+      lastCrossSession = si;
+    }
+    o.mAh += MA_SLEEP * p.sleepS / 3600;
+    t += p.sleepS + awake;
+  }
+  return o;
+}
+
+static double pct(std::vector<double> v, double q) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[(size_t)(q * (v.size() - 1))];
+}
+
+int main(int argc, char **argv) {
+  testUnits();
+  const uint32_t days = benchEnabled(argc, argv) ? 60 : 20;
+  std::mt19937 rng(17);
+  const std::vector<Session> sessions = makeSessions(days, rng);
+  struct Case { const char *name; const WakeConfig *cfg; uint16_t mV; };
+  const Case cases[] = { {"fixed 120 s", &WAKE_FIXED, 3700}, {"adaptive", &WAKE_ADAPTIVE, 3700},
+                         {"fixed 120 s, 3.4 V", &WAKE_FIXED, 3400}, {"adaptive, 3.4 V", &WAKE_ADAPTIVE, 3400} };
+  SimOut out[4];
+  for (int i = 0; i < 4; i++) out[i] = simulate(*cases[i].cfg, cases[i].mV, sessions, days, 170);
+
+  CHECK(out[0].crossings > 0);
+  for (const SimOut &o : out) { CHECK_EQ(o.missed, 0); CHECK_EQ(o.latency.size(), o.crossings); }
+  CHECK(out[1].mAh < out[0].mAh);                                    // adaptive saves charge
+  CHECK(pct(out[1].latency, 1.0) <= pct(out[0].latency, 1.0));       // and detects no later
+  CHECK(pct(out[3].latency, 1.0) <= pct(out[0].latency, 1.0));       // low battery doesn't stretch near risk
+  CHECK(out[3].mAh <= out[1].mAh);
+
+  if (benchEnabled(argc, argv)) {
+    printf("\n%u days, %zu sessions (%u cross the alarm):\n", days, sessions.size(), out[0].crossings);
+    printf("%-20s %10s %10s %10s %12s %28s\n", "", "wakes/day", "sends/day", "mAh/day", "days@3000", "detect latency s p50/p90/max");
+    for (int i = 0; i < 4; i++) {
+      const SimOut &o = out[i];
+      printf("%-20s %10.0f %10.0f %10.3f %12.0f %12.0f / %4.0f / %4.0f\n", cases[i].name,
+             (double)o.wakes / days, (double)o.sends / days, o.mAh / days, 3000 / (o.mAh / days),
+             pct(o.latency, 0.5), pct(o.latency, 0.9), pct(o.latency, 1.0));
+    }
+  }
+  return testResult("sleep_policy");
+}
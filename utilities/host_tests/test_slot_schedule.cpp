@@ -0,0 +1,176 @@
+// test_slot_schedule.cpp — TDMA slots (sensor_mcu/ and webserver_mcu/include/slot_schedule.h)
+// Units: slotAssign() centres and CRC, decodeSlotReply() rejections, slotWaitMs() for
+// early, slightly late and far-off wakes, and slotSleepUs() never sleeping past the
+// wanted interval (random schedules, drifts and intervals). The simulation runs one
+// sensor for ten days against the webserver's clock with an RC oscillator that is
+// off by a fixed rate and swings with a daily temperature cycle, waking at the sleep
+// policy's intervals. Reported per drift: transmit error against the true slot centre
+// (in slot widths, 64 tanks), how often the sensor lands in its slot, and how much
+// of the wanted interval the slot alignment gives up.
+#include "slot_schedule.h"
+#include "host_test.h"
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const uint32_t JITTER_MS = 2000;                    // the sensor's longest wait for a slot
+static const uint32_t SLOT_LEAD_MARGIN_MS = 200;
+
+static void testUnits() {
+  // 4 tanks in 30 s: centres at 3.75, 11.25, 18.75, 26.25 s into each frame.
+  SlotReply r = slotAssign(2, 77, 4, 1000000);              // phase 10 s
+  CHECK_EQ(r.slot, 2);
+  CHECK_EQ(r.slots, 4);
+  CHECK_EQ(r.seq, 77);
+  CHECK_EQ(r.until_ms, 8750);
+  CHECK_EQ(slotAssign(0, 1, 4, 1000000).until_ms, 23750);   // wraps into the next frame
+  CHECK_EQ(slotAssign(0, 1, 0, 0).until_ms, 15000);          // no tanks: treated as one
+
+  SlotReply d;
+  CHECK(decodeSlotReply((const uint8_t *)&r, sizeof(r), d));
+  CHECK_EQ(d.until_ms, 8750);
+  CHECK(!decodeSlotReply((const uint8_t *)&r, sizeof(r) - 1, d));
+  SlotReply bad = r;
+  bad.until_ms ^= 1;
+  CHECK(!decodeSlotReply((const uint8_t *)&bad, sizeof(bad), d));
+  bad = r;
+  bad.slots = 0;
+  bad.crc8 = crc8((const uint8_t *)&bad, sizeof(bad) - 1);
+  CHECK(!decodeSlotReply((const uint8_t *)&bad, sizeof(bad), d));
+
+  SlotSchedule s{};
+  uint32_t waitMs;
+  int64_t sleepUs;
+  CHECK(!slotWaitMs(s, 0, JITTER_MS, waitMs));              // cold boot: jitter
+  CHECK(!slotSleepUs(s, 0, 120, 800, sleepUs));
+  CHECK(!slotOnReply(s, r, 5000000));                       // first reply replaces
+  CHECK_EQ(s.anchorUs, 13750000);
+  CHECK(slotWaitMs(s, 13000000, JITTER_MS, waitMs));
+  CHECK_EQ(waitMs, 750);
+  CHECK(slotWaitMs(s, 14000000, JITTER_MS, waitMs));        // 250 ms late, under a quarter slot
+  CHECK_EQ(waitMs, 0);
+  CHECK(!slotWaitMs(s, 20000000, JITTER_MS, waitMs));       // next centre 23.75 s away
+
+  // 120 s wanted from 20 s: the last centre at or before 140 s is 133.75 s.
+  CHECK(slotSleepUs(s, 20000000, 120, 800, sleepUs));
+  CHECK_EQ(sleepUs, 133750000 - 800000 - 20000000);
+  CHECK(slotSleepUs(s, 13750000, 120, 0, sleepUs));         // exactly on a centre: sleep the full 120 s
+  CHECK_EQ(sleepUs, 120000000);
+  CHECK(!slotSleepUs(s, 20000000, 20, 800, sleepUs));       // shorter than a frame: unaligned
+
+  // A reply one frame on that puts the centre 300 us later than predicted: tracked,
+  // and the sensor's clock is taken to run fast.
+  const SlotReply r2 = slotAssign(2, 78, 4, 1000000 + 30000);
+  CHECK(slotOnReply(s, r2, 35000000 + 300));
+  CHECK_EQ(s.driftPpm, 5);
+  CHECK_EQ(s.lastErrUs, -300);
+  CHECK_EQ(s.resets, 0);
+  const SlotReply r3 = slotAssign(2, 79, 8, 1060000);        // fleet grew: replaced
+  CHECK(!slotOnReply(s, r3, 65000000));
+  CHECK_EQ(s.resets, 1);
+
+  // Never past the wanted interval, whatever the anchor, drift, lead and interval.
+  std::mt19937 rng(20);
+  bool ok = true;
+  for (int i = 0; i < 200000; i++) {
+    SlotSchedule x{};
+    x.frameMs  = (uint16_t)(5000 + rng() % 60000);
+    x.slots    = (uint8_t)(1 + rng() % 255);
+    x.driftPpm = (int32_t)(rng() % (2 * SLOT_DRIFT_MAX_PPM + 1)) - SLOT_DRIFT_MAX_PPM;
+    x.anchorUs = (int64_t)(rng() % 4000000000u);
+    const int64_t now = (int64_t)(rng() % 4000000000u);
+    const uint32_t want = 1 + rng() % 3600, lead = rng() % 3000;
+    int64_t us;
+    if (slotSleepUs(x, now, want, lead, us) && (us > (int64_t)want * 1000000 || us < (int64_t)want * 500000)) ok = false;
+  }
+  CHECK(ok);
+}
+
+// ---- Ten days on a drifting RC clock ----
+struct DriftResult { uint32_t wakes = 0, sends = 0, inSlot = 0, replaced = 0, unaligned = 0, overWant = 0; double maxErr = 0, giveUp = 0; std::vector<double> err; };
+
+// fixedPpm: the oscillator's offset; swingPpm: the daily temperature cycle on top.
+static DriftResult runDrift(double fixedPpm, double swingPpm, uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> u(0, 1);
+  const uint16_t tanks = 64, tank = 17;
+  const int64_t F = (int64_t)SLOT_FRAME_MS * 1000, W = F / tanks;
+  const int64_t centre = tank * W + W / 2;
+  DriftResult o;
+  SlotSchedule s{};
+  double trueUs = 1e9 * u(rng), localUs = 0;                 // webserver clock, sensor RTC
+  uint16_t seq = 0;
+  auto ppmAt = [&](double t) { return fixedPpm + swingPpm * sin(2 * M_PI * t / 86400e6); };
+  auto advance = [&](double localDelta) {                    // sensor-clock time passes
+    trueUs += localDelta / (1 + ppmAt(trueUs) / 1e6);
+    localUs += localDelta;
+  };
+  while (trueUs < 10 * 86400e6) {
+    o.wakes++;
+    // Wake: sample, then wait for the slot (or jitter without one) and transmit.
+    const double wokeLocal = localUs;
+    advance((600 + 300 * u(rng)) * 1000);
+    slotNoteLead(s, (uint32_t)((localUs - wokeLocal) / 1000), SLOT_LEAD_MARGIN_MS);
+    uint32_t waitMs;
+    const bool slotted = slotWaitMs(s, (int64_t)localUs, JITTER_MS, waitMs);
+    if (!slotted) waitMs = rng() % JITTER_MS;
+    advance(waitMs * 1000.0);
+    if (slotted) {
+      o.sends++;
+      int64_t e = ((int64_t)trueUs - centre) % F;             // distance from the nearest true centre
+      if (e > F / 2) e -= F;
+      if (e < -F / 2) e += F;
+      const double slots = fabs((double)e) / W;
+      o.err.push_back(slots);
+      o.maxErr = std::max(o.maxErr, slots);
+      if (slots < 0.5) o.inSlot++;
+    }
+    // The webserver answers 4 ms later; until_ms counts from sending the reply.
+    const SlotReply r = slotAssign(tank, ++seq, tanks, (uint64_t)((trueUs + 4000) / 1000));
+    advance(4000 * (1 + ppmAt(trueUs) / 1e6) + 1500);       // flight and the sensor's receive path
+    if (!slotOnReply(s, r, (int64_t)(localUs - 1500)) && s.fixes > 1) o.replaced++;
+    advance(150 * 1000.0);
+
+    // Sleep for what the policy wants: mostly the far-level maximum, sometimes shorter.
+    const uint32_t wantS = u(rng) < 0.7 ? 900 : 120 + rng() % 600;
+    int64_t sleepUs = (int64_t)wantS * 1000000;
+    if (!slotSleepUs(s, (int64_t)localUs, wantS, s.leadMs, sleepUs)) o.unaligned++;
+    if (sleepUs > (int64_t)wantS * 1000000) o.overWant++;
+    o.giveUp += (double)((int64_t)wantS * 1000000 - sleepUs) / ((int64_t)wantS * 1000000);
+    s.wakeUs = (int64_t)localUs + sleepUs;
+    advance((double)sleepUs);
+  }
+  return o;
+}
+
+int main(int argc, char **argv) {
+  testUnits();
+  struct Case { const char *name; double fixed, swing; };
+  const Case cases[] = { {"crystal-like", 20, 0}, {"RC +300 ppm", 300, 0}, {"RC -1.5 %", -15000, 0},
+                         {"RC +500 ppm, +-2000 daily", 500, 2000}, {"RC -1 %, +-5000 daily", -10000, 5000} };
+  const int n = sizeof(cases) / sizeof(cases[0]);
+  DriftResult out[n];
+  for (int i = 0; i < n; i++) out[i] = runDrift(cases[i].fixed, cases[i].swing, 200 + i);
+  for (int i = 0; i < n; i++) {
+    CHECK_EQ(out[i].overWant, 0);
+    CHECK(out[i].sends > 800);
+  }
+  // Up to +-2000 ppm of daily swing the sensor stays in its slot; the +-5000 case is
+  // reported to show where tracking between 15-minute replies runs out.
+  for (int i = 0; i < n - 1; i++) CHECK(out[i].inSlot >= out[i].sends * 99 / 100);
+
+  if (benchEnabled(argc, argv)) {
+    printf("\n10 days, 64 tanks in a %u ms frame (slot %u ms), 120..900 s sleeps:\n", SLOT_FRAME_MS, SLOT_FRAME_MS / 64);
+    printf("%-27s %7s %9s %22s %9s %10s %12s\n", "", "sends", "in slot", "error slots p50/p99/max", "resets", "unaligned",
+           "sleep given up");
+    for (int i = 0; i < n; i++) {
+      DriftResult &o = out[i];
+      std::sort(o.err.begin(), o.err.end());
+      printf("%-27s %7u %8.1f%% %8.3f / %5.3f / %5.3f %9u %10u %11.2f%%\n", cases[i].name, o.sends,
+             100.0 * o.inSlot / o.sends, o.err[o.err.size() / 2], o.err[o.err.size() * 99 / 100], o.maxErr,
+             o.replaced, o.unaligned, 100.0 * o.giveUp / o.wakes);
+    }
+  }
+  return testResult("slot_schedule");
+}
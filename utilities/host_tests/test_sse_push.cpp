@@ -0,0 +1,274 @@
+// test_sse_push.cpp — the /api/events stream (webserver_mcu/include/sse_hub.h) over
+// real loopback TCP. The main thread plays the webserver's loop(): it accepts and
+// answers one request at a time like handleClient(), parks event streams in an
+// SseHub<TcpClient, 4> and pushes a "tank" event every 500 µs. Client
+// threads speak plain HTTP/1.1: three EventSource-like readers, one that stops
+// reading (its socket buffers are shrunk so it fills up), one over the client limit
+// and a status poller that must still be answered while the streams are open. Push
+// latency is measured from broadcast() to the reader parsing the event, against the
+// 10 s setInterval poll the dashboard used before.
+#include "sse_hub.h"
+#include "host_test.h"
+#include <errno.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// WiFiClient stand-in: copies share the socket, as WiFiClient copies do.
+struct TcpClient {
+  int fd = -1;
+  bool connected() {
+    if (fd < 0) return false;
+    char b;
+    const ssize_t r = recv(fd, &b, 1, MSG_PEEK | MSG_DONTWAIT);
+    if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) { stop(); return false; }
+    return true;
+  }
+  size_t write(const uint8_t *buf, size_t n) {
+    const ssize_t r = send(fd, buf, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+    return r < 0 ? 0 : (size_t)r;
+  }
+  void stop() { if (fd >= 0) close(fd); fd = -1; }
+};
+
+static const int EVENTS = 2000;
+static const int SMALL_BUF = 4096;
+static uint16_t g_port;
+
+static int dial(bool smallBuf) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (smallBuf) setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &SMALL_BUF, sizeof(SMALL_BUF));
+  sockaddr_in a{};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(g_port);
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (sockaddr*)&a, sizeof(a)) != 0) { close(fd); return -1; }
+  return fd;
+}
+
+static void sendAll(int fd, const char *s) { send(fd, s, strlen(s), MSG_NOSIGNAL); }
+
+struct Reader {
+  std::vector<uint64_t> latNs;
+  int  status = 0;
+  bool sawDone = false;
+};
+
+// An EventSource: GET /api/events, then parse "data:" lines until the "done" event.
+static void readStream(Reader *r) {
+  const int fd = dial(false);
+  if (fd < 0) return;
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  sendAll(fd, "GET /api/events HTTP/1.1\r\nHost: tank\r\nAccept: text/event-stream\r\n\r\n");
+  std::string buf;
+  char chunk[4096];
+  for (;;) {
+    const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) break;
+    const uint64_t now = nowNs();
+    buf.append(chunk, (size_t)n);
+    if (!r->status && buf.size() >= 12) r->status = atoi(buf.c_str() + 9);
+    size_t end;
+    while ((end = buf.find("\n\n")) != std::string::npos) {
+      const std::string ev = buf.substr(0, end);
+      buf.erase(0, end + 2);
+      if (ev.find("event: done") != std::string::npos) { r->sawDone = true; close(fd); return; }
+      const size_t at = ev.find("\"t_ns\":");
+      if (ev.find("event: tank") != std::string::npos && at != std::string::npos) {
+        r->latNs.push_back(now - strtoull(ev.c_str() + at + 7, nullptr, 10));
+      }
+    }
+  }
+  close(fd);
+}
+
+// Connects, asks for the stream, then never reads again.
+static void stuckStream(std::atomic<bool> *release) {
+  const int fd = dial(true);
+  sendAll(fd, "GET /api/events HTTP/1.1\r\nHost: tank\r\n\r\n");
+  while (!*release) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  close(fd);
+}
+
+// Any request that gets a complete response: status code and time to the answer.
+static int oneShot(const char *path, uint64_t *ns) {
+  const int fd = dial(false);
+  const uint64_t t0 = nowNs();
+  std::string req = std::string("GET ") + path + " HTTP/1.1\r\nHost: tank\r\nConnection: close\r\n\r\n";
+  sendAll(fd, req.c_str());
+  char b[512];
+  const ssize_t n = recv(fd, b, sizeof(b) - 1, 0);
+  if (ns) *ns = nowNs() - t0;
+  close(fd);
+  if (n < 12) return 0;
+  b[n] = 0;
+  return atoi(b + 9);
+}
+
+// ---- The webserver side ----
+static SseHub<TcpClient, 4> hub;
+static int listenFd;
+static uint32_t served503 = 0;
+
+// One handleClient() pass: accept one pending connection, read its request line and
+// answer it. /api/events hands the socket to the hub; everything else is closed.
+static void handleClient() {
+  pollfd p{listenFd, POLLIN, 0};
+  if (poll(&p, 1, 0) <= 0) return;
+  TcpClient c;
+  c.fd = accept(listenFd, nullptr, nullptr);
+  if (c.fd < 0) return;
+  pollfd q{c.fd, POLLIN, 0};
+  char req[512];
+  ssize_t n = poll(&q, 1, 1000) > 0 ? recv(c.fd, req, sizeof(req) - 1, 0) : 0;
+  if (n <= 0) { c.stop(); return; }
+  req[n] = 0;
+  if (strncmp(req, "GET /api/events", 15) == 0) {
+    const int slot = hub.freeSlot();
+    if (slot < 0) {
+      served503++;
+      static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+      c.write((const uint8_t*)busy, sizeof(busy) - 1);
+      c.stop();
+      return;
+    }
+    if (strstr(req, "Accept: text/event-stream") == nullptr) {     // the stuck client
+      setsockopt(c.fd, SOL_SOCKET, SO_SNDBUF, &SMALL_BUF, sizeof(SMALL_BUF));
+    }
+    int one = 1;
+    setsockopt(c.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (!hub.open(slot, c)) c.stop();
+    return;
+  }
+  static const char ok[] = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: 2\r\nConnection: close\r\n\r\n{}";
+  c.write((const uint8_t*)ok, sizeof(ok) - 1);
+  c.stop();
+}
+
+// Runs the loop until done() or the timeout; false on timeout.
+template <typename F> static bool loopUntil(F done, int timeoutMs) {
+  const uint64_t end = nowNs() + (uint64_t)timeoutMs * 1000000;
+  while (!done()) {
+    if (nowNs() > end) return false;
+    handleClient();
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+  return true;
+}
+
+static void testFraming() {
+  char f[64];
+  static const char want[] = "event: tank\ndata: {\"a\":1}\n\n";
+  CHECK_EQ(sseFrame(f, sizeof(f), "tank", "{\"a\":1}"), sizeof(want) - 1);
+  CHECK(strcmp(f, want) == 0);
+  volatile size_t small = sizeof(want) - 1;             // one short of the terminator
+  CHECK_EQ(sseFrame(f, small, "tank", "{\"a\":1}"), 0);   // nothing, not a cut frame
+  SseHub<TcpClient, 2> empty;
+  empty.broadcast("tank", "{}");
+  CHECK_EQ(empty.eventsSent, 0);
+  CHECK_EQ(empty.freeSlot(), 0);
+}
+
+static uint64_t pct(std::vector<uint64_t> v, int p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[(v.size() - 1) * p / 100];
+}
+
+int main(int argc, char **argv) {
+  const bool verbose = benchEnabled(argc, argv);
+  testFraming();
+
+  listenFd = socket(AF_INET, SOCK_STREAM, 0);
+  int one = 1;
+  setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in a{};
+  a.sin_family = AF_INET;
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t alen = sizeof(a);
+  CHECK(bind(listenFd, (sockaddr*)&a, sizeof(a)) == 0);
+  CHECK(listen(listenFd, 8) == 0);
+  getsockname(listenFd, (sockaddr*)&a, &alen);
+  g_port = ntohs(a.sin_port);
+
+  // Three readers and the stuck client fill the four slots.
+  Reader readers[3];
+  std::vector<std::thread> threads;
+  for (Reader &r : readers) threads.emplace_back(readStream, &r);
+  std::atomic<bool> release{false};
+  std::thread stuck(stuckStream, &release);
+  CHECK(loopUntil([] { return hub.connectedCount() == 4; }, 5000));
+
+  // A fifth stream is turned away; a plain request is still answered.
+  std::atomic<int> fifth{0}, status{0};
+  std::atomic<uint64_t> statusNs{0};
+  std::thread extra([&] { fifth = oneShot("/api/events", nullptr); });
+  CHECK(loopUntil([&] { return fifth != 0; }, 5000));
+  extra.join();
+  CHECK_EQ(fifth, 503);
+  std::thread poller([&] { uint64_t ns; status = oneShot("/api/status", &ns); statusNs = ns; });
+  CHECK(loopUntil([&] { return status != 0; }, 5000));
+  poller.join();
+  CHECK_EQ(status, 200);
+
+  // Push: one event every 500 µs with a dashboard-sized payload, the loop serving
+  // requests in between. The stuck client's buffers fill and it gets dropped.
+  char data[256];
+  uint64_t maxBroadcastNs = 0;
+  for (int k = 0; k < EVENTS; k++) {
+    const uint64_t t = nowNs();
+    snprintf(data, sizeof(data),
+      "{\"tank_id\":%d,\"distance_cm\":%.1f,\"at_risk\":false,\"last_update_iso\":\"2026-10-16T08:00:00Z\","
+      "\"last_seen_uptime_s\":1234,\"battery_mV\":3712,\"offline\":false,\"uptime_s\":5678,\"seq\":%d,\"t_ns\":%llu}",
+      k % 3, 40.0 + k % 50, k, (unsigned long long)t);
+    hub.broadcast("tank", data);
+    const uint64_t took = nowNs() - t;
+    if (took > maxBroadcastNs) maxBroadcastNs = took;
+    handleClient();
+    while (nowNs() - t < 500000) std::this_thread::yield();
+  }
+  CHECK_EQ(hub.dropped, 1);
+  CHECK_EQ(hub.connectedCount(), 3);
+  CHECK_EQ(hub.oversize, 0);
+
+  // The freed slot takes a new stream.
+  Reader late;
+  std::thread lateT(readStream, &late);
+  CHECK(loopUntil([] { return hub.connectedCount() == 4; }, 5000));
+  hub.broadcast("done", "{}");
+  for (std::thread &t : threads) t.join();
+  lateT.join();
+  release = true;
+  stuck.join();
+  close(listenFd);
+
+  std::vector<uint64_t> all;
+  for (Reader &r : readers) {
+    CHECK_EQ(r.status, 200);
+    CHECK(r.sawDone);
+    CHECK_EQ(r.latNs.size(), EVENTS);                   // a slow peer costs the others nothing
+    all.insert(all.end(), r.latNs.begin(), r.latNs.end());
+  }
+  CHECK_EQ(late.status, 200);
+  CHECK(late.sawDone);
+  CHECK(pct(all, 99) < 50000000ull);                    // generous: loaded CI machines
+
+  if (verbose) {
+    printf("\n%d events to 3 readers (+1 stuck, dropped after it stopped reading):\n", EVENTS);
+    printf("push latency p50 %.0f us, p99 %.0f us, max %.0f us; slowest broadcast() %.0f us\n",
+           pct(all, 50) / 1e3, pct(all, 99) / 1e3, pct(all, 100) / 1e3, maxBroadcastNs / 1e3);
+    printf("status request with 4 streams open answered in %.0f us (503s: %u)\n",
+           statusNs / 1e3, (unsigned)served503);
+    printf("before: setInterval(fetchData, 10000) -> 5 s average, 10 s worst case, one request per client per 10 s\n");
+  }
+  return testResult("sse_push");
+}
@@ -0,0 +1,155 @@
+// test_status_snapshot.cpp — /api/status rebuild and 304 decisions
+// (webserver_mcu/include/status_snapshot.h)
+// Units: the first build, each rebuild trigger (reading, offline flip, NTP, channel)
+// and their order, the FNV-1a ETag against a reference, and 304 only on an exact
+// If-None-Match of a built snapshot. The simulation runs a day of handleStatus()
+// against 8 tanks reporting every 120 s (one going offline for an hour), NTP syncing
+// late and one channel change, polled every 5 s by two dashboards that send their
+// last ETag. Every reply is checked against a body built fresh for that request.
+// Reported: builds by trigger, 200s and 304s, and body bytes against building and
+// sending the full body on every poll.
+#include "status_snapshot.h"
+#include "host_test.h"
+#include <string>
+#include <random>
+
+static uint32_t fnv1a(const std::string &s) {
+  uint32_t h = 2166136261u;
+  for (unsigned char c : s) h = (h ^ c) * 16777619u;
+  return h;
+}
+
+static void testUnits() {
+  StatusSnapshot s{};
+  CHECK_EQ(statusTrigger(s, false, 0, false, 0), STATUS_FIRST);
+  CHECK_EQ(statusReplyCode(s, ""), 200);                    // nothing built: never 304
+  CHECK_EQ(statusReplyCode(s, s.etag), 200);
+
+  const std::string body = "{\"tanks\":[]}";
+  statusSeal(s, body.data(), body.size(), 3, false, 6);
+  char want[12];
+  snprintf(want, sizeof(want), "\"%08x\"", (unsigned)fnv1a(body));
+  CHECK(strcmp(s.etag, want) == 0);
+  CHECK_EQ(strlen(s.etag), 10);
+
+  CHECK_EQ(statusTrigger(s, false, 3, false, 6), STATUS_CURRENT);
+  CHECK_EQ(statusTrigger(s, true,  3, false, 6), STATUS_READING);
+  CHECK_EQ(statusTrigger(s, false, 4, false, 6), STATUS_OFFLINE);
+  CHECK_EQ(statusTrigger(s, false, 3, true,  6), STATUS_NTP);
+  CHECK_EQ(statusTrigger(s, false, 3, false, 11), STATUS_CHANNEL);
+  CHECK_EQ(statusTrigger(s, true,  4, true,  11), STATUS_READING);   // first match wins
+  CHECK_EQ(statusTrigger(s, false, 4, true,  11), STATUS_OFFLINE);
+  CHECK_EQ(statusTrigger(s, false, 2, false, 6), STATUS_OFFLINE);    // any change, not just up
+
+  CHECK_EQ(statusReplyCode(s, want), 304);
+  CHECK_EQ(statusReplyCode(s, ""), 200);
+  std::string weak = std::string("W/") + want;
+  CHECK_EQ(statusReplyCode(s, weak.c_str()), 200);
+  std::string bare(want + 1, 8);                             // unquoted
+  CHECK_EQ(statusReplyCode(s, bare.c_str()), 200);
+
+  const std::string body2 = "{\"tanks\":[1]}";
+  statusSeal(s, body2.data(), body2.size(), 3, true, 6);
+  CHECK_EQ(statusReplyCode(s, want), 200);                   // old ETag after a rebuild
+  CHECK_EQ(statusTrigger(s, false, 3, true, 6), STATUS_CURRENT);
+  CHECK(strcmp(STATUS_TRIGGER_NAMES[STATUS_CHANNEL], "channel") == 0);
+}
+
+// ---- A day of dashboard polls ----
+struct SimTank { uint32_t lastRxS; uint16_t mm, battery; bool offline; };
+
+static std::string buildBody(const SimTank *t, int n, bool ntp, int channel) {
+  char buf[96];
+  snprintf(buf, sizeof(buf), "{\"ntp_synced\":%s,\"wifi_channel\":%d,\"tanks\":[", ntp ? "true" : "false", channel);
+  std::string s = buf;
+  for (int i = 0; i < n; i++) {
+    snprintf(buf, sizeof(buf), "%s{\"tank_id\":%d,\"distance_cm\":%.1f,\"last_seen_uptime_s\":%u,\"battery_mV\":%u,"
+             "\"offline\":%s}", i ? "," : "", i, t[i].mm / 10.0, (unsigned)t[i].lastRxS, (unsigned)t[i].battery,
+             t[i].offline ? "true" : "false");
+    s += buf;
+  }
+  return s + "]}";
+}
+
+struct PollResult { uint32_t polls = 0, builds[STATUS_TRIGGERS] = {}, r200 = 0, r304 = 0, stale = 0; uint64_t bytes = 0, fullBytes = 0; };
+
+static PollResult runDay(uint32_t seed) {
+  std::mt19937 rng(seed);
+  const int N = 8;
+  const uint32_t DAY = 86400, OFFLINE_S = 360;
+  SimTank tanks[N];
+  uint32_t nextRx[N];
+  for (int i = 0; i < N; i++) { tanks[i] = {0, (uint16_t)(500 + 50 * i), 3900, true}; nextRx[i] = 1 + rng() % 120; }
+  uint32_t offlineFlips = 0;
+  bool dirty = true, ntp = false;
+  int channel = 6;
+  StatusSnapshot snap{};
+  std::string body;
+  std::string clientEtag[2];
+  PollResult r;
+  for (uint32_t now = 0; now < DAY; now++) {
+    if (now == 40) ntp = true;
+    if (now == 50000) channel = 11;                           // router moved; the webserver followed
+    for (int i = 0; i < N; i++) {
+      if (now != nextRx[i]) continue;
+      nextRx[i] += 120;
+      if (i == 3 && now >= 30000 && now < 33600) continue;    // tank 3 silent for an hour
+      tanks[i].lastRxS = now;
+      tanks[i].mm = (uint16_t)(tanks[i].mm + (rng() % 4 == 0 ? (int)(rng() % 5) - 2 : 0));
+      dirty = true;                                           // applyReading()
+    }
+    for (int c = 0; c < 2; c++) {
+      if ((now + c * 2) % 5) continue;
+      r.polls++;
+      // handleStatus(): scanOffline(), then the decision.
+      for (int i = 0; i < N; i++) {
+        const bool off = !tanks[i].lastRxS || now - tanks[i].lastRxS > OFFLINE_S;
+        if (off != tanks[i].offline) { tanks[i].offline = off; offlineFlips++; }
+      }
+      const StatusTrigger why = statusTrigger(snap, dirty, offlineFlips, ntp, channel);
+      if (why != STATUS_CURRENT) {
+        dirty = false;
+        body = buildBody(tanks, N, ntp, channel);
+        statusSeal(snap, body.data(), body.size(), offlineFlips, ntp, channel);
+        r.builds[why]++;
+      }
+      const std::string fresh = buildBody(tanks, N, ntp, channel);
+      r.fullBytes += fresh.size();
+      if (statusReplyCode(snap, clientEtag[c].c_str()) == 304) {
+        r.r304++;
+        if (fresh != body) r.stale++;                        // the client's copy must still be right
+      } else {
+        r.r200++;
+        r.bytes += body.size();
+        if (body != fresh) r.stale++;
+        clientEtag[c] = snap.etag;
+      }
+    }
+  }
+  return r;
+}
+
+int main(int argc, char **argv) {
+  testUnits();
+  const PollResult r = runDay(60);
+  CHECK_EQ(r.stale, 0);
+  CHECK_EQ(r.r200 + r.r304, r.polls);
+  CHECK_EQ(r.builds[STATUS_FIRST], 1);
+  CHECK_EQ(r.builds[STATUS_NTP], 1);
+  CHECK_EQ(r.builds[STATUS_CHANNEL], 1);
+  CHECK_EQ(r.builds[STATUS_OFFLINE], 1);                     // tank 3 going quiet (its return is a reading)
+  CHECK(r.r304 > r.r200);                                     // 8 tanks at 120 s, polls every 5 s
+
+  if (benchEnabled(argc, argv)) {
+    uint32_t builds = 0;
+    for (int i = 1; i < STATUS_TRIGGERS; i++) builds += r.builds[i];
+    printf("\none day, 8 tanks at 120 s, two dashboards polling every 5 s (%u polls):\n", r.polls);
+    printf("builds %u (", builds);
+    for (int i = 1; i < STATUS_TRIGGERS; i++) printf("%s%s %u", i > 1 ? ", " : "", STATUS_TRIGGER_NAMES[i], r.builds[i]);
+    printf(") against %u without the snapshot\n", r.polls);
+    printf("replies 200 %u, 304 %u (%.1f%%); body bytes %llu against %llu (%.1f%%)\n", r.r200, r.r304,
+           100.0 * r.r304 / r.polls, (unsigned long long)r.bytes, (unsigned long long)r.fullBytes,
+           100.0 * r.bytes / r.fullBytes);
+  }
+  return testResult("status_snapshot");
+}
@@ -0,0 +1,220 @@
+// test_telemetry_log.cpp — TelemetryLog (webserver_mcu/include/telemetry_log.h) on a
+// file-backed block device (StdioBlockDevice, build/tlog_test.bin)
+// Checks range and tank queries against a reference copy, remount recovery, a torn
+// last page, wrap-around, and backfilled readings appended after newer live ones
+// (the webserver logs onHistoryBatch backfill as it arrives, so a later segment can
+// hold older timestamps). The benchmark fills the firmware's 8 MB / 64-page-segment
+// layout: appends per second, write amplification for full pages and for the 10-minute
+// flush of a small farm, and pages read / time per range query. Host file reads come
+// from the page cache; on the SD card the pages read are what cost.
+#include "telemetry_log.h"
+#include "host_test.h"
+#include <random>
+#include <vector>
+
+static const char *PATH = "build/tlog_test.bin";
+
+static std::vector<TlogRecord> queryAll(TelemetryLog &log, uint32_t from, uint32_t to, int tank, uint32_t *reads = nullptr) {
+  std::vector<TlogRecord> out;
+  const uint32_t n = log.query(from, to, tank, [&](const TlogRecord &r) { out.push_back(r); });
+  if (reads) *reads = n;
+  return out;
+}
+
+static bool same(const TlogRecord &a, const TlogRecord &b) { return memcmp(&a, &b, sizeof(a)) == 0; }
+
+// What the log holds is the newest suffix of everything appended, in append order.
+static size_t retainedFrom(TelemetryLog &log, const std::vector<TlogRecord> &ref) {
+  const std::vector<TlogRecord> all = queryAll(log, 0, 0xFFFFFFFFUL, -1);
+  if (all.size() > ref.size()) return (size_t)-1;
+  const size_t start = ref.size() - all.size();
+  for (size_t i = 0; i < all.size(); i++) if (!same(all[i], ref[start + i])) return (size_t)-1;
+  return start;
+}
+
+static bool rangeMatches(TelemetryLog &log, const std::vector<TlogRecord> &ref, size_t start,
+                         uint32_t from, uint32_t to, int tank) {
+  std::vector<TlogRecord> want;
+  for (size_t i = start; i < ref.size(); i++) {
+    const TlogRecord &r = ref[i];
+    if (r.t >= from && r.t <= to && (tank < 0 || r.tank_id == tank)) want.push_back(r);
+  }
+  const std::vector<TlogRecord> got = queryAll(log, from, to, tank);
+  if (got.size() != want.size()) return false;
+  for (size_t i = 0; i < got.size(); i++) if (!same(got[i], want[i])) return false;
+  return true;
+}
+
+static TlogRecord rec(uint32_t t, uint8_t tank, uint16_t mm) { return TlogRecord{t, tank, 0x01, mm, 3700}; }
+
+static void testBasics() {
+  remove(PATH);
+  StdioBlockDevice dev;
+  CHECK(dev.open(PATH, 8 * 4));                           // 8 segments of 4 pages
+  TelemetryLog log;
+  CHECK(log.begin(&dev, 4));
+  CHECK_EQ(log.segments, 8);
+  CHECK(queryAll(log, 0, 0xFFFFFFFFUL, -1).empty());
+
+  std::vector<TlogRecord> ref;
+  for (uint32_t i = 0; i < 300; i++) {
+    ref.push_back(rec(1000 + i * 120, (uint8_t)(i % 3), (uint16_t)(500 + i)));
+    CHECK(log.append(ref.back()));
+  }
+  CHECK_EQ(retainedFrom(log, ref), 0);                    // pending records included
+  CHECK(rangeMatches(log, ref, 0, 1000 + 50 * 120, 1000 + 80 * 120, -1));
+  CHECK(rangeMatches(log, ref, 0, 0, 0xFFFFFFFFUL, 2));
+  CHECK(rangeMatches(log, ref, 0, 1000 + 299 * 120, 0xFFFFFFFFUL, -1));   // only the RAM buffer
+  CHECK(queryAll(log, 5000, 4000, -1).empty());           // inverted
+  CHECK(log.flush());
+
+  // Remount: everything flushed comes back, and appends continue after it.
+  TelemetryLog again;
+  CHECK(again.begin(&dev, 4));
+  CHECK_EQ(again.nextSeq, log.nextSeq);
+  CHECK_EQ(retainedFrom(again, ref), 0);
+  CHECK(rangeMatches(again, ref, 0, 1000 + 10 * 120, 1000 + 200 * 120, 1));
+
+  // Torn last page: recovery stops before it and the next flush overwrites it.
+  again.append(rec(900000, 0, 42));
+  again.flush();
+  const uint32_t tornPage = (again.nextSeq - 2) % 4 + again.seqToSegment(again.nextSeq - 1) * 4;
+  uint8_t page[TLOG_PAGE_SIZE];
+  dev.read(tornPage, page);
+  page[TLOG_PAGE_SIZE - 100] ^= 0x5A;
+  dev.write(tornPage, page);
+  TelemetryLog third;
+  CHECK(third.begin(&dev, 4));
+  CHECK_EQ(third.nextSeq, again.nextSeq - 1);
+  CHECK_EQ(retainedFrom(third, ref), 0);
+  third.append(rec(900001, 0, 43));
+  third.flush();
+  ref.push_back(rec(900001, 0, 43));
+  TelemetryLog fourth;
+  CHECK(fourth.begin(&dev, 4));
+  CHECK_EQ(retainedFrom(fourth, ref), 0);
+}
+
+// A later segment holds older timestamps than the one before it.
+static void testBackfill() {
+  remove(PATH);
+  StdioBlockDevice dev;
+  CHECK(dev.open(PATH, 16 * 2));
+  TelemetryLog log;
+  CHECK(log.begin(&dev, 2));
+  std::vector<TlogRecord> ref;
+  const uint32_t perSeg = 2 * TLOG_RECS_PER_PAGE;
+  uint32_t t = 100000;
+  for (uint32_t i = 0; i < perSeg * 3 + 10; i++) { ref.push_back(rec(t += 120, 0, 1500)); log.append(ref.back()); }
+  // Tank 1 comes back after a day offline and backfills its buffered readings: older
+  // than everything tank 0 logged since, landing behind newer records in segment 3.
+  const uint32_t bfFrom = 100000 + 60;
+  for (uint32_t i = 0; i < perSeg + 7; i++) { ref.push_back(rec(bfFrom + i * 120, 1, 2000)); log.append(ref.back()); }
+  for (uint32_t i = 0; i < 20; i++) { ref.push_back(rec(t += 120, 0, 1500)); log.append(ref.back()); }
+  log.flush();
+
+  CHECK(rangeMatches(log, ref, 0, bfFrom, bfFrom + 10 * 120, -1));           // mostly segment 0
+  CHECK(rangeMatches(log, ref, 0, bfFrom, bfFrom + 10 * 120, 1));
+  CHECK_EQ(queryAll(log, bfFrom, bfFrom + 10 * 120, 1).size(), 11);
+  CHECK(rangeMatches(log, ref, 0, bfFrom + perSeg * 120, bfFrom + (perSeg + 6) * 120, 1));
+  CHECK(rangeMatches(log, ref, 0, 0, 0xFFFFFFFFUL, -1));
+
+  // The ranges survive a remount (read back from each segment's last page).
+  TelemetryLog again;
+  CHECK(again.begin(&dev, 2));
+  CHECK_EQ(queryAll(again, bfFrom, bfFrom + 10 * 120, 1).size(), 11);
+  for (uint32_t s = 0; s < again.segments; s++) {
+    CHECK_EQ(again.idx[s].firstSeq, log.idx[s].firstSeq);
+    if (log.idx[s].firstSeq) { CHECK_EQ(again.idx[s].minT, log.idx[s].minT); CHECK_EQ(again.idx[s].maxT, log.idx[s].maxT); }
+  }
+
+  // A window no segment covers reads nothing.
+  uint32_t reads = 0;
+  CHECK(queryAll(log, 10, 20, -1, &reads).empty());
+  CHECK_EQ(reads, 0);
+}
+
+static void testRandomWrap() {
+  remove(PATH);
+  StdioBlockDevice dev;
+  CHECK(dev.open(PATH, 6 * 3));
+  TelemetryLog log;
+  CHECK(log.begin(&dev, 3));
+  std::mt19937 rng(14);
+  std::vector<TlogRecord> ref;
+  uint32_t t = 50000;
+  bool ok = true;
+  for (int i = 0; i < 20000; i++) {
+    t += rng() % 200;
+    const uint32_t at = rng() % 8 == 0 ? t - rng() % 20000 : t;   // some backfill
+    ref.push_back(rec(at, (uint8_t)(rng() % 4), (uint16_t)rng()));
+    log.append(ref.back());
+    if (rng() % 50 == 0) log.flush();                             // partial pages too
+    if (i % 500 == 499) {
+      const size_t start = retainedFrom(log, ref);
+      if (start == (size_t)-1) { ok = false; continue; }
+      const uint32_t a = t - rng() % 30000, b = a + rng() % 10000;
+      if (!rangeMatches(log, ref, start, a, b, -1) || !rangeMatches(log, ref, start, a, b, (int)(rng() % 4))) ok = false;
+      if (i % 2000 == 1999) {                                     // remount now and then
+        log.flush();                                              // may recycle a segment
+        const size_t kept = retainedFrom(log, ref);
+        TelemetryLog again;
+        again.begin(&dev, 3);
+        if (kept == (size_t)-1 || retainedFrom(again, ref) != kept) ok = false;
+        if (!log.begin(&dev, 3)) ok = false;
+      }
+    }
+  }
+  CHECK(ok);
+}
+
+static void bench() {
+  remove(PATH);
+  StdioBlockDevice dev;
+  dev.open(PATH, 16384);                                  // the firmware's 8 MB file
+  TelemetryLog log;
+  log.begin(&dev, 64);
+  // Fill it: three tanks every 120 s, ~58 days to wrap once, plus more to wrap.
+  const uint32_t n = 16384 * TLOG_RECS_PER_PAGE + 5000;
+  const uint32_t t0s = 1760000000;
+  uint64_t t0 = nowNs();
+  for (uint32_t i = 0; i < n; i++) log.append(rec(t0s + i / 3 * 120, (uint8_t)(i % 3), (uint16_t)(1000 + i % 500)));
+  const double secs = (nowNs() - t0) / 1e9;
+  const uint32_t lastT = t0s + (n - 1) / 3 * 120;
+  printf("\n%u records, %u pages written: %.0f appends/s, write amplification %.2f (full pages, %u records/page)\n",
+         n, (unsigned)log.pagesWritten, n / secs, log.writeAmplification(), (unsigned)TLOG_RECS_PER_PAGE);
+  // The firmware flushes every 10 minutes: 5 readings per tank at 120 s, partial pages.
+  printf("write amplification with the 10-minute flush:");
+  for (uint32_t tanks : {1u, 3u, 20u, 64u}) {
+    const uint32_t recs = tanks * 5, pages = (recs + TLOG_RECS_PER_PAGE - 1) / TLOG_RECS_PER_PAGE;
+    printf(" %u tanks %.2f%s", (unsigned)tanks, (double)pages * TLOG_PAGE_SIZE / (recs * sizeof(TlogRecord)),
+           tanks == 64 ? "\n" : ",");
+  }
+
+  struct Q { const char *name; uint32_t span; } qs[] = { {"last hour", 3600}, {"last day", 86400}, {"last week", 7 * 86400}, {"everything", 0xFFFFFFFFUL} };
+  printf("%-11s %8s %8s %10s\n", "range", "records", "pages", "host us");
+  for (const Q &q : qs) {
+    const uint32_t from = q.span == 0xFFFFFFFFUL ? 0 : lastT - q.span;
+    uint32_t reads = 0, count = 0;
+    const uint64_t t1 = nowNs();
+    reads = log.query(from, lastT, -1, [&](const TlogRecord &) { count++; });
+    printf("%-11s %8u %8u %10.0f\n", q.name, (unsigned)count, (unsigned)reads, (nowNs() - t1) / 1e3);
+  }
+  // Same window, but tank 1 backfilled a day of readings at the very end.
+  for (uint32_t i = 0; i < 720; i++) log.append(rec(lastT - 30 * 86400 + i * 120, 1, 777));
+  log.flush();
+  uint32_t reads = 0, count = 0;
+  reads = log.query(lastT - 30 * 86400, lastT - 29 * 86400, 1, [&](const TlogRecord &r) { count += r.distance_mm == 777; });
+  printf("a day backfilled a month late: %u of 720 found, %u pages read\n", (unsigned)count, (unsigned)reads);
+  CHECK_EQ(count, 720);
+  remove(PATH);
+}
+
+int main(int argc, char **argv) {
+  testBasics();
+  testBackfill();
+  testRandomWrap();
+  if (benchEnabled(argc, argv)) bench();
+  remove(PATH);
+  return testResult("telemetry_log");
+}
@@ -0,0 +1,65 @@
+// chunked_out.h — Webserver MCU: buffered writer for streamed (chunked) HTTP bodies
+// Handlers that stream (/api/history, /api/log, /api/power, /metrics, ...) printf
+// into a 512-byte buffer that goes out as one chunk whenever the next piece would
+// not fit. A piece is never cut: one longer than the whole buffer is formatted on the
+// heap and sent as a chunk of its own. The sink is a plain function (the firmware
+// passes one that calls server.sendContent()), so host tests can capture the body.
+// Plain C++, no Arduino deps.
+#pragma once
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct ChunkedOut {
+  typedef void (*Sink)(const char *s, size_t n);
+  Sink     sink;
+  char     buf[512];
+  size_t   len = 0;
+  uint32_t heapPieces = 0;     // pieces bigger than buf (formatted via malloc)
+  uint32_t lostPieces = 0;     // ... and ones dropped because malloc failed
+
+  explicit ChunkedOut(Sink s) : sink(s) {}
+
+  void printf(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    const int n = vsnprintf(buf + len, sizeof(buf) - len, fmt, ap);   // straight into the buffer
+    va_end(ap);
+    if (n <= 0) return;
+    if ((size_t)n < sizeof(buf) - len) { len += n; return; }
+
+    // Didn't fit (what did is past len and gets overwritten): send what's buffered,
+    // then format again into the empty buffer, or on the heap if even that's too small.
+    flush();
+    va_start(ap, fmt);
+    if ((size_t)n < sizeof(buf)) {
+      vsnprintf(buf, sizeof(buf), fmt, ap);
+      len = n;
+    } else {
+      char *big = (char *)malloc((size_t)n + 1);
+      if (big) {
+        vsnprintf(big, (size_t)n + 1, fmt, ap);
+        sink(big, (size_t)n);
+        free(big);
+        heapPieces++;
+      } else {
+        lostPieces++;
+      }
+    }
+    va_end(ap);
+  }
+
+  void write(const char *s, size_t n) {        // raw bytes, no formatting
+    if (len + n > sizeof(buf)) flush();
+    if (n > sizeof(buf)) { sink(s, n); return; }
+    memcpy(buf + len, s, n);
+    len += n;
+  }
+
+  void flush() {
+    if (len) sink(buf, len);
+    len = 0;
+  }
+};
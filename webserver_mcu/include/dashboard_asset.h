@@ -0,0 +1,28 @@
+// dashboard_asset.h — Webserver MCU: what GET / answers, minus the WebServer
+// The dashboard is only ever served at /?v=<content hash>: that URL can be cached
+// for a year, and a firmware update changes the hash so browsers pick it up on the
+// next visit to /. Plain / (or a stale v=) gets a tiny uncached redirect, and a
+// matching If-None-Match gets 304. handleRoot() sends whatever this decides; the
+// host harness (utilities/host_tests/test_dashboard_asset.cpp) serves the same
+// replies over loopback. Plain C++, no Arduino deps (define PROGMEM off-target).
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "index_html_gz.h"    // generated from web/index.html
+
+#define DASHBOARD_URL "/?v=" INDEX_HTML_HASH
+#define DASHBOARD_CACHE_CONTROL "public, max-age=31536000, immutable"
+
+struct DashboardReply {
+  int            code;         // 302, 304 or 200
+  const uint8_t *body;         // gzip, 200 only
+  size_t         len;
+};
+
+// v: the ?v= argument ("" if absent); ifNoneMatch: the request header ("" if absent).
+static inline DashboardReply dashboardReply(const char *v, const char *ifNoneMatch) {
+  if (strcmp(v, INDEX_HTML_HASH) != 0) return { 302, nullptr, 0 };
+  if (strcmp(ifNoneMatch, INDEX_HTML_ETAG) == 0) return { 304, nullptr, 0 };
+  return { 200, INDEX_HTML_GZ, INDEX_HTML_GZ_LEN };
+}
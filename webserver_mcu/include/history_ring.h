@@ -0,0 +1,102 @@
+// history_ring.h — Webserver MCU: compressed in-RAM reading history, one ring per tank
+// Each sample is stored as varint(dt seconds) + zigzag-varint(d distance_mm) relative
+// to the previous sample, in a fixed byte budget. When full, the oldest samples are
+// decoded and folded into (baseT, baseMm) before their bytes are reused, so the ring
+// always decodes from its first retained record. At ~2-3 bytes per 120 s reading a
+// 4 KB ring holds two to three days. The buffer is handed in by init(), so main.cpp
+// can size the rings from the number of tanks. RAM only (see the storage note in
+// main.cpp). Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef HISTORY_RING_BYTES
+#define HISTORY_RING_BYTES 4096   // per tank at most, power of two
+#endif
+
+struct TankHistory {
+  uint8_t *buf;
+  uint32_t cap;        // buffer bytes, power of two
+  uint32_t tail;       // first byte of the oldest record (free-running)
+  uint32_t head;       // one past the newest record (free-running)
+  uint32_t samples;    // records held
+  uint32_t evicted;    // records dropped to make room
+  uint32_t baseT;      // the oldest record decodes relative to these
+  int32_t  baseMm;
+  uint32_t lastT;      // newest sample, for encoding the next one
+  int32_t  lastMm;
+
+  void init(uint8_t *mem, uint32_t bytes) { buf = mem; cap = bytes; reset(); }
+  void reset() { tail = head = samples = evicted = 0; baseT = lastT = 0; baseMm = lastMm = 0; }
+  uint32_t used() const { return head - tail; }
+  uint32_t oldestT() const { return samples ? baseT + peekFirstDt() : 0; }
+
+  // Samples must arrive in time order; t == lastT or older is ignored (duplicate).
+  bool append(uint32_t t, uint16_t mm) {
+    if (samples && t <= lastT) return false;
+    if (!samples) { baseT = lastT = t; baseMm = lastMm = mm; }
+
+    uint8_t rec[10];
+    size_t n = putVarint(rec, 0, t - lastT);
+    n = putVarint(rec, n, zigzag((int32_t)mm - lastMm));
+    while (cap - used() < n) evictOldest();
+
+    for (size_t i = 0; i < n; ++i) buf[(head + i) & (cap - 1)] = rec[i];
+    head += n;
+    samples++;
+    lastT = t;
+    lastMm = mm;
+    return true;
+  }
+
+  // Forward decoder over the retained samples, oldest first.
+  struct Cursor {
+    const TankHistory *h;
+    uint32_t pos, left;
+    uint32_t t;
+    int32_t  mm;
+
+    bool next(uint32_t &tOut, uint16_t &mmOut) {
+      if (!left) return false;
+      uint32_t dt = h->getVarint(pos), zz = h->getVarint(pos);
+      t  += dt;
+      mm += (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+      left--;
+      tOut = t;
+      mmOut = (uint16_t)mm;
+      return true;
+    }
+  };
+  Cursor begin() const { return Cursor{this, tail, samples, baseT, baseMm}; }
+
+  // ---- encoding helpers ----
+  static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+  static size_t putVarint(uint8_t *out, size_t pos, uint32_t v) {
+    do {
+      uint8_t b = v & 0x7F;
+      v >>= 7;
+      out[pos++] = v ? (uint8_t)(b | 0x80) : b;
+    } while (v);
+    return pos;
+  }
+  uint32_t getVarint(uint32_t &pos) const {
+    uint32_t v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+      uint8_t b = buf[pos++ & (cap - 1)];
+      v |= (uint32_t)(b & 0x7F) << shift;
+      if (!(b & 0x80)) break;
+    }
+    return v;
+  }
+  uint32_t peekFirstDt() const { uint32_t p = tail; return getVarint(p); }
+
+  void evictOldest() {
+    uint32_t p = tail;
+    uint32_t dt = getVarint(p), zz = getVarint(p);
+    baseT  += dt;
+    baseMm += (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+    tail = p;
+    samples--;
+    evicted++;
+  }
+};
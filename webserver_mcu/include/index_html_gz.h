@@ -0,0 +1,208 @@
+// index_html_gz.h — GENERATED by tools/build_dashboard.py from web/index.html.
+// Do not edit; change web/index.html and rebuild.
+// raw 14443 B -> minified 11587 B -> gzip 3883 B
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#define INDEX_HTML_ETAG "\"8eea74b6501ec4fc\""
+#define INDEX_HTML_HASH "8eea74b6501ec4fc"
+
+static const size_t INDEX_HTML_GZ_LEN = 3883;
+static const uint8_t INDEX_HTML_GZ[] PROGMEM = {
+  0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0xed,0x5a,0x4b,0x73,0xdb,0xc8,0x11,0xbe,0xf3,0x57,
+  0x8c,0x69,0x7b,0x01,0xac,0x09,0x0a,0x24,0x45,0x91,0x26,0x45,0x3a,0xb6,0x2c,0xad,0x95,0xc8,0x92,0x6b,
+  0x45,0xef,0x66,0x6b,0x6b,0x4b,0x1a,0x02,0x03,0x12,0x12,0x88,0x61,0x01,0x43,0x3d,0x96,0xe2,0x2f,0x48,
+  0xe5,0x96,0x53,0x2e,0xb9,0xe6,0x96,0xbf,0x96,0x9f,0x90,0xee,0x19,0x3c,0x49,0x50,0x52,0x6d,0x65,0x73,
+  0x8a,0x6d,0x89,0x20,0x30,0xfd,0x98,0x9e,0xee,0xaf,0x1f,0xf0,0xfe,0x8b,0x8f,0x67,0x07,0xa3,0x9f,0xbe,
+  0x1c,0x92,0xa9,0x98,0xf9,0xc3,0xca,0x3e,0x7e,0x10,0x9f,0x06,0x93,0x41,0x95,0x05,0x55,0xbc,0xc1,0xa8,
+  0x03,0x1f,0x33,0x26,0x28,0xb1,0xa7,0x34,0x8c,0x98,0x18,0x54,0xbf,0x8e,0x8e,0xcc,0x6e,0x35,0xb9,0x1d,
+  0xd0,0x19,0x1b,0x54,0x6f,0x3c,0x76,0x3b,0xe7,0xa1,0xa8,0x12,0x9b,0x07,0x82,0x05,0xb0,0xec,0xd6,0x73,
+  0xc4,0x74,0xe0,0xb0,0x1b,0xcf,0x66,0xa6,0xfc,0x52,0x23,0x5e,0xe0,0x09,0x8f,0xfa,0x66,0x64,0x53,0x9f,
+  0x0d,0x1a,0x75,0x0b,0xd9,0x08,0x4f,0xf8,0x6c,0xf8,0x89,0x07,0xec,0x9e,0x8c,0x68,0x70,0x1d,0xed,0xef,
+  0xa8,0x5b,0x95,0xfd,0x48,0xdc,0xe3,0xe7,0xb7,0x64,0x49,0x66,0x34,0x9c,0x78,0x41,0x8f,0x58,0x7d,0x32,
+  0xa7,0x8e,0xe3,0x05,0x13,0x79,0x3d,0xe6,0x77,0x66,0xe4,0xfd,0x2a,0xbf,0x8e,0x79,0xe8,0xb0,0xd0,0x84,
+  0x5b,0x7d,0xb2,0xaa,0x8c,0xb9,0x73,0x4f,0x96,0x15,0x17,0xf4,0x31,0x5d,0x3a,0xf3,0xfc,0xfb,0x1e,0x31,
+  0xe9,0x7c,0xee,0x33,0x33,0xba,0x8f,0x04,0x9b,0xd5,0xc8,0x07,0xdf,0x0b,0xae,0x3f,0x53,0xfb,0x5c,0x7e,
+  0x3f,0x82,0x95,0x35,0xa2,0x9d,0xb3,0x09,0x67,0xe4,0xeb,0xb1,0x56,0x23,0xef,0x43,0x50,0xb6,0x46,0x22,
+  0x1a,0x44,0x66,0xc4,0x42,0xcf,0xed,0x57,0xc6,0xd4,0xbe,0x9e,0x84,0x7c,0x11,0x38,0x3d,0x02,0xd4,0x8c,
+  0x86,0xe6,0x24,0xa4,0x8e,0x07,0x5b,0xd6,0x1b,0xad,0xb6,0xc3,0x26,0x35,0xf2,0xd2,0x75,0xdd,0x2e,0x6b,
+  0x10,0xeb,0xb5,0xbc,0x66,0xf6,0xb8,0x45,0x1a,0x96,0xf5,0xda,0xe8,0x57,0x6c,0xee,0xf3,0xb0,0x47,0x5e,
+  0xb6,0x58,0xb3,0xd3,0x6c,0xf5,0x25,0x0b,0x73,0xca,0xbc,0xc9,0x54,0xf4,0x48,0xa3,0xbe,0xdb,0x27,0x33,
+  0x2f,0xc8,0x6e,0x58,0xd6,0xcd,0xb4,0x5f,0x59,0x55,0xea,0x68,0x55,0x0a,0x6b,0x43,0x69,0x89,0x3b,0x65,
+  0xcf,0x1e,0xe9,0x5a,0xd6,0x1c,0x36,0x9b,0xda,0x86,0xd0,0x85,0xe0,0x39,0x03,0x35,0xe5,0x63,0xa0,0xc7,
+  0x83,0x94,0xc4,0x82,0xdd,0x09,0x93,0xfa,0xde,0x04,0x96,0xdb,0xa0,0x34,0x0b,0x13,0x72,0xb0,0x9b,0x10,
+  0x7c,0xd6,0x23,0x2d,0x24,0x7a,0xee,0x46,0xc7,0x2d,0xcb,0x4a,0x36,0xda,0x75,0xe1,0xba,0xb8,0xd1,0xdb,
+  0xa9,0x27,0xd8,0x86,0x42,0xf1,0x41,0x21,0xbb,0x45,0x84,0xdb,0x94,0x02,0xf1,0x24,0xa7,0xd4,0xe1,0xb7,
+  0xb8,0x91,0xdd,0xf9,0x1d,0x69,0xb4,0xe1,0x57,0x38,0x19,0x53,0xbd,0xd9,0x6e,0xd7,0x48,0x63,0xb7,0x55,
+  0x23,0x16,0xfc,0xab,0xb7,0x0c,0x69,0x94,0x78,0x53,0xd3,0x06,0xec,0x4b,0x1e,0x33,0x38,0x02,0x03,0x19,
+  0xf5,0x76,0xc8,0x66,0x7d,0x52,0x54,0x61,0x6d,0x93,0x4a,0xa6,0xb4,0x46,0x22,0xb4,0x09,0xd2,0xf0,0x67,
+  0x37,0x91,0x6a,0xd5,0xe4,0xdf,0x7a,0xd3,0xe8,0x83,0xb4,0x40,0xcc,0xcd,0x48,0x50,0xb1,0x88,0x8a,0xe2,
+  0xac,0xfa,0x5b,0x29,0x2e,0xdd,0x63,0x3b,0x56,0x7d,0x63,0x9f,0x6a,0xf3,0x8e,0x17,0xcd,0x7d,0x0a,0xce,
+  0xe8,0x05,0xf2,0xf4,0xc7,0x3e,0xb7,0xaf,0xe5,0x21,0x49,0x09,0xf7,0x81,0xcd,0x1c,0x90,0x90,0xb7,0xff,
+  0x4b,0xbb,0xcb,0xf6,0xec,0xb7,0xe9,0x96,0x5e,0x36,0x59,0xc7,0x69,0x35,0x53,0xa2,0x80,0x8b,0x2d,0x84,
+  0xae,0x6b,0xdb,0xf6,0x38,0x23,0xb4,0xf7,0x9a,0xdd,0x66,0x57,0x12,0x0a,0x0c,0x35,0x58,0x9f,0xea,0x33,
+  0x09,0x3d,0xa7,0x2f,0x7f,0x9b,0x10,0x0d,0x70,0x4f,0x30,0x13,0xe8,0x16,0xb3,0x00,0x74,0x0f,0xd9,0x9c,
+  0x51,0xa1,0xa3,0x7f,0x99,0xae,0x07,0x71,0x02,0x7e,0x0a,0x8e,0x08,0x27,0x03,0x9b,0x82,0xb3,0x71,0x43,
+  0x03,0x0e,0x65,0x42,0xe7,0xc9,0x36,0xcb,0x9c,0x2a,0x11,0x6b,0xda,0x34,0x5c,0x57,0x75,0xc3,0xc7,0x76,
+  0xb3,0x60,0x6a,0xb1,0xd4,0xc7,0x98,0x35,0x6e,0x26,0x3e,0xa6,0xcc,0xab,0x0e,0x2e,0xe2,0xbe,0xe7,0x48,
+  0x87,0xec,0xec,0x3a,0x9b,0x1e,0x26,0x8f,0x23,0xf3,0xc2,0xf6,0xf3,0x1c,0xae,0x0b,0x0e,0xd7,0xe9,0xa0,
+  0xc7,0x81,0x0b,0x94,0x86,0x8e,0x08,0x01,0x1b,0x00,0xd3,0x38,0xdc,0x93,0xd7,0x2e,0x0f,0x67,0xb8,0x3e,
+  0x2a,0x6e,0xb6,0x37,0xe5,0x37,0x2a,0xfe,0x92,0x45,0xf1,0x7a,0xb4,0xf2,0x4f,0xba,0x09,0x5b,0x30,0x62,
+  0x30,0x4b,0x35,0xda,0x43,0x7f,0xb4,0xb6,0x69,0x04,0x31,0x50,0x90,0x50,0xe7,0xae,0x8b,0x36,0x7c,0xae,
+  0x59,0x99,0xcb,0xc6,0xec,0xad,0x32,0xab,0xd3,0x01,0x2f,0xe9,0x16,0xcd,0x6a,0x26,0x2e,0x43,0x1b,0xdd,
+  0x6e,0xc7,0xed,0x13,0x3e,0xa7,0xb6,0x27,0xee,0xd1,0xe1,0x33,0x07,0x32,0x25,0x52,0x17,0x03,0xa2,0x51,
+  0x6f,0xc9,0x80,0x90,0xb7,0x6e,0x63,0x28,0x1b,0x73,0xdf,0xd9,0x0c,0x42,0x79,0x2c,0x89,0xa0,0xb1,0xdb,
+  0xda,0xb3,0x6c,0xc9,0x1a,0x7c,0x12,0xb8,0xdb,0x6b,0x8c,0x7f,0x1b,0x5b,0xb6,0xd7,0x86,0x8d,0x15,0xd8,
+  0xe6,0x6c,0x95,0xac,0xea,0x3a,0x7b,0x6c,0xaf,0x25,0x57,0xa9,0x20,0x37,0xed,0xa9,0x37,0xcf,0x87,0x47,
+  0x31,0x5c,0x53,0x5f,0xea,0xa2,0xdf,0xec,0x95,0x45,0xbb,0xd4,0xa2,0x44,0xdb,0x12,0xec,0x28,0xdd,0x80,
+  0xf4,0xb7,0x9c,0xbf,0x2c,0xe6,0x73,0x16,0xda,0x34,0x62,0x79,0x2d,0xf9,0xf5,0x53,0x58,0xd1,0x18,0xb7,
+  0x59,0xd3,0xca,0xd3,0x50,0x61,0x86,0x5e,0x74,0x5d,0x82,0x15,0x8e,0xd3,0xcc,0x9d,0x47,0xa7,0x61,0x37,
+  0xec,0x82,0xb0,0x52,0x17,0x7b,0x39,0xb6,0x29,0xa5,0xbb,0x19,0x61,0x92,0xdc,0x80,0xd0,0xa7,0x91,0x30,
+  0x17,0x73,0x07,0xbc,0x7c,0x03,0x35,0x0b,0x28,0xfd,0x72,0xcf,0xee,0xb4,0x3b,0x4e,0x39,0x4e,0x23,0xa7,
+  0x31,0x15,0x10,0x71,0xf7,0xeb,0x5c,0xba,0xe5,0x5c,0x80,0xc0,0xf5,0x7c,0xdf,0x1c,0x53,0x74,0xe4,0x2c,
+  0x77,0xc6,0x79,0x13,0x3d,0xbd,0x4f,0xd2,0x34,0x1b,0x67,0xa5,0x82,0x31,0x5a,0xac,0x4d,0xc7,0x1b,0x87,
+  0xda,0xcd,0xa7,0x5b,0x09,0x17,0x58,0x8f,0xf0,0x04,0x02,0x42,0x06,0xf1,0xec,0xdd,0xb0,0x84,0xae,0x80,
+  0x4d,0xce,0x2e,0x75,0x5b,0x9d,0x82,0x6e,0xeb,0x1a,0x3d,0x16,0xb9,0x82,0x13,0xc1,0xe7,0xb5,0x84,0x8f,
+  0x44,0x43,0xa7,0x63,0x59,0x69,0x1a,0xce,0x42,0x37,0xd1,0x56,0xba,0x65,0x1e,0xa2,0xd4,0x8e,0xc1,0x6c,
+  0xed,0x88,0x30,0xe9,0x49,0x99,0xee,0x74,0x0c,0x7a,0x2e,0x84,0xd4,0x5d,0xd9,0xde,0x2a,0x22,0x92,0x17,
+  0x40,0xf9,0x07,0xb8,0x54,0x9a,0x23,0x1b,0x46,0xb6,0x31,0x74,0x53,0xd0,0x98,0x4e,0xf0,0xcc,0xcb,0x04,
+  0xc0,0x3e,0x20,0x4d,0xe2,0x86,0x7d,0xe6,0x8a,0xf8,0xb2,0x0c,0x19,0x75,0xb3,0x8d,0x00,0x85,0xbf,0x61,
+  0x77,0x25,0xb1,0xb4,0xee,0x72,0x25,0xb1,0x55,0xc8,0xf1,0x0d,0x8c,0xd6,0x38,0xcf,0xa7,0xb0,0x9a,0xfc,
+  0x80,0x37,0xa9,0x5d,0xdc,0x52,0x50,0x39,0x98,0xa0,0xe7,0x04,0xcc,0x46,0xed,0x73,0x48,0x91,0xb8,0x98,
+  0x12,0x85,0x05,0x2a,0x98,0x46,0x40,0x5e,0x50,0xa1,0x82,0xde,0x16,0x72,0x30,0x02,0x0d,0x98,0xff,0x14,
+  0x18,0x27,0x75,0x94,0x52,0x5f,0x81,0x71,0xdb,0xd9,0xb5,0x5a,0x9d,0x18,0x8c,0x53,0xa9,0xaa,0xa4,0x2c,
+  0xf5,0xab,0x1c,0x74,0x15,0x85,0x17,0x11,0x7a,0x9d,0xd3,0x5a,0xa0,0xa5,0xa5,0x62,0xc2,0x63,0xbc,0x80,
+  0x07,0x41,0xa1,0x42,0x70,0x7d,0x86,0x90,0x06,0xbf,0x4d,0xc7,0x0b,0x95,0x65,0x7a,0x44,0xd5,0x08,0x50,
+  0x39,0x60,0xf2,0x6f,0x6c,0xb0,0x11,0xc1,0x9a,0x15,0x4a,0xec,0xde,0x34,0xb2,0x9d,0x35,0xd2,0x9d,0x95,
+  0x2c,0x6c,0x6d,0x2f,0x2d,0x1b,0xcd,0x6d,0x48,0x2c,0x83,0xd6,0x5e,0x84,0x11,0x92,0xcd,0xb9,0xa7,0x52,
+  0x77,0x89,0xab,0x14,0x1c,0xac,0x8d,0x49,0x23,0x1f,0x3c,0xd4,0xf7,0xb3,0xcc,0x9e,0xdb,0x5e,0x9a,0xdb,
+  0x9f,0xd8,0x24,0x66,0xec,0x2d,0xe9,0xbf,0x21,0xd3,0xff,0x1a,0x5b,0x6a,0x23,0x94,0x6c,0xad,0x19,0xac,
+  0x0d,0x8a,0xba,0x60,0x91,0xd8,0xa6,0x47,0xe3,0x6d,0xab,0xd6,0x01,0x2d,0x76,0x53,0x53,0x27,0x19,0x7e,
+  0x63,0xc9,0xde,0x26,0x67,0xdb,0x67,0xb4,0x74,0x8b,0x8d,0xd6,0x5b,0xa0,0x6b,0xd7,0x3a,0xbb,0xdb,0x79,
+  0x17,0xd6,0xc4,0xcc,0x5d,0xce,0xc5,0xd6,0x86,0xa4,0x88,0xf0,0x05,0x80,0x57,0xd1,0xf1,0x44,0x7b,0xf2,
+  0x64,0xe9,0x48,0x1e,0x29,0x1d,0x33,0x87,0x6a,0x6f,0xeb,0x55,0xd6,0x0a,0x35,0xe9,0x78,0x85,0x42,0x0d,
+  0xeb,0xb4,0x4e,0x27,0x76,0xec,0x6c,0xb7,0x8e,0x77,0x93,0xeb,0x64,0x9b,0x2a,0x7b,0x60,0x96,0xe4,0x14,
+  0x45,0x6e,0xb1,0x46,0xd6,0x58,0x58,0xf9,0xba,0x26,0x0b,0xfb,0x3f,0xcc,0x98,0xe3,0x51,0xa2,0xe7,0x1a,
+  0xc3,0x3d,0x6c,0x0c,0x0d,0x68,0x7f,0x0b,0x9d,0xe3,0xda,0xd6,0x1e,0x69,0xa1,0xa4,0xcd,0xb7,0x16,0x62,
+  0x49,0x87,0xb5,0x56,0xce,0x6f,0xb4,0x9d,0xab,0xca,0xfe,0x4e,0xdc,0xc2,0xef,0xef,0xc4,0xb3,0x04,0x6c,
+  0xcb,0xe1,0x03,0x4d,0x61,0x43,0x75,0x10,0x0d,0xaa,0xa9,0x86,0xd5,0xe2,0x7d,0xa5,0x9b,0x1c,0x43,0x34,
+  0x86,0xff,0xfe,0xc7,0x5f,0xff,0x45,0x7e,0xa4,0x21,0xec,0x9e,0x12,0x35,0x2b,0x38,0xa2,0xe1,0x2c,0x02,
+  0xbe,0x8d,0x22,0x59,0xd6,0xa7,0x55,0x89,0xe7,0xc8,0xef,0xe7,0xea,0xeb,0xf0,0x1c,0x7a,0x24,0x50,0xb0,
+  0x5e,0xaf,0xef,0xef,0x00,0x05,0x6a,0xa5,0x3e,0x72,0xe4,0xb2,0x2d,0x52,0x94,0xf2,0xf2,0x60,0x8b,0x76,
+  0xf1,0x99,0x55,0x87,0x3f,0xaa,0x64,0x01,0xf6,0x09,0x49,0xc4,0x02,0x00,0x19,0x02,0xe5,0x0e,0x7d,0x54,
+  0x88,0xf2,0x07,0x25,0x25,0xbe,0x56,0x0b,0x86,0x27,0x8a,0xed,0x26,0x75,0xfc,0x11,0xd9,0xa1,0x37,0x17,
+  0xc3,0x8a,0x0f,0xa9,0x18,0x8b,0xab,0xaf,0xb2,0xb6,0x1a,0x79,0x33,0x46,0x06,0xe4,0x23,0x5c,0xd6,0x03,
+  0x7e,0xab,0x03,0x4a,0xe2,0x82,0x29,0x8d,0xbe,0x67,0x36,0x03,0x14,0x71,0xe0,0x11,0x85,0x15,0x2e,0xf5,
+  0x21,0xeb,0xcb,0x87,0xca,0x46,0x87,0x90,0xa6,0xe1,0x7e,0xb0,0xf0,0xfd,0x9a,0x64,0xa8,0x6c,0x95,0xde,
+  0x8a,0x58,0x08,0xe0,0xf6,0x75,0x2e,0x94,0x04,0xbc,0x89,0x08,0x1c,0x00,0xd0,0x7c,0x3c,0x3c,0x7a,0xff,
+  0xf5,0x64,0x74,0xf1,0xe9,0xf0,0xf8,0xbb,0x4f,0xa3,0x8b,0x83,0xcf,0xf0,0xfc,0x2d,0x38,0x34,0x21,0x3b,
+  0x3b,0x80,0xce,0x2c,0x20,0x62,0xca,0x88,0xeb,0x85,0xb3,0x5b,0x1a,0x32,0x22,0xe8,0x18,0xf2,0x10,0xa8,
+  0x44,0x02,0x4e,0x1c,0x36,0x17,0x53,0x69,0x32,0x4a,0xd0,0xcc,0x15,0x77,0x11,0xa8,0x44,0x8b,0x38,0x47,
+  0x05,0x6e,0x48,0xc7,0x9d,0x9d,0x8b,0xd0,0x58,0x12,0xcf,0xd5,0x5f,0x24,0xdf,0xa0,0xc8,0x12,0x8b,0x30,
+  0x20,0xda,0x29,0x03,0xcd,0x34,0x0c,0x08,0xd4,0xc6,0x19,0x04,0xec,0x56,0x5a,0x20,0xa5,0xeb,0x27,0x4b,
+  0x9d,0xba,0xe0,0x27,0x1c,0x67,0x4e,0xc8,0x17,0x1e,0x81,0x85,0x75,0x8d,0x05,0xe6,0xd7,0x73,0xad,0xb6,
+  0x9c,0xf2,0x45,0xd8,0x68,0xf6,0xa4,0x69,0x56,0x32,0x5e,0x4b,0x94,0x39,0xf7,0x20,0x0a,0xf4,0x88,0xd9,
+  0x4a,0x1b,0xb8,0x18,0x0c,0xd0,0x18,0x99,0x3a,0x5f,0x83,0x6b,0x30,0x7d,0x00,0x0a,0xa9,0xe7,0xfb,0x7b,
+  0x56,0xfa,0xf0,0xf2,0xd5,0x12,0xee,0xac,0x22,0x42,0x27,0xfc,0x32,0xd1,0x78,0x36,0xf8,0x4c,0xc5,0xb4,
+  0xee,0xfa,0x9c,0x87,0x48,0xb0,0xb3,0x87,0x90,0x0e,0xc4,0xb3,0x35,0xd2,0xd9,0x6a,0x56,0x20,0x9c,0xe6,
+  0x09,0x67,0x8a,0x2c,0x5b,0x3d,0x5d,0x4d,0x09,0xd0,0xbc,0xde,0xb3,0x52,0xb2,0xdc,0x8e,0xc0,0x08,0xf6,
+  0x02,0x13,0x88,0x8c,0xa1,0x13,0x30,0xa1,0xaf,0x4f,0x6b,0x98,0xe2,0x85,0xda,0x19,0x5e,0xad,0x6d,0x4d,
+  0x1e,0x7a,0x2c,0xdb,0xbf,0xf1,0x07,0x53,0x62,0x4a,0x82,0x54,0xaa,0x54,0x07,0xa7,0x01,0x50,0x8c,0xc2,
+  0x02,0xa3,0x5c,0xe2,0x11,0xd4,0x86,0x5f,0xd2,0xd2,0x30,0x27,0x35,0xe3,0xfc,0x98,0x76,0xd2,0x34,0xb8,
+  0xa8,0xa8,0x9c,0xb5,0xa6,0x85,0x17,0xe8,0x0d,0x2c,0x8a,0xf3,0x3a,0x21,0xd9,0xce,0xd4,0xf8,0x16,0x1e,
+  0x18,0x52,0x39,0x8a,0xd3,0x12,0x92,0xaa,0x18,0x41,0x31,0x13,0x1c,0xa8,0x74,0xa7,0x53,0x79,0xcf,0x58,
+  0x56,0x44,0x78,0xbf,0x8c,0x5d,0x3d,0x04,0xd7,0xa6,0x58,0x15,0x12,0x97,0x09,0x7b,0xaa,0x6b,0x3b,0x74,
+  0xee,0xed,0x48,0x32,0xad,0x86,0x90,0xce,0xc4,0x94,0x3b,0x3d,0xed,0xcb,0xd9,0xf9,0x08,0x6e,0x28,0xe4,
+  0x8a,0x7a,0x4b,0xed,0x40,0x4d,0x43,0xcd,0xd1,0xfd,0x9c,0x69,0x3d,0x0d,0xc7,0x8f,0x9e,0x4d,0x51,0xc0,
+  0xce,0x55,0xc4,0x03,0x6d,0x55,0x23,0x08,0x88,0x3d,0xf2,0xc7,0xf3,0xb3,0x53,0x68,0xb3,0xd0,0x33,0x3d,
+  0xf7,0x5e,0x5f,0x2a,0x2d,0x56,0x06,0x59,0x19,0x49,0xbc,0x5d,0xa5,0x4a,0x84,0x75,0x24,0xd6,0x8d,0x3a,
+  0xb0,0x02,0x6d,0x74,0x63,0x30,0x94,0x36,0xe9,0x57,0x30,0x50,0xc2,0x3a,0xbf,0x8e,0xad,0xca,0x7d,0x56,
+  0x67,0x61,0x08,0x6e,0xa2,0x9d,0xa3,0xb2,0x84,0xc6,0x7e,0x4d,0x3d,0x9f,0x39,0xa0,0x69,0x18,0xb7,0x76,
+  0x35,0x72,0xf5,0xf0,0xa0,0x69,0x60,0x1c,0x08,0x92,0x50,0xe8,0x57,0xe4,0x9b,0x6f,0xc8,0x95,0xa2,0x25,
+  0xef,0xd2,0xab,0x1e,0xb9,0x2c,0xe1,0x43,0xf4,0x57,0xcb,0x84,0xd1,0xca,0xb8,0x94,0x16,0x5e,0x29,0xd5,
+  0xd8,0x13,0x8a,0xc8,0x7b,0xa0,0x07,0x4b,0x25,0x97,0x3d,0x57,0x1c,0x33,0x97,0x52,0x0d,0x25,0xce,0x8a,
+  0x3f,0xaa,0xd2,0x14,0x43,0x9e,0x1a,0xc9,0x69,0xd9,0x60,0x28,0x87,0xdb,0x8b,0x19,0x58,0xbe,0x3e,0x61,
+  0xe2,0xd0,0x67,0x78,0xf9,0xe1,0xfe,0xd8,0xd1,0xb5,0x22,0xa8,0x6b,0xa9,0x75,0x21,0x4d,0x3c,0x46,0x96,
+  0x66,0x11,0xa4,0xd8,0xc4,0x55,0x11,0x2e,0x00,0x56,0x61,0x51,0x1d,0x33,0x78,0x7c,0xea,0xc8,0x0f,0x33,
+  0x01,0xdc,0xbe,0x88,0xc7,0x73,0xef,0x88,0x76,0x2e,0xaf,0x34,0xb0,0xa5,0x76,0xca,0x05,0x89,0xbf,0x2a,
+  0x62,0x99,0x1e,0x4e,0xa9,0x84,0xda,0xcb,0xdc,0xc0,0xf1,0xd5,0xb2,0x84,0x51,0x36,0x2e,0x94,0xcc,0x8a,
+  0x83,0x40,0x6d,0x75,0x19,0xe7,0x00,0x9c,0xe9,0x03,0xb7,0x8d,0x24,0xa7,0xb2,0x76,0xa1,0x63,0xa8,0x6e,
+  0xa6,0x42,0xd5,0x3e,0x54,0x21,0xff,0xfe,0xfd,0x9f,0x44,0x1d,0x4d,0x1c,0x28,0x25,0x69,0x6d,0xad,0x75,
+  0x40,0x76,0xea,0x72,0x63,0x01,0x34,0x05,0x58,0xac,0x56,0x09,0xe1,0x81,0x0d,0x21,0x71,0x3d,0xa8,0x16,
+  0x82,0x50,0xc3,0xa7,0x9a,0x51,0x1d,0x8e,0xb0,0xa4,0x95,0x72,0xf7,0x77,0x14,0xaf,0xc7,0x98,0x02,0x3f,
+  0xf9,0x67,0x0b,0xd3,0x28,0xe0,0xfc,0x57,0x76,0xd1,0xb0,0x66,0xc8,0xfa,0x5c,0x7e,0x83,0xca,0x8d,0x7c,
+  0xf6,0x02,0xe8,0x4b,0xa3,0xff,0x9e,0x84,0x66,0x41,0x42,0xf3,0x77,0x90,0xd0,0x98,0xe6,0xb7,0x00,0x15,
+  0xd1,0x22,0x7c,0x0e,0x73,0x22,0x0b,0xf9,0xea,0x36,0xe6,0xf2,0xe9,0x85,0x12,0x81,0xfc,0x0f,0x64,0xd9,
+  0xaf,0xa4,0xe4,0xd8,0x17,0x4a,0x92,0xcb,0x24,0x82,0x7c,0x40,0x69,0xf0,0x34,0x19,0x8b,0x6a,0xba,0xfc,
+  0xf0,0xf0,0xf3,0x2f,0x46,0x3d,0x02,0x49,0x0c,0xc0,0x0a,0x2a,0x23,0xa1,0xeb,0xb4,0x36,0x06,0xb8,0x52,
+  0x0b,0x2e,0x3c,0xc7,0x1c,0x27,0x57,0xb2,0xc1,0x0f,0x75,0xc5,0x4b,0x10,0xee,0x4a,0x86,0x69,0x50,0x7b,
+  0x18,0x65,0xc9,0x5a,0x80,0x58,0xf9,0x55,0xcd,0x33,0x2e,0xec,0x19,0x79,0x78,0xd8,0xac,0x47,0x12,0xc5,
+  0x20,0x09,0xa2,0x5e,0x42,0x4e,0xa3,0x2e,0x22,0xc6,0x82,0x8b,0x85,0x2c,0x68,0x2e,0x22,0x95,0x4c,0x90,
+  0x3a,0x5f,0xe8,0x24,0x29,0xe6,0x9d,0x4c,0x7d,0x10,0x5c,0xf9,0x64,0x52,0xa8,0x88,0x4c,0x52,0xc6,0x35,
+  0x05,0x95,0x64,0x60,0x86,0xba,0xc6,0xd7,0xc9,0x23,0xc0,0x90,0x04,0x3b,0xd2,0x2a,0x1b,0x36,0xf2,0x62,
+  0xa0,0x4a,0xac,0xac,0x42,0x3b,0x90,0x87,0xa8,0x15,0x47,0x70,0x00,0x99,0xea,0xc6,0x08,0xe0,0x66,0xa0,
+  0x9d,0x1d,0x1d,0x9d,0x1c,0x9f,0x1e,0x6a,0x2a,0x01,0x24,0x52,0x01,0xc2,0x63,0x29,0x2a,0xb5,0x8b,0x3a,
+  0x15,0x17,0x38,0xf9,0x33,0x96,0x65,0xac,0xe3,0xb1,0x20,0x14,0x30,0x79,0xd6,0xef,0x47,0xe4,0xfb,0xe3,
+  0xf3,0x3f,0x69,0xfd,0x15,0x61,0x50,0x20,0x91,0x52,0x52,0xbe,0x4e,0x75,0x26,0x09,0x56,0xf1,0x5e,0x71,
+  0x7f,0x78,0x1f,0x36,0x9b,0x6c,0xfb,0x1d,0x96,0x2a,0x85,0x9d,0x43,0x8d,0x76,0xe4,0xdd,0x31,0x47,0x6f,
+  0x18,0x2b,0x62,0xcf,0x2e,0x11,0xd3,0x4c,0x53,0x4b,0xed,0x25,0x2b,0x82,0x1b,0xc4,0xb2,0x2d,0x55,0x42,
+  0x81,0x5b,0x7a,0x04,0x38,0x91,0xfa,0x62,0x0b,0x92,0xa7,0xdb,0xac,0x44,0xca,0x69,0xa5,0xcc,0x44,0xf1,
+  0x58,0xbe,0x3a,0x20,0xa5,0x7f,0x72,0xef,0x09,0xd5,0xc7,0x54,0xc8,0x63,0x8e,0x47,0x98,0x17,0xb3,0x1f,
+  0x86,0x16,0x32,0xc8,0x43,0x67,0xfc,0x0c,0x81,0xf6,0x6f,0x7f,0x01,0xbc,0xd7,0xf3,0xcb,0x77,0xa0,0x70,
+  0xb1,0x8c,0x54,0x4a,0xd3,0x58,0xfd,0xa0,0x82,0x4f,0x4a,0x02,0x39,0x12,0xe4,0xdf,0x6c,0x47,0xf9,0x57,
+  0xcb,0xd8,0x27,0xde,0x69,0x89,0x03,0xf5,0x34,0x6d,0xf5,0x08,0xde,0x63,0x72,0x05,0x32,0xef,0x4d,0x63,
+  0x55,0x02,0xf4,0x69,0x5b,0xb8,0x9d,0xf1,0xc7,0x78,0x49,0x0f,0x93,0x57,0x7c,0xfe,0xab,0xfd,0x71,0x38,
+  0xdc,0x8f,0x66,0xd4,0xf7,0xd5,0xfb,0x5e,0x7c,0x98,0x1a,0x19,0x04,0xa9,0x47,0xa5,0x1d,0xd3,0xc6,0x34,
+  0xb7,0x5a,0xbe,0xa0,0x4a,0x64,0xc7,0x89,0xed,0xa3,0x9c,0xe3,0xbc,0x5a,0xc6,0x1e,0xb0,0x7a,0x5d,0x1d,
+  0x6e,0x63,0x9c,0x4d,0x2c,0xab,0x43,0xd0,0x48,0xf9,0xe8,0x3b,0xa2,0xc7,0xa4,0x0f,0x96,0xf1,0x46,0x7b,
+  0x0d,0x3b,0x83,0x43,0x5d,0x6d,0xef,0xea,0xf2,0x2f,0x0e,0x5e,0xe5,0xe3,0x64,0x85,0x5c,0xb3,0xf0,0x28,
+  0xb3,0x68,0x6e,0x50,0x8e,0x8b,0xd7,0x1b,0x0f,0x80,0x30,0x70,0x2d,0x3d,0xff,0x20,0xc1,0x33,0x45,0x74,
+  0xe1,0x45,0xb0,0xc2,0x88,0x39,0xbf,0x5a,0x82,0xf3,0xac,0x62,0x1d,0x2f,0xf1,0x65,0xa9,0x5d,0xf7,0x02,
+  0x30,0xda,0xa7,0xd1,0xe7,0x13,0x74,0x66,0xf0,0x17,0xc0,0x98,0xc7,0xfa,0xc7,0x5c,0xb9,0x15,0x4d,0xf9,
+  0x6d,0xdc,0xe5,0x1e,0xa4,0x13,0x51,0xfd,0x7f,0x57,0x6e,0xad,0x95,0x55,0x03,0x2d,0x56,0x06,0x9a,0x64,
+  0x80,0x9d,0x42,0xdd,0x34,0xd0,0x72,0x55,0xd3,0x5a,0x45,0xf4,0xff,0x7a,0xe8,0xff,0xf5,0xd0,0xef,0x5f,
+  0x0f,0x5d,0x3e,0x89,0xc6,0x4f,0xa0,0x6e,0xf4,0x18,0xde,0x6e,0xbe,0x99,0xa8,0x0e,0x33,0xa4,0x35,0xcd,
+  0x4d,0x80,0x85,0x7b,0x31,0xac,0x3e,0x13,0x55,0x9f,0x03,0xaa,0x56,0x8a,0xa5,0x8f,0x42,0x29,0xca,0x96,
+  0x8b,0x1e,0xc7,0xca,0x62,0x69,0x53,0x1d,0xfe,0xf8,0xfe,0x78,0x74,0x7c,0xfa,0x1d,0x39,0x38,0x3b,0x3d,
+  0x3d,0x3c,0x18,0x1d,0x9f,0x9d,0x3e,0x0e,0x98,0xa5,0x56,0x39,0xe5,0xb2,0xf9,0x22,0x61,0xdc,0xa8,0x91,
+  0x7b,0x26,0xd6,0x0f,0xaa,0x0c,0x14,0x37,0xda,0xcc,0x23,0x39,0x9f,0xcb,0xe0,0xce,0x7d,0x0c,0xb7,0xd4,
+  0x30,0x0f,0x41,0xcb,0x2d,0xf0,0x56,0xae,0x30,0xfc,0xfc,0xfe,0xa0,0x47,0x0e,0x0e,0x7a,0x1f,0x3f,0xf4,
+  0xde,0x77,0x7a,0x6f,0x9b,0xbd,0x83,0x66,0xef,0x43,0x37,0xb7,0xbb,0xe1,0x09,0xc5,0x71,0x03,0x73,0x43,
+  0x16,0x4d,0x31,0x3b,0xa6,0x43,0xad,0x22,0x58,0x1b,0x65,0x13,0x2d,0x23,0x9f,0x58,0x86,0x3f,0xb0,0x30,
+  0x92,0xef,0x2d,0x1a,0x75,0x2b,0x97,0x08,0xd6,0x46,0x1f,0x72,0x9e,0x81,0xd9,0x4e,0x7f,0xd6,0xc4,0x43,
+  0x61,0x32,0x8e,0x3c,0x6c,0x6a,0x4f,0x59,0x4f,0x0b,0x38,0xa0,0x2d,0x0f,0x59,0x6e,0xea,0x91,0x9f,0x2c,
+  0xbe,0x23,0x4b,0xed,0xd8,0x35,0x4f,0xc1,0x17,0xcd,0xcf,0x38,0x11,0xd0,0xf2,0x8f,0x57,0x50,0xbe,0x2c,
+  0x57,0x72,0xc4,0x01,0xe5,0x69,0x32,0x42,0x78,0x31,0x18,0xb4,0xac,0x5d,0x50,0x27,0x1d,0x66,0x10,0x31,
+  0x0d,0xf9,0x2d,0x41,0x5b,0x1c,0xaa,0x21,0xc2,0xa7,0xd1,0xe8,0x0b,0xd1,0xde,0x24,0x24,0x86,0x4a,0x66,
+  0xe9,0xec,0xb2,0x38,0x26,0xe9,0x57,0x0a,0xb3,0xce,0x30,0x9e,0x7a,0x47,0x78,0x7a,0xba,0x76,0x38,0xa2,
+  0x13,0x4d,0x26,0x3c,0x94,0x97,0xb1,0x29,0x91,0x1a,0x70,0x12,0x05,0x74,0x0e,0xf9,0x50,0x64,0x99,0x6c,
+  0x81,0x89,0x6c,0x8e,0xff,0x37,0xee,0x38,0x10,0xfa,0x1a,0xf3,0x3f,0x9b,0xaa,0x51,0x30,0xcf,0x35,0xa3,
+  0x06,0xd0,0x8a,0xba,0x14,0x27,0xaa,0x1e,0xe4,0xad,0x53,0x7d,0x31,0xcf,0x75,0x1b,0x8b,0x79,0xbf,0xb2,
+  0x39,0xe2,0xc8,0x69,0x96,0x3c,0x4e,0x5c,0xb3,0x9f,0x8e,0x5b,0xc2,0x30,0xf6,0xd3,0xdc,0xc0,0xe5,0x48,
+  0x0d,0x69,0x04,0x57,0x47,0x29,0xc3,0xa2,0x87,0x33,0x17,0x58,0xbc,0x66,0x1a,0xd5,0x7b,0xa0,0x1d,0xd6,
+  0x46,0x1c,0xc0,0x75,0x4b,0x15,0x00,0xb2,0xb1,0x2f,0x58,0x56,0x9e,0x5d,0x02,0xe4,0x03,0xa3,0x72,0x59,
+  0x36,0x53,0x4f,0xd0,0x46,0xbd,0xea,0x78,0xe9,0xd8,0xad,0xf6,0x6e,0xbb,0x0f,0xf0,0x9b,0xbd,0x8f,0x95,
+  0x27,0x92,0x43,0xbb,0xef,0x19,0x38,0x2f,0x8e,0xe1,0xbd,0x00,0xcc,0x1c,0xc9,0xf9,0x79,0x1e,0xf6,0xa4,
+  0xef,0xe3,0x5f,0xd9,0x58,0x45,0xec,0x04,0x5f,0xad,0xc5,0xf3,0xf0,0x1a,0x99,0x73,0xdf,0x1f,0x01,0xfe,
+  0xc3,0x1d,0xab,0x9f,0x01,0xc0,0x8c,0x85,0x13,0x79,0x06,0xba,0x50,0xee,0x28,0xea,0x49,0x8b,0xa7,0xda,
+  0x00,0xe8,0xab,0xd6,0x8e,0x33,0x5b,0xd1,0x27,0x0e,0x03,0x61,0xac,0x70,0x6b,0xd3,0xc9,0xd4,0xf0,0xb2,
+  0x9f,0xeb,0x72,0xb3,0xa7,0xaa,0x8b,0xae,0xbb,0x5e,0xe0,0x1c,0x07,0x0e,0xbb,0xd3,0xef,0x06,0xc3,0xbb,
+  0xa4,0x07,0x1e,0x0c,0x06,0x22,0xd7,0x3b,0x03,0x5f,0x6f,0x38,0xb0,0x0c,0x72,0x36,0xbe,0x02,0x1b,0xd5,
+  0xc1,0xa0,0xde,0x24,0xd0,0xd7,0x99,0xfd,0xec,0xfd,0x02,0xdd,0x8e,0xd1,0x57,0xcd,0xdc,0x86,0xa8,0xf9,
+  0x22,0x9a,0xc2,0x66,0xcb,0xdc,0x42,0xcd,0xf5,0x7d,0x04,0x1d,0xa8,0x92,0xe6,0xf7,0x38,0xc6,0xf7,0x79,
+  0x30,0x61,0x21,0x99,0xa1,0xf3,0xb1,0x48,0xce,0xfb,0x95,0x3d,0xd2,0x38,0x79,0xc2,0x91,0xc9,0x86,0x23,
+  0xe7,0xca,0x4e,0x41,0x43,0x71,0x78,0x03,0x7e,0x14,0xe9,0x31,0x1a,0xdc,0x82,0x25,0xf8,0x6d,0x5d,0xde,
+  0x3c,0x87,0x14,0x6f,0xb3,0x75,0x03,0x32,0xf9,0xea,0x02,0x43,0x36,0x5b,0x13,0x83,0x17,0x93,0xac,0x30,
+  0x70,0x59,0x54,0xe7,0x01,0x9f,0x43,0xed,0x86,0x73,0x01,0x63,0x30,0x5c,0xe6,0x5c,0x42,0x8e,0xf2,0xf2,
+  0xb8,0x08,0xa7,0x16,0x93,0xa8,0x21,0xe8,0x26,0x89,0x7a,0xab,0x02,0xcb,0x94,0x8d,0x72,0xa2,0x31,0xfd,
+  0x28,0xa7,0x8d,0xa0,0xc6,0x20,0x1e,0x7e,0xdc,0x06,0xc8,0x8d,0x3a,0x8e,0x5c,0x77,0x02,0xd9,0x9b,0x01,
+  0x67,0x15,0x27,0x10,0x96,0xf0,0x87,0x0d,0x86,0x99,0xeb,0xc9,0xc9,0xb0,0xc4,0x17,0x9d,0xd5,0xe5,0x9c,
+  0xd3,0x50,0x5b,0xd8,0xe4,0x90,0x0d,0x07,0x7e,0x2b,0x87,0x64,0xa4,0x2d,0x75,0x48,0x26,0xf3,0x57,0x83,
+  0x4d,0x0e,0x72,0x1a,0xff,0xe2,0x4a,0xa2,0x73,0xe9,0x80,0xd7,0xe6,0xb3,0x19,0x0d,0x9c,0x6c,0xd4,0x7c,
+  0x85,0x86,0x94,0x27,0xbc,0x0d,0x49,0x8a,0x46,0x5f,0xf3,0x8c,0xa2,0x3b,0x20,0x8c,0x8a,0x63,0x7c,0x3f,
+  0x7a,0x43,0x7d,0x5d,0x9d,0x07,0x2a,0x94,0x9c,0xc9,0xc3,0x03,0x79,0xf3,0x26,0x89,0xea,0xd7,0x7b,0x10,
+  0x2b,0x10,0x19,0xc5,0x33,0x45,0x38,0xc6,0xb6,0x1a,0x38,0xe7,0x58,0xe5,0xa5,0xaa,0x15,0x20,0x0b,0xa0,
+  0x24,0x7e,0xed,0x06,0x45,0x9f,0x7a,0x7f,0xb9,0xa3,0xfe,0xcb,0xf4,0x7f,0x00,0xad,0xb9,0x6b,0xb4,0x43,
+  0x2d,0x00,0x00,
+};
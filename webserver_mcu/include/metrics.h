@@ -0,0 +1,155 @@
+// metrics.h — Webserver MCU: tiny metrics registry rendered in Prometheus text format
+// Counters, gauges and fixed-bucket histograms are plain statics that link themselves
+// into one list at construction, so there is no heap use and nothing to register by
+// hand. Updates are single relaxed atomic adds (safe from the Wi-Fi task as well as
+// loop()); metrics sharing a name form one family and differ only in their labels.
+// Per-tank series are one MetricVec each, over an array the caller sizes at boot.
+// Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+
+#ifndef METRICS_MAX_BUCKETS
+#define METRICS_MAX_BUCKETS 12
+#endif
+
+enum MetricType : uint8_t { METRIC_COUNTER, METRIC_GAUGE, METRIC_HISTOGRAM, METRIC_COUNTER_VEC, METRIC_GAUGE_VEC };
+
+struct Metric {
+  const char *name;
+  const char *help;
+  const char *labels;          // e.g. "tank=\"0\"" or nullptr
+  MetricType  type;
+  Metric     *next = nullptr;
+
+  static Metric *&head() { static Metric *h = nullptr; return h; }
+  static Metric *&tail() { static Metric *t = nullptr; return t; }
+
+  Metric(const char *n, const char *h, const char *l, MetricType t) : name(n), help(h), labels(l), type(t) {
+    if (tail()) tail()->next = this; else head() = this;
+    tail() = this;
+  }
+  Metric(const Metric &) = delete;
+  Metric &operator=(const Metric &) = delete;
+};
+
+struct Counter : Metric {
+  std::atomic<uint32_t> v{0};
+  Counter(const char *n, const char *h, const char *l = nullptr) : Metric(n, h, l, METRIC_COUNTER) {}
+  void inc(uint32_t by = 1) { v.fetch_add(by, std::memory_order_relaxed); }
+  uint32_t value() const { return v.load(std::memory_order_relaxed); }
+};
+
+struct Gauge : Metric {
+  std::atomic<int32_t> v{0};
+  Gauge(const char *n, const char *h, const char *l = nullptr) : Metric(n, h, l, METRIC_GAUGE) {}
+  void set(int32_t x) { v.store(x, std::memory_order_relaxed); }
+  int32_t value() const { return v.load(std::memory_order_relaxed); }
+};
+
+// Observations are in microseconds (or any integer unit); `scale` converts bucket
+// bounds and the sum to the exported unit, e.g. 1e-6 for seconds. The sum is 32 bits
+// because 64-bit atomics are not lock-free on the ESP32; it wraps after 2^32 units
+// (71 min of summed microseconds), which Prometheus reads as a counter reset.
+struct Histogram : Metric {
+  const uint32_t *bounds;      // ascending upper bounds, +Inf implied
+  uint8_t nb;
+  float   scale;
+  std::atomic<uint32_t> counts[METRICS_MAX_BUCKETS + 1];
+  std::atomic<uint32_t> sum{0};
+
+  Histogram(const char *n, const char *h, const char *l, const uint32_t *b, uint8_t count, float sc = 1e-6f)
+      : Metric(n, h, l, METRIC_HISTOGRAM), bounds(b), nb(count > METRICS_MAX_BUCKETS ? METRICS_MAX_BUCKETS : count), scale(sc) {
+    for (auto &c : counts) c.store(0, std::memory_order_relaxed);
+  }
+  void observe(uint32_t x) {
+    uint8_t i = 0;
+    while (i < nb && x > bounds[i]) ++i;
+    counts[i].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(x, std::memory_order_relaxed);
+  }
+};
+
+// One series per index, `key`="0".."n-1" (e.g. one per tank). The values live in a
+// caller-owned array handed over by bind(); plain stores, so update from loop() only.
+struct MetricVec : Metric {
+  const char *key;
+  uint32_t   *v = nullptr;
+  uint16_t    n = 0;
+  MetricVec(const char *nm, const char *h, const char *k, MetricType t) : Metric(nm, h, nullptr, t), key(k) {}
+  void bind(uint32_t *values, uint16_t count) { v = values; n = count; }
+  void inc(uint16_t i) { if (i < n) v[i]++; }
+  void set(uint16_t i, uint32_t x) { if (i < n) v[i] = x; }
+};
+
+// Latency buckets in microseconds: 100 us .. 1 s.
+static const uint32_t METRICS_LATENCY_US[] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000};
+static const uint8_t  METRICS_LATENCY_N    = sizeof(METRICS_LATENCY_US) / sizeof(METRICS_LATENCY_US[0]);
+
+// `out` needs printf(const char *fmt, ...).
+template <class Out>
+static void metricsSample(Out &out, const char *name, const char *suffix, const char *labels, const char *extra) {
+  const bool l = labels && *labels, e = extra && *extra;
+  out.printf("%s%s", name, suffix);
+  if (l || e) out.printf("{%s%s%s}", l ? labels : "", (l && e) ? "," : "", e ? extra : "");
+  out.printf(" ");
+}
+
+template <class Out>
+static void metricsRenderOne(Out &out, const Metric *m) {
+  switch (m->type) {
+    case METRIC_COUNTER:
+      metricsSample(out, m->name, "", m->labels, nullptr);
+      out.printf("%lu\n", (unsigned long)static_cast<const Counter *>(m)->value());
+      break;
+    case METRIC_GAUGE:
+      metricsSample(out, m->name, "", m->labels, nullptr);
+      out.printf("%ld\n", (long)static_cast<const Gauge *>(m)->value());
+      break;
+    case METRIC_HISTOGRAM: {
+      const Histogram *h = static_cast<const Histogram *>(m);
+      char le[24];
+      uint32_t cum = 0;
+      for (uint8_t i = 0; i <= h->nb; ++i) {
+        cum += h->counts[i].load(std::memory_order_relaxed);
+        if (i < h->nb) snprintf(le, sizeof(le), "le=\"%g\"", h->bounds[i] * (double)h->scale);
+        else           snprintf(le, sizeof(le), "le=\"+Inf\"");
+        metricsSample(out, m->name, "_bucket", m->labels, le);
+        out.printf("%lu\n", (unsigned long)cum);
+      }
+      metricsSample(out, m->name, "_sum", m->labels, nullptr);
+      out.printf("%g\n", (double)h->sum.load(std::memory_order_relaxed) * h->scale);
+      metricsSample(out, m->name, "_count", m->labels, nullptr);
+      out.printf("%lu\n", (unsigned long)cum);
+      break;
+    }
+    case METRIC_COUNTER_VEC:
+    case METRIC_GAUGE_VEC: {
+      const MetricVec *mv = static_cast<const MetricVec *>(m);
+      char label[32];
+      for (uint16_t i = 0; i < mv->n; ++i) {
+        snprintf(label, sizeof(label), "%s=\"%u\"", mv->key, (unsigned)i);
+        metricsSample(out, m->name, "", nullptr, label);
+        out.printf("%lu\n", (unsigned long)mv->v[i]);
+      }
+      break;
+    }
+  }
+}
+
+// Emits each family once (HELP/TYPE, then every labelled member) in first-seen order.
+template <class Out>
+static void metricsRender(Out &out) {
+  static const char *TYPE_NAMES[] = {"counter", "gauge", "histogram", "counter", "gauge"};
+  for (const Metric *m = Metric::head(); m; m = m->next) {
+    bool seen = false;
+    for (const Metric *p = Metric::head(); p != m && !seen; p = p->next) seen = strcmp(p->name, m->name) == 0;
+    if (seen) continue;
+    out.printf("# HELP %s %s\n# TYPE %s %s\n", m->name, m->help, m->name, TYPE_NAMES[m->type]);
+    for (const Metric *f = m; f; f = f->next) {
+      if (f == m || strcmp(f->name, m->name) == 0) metricsRenderOne(out, f);
+    }
+  }
+}
@@ -0,0 +1,178 @@
+// relay_frame.h — sensor readings relayed webserver -> siren, authenticated and sequenced
+// Shared verbatim by siren_mcu and webserver_mcu (keep the copies equal).
+//
+// With SIREN_RELAY on, the webserver forwards every new reading it accepts to the
+// siren. A sensor then only has to reach the webserver: one send per wake, on one
+// channel. The siren may get the same reading twice, directly and relayed. Both
+// copies carry the sensor's seq, so its LinkStats drops whichever arrives second,
+// and PathStats records which path won and each path's latency.
+//
+// The reading travels as the SensorPacketV3 the sensor would have sent. The webserver
+// adds a nonce drawn once per boot, its own relay_seq (from 1 each boot) and how long
+// it held the reading. A 64-bit SipHash-2-4 tag under RELAY_KEY (16 bytes, set on
+// both sides) covers it all, so a frame spoofed with the webserver's MAC is rejected
+// and the nonce can't be rewritten. RelayLink keeps a relay_seq window for each of
+// the last RELAY_BOOTS - 1 boots: a replayed frame from any of those is dropped,
+// however far behind its window it is, and a webserver reboot (a new nonce) starts a
+// fresh window, so the first relays after it are taken instead of read as replays.
+// A frame captured from a boot older than that still reads as a new boot; the
+// reading's own seq and boot nonce then dedupe it. Plain C++, no Arduino deps;
+// assumes a little-endian CPU, as the wire formats already do.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "sensor_packet.h"
+
+#define RELAY_TYPE  0xF1
+#define RELAY_BOOTS 8            // relay_seq windows on the siren: 7 recent boots + 1 newcomer
+
+#pragma pack(push,1)
+struct RelayFrame {      // Webserver -> Siren
+  uint8_t  ver;          // 2 (v1 had no boot nonce)
+  uint8_t  type;         // 0xF1
+  uint32_t boot;         // the webserver's per-boot nonce, never 0
+  uint16_t relay_seq;    // per relayed reading, from 1 each boot
+  uint16_t held_ms;      // webserver rx -> relay sent (saturates)
+  SensorPacketV3 pkt;    // the reading; its age_ms is as of the sensor's send
+  uint8_t  tag[8];       // SipHash-2-4(RELAY_KEY, [ver..pkt])
+};
+#pragma pack(pop)
+
+// ---- SipHash-2-4 (Aumasson & Bernstein), 64-bit output ----
+static inline uint64_t sipRotl(uint64_t x, int b) { return (x << b) | (x >> (64 - b)); }
+
+#define SIP_ROUND(v0, v1, v2, v3) do { \
+    v0 += v1; v1 = sipRotl(v1, 13); v1 ^= v0; v0 = sipRotl(v0, 32); \
+    v2 += v3; v3 = sipRotl(v3, 16); v3 ^= v2;                        \
+    v0 += v3; v3 = sipRotl(v3, 21); v3 ^= v0;                        \
+    v2 += v1; v1 = sipRotl(v1, 17); v1 ^= v2; v2 = sipRotl(v2, 32); \
+  } while (0)
+
+static inline uint64_t siphash24(const uint8_t key[16], const uint8_t *m, size_t n) {
+  uint64_t k0, k1;
+  memcpy(&k0, key, 8);
+  memcpy(&k1, key + 8, 8);
+  uint64_t v0 = k0 ^ 0x736f6d6570736575ULL, v1 = k1 ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = k0 ^ 0x6c7967656e657261ULL, v3 = k1 ^ 0x7465646279746573ULL;
+  const size_t whole = n & ~(size_t)7;
+  for (size_t i = 0; i < whole; i += 8) {
+    uint64_t w;
+    memcpy(&w, m + i, 8);
+    v3 ^= w;
+    SIP_ROUND(v0, v1, v2, v3); SIP_ROUND(v0, v1, v2, v3);
+    v0 ^= w;
+  }
+  uint64_t last = (uint64_t)n << 56;
+  for (size_t i = whole; i < n; i++) last |= (uint64_t)m[i] << (8 * (i - whole));
+  v3 ^= last;
+  SIP_ROUND(v0, v1, v2, v3); SIP_ROUND(v0, v1, v2, v3);
+  v0 ^= last;
+  v2 ^= 0xff;
+  SIP_ROUND(v0, v1, v2, v3); SIP_ROUND(v0, v1, v2, v3);
+  SIP_ROUND(v0, v1, v2, v3); SIP_ROUND(v0, v1, v2, v3);
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// ---- Webserver side ----
+static inline RelayFrame makeRelay(const SensorReading &r, uint32_t boot, uint16_t relaySeq, uint32_t heldMs,
+                                   const uint8_t key[16]) {
+  RelayFrame f{};
+  f.ver       = 2;
+  f.type      = RELAY_TYPE;
+  f.boot      = boot;
+  f.relay_seq = relaySeq;
+  f.held_ms   = heldMs > 0xFFFF ? 0xFFFF : (uint16_t)heldMs;
+  encodeSensorPacket(r, (uint8_t *)&f.pkt);
+  const uint64_t tag = siphash24(key, (const uint8_t *)&f, offsetof(RelayFrame, tag));
+  memcpy(f.tag, &tag, sizeof(f.tag));
+  return f;
+}
+
+// ---- Siren side ----
+enum RelayStatus { RELAY_OK, RELAY_NOT_RELAY, RELAY_BAD_TAG, RELAY_BAD_PACKET };
+
+static inline RelayStatus decodeRelay(const uint8_t *data, int len, const uint8_t key[16],
+                                      SensorReading &r, uint32_t &boot, uint16_t &relaySeq, uint16_t &heldMs) {
+  if (len != (int)sizeof(RelayFrame) || data[0] != 2 || data[1] != RELAY_TYPE) return RELAY_NOT_RELAY;
+  RelayFrame f;
+  memcpy(&f, data, sizeof(f));
+  const uint64_t want = siphash24(key, data, offsetof(RelayFrame, tag));
+  uint8_t diff = 0;                       // constant time: don't leak how many bytes matched
+  for (size_t i = 0; i < sizeof(f.tag); i++) diff |= (uint8_t)(f.tag[i] ^ (uint8_t)(want >> (8 * i)));
+  if (diff) return RELAY_BAD_TAG;
+  if (decodeSensorPacket((const uint8_t *)&f.pkt, sizeof(f.pkt), r) != PKT_OK) return RELAY_BAD_PACKET;
+  boot     = f.boot;
+  relaySeq = f.relay_seq;
+  heldMs   = f.held_ms;
+  return RELAY_OK;
+}
+
+// relay_seq windows for recent webserver boots. Each is a LinkStats run with a fixed
+// nonzero boot, so a seq behind its window is SEQ_STALE, never a restart. A nonce not
+// seen before returns SEQ_RESTART and goes into the probation window, win[0]. A second
+// new frame less than a window ahead (what a live webserver sends next) moves it into
+// one of the other RELAY_BOOTS - 1, replacing a boot heard fewer than SEQ_WINDOW
+// times if there is one, else the least recently heard; replays don't count as
+// hearing one. A rebooted webserver passes at once, while stray replayed frames from
+// boots old enough to be forgotten mostly displace each other, not the boots the
+// siren is protecting. cur is the boot heard most recently, for DIAG.
+struct RelayLink {
+  LinkStats win[RELAY_BOOTS];
+  uint32_t  nonce[RELAY_BOOTS] = {0};   // 0 = window unused
+  uint32_t  used[RELAY_BOOTS]  = {0};
+  uint32_t  tick = 0;
+  uint8_t   cur  = 0;
+  uint32_t  received = 0, duplicates = 0, stale = 0;
+  uint32_t  boots = 0;                  // new nonces: reboots, or replays from forgotten boots
+
+  SeqVerdict accept(uint16_t seq, uint32_t boot) {
+    int i = 0;
+    while (i < RELAY_BOOTS && !(nonce[i] && nonce[i] == boot)) i++;
+    const bool fresh = i == RELAY_BOOTS;
+    if (fresh) {
+      i = 0;
+      win[0]   = LinkStats{};
+      nonce[0] = boot;
+      boots++;
+    }
+    const SeqVerdict v = win[i].accept(seq, 1);
+    if (v == SEQ_DUPLICATE) { duplicates++; return v; }
+    if (v == SEQ_STALE)     { stale++; return v; }
+    used[i] = ++tick;                   // replays don't count as hearing a boot
+    received++;
+    if (i == 0 && win[0].received >= 2 && win[0].lost < SEQ_WINDOW) {
+      int j = 1;
+      for (int k = 2; k < RELAY_BOOTS; k++) {
+        const bool thinK = win[k].received < SEQ_WINDOW, thinJ = win[j].received < SEQ_WINDOW;
+        if (thinK != thinJ ? thinK : used[k] < used[j]) j = k;
+      }
+      win[j] = win[0]; nonce[j] = nonce[0]; used[j] = used[0];
+      nonce[0] = 0;
+      i = j;
+    }
+    cur = (uint8_t)i;
+    return fresh && boots > 1 ? SEQ_RESTART : v;
+  }
+
+  bool synced() const { return boots != 0; }
+  const LinkStats &current() const { return win[cur]; }
+  uint32_t currentBoot() const { return nonce[cur]; }
+};
+
+// Per tank and path: how many copies came that way, how often that copy was the one
+// acted on, and sensor-sample-to-siren latency over all copies.
+enum DeliveryPath : uint8_t { PATH_DIRECT, PATH_RELAY, PATH_COUNT };
+
+struct PathStats {
+  uint32_t copies = 0, first = 0;
+  uint32_t latSumMs = 0, latMaxMs = 0;
+
+  void copy(uint32_t latMs, bool wasFirst) {
+    copies++;
+    if (wasFirst) first++;
+    latSumMs += latMs;
+    if (latMs > latMaxMs) latMaxMs = latMs;
+  }
+  uint32_t latAvgMs() const { return copies ? latSumMs / copies : 0; }
+};
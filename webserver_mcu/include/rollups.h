@@ -0,0 +1,87 @@
+// rollups.h — Webserver MCU: incremental minute/hour/day rollups per tank
+// Every accepted reading updates one bucket in each tier (O(1) per tier). A bucket
+// keeps count/min/max/sum/first/last, so week- and month-scale views are answered
+// from at most ROLLUP_* buckets without touching raw samples. Buckets are keyed by
+// uptime seconds / width (the same clock as history_ring.h). The buckets come from a
+// caller-owned pool (init()), so tiers can be shortened when RAM is shared by many
+// tanks. Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+
+#ifndef ROLLUP_MINUTES
+#define ROLLUP_MINUTES 60    // 1 hour of 1-minute buckets (per-tank maximum)
+#endif
+#ifndef ROLLUP_HOURS
+#define ROLLUP_HOURS 168     // 7 days of 1-hour buckets
+#endif
+#ifndef ROLLUP_DAYS
+#define ROLLUP_DAYS 62       // ~2 months of 1-day buckets
+#endif
+
+struct RollupBucket {
+  uint32_t id;       // t / width + 1; 0 = empty slot
+  uint16_t count;
+  uint16_t min, max;
+  uint16_t first, last;
+  uint32_t sum;
+
+  uint32_t start(uint32_t width) const { return (id - 1) * width; }
+  uint16_t avg() const { return count ? (uint16_t)((sum + count / 2) / count) : 0; }
+};
+
+enum RollupTierId : uint8_t { TIER_MINUTE, TIER_HOUR, TIER_DAY, TIER_COUNT };
+
+struct RollupTier {
+  RollupBucket *b;
+  uint16_t n;
+  uint32_t width;     // seconds
+  uint32_t newest;    // highest bucket id seen
+};
+
+static inline void rollupAdd(RollupTier &tier, uint32_t t, uint16_t mm) {
+  const uint32_t id = t / tier.width + 1;
+  if (tier.newest >= tier.n && id <= tier.newest - tier.n) return;   // older than the ring covers
+  RollupBucket &k = tier.b[id % tier.n];
+  if (k.id != id) {
+    if (k.id > id) return;                                           // slot already reused
+    k = RollupBucket{id, 0, mm, mm, mm, mm, 0};
+  }
+  k.count++;
+  k.sum += mm;
+  if (mm < k.min) k.min = mm;
+  if (mm > k.max) k.max = mm;
+  k.last = mm;
+  if (id > tier.newest) tier.newest = id;
+}
+
+// Calls f(const RollupBucket&) for each non-empty bucket overlapping [from, to],
+// oldest first; nothing for an inverted range. O(buckets in range).
+template <class F>
+static inline void rollupForEach(const RollupTier &tier, uint32_t from, uint32_t to, F f) {
+  if (!tier.newest || to < from) return;
+  uint32_t lo = from / tier.width + 1;
+  uint32_t hi = to / tier.width + 1;
+  if (hi > tier.newest) hi = tier.newest;
+  if (tier.newest >= tier.n && lo <= tier.newest - tier.n) lo = tier.newest - tier.n + 1;
+  for (uint32_t id = lo; id <= hi; ++id) {
+    const RollupBucket &k = tier.b[id % tier.n];
+    if (k.id == id && k.count) f(k);
+  }
+}
+
+struct TankRollups {
+  RollupTier tiers[TIER_COUNT];
+
+  // pool: minutes + hours + days zeroed buckets, each count >= 1.
+  void init(RollupBucket *pool, uint16_t minutes, uint16_t hours, uint16_t days) {
+    tiers[TIER_MINUTE] = { pool,                   minutes, 60,    0 };
+    tiers[TIER_HOUR]   = { pool + minutes,         hours,   3600,  0 };
+    tiers[TIER_DAY]    = { pool + minutes + hours, days,    86400, 0 };
+  }
+
+  // Invalid readings (mm == 0) are not rolled up.
+  void add(uint32_t t, uint16_t mm) {
+    if (!mm) return;
+    for (int i = 0; i < TIER_COUNT; ++i) rollupAdd(tiers[i], t, mm);
+  }
+};
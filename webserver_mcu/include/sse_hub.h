@@ -0,0 +1,77 @@
+// sse_hub.h — Webserver MCU: the open /api/events streams and their framing
+// handleEvents() writes SSE_RESPONSE_HEAD on the request's socket and parks the
+// client here, so handleClient() goes straight back to serving everyone else.
+// Events are small and written from loop() only; a client whose write comes up short
+// is stopped and its slot freed (EventSource reconnects by itself). Templated on the
+// client so the firmware keeps WiFiClient and the host test a plain TCP socket; a
+// client needs connected(), write(const uint8_t*, size_t) and stop().
+// Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char SSE_RESPONSE_HEAD[] =
+  "HTTP/1.1 200 OK\r\n"
+  "Content-Type: text/event-stream\r\n"
+  "Cache-Control: no-cache\r\n"
+  "Connection: keep-alive\r\n\r\n"
+  "retry: 5000\n\n";
+
+#ifndef SSE_FRAME_MAX
+#define SSE_FRAME_MAX 320
+#endif
+
+// "event: <event>\ndata: <data>\n\n" into out; 0 if it doesn't fit.
+static inline int sseFrame(char *out, size_t cap, const char *event, const char *data) {
+  const int n = snprintf(out, cap, "event: %s\ndata: %s\n\n", event, data);
+  return (n <= 0 || n >= (int)cap) ? 0 : n;
+}
+
+template <typename Client, int N>
+struct SseHub {
+  Client   clients[N];
+  uint32_t eventsSent = 0, dropped = 0, oversize = 0;
+
+  // A free slot, or -1: the caller answers 503 instead of opening the stream.
+  int freeSlot() {
+    for (int i = 0; i < N; i++) if (!clients[i].connected()) return i;
+    return -1;
+  }
+
+  // Writes the response head on c and keeps it in slot. False if c is already gone.
+  bool open(int slot, Client &c) {
+    if (!write(c, SSE_RESPONSE_HEAD, sizeof(SSE_RESPONSE_HEAD) - 1)) return false;
+    clients[slot] = c;
+    return true;
+  }
+
+  void broadcast(const char *event, const char *data) {
+    char frame[SSE_FRAME_MAX];
+    const int n = sseFrame(frame, sizeof(frame), event, data);
+    if (!n) { oversize++; return; }
+    for (int i = 0; i < N; i++) if (write(clients[i], frame, n)) eventsSent++;
+  }
+
+  // Keep-alive comment; also how dead sockets get noticed and their slots reused.
+  void ping() {
+    for (int i = 0; i < N; i++) write(clients[i], ": ping\n\n", 8);
+  }
+
+  int connectedCount() {
+    int n = 0;
+    for (int i = 0; i < N; i++) if (clients[i].connected()) n++;
+    return n;
+  }
+
+private:
+  bool write(Client &c, const char *buf, size_t n) {
+    if (!c.connected()) return false;
+    if (c.write((const uint8_t*)buf, n) != n) {
+      c.stop();
+      dropped++;
+      return false;
+    }
+    return true;
+  }
+};
@@ -0,0 +1,58 @@
+// status_snapshot.h — Webserver MCU: when /api/status is rebuilt, and when it's a 304
+// The status JSON is built once into a buffer and served from there until one of
+// its inputs changes: a new reading (the caller's dirty flag), a tank crossing its
+// offline timeout (a transition counter), NTP sync or the Wi-Fi channel. The body
+// holds nothing "now"-relative, so its FNV-1a hash is a strong ETag and an unchanged
+// poll with a matching If-None-Match gets 304. handleStatus() builds the body and
+// sends whatever this decides; utilities/host_tests/test_status_snapshot.cpp checks
+// the same decisions. Plain C++, no Arduino deps.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// Why a snapshot has to be rebuilt, first match wins; STATUS_CURRENT: it doesn't.
+enum StatusTrigger : uint8_t {
+  STATUS_CURRENT, STATUS_FIRST, STATUS_READING, STATUS_OFFLINE, STATUS_NTP, STATUS_CHANNEL,
+  STATUS_TRIGGERS
+};
+
+static const char *const STATUS_TRIGGER_NAMES[STATUS_TRIGGERS] = {
+  "current", "first", "reading", "offline", "ntp", "channel"
+};
+
+struct StatusSnapshot {
+  bool     built;
+  uint32_t offlineFlips;     // the inputs the body was built from
+  bool     ntp;
+  int      channel;
+  char     etag[12];         // "\"xxxxxxxx\"", quotes included
+};
+
+static inline StatusTrigger statusTrigger(const StatusSnapshot &s, bool dirty, uint32_t offlineFlips, bool ntp,
+                                          int channel) {
+  if (!s.built)                        return STATUS_FIRST;
+  if (dirty)                           return STATUS_READING;
+  if (offlineFlips != s.offlineFlips)  return STATUS_OFFLINE;
+  if (ntp != s.ntp)                    return STATUS_NTP;
+  if (channel != s.channel)            return STATUS_CHANNEL;
+  return STATUS_CURRENT;
+}
+
+// After building `body`: record what it was built from and hash it into the ETag.
+static inline void statusSeal(StatusSnapshot &s, const char *body, size_t len, uint32_t offlineFlips, bool ntp,
+                              int channel) {
+  uint32_t h = 2166136261UL;   // FNV-1a
+  for (size_t i = 0; i < len; i++) { h ^= (uint8_t)body[i]; h *= 16777619UL; }
+  snprintf(s.etag, sizeof(s.etag), "\"%08x\"", (unsigned)h);
+  s.built        = true;
+  s.offlineFlips = offlineFlips;
+  s.ntp          = ntp;
+  s.channel      = channel;
+}
+
+// ifNoneMatch: the request header ("" if absent). 304 or 200.
+static inline int statusReplyCode(const StatusSnapshot &s, const char *ifNoneMatch) {
+  return s.built && strcmp(ifNoneMatch, s.etag) == 0 ? 304 : 200;
+}
@@ -0,0 +1,263 @@
+// telemetry_log.h — Webserver MCU: append-only, segment-based reading log for external media
+// Layout on the block device (only the first segments * pagesPerSegment pages are used):
+//
+//   segment 0            segment 1            ...   (ring: the oldest segment is reused)
+//   [page][page]...[page][page][page]...[page]
+//
+// Every page is written exactly once per pass, whole, with its own header:
+//   magic "TL", version, record count, global page sequence number, CRC-32, the
+//   page's min/max record time, and min/max over its segment so far.
+// Records are batched in a one-page RAM buffer and flushed when it fills (or by
+// flush() on a timer), so writes are always full pages. Records need not arrive in
+// time order (backfilled history interleaves with live readings), so nothing assumes
+// it: range queries skip every segment and page whose [min_t, max_t] misses the
+// window. Recovery reads the first and last page of every segment (sparse index:
+// first seq + time range per segment), then walks the newest segment while the seq
+// keeps counting up and the CRC holds; a torn or stale page simply ends the log
+// there and is overwritten next.
+// Plain C++, no Arduino deps; StdioBlockDevice runs it against a file on the host.
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#ifndef TLOG_PAGE_SIZE
+#define TLOG_PAGE_SIZE 512          // SD sector
+#endif
+#ifndef TLOG_MAX_SEGMENTS
+#define TLOG_MAX_SEGMENTS 256       // RAM for the sparse index: 12 B per segment
+#endif
+
+// ---- Block device ----
+struct BlockDevice {
+  virtual ~BlockDevice() {}
+  virtual uint32_t pageCount() const = 0;                      // TLOG_PAGE_SIZE pages
+  virtual bool read(uint32_t page, uint8_t *buf) = 0;          // unwritten pages may read as anything
+  virtual bool write(uint32_t page, const uint8_t *buf) = 0;
+  virtual bool sync() { return true; }
+};
+
+#pragma pack(push,1)
+struct TlogRecord {            // one stored SensorPacket reading
+  uint32_t t;                  // Unix seconds
+  uint8_t  tank_id;
+  uint8_t  flags;
+  uint16_t distance_mm;
+  uint16_t battery_mV;
+};
+
+struct TlogPageHeader {
+  uint16_t magic;              // 'T','L'
+  uint8_t  version;            // 2 (1 had no time ranges and is not read back)
+  uint8_t  count;              // records in page
+  uint32_t seq;                // global page sequence, starts at 1
+  uint32_t crc;                // CRC-32 over the page with this field zeroed
+  uint32_t minT, maxT;         // this page's records
+  uint32_t segMinT, segMaxT;   // this segment's pages up to and including this one
+};
+#pragma pack(pop)
+
+static const uint16_t TLOG_MAGIC = 0x4C54;
+static const uint8_t  TLOG_VERSION = 2;
+static const uint32_t TLOG_RECS_PER_PAGE = (TLOG_PAGE_SIZE - sizeof(TlogPageHeader)) / sizeof(TlogRecord);
+
+static inline uint32_t tlogCrc32(const uint8_t *d, size_t n) {
+  uint32_t c = 0xFFFFFFFFUL;
+  for (size_t i = 0; i < n; ++i) {
+    c ^= d[i];
+    for (int b = 0; b < 8; ++b) c = (c >> 1) ^ (0xEDB88320UL & (0UL - (c & 1)));
+  }
+  return ~c;
+}
+
+struct TelemetryLog {
+  struct SegIndex { uint32_t firstSeq; uint32_t minT, maxT; };   // firstSeq 0 = empty
+
+  BlockDevice *dev = nullptr;
+  uint32_t pagesPerSeg = 0, segments = 0;
+  SegIndex idx[TLOG_MAX_SEGMENTS];
+
+  uint32_t nextSeq = 1;        // seq of the page the buffer will become
+  uint32_t nextPage = 0;       // where it will be written
+  uint8_t  page[TLOG_PAGE_SIZE];
+  uint8_t  pending = 0;        // records in the RAM buffer
+
+  // Stats
+  uint32_t appends = 0, pagesWritten = 0, writeErrors = 0, recoveredPages = 0;
+  uint64_t recordBytes = 0, deviceBytes = 0;
+
+  float writeAmplification() const { return recordBytes ? (float)deviceBytes / (float)recordBytes : 0.0f; }
+  uint32_t seqToSegment(uint32_t seq) const { return ((seq - 1) / pagesPerSeg) % segments; }
+
+  bool validPage(const uint8_t *p) const {
+    TlogPageHeader h;
+    memcpy(&h, p, sizeof(h));
+    if (h.magic != TLOG_MAGIC || h.version != TLOG_VERSION || h.count == 0 || h.count > TLOG_RECS_PER_PAGE) return false;
+    uint8_t tmp[TLOG_PAGE_SIZE];
+    memcpy(tmp, p, TLOG_PAGE_SIZE);
+    memset(tmp + offsetof(TlogPageHeader, crc), 0, sizeof(h.crc));
+    return tlogCrc32(tmp, TLOG_PAGE_SIZE) == h.crc;
+  }
+  static TlogPageHeader pageHeader(const uint8_t *p) { TlogPageHeader h; memcpy(&h, p, sizeof(h)); return h; }
+  static uint32_t pageSeq(const uint8_t *p) { return pageHeader(p).seq; }
+  static uint8_t pageCount(const uint8_t *p) { return p[offsetof(TlogPageHeader, count)]; }
+  static TlogRecord pageRecord(const uint8_t *p, uint32_t i) {
+    TlogRecord r;
+    memcpy(&r, p + sizeof(TlogPageHeader) + i * sizeof(TlogRecord), sizeof(r));
+    return r;
+  }
+
+  // Mount and recover. False only if the device is too small for two segments.
+  bool begin(BlockDevice *d, uint32_t pagesPerSegment) {
+    dev = d;
+    pagesPerSeg = pagesPerSegment;
+    segments = d->pageCount() / pagesPerSeg;
+    if (segments > TLOG_MAX_SEGMENTS) segments = TLOG_MAX_SEGMENTS;
+    if (segments < 2 || pagesPerSeg < 1) return false;
+
+    uint8_t buf[TLOG_PAGE_SIZE];
+    uint32_t headSeg = 0, headSeq = 0;
+    for (uint32_t s = 0; s < segments; ++s) {
+      idx[s] = SegIndex{0, 0, 0};
+      if (!dev->read(s * pagesPerSeg, buf) || !validPage(buf)) continue;
+      const TlogPageHeader h = pageHeader(buf);
+      if ((h.seq - 1) % pagesPerSeg != 0 || seqToSegment(h.seq) != s) continue;   // not a segment head
+      idx[s] = SegIndex{h.seq, h.segMinT, h.segMaxT};
+      if (h.seq > headSeq) { headSeq = h.seq; headSeg = s; }
+    }
+
+    pending = 0;
+    if (!headSeq) { nextSeq = 1; nextPage = 0; return true; }
+
+    // Older segments are full: their last page carries the whole segment's range. If
+    // it can't be read the range stays unknown, and the segment is never skipped.
+    for (uint32_t s = 0; s < segments && pagesPerSeg > 1; ++s) {
+      if (!idx[s].firstSeq || s == headSeg) continue;
+      const uint32_t lastSeq = idx[s].firstSeq + pagesPerSeg - 1;
+      if (dev->read(s * pagesPerSeg + pagesPerSeg - 1, buf) && validPage(buf) && pageSeq(buf) == lastSeq) {
+        const TlogPageHeader h = pageHeader(buf);
+        idx[s].minT = h.segMinT;
+        idx[s].maxT = h.segMaxT;
+      } else {
+        idx[s].minT = 0;
+        idx[s].maxT = 0xFFFFFFFFUL;
+      }
+    }
+
+    // Walk the head segment while pages continue the sequence.
+    uint32_t lastSeq = headSeq;
+    for (uint32_t i = 1; i < pagesPerSeg; ++i) {
+      if (!dev->read(headSeg * pagesPerSeg + i, buf) || !validPage(buf) || pageSeq(buf) != lastSeq + 1) break;
+      const TlogPageHeader h = pageHeader(buf);
+      idx[headSeg].minT = h.segMinT;
+      idx[headSeg].maxT = h.segMaxT;
+      lastSeq++;
+    }
+    recoveredPages = lastSeq - headSeq + 1;
+    nextSeq  = lastSeq + 1;
+    nextPage = seqToSegment(nextSeq) * pagesPerSeg + (nextSeq - 1) % pagesPerSeg;
+    if ((nextSeq - 1) % pagesPerSeg == 0) idx[seqToSegment(nextSeq)] = SegIndex{0, 0, 0};
+    return true;
+  }
+
+  bool append(const TlogRecord &r) {
+    if (!dev) return false;
+    memcpy(page + sizeof(TlogPageHeader) + pending * sizeof(TlogRecord), &r, sizeof(r));
+    pending++;
+    appends++;
+    recordBytes += sizeof(r);
+    return pending < TLOG_RECS_PER_PAGE ? true : flush();
+  }
+
+  // Writes the buffered records as one page (even if partial) and starts a new one.
+  bool flush() {
+    if (!dev || !pending) return true;
+    const uint32_t seg = seqToSegment(nextSeq);
+    const bool segHead = (nextSeq - 1) % pagesPerSeg == 0;
+    TlogPageHeader h{TLOG_MAGIC, TLOG_VERSION, pending, nextSeq, 0, 0xFFFFFFFFUL, 0, 0, 0};
+    for (uint32_t r = 0; r < pending; ++r) {
+      const uint32_t t = pageRecord(page, r).t;
+      if (t < h.minT) h.minT = t;
+      if (t > h.maxT) h.maxT = t;
+    }
+    h.segMinT = (segHead || h.minT < idx[seg].minT) ? h.minT : idx[seg].minT;
+    h.segMaxT = (segHead || h.maxT > idx[seg].maxT) ? h.maxT : idx[seg].maxT;
+    memcpy(page, &h, sizeof(h));
+    memset(page + sizeof(h) + pending * sizeof(TlogRecord), 0xFF,
+           TLOG_PAGE_SIZE - sizeof(h) - pending * sizeof(TlogRecord));
+    h.crc = tlogCrc32(page, TLOG_PAGE_SIZE);
+    memcpy(page, &h, sizeof(h));
+
+    if (!dev->write(nextPage, page) || !dev->sync()) { writeErrors++; return false; }
+    idx[seg] = SegIndex{segHead ? nextSeq : idx[seg].firstSeq, h.segMinT, h.segMaxT};
+
+    pagesWritten++;
+    deviceBytes += TLOG_PAGE_SIZE;
+    pending = 0;
+    nextSeq++;
+    nextPage = seqToSegment(nextSeq) * pagesPerSeg + (nextSeq - 1) % pagesPerSeg;
+    if ((nextSeq - 1) % pagesPerSeg == 0) idx[seqToSegment(nextSeq)] = SegIndex{0, 0, 0};   // about to recycle
+    return true;
+  }
+
+  // Calls f(const TlogRecord&) for records with from <= t <= to (tank < 0 = all), in
+  // the order they were appended: oldest segment first, then the unflushed RAM buffer.
+  // Returns pages read.
+  template <class F>
+  uint32_t query(uint32_t from, uint32_t to, int tank, F f) {
+    if (!dev || to < from) return 0;
+    uint32_t reads = 0;
+    uint8_t buf[TLOG_PAGE_SIZE];
+    const uint32_t newestSeg = seqToSegment(nextSeq);
+    for (uint32_t k = 1; k <= segments; ++k) {
+      const uint32_t s = (newestSeg + k) % segments;     // oldest first, newest last
+      if (!idx[s].firstSeq || idx[s].maxT < from || idx[s].minT > to) continue;
+
+      for (uint32_t i = 0; i < pagesPerSeg; ++i) {
+        const uint32_t seq = idx[s].firstSeq + i;
+        if (seq >= nextSeq) break;
+        if (!dev->read(s * pagesPerSeg + i, buf)) break;
+        reads++;
+        if (!validPage(buf) || pageSeq(buf) != seq) break;
+        const TlogPageHeader h = pageHeader(buf);
+        if (h.maxT < from || h.minT > to) continue;
+        for (uint32_t r = 0; r < pageCount(buf); ++r) {
+          const TlogRecord rec = pageRecord(buf, r);
+          if (rec.t >= from && rec.t <= to && (tank < 0 || rec.tank_id == tank)) f(rec);
+        }
+      }
+    }
+    for (uint32_t r = 0; r < pending; ++r) {
+      const TlogRecord rec = pageRecord(page, r);
+      if (rec.t >= from && rec.t <= to && (tank < 0 || rec.tank_id == tank)) f(rec);
+    }
+    return reads;
+  }
+};
+
+#ifndef ARDUINO
+#include <stdio.h>
+// Host: a plain file as the block device (sparse; unwritten pages read as zeros).
+struct StdioBlockDevice : BlockDevice {
+  FILE *f = nullptr;
+  uint32_t pages = 0;
+  bool open(const char *path, uint32_t pageCount) {
+    f = fopen(path, "r+b");
+    if (!f) f = fopen(path, "w+b");
+    pages = pageCount;
+    return f != nullptr;
+  }
+  ~StdioBlockDevice() { if (f) fclose(f); }
+  uint32_t pageCount() const override { return pages; }
+  bool read(uint32_t p, uint8_t *buf) override {
+    memset(buf, 0, TLOG_PAGE_SIZE);
+    if (fseek(f, (long)p * TLOG_PAGE_SIZE, SEEK_SET)) return false;
+    fread(buf, 1, TLOG_PAGE_SIZE, f);
+    return true;
+  }
+  bool write(uint32_t p, const uint8_t *buf) override {
+    return !fseek(f, (long)p * TLOG_PAGE_SIZE, SEEK_SET) && fwrite(buf, 1, TLOG_PAGE_SIZE, f) == TLOG_PAGE_SIZE;
+  }
+  bool sync() override { return fflush(f) == 0; }
+};
+#endif
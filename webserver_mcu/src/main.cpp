@@ -1,16 +1,67 @@
 // main.cpp — Webserver MCU (ESP-NOW receiver + NTP + JSON API + POST /api/siren)
-// - Serves your honey-themed INDEX_HTML
-// - Adds POST /api/siren that parses {"action": "..."} JSON
-// - Maps supported actions: "test", "clear_snooze"
-// - Returns 400 for unsupported snoozes until siren firmware is extended
+// - Serves your honey-themed dashboard (pre-gzipped, cacheable)
+// - Adds POST /api/siren that parses {"action": "..."} JSON, queues the command for the
+//   siren and answers 202 with its id; GET /api/siren?id=N reports delivery
 
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WebServer.h>
 #include <esp_now.h>
 #include <esp_wifi.h>  // Added for power save control
+#include <esp_timer.h>
 #include <time.h>
+#include <stdarg.h>
 #include <ArduinoJson.h>   // <-- JSON parsing for POST /api/siren
+#include "dashboard_asset.h" // gzipped dashboard (index_html_gz.h) and GET / replies
+#include "rx_queue.h"
+#include "history_ring.h"
+#include "rollups.h"
+#include "telemetry_log.h"
+#include "metrics.h"
+#include "sse_hub.h"          // /api/events clients and SSE framing
+#include "chunked_out.h"      // buffered writer for streamed bodies
+#include "status_snapshot.h"  // /api/status rebuild triggers, ETag and 304
+#include "sensor_packet.h"    // SensorPacketV1/V2/V3, crc8, LinkStats
+#include "sensor_registry.h"  // SensorInfo table + MAC hash
+#include "slot_schedule.h"    // TDMA slot replies to sensors
+#include "power_budget.h"     // per-phase awake time reported by sensors
+#include "reading_history.h"  // batch delta decoding (the sensor encodes with the same header)
+#include "relay_frame.h"      // authenticated relay of readings to the siren
+#include "siren_command.h"    // acked, retried, coalescing command queue
+
+// ================== Telemetry log (external SD) ==================
+// 1 = append every reading to a preallocated-on-demand file on a microSD card
+// (see the storage note below). Readings are only logged once NTP has synced.
+// The esp32dev_tlog env in platformio.ini builds with it on.
+#ifndef TELEMETRY_LOG
+#define TELEMETRY_LOG        0
+#endif
+#define TLOG_SD_CS_PIN       5
+#define TLOG_FILE            "/telemetry.log"
+#define TLOG_FILE_PAGES      16384UL         // 8 MB
+#define TLOG_PAGES_PER_SEG   64              // 32 KB segments -> 256 index entries
+#define TLOG_FLUSH_MS        (10UL*60UL*1000UL) // bound on readings lost to a power cut
+#if TELEMETRY_LOG
+#include <SD.h>
+#endif
+
+// ================== Transmit slots ==================
+// 1 = answer every v2 history batch with the tank's TDMA slot (slot_schedule.h) so
+// sensors transmit in turn instead of after a random jitter. Sensors in the ESP-NOW
+// peer table get it unicast (acked, retried), the rest by broadcast.
+#define SLOT_SCHEDULE        1
+
+// ================== Channel announce ==================
+// Broadcast our channel (the router's) this often. The siren listens for it to find
+// and follow us, so a sensor's single broadcast reaches both (siren channel_follow.h).
+#define ANNOUNCE_MS          1000
+
+// ================== Siren relay ==================
+// 1 = forward every new v2 reading to the siren as an authenticated RelayFrame, so
+// sensors built with SIREN_RELAY 1 need to reach only us. The siren dedupes relayed
+// against direct copies and logs per-path latency, so this can also run alongside
+// direct delivery to compare the two.
+#define SIREN_RELAY          0
 
 // ================== Wi-Fi (STA) ==================
 const char* WIFI_SSID = "YOUR_WIFI_SSID";
@@ -20,51 +71,142 @@ const char* NTP_POOL  = "pool.ntp.org";
 
 // ================== Peer MACs (STA MACs) ==================
 static const uint8_t MAC_SIREN[6] = {0x00,0x00,0x00,0x00,0x00,0x00}; // Replace with Siren STA MAC
-static const uint8_t MAC_SENSORS[3][6] = {
-  {0x00,0x00,0x00,0x00,0x00,0x00}, // Replace with Sensor 1 STA MAC
-  {0x00,0x00,0x00,0x00,0x00,0x00}, // Replace with Sensor 2 STA MAC  
-  {0x00,0x00,0x00,0x00,0x00,0x00}  // Replace with Sensor 3 STA MAC
+// SipHash key for relay frames; the same 16 bytes go in the siren. Keep it out of git.
+static const uint8_t RELAY_KEY[16] = {0};
+// One row per tank, tank_id = row (up to 255). Add rows to add tanks: per-tank state,
+// the status JSON and the dashboard are all sized from this table at boot.
+static const SensorInfo SENSORS[] = {
+  {{0x00,0x00,0x00,0x00,0x00,0x00}, 90}, // Replace with Sensor 1 STA MAC, tank depth (cm)
+  {{0x00,0x00,0x00,0x00,0x00,0x00}, 85}, // Replace with Sensor 2 STA MAC
+  {{0x00,0x00,0x00,0x00,0x00,0x00}, 95}  // Replace with Sensor 3 STA MAC
 };
+static const uint16_t SENSOR_COUNT = sizeof(SENSORS) / sizeof(SENSORS[0]);
 
 
 // ================== Packets ==================
-#pragma pack(push,1)
-struct SensorPacket {
-  uint8_t  ver;          // 1
-  uint8_t  tank_id;      // 0/1/2
-  uint16_t distance_mm;  // median over 5 s (0 if invalid)
-  uint16_t battery_mV;   // 0 if unused
-  uint8_t  flags;        // bit0: valid_median, bit1: at_risk_le_6cm
-  uint8_t  crc8;         // CRC-8 over [ver..flags]
-};
+// Sensor packets (v1/v2 single readings, history batches, acks) are in sensor_packet.h,
+// siren commands and their acks in siren_command.h.
 
-struct CommandPacket {   // Webserver -> Siren
-  uint8_t  ver;       // 1
-  uint8_t  type;      // 0xC1
-  uint8_t  cmd;       // 1=FORCE_ON, 2=FORCE_OFF, 3=SNOOZE_5MIN, 4=CLEAR_SNOOZE, 5=SNOOZE_CUSTOM_MS
-  uint8_t  tank_id;   // 0/1/2 or 255=ALL
-  uint16_t ms;        // used for FORCE_ON and SNOOZE_CUSTOM_MS
-  uint8_t  crc8;      // CRC-8 over [ver..ms]
-};
-#pragma pack(pop)
+// ================== State (latest per tank) ==================
+// Allocated at boot for SENSOR_COUNT tanks (allocTanks()). What the status build,
+// offline scan and SSE poll walk every time is packed into one small TankState per
+// tank; history, rollups and link stats are separate arrays touched per reading.
+// History and rollups share TANK_HISTORY_RAM: each tank gets the full ring and tiers
+// while they fit, and proportionally shorter ones beyond that.
+#ifndef TANK_HISTORY_RAM
+#define TANK_HISTORY_RAM (64UL * 1024UL)
+#endif
+static const uint32_t OFFLINE_MS = 5UL*60UL*1000UL;    // default when the sensor doesn't say
 
-// CRC-8-ATM (poly 0x07, init 0x00)
-static uint8_t crc8(const uint8_t* d, size_t n) {
-  uint8_t c = 0;
-  for (size_t i=0;i<n;i++){ c^=d[i]; for(int b=0;b<8;b++) c = (c&0x80)? (uint8_t)((c<<1)^0x07):(uint8_t)(c<<1); }
-  return c;
-}
+struct TankState {
+  float    distanceCm;       // NAN until a valid reading
+  uint32_t lastRxMillis;     // monotonic for "ago"; 0 = never
+  uint32_t lastRxEpoch;      // UTC wall time (once NTP syncs)
+  uint32_t offlineAfterMs;
+  uint16_t battery_mV;
+  uint16_t reportIntervalS;  // sensor's adaptive sleep; 0 = unknown
+  bool     offline;
+  bool     ssePending;       // push a "tank" event
+  bool     sseOffline;       // offline state last pushed over SSE
+};
 
-// ================== State (latest per tank) ==================
-static const int MAX_TANKS = 3;
-static float    lastDistanceCm[MAX_TANKS] = {NAN,NAN,NAN};
-static uint16_t lastBattery_mV[MAX_TANKS] = {0,0,0};
-static uint32_t lastRxMillis[MAX_TANKS]   = {0,0,0};  // monotonic for "ago"
-static time_t   lastRxEpoch[MAX_TANKS]    = {0,0,0};  // UTC wall time (once NTP syncs)
+static SensorRegistry registry;                         // MAC -> tank_id
+static uint16_t     tankCount   = 0;
+static TankState   *tanks       = nullptr;
+static TankHistory *tankHistory = nullptr;              // compressed readings, RAM only
+static TankRollups *tankRollups = nullptr;              // minute/hour/day aggregates
+static LinkStats   *sensorLink  = nullptr;              // v2 seq dedupe, loss and latency
+struct TankPower {
+  PowerReport report;        // last PowerBlock the sensor sent (power_budget.h)
+  uint32_t    rxMillis;      // 0 = none yet
+};
+static TankPower   *tankPower   = nullptr;
+static uint32_t     offlineFlips = 0;                   // bumped whenever a tank goes on/offline
+static bool     statusDirty = true;                     // set by applyReading(), cleared by rebuild
+static bool     ssePendingAny = false;                  // some tank has ssePending set
+static CommandQueue cmdq;                               // commands to the siren (siren_command.h)
 
 // ================== HTTP server ==================
 WebServer server(80);
 
+// ================== Metrics (GET /metrics) ==================
+static Counter mRxAccepted   ("espnow_frames_total", "ESP-NOW frames from sensors by outcome", "result=\"accepted\"");
+static Counter mRxCrc        ("espnow_frames_total", "ESP-NOW frames from sensors by outcome", "result=\"crc_mismatch\"");
+static Counter mRxSize       ("espnow_frames_total", "ESP-NOW frames from sensors by outcome", "result=\"bad_size\"");
+static Counter mRxVersion    ("espnow_frames_total", "ESP-NOW frames from sensors by outcome", "result=\"bad_version\"");
+static Counter mRxTankId     ("espnow_frames_total", "ESP-NOW frames from sensors by outcome", "result=\"bad_tank_id\"");
+static Counter mRxQueueFull  ("espnow_frames_total", "ESP-NOW frames from sensors by outcome", "result=\"queue_full\"");
+static Counter mRxDuplicate  ("espnow_frames_total", "ESP-NOW frames from sensors by outcome", "result=\"duplicate\"");
+static Counter mRxStale      ("espnow_frames_total", "ESP-NOW frames from sensors by outcome", "result=\"stale\"");
+static MetricVec mRxTankMismatch("espnow_tank_id_mismatch_total",   // indexed by the tank the sender's MAC belongs to
+                                 "Frames whose tank_id disagrees with the sender MAC", "tank", METRIC_COUNTER_VEC);
+static MetricVec mLinkLost("sensor_frames_lost",                    // sequence gaps in v2 frames
+                           "Sensor transmissions never received (seq gaps)", "tank", METRIC_GAUGE_VEC);
+static MetricVec mSensorPower("sensor_power_uah_per_day",           // from the last power budget, sleep included
+                              "Estimated sensor battery drain (uAh/day)", "tank", METRIC_GAUGE_VEC);
+static const uint32_t READING_AGE_MS[] = {100, 250, 500, 1000, 2000, 3000, 5000, 10000, 30000, 60000};
+static Histogram mReadingAge ("sensor_reading_age_seconds", "Sample end on the sensor -> handled here (v2 frames)",
+                              nullptr, READING_AGE_MS, sizeof(READING_AGE_MS) / sizeof(READING_AGE_MS[0]), 1e-3f);
+static Counter mSlotOk       ("slot_replies_total", "Slot replies handed to esp_now_send()", "result=\"ok\"");
+static Counter mSlotFail     ("slot_replies_total", "Slot replies handed to esp_now_send()", "result=\"fail\"");
+static Counter mAckOk        ("sensor_acks_total", "App-level acks handed to esp_now_send()", "result=\"ok\"");
+static Counter mAckFail      ("sensor_acks_total", "App-level acks handed to esp_now_send()", "result=\"fail\"");
+static Counter mRelayOk      ("siren_relays_total", "Readings relayed to the siren, handed to esp_now_send()", "result=\"ok\"");
+static Counter mRelayFail    ("siren_relays_total", "Readings relayed to the siren, handed to esp_now_send()", "result=\"fail\"");
+static Counter mAnnounce     ("channel_announces_total", "ChannelAnnounce broadcasts sent");
+static Counter mCmdOk        ("siren_commands_total", "Command frames (first sends and resends) handed to esp_now_send()", "result=\"ok\"");
+static Counter mCmdFail      ("siren_commands_total", "Command frames (first sends and resends) handed to esp_now_send()", "result=\"fail\"");
+static Histogram mCmdLatency ("siren_command_send_seconds", "Time spent in esp_now_send() for siren commands",
+                              nullptr, METRICS_LATENCY_US, METRICS_LATENCY_N);
+static Counter mCmdApplied   ("siren_command_results_total", "Queued siren commands by outcome", "result=\"applied\"");
+static Counter mCmdRejected  ("siren_command_results_total", "Queued siren commands by outcome", "result=\"rejected\"");
+static Counter mCmdFailed    ("siren_command_results_total", "Queued siren commands by outcome", "result=\"failed\"");
+static Counter mCmdSuperseded("siren_command_results_total", "Queued siren commands by outcome", "result=\"superseded\"");
+static Counter mCmdQueueFull ("siren_command_results_total", "Queued siren commands by outcome", "result=\"queue_full\"");
+static const uint32_t CMD_APPLY_US[] = {10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000, 5000000};
+static Histogram mCmdApply   ("siren_command_apply_seconds", "Command queued -> siren's ack that it applied it",
+                              nullptr, CMD_APPLY_US, sizeof(CMD_APPLY_US) / sizeof(CMD_APPLY_US[0]));
+static Counter mStatusBuilds[STATUS_TRIGGERS - 1] = {  // indexed by StatusTrigger - 1
+  {"status_snapshot_builds_total", "/api/status snapshot rebuilds by trigger", "trigger=\"first\""},
+  {"status_snapshot_builds_total", "/api/status snapshot rebuilds by trigger", "trigger=\"reading\""},
+  {"status_snapshot_builds_total", "/api/status snapshot rebuilds by trigger", "trigger=\"offline\""},
+  {"status_snapshot_builds_total", "/api/status snapshot rebuilds by trigger", "trigger=\"ntp\""},
+  {"status_snapshot_builds_total", "/api/status snapshot rebuilds by trigger", "trigger=\"channel\""},
+};
+static Counter mStatus200    ("status_replies_total", "/api/status replies by code", "code=\"200\"");
+static Counter mStatus304    ("status_replies_total", "/api/status replies by code", "code=\"304\"");
+static Counter mStatusBytes  ("status_body_bytes_total", "/api/status body bytes sent in 200 replies");
+static Gauge mUptime         ("uptime_seconds", "Seconds since boot");
+static Gauge mHeapFree       ("heap_free_bytes", "Free heap");
+static Gauge mRssi           ("wifi_rssi_dbm", "RSSI of the Wi-Fi uplink (0 when disconnected)");
+static Gauge mRxHighWater    ("espnow_rx_queue_high_water", "Most frames ever waiting in the RX queue");
+
+struct RouteMetrics {
+  Counter   requests;
+  Histogram latency;
+  explicit RouteMetrics(const char *label)
+    : requests("http_requests_total", "HTTP requests by handler", label),
+      latency("http_request_duration_seconds", "Handler run time, including sending the response",
+              label, METRICS_LATENCY_US, METRICS_LATENCY_N) {}
+};
+static RouteMetrics mHttpRoot   ("handler=\"root\"");
+static RouteMetrics mHttpStatus ("handler=\"status\"");
+static RouteMetrics mHttpEvents ("handler=\"events\"");
+static RouteMetrics mHttpHistory("handler=\"history\"");
+static RouteMetrics mHttpLog    ("handler=\"log\"");
+static RouteMetrics mHttpPower  ("handler=\"power\"");
+static RouteMetrics mHttpSiren  ("handler=\"siren\"");
+static RouteMetrics mHttpLegacy ("handler=\"legacy\"");
+static RouteMetrics mHttpMetrics("handler=\"metrics\"");
+
+template <class F>
+static void timed(RouteMetrics &m, F handler) {
+  const uint32_t t0 = micros();
+  handler();
+  m.latency.observe(micros() - t0);
+  m.requests.inc();
+}
+
 // ================== Storage note (please read) ==================
 // This project only keeps static assets (e.g., INDEX_HTML[]) in flash/PROGMEM.
 // Do NOT log sensor history or frequent telemetry to internal flash
@@ -80,281 +222,275 @@ WebServer server(80);
 // (batch/ratelimit to minutes or hours; avoid per-reading writes).
 //
 // TL;DR: flash = code + static files; SD/FRAM/server = logs/history.
+//
+// TELEMETRY_LOG=1 does exactly that: telemetry_log.h writes whole 512-byte pages
+// to a file on the SD card, so each sector is written once per pass of the log.
+// An FRAM chip only needs another BlockDevice implementation.
+
+#if TELEMETRY_LOG
+struct SdFileBlockDevice : BlockDevice {
+  File f;
+  bool open() {
+    if (!SD.begin(TLOG_SD_CS_PIN)) return false;
+    if (!SD.exists(TLOG_FILE)) { File c = SD.open(TLOG_FILE, FILE_WRITE); if (!c) return false; c.close(); }
+    f = SD.open(TLOG_FILE, "r+");
+    return (bool)f;
+  }
+  uint32_t pageCount() const override { return TLOG_FILE_PAGES; }
+  bool read(uint32_t p, uint8_t *buf) override {
+    memset(buf, 0, TLOG_PAGE_SIZE);                 // past EOF = never written
+    if ((uint64_t)p * TLOG_PAGE_SIZE >= f.size()) return true;
+    return f.seek((uint64_t)p * TLOG_PAGE_SIZE) && f.read(buf, TLOG_PAGE_SIZE) == TLOG_PAGE_SIZE;
+  }
+  bool write(uint32_t p, const uint8_t *buf) override {
+    // Pages are appended in order, so the file only ever grows by one page at its end.
+    return f.seek((uint64_t)p * TLOG_PAGE_SIZE) && f.write(buf, TLOG_PAGE_SIZE) == TLOG_PAGE_SIZE;
+  }
+  bool sync() override { f.flush(); return true; }
+};
+static SdFileBlockDevice tlogDev;
+#endif
+static TelemetryLog tlog;
+static bool tlogReady = false;
 
 
 // ================== Your themed INDEX_HTML ==================
-static const char INDEX_HTML[] PROGMEM = R"HTML(<!DOCTYPE html>
-<html lang="en">
-<head>
-    <meta charset="UTF-8">
-    <meta name="viewport" content="width=device-width, initial-scale=1.0">
-    <title>Honey Tanks</title>
-    <style>
-        * { margin: 0; padding: 0; box-sizing: border-box; }
-        body {
-            font-family: -apple-system, BlinkMacSystemFont, 'Segoe UI', Arial, sans-serif;
-            background: linear-gradient(135deg, #fff8e1 0%, #ffecb3 100%);
-            color: #3e2723; line-height: 1.4; min-height: 100vh;
-        }
-        .container { max-width: 800px; margin: 0 auto; padding: 20px; }
-        .header { text-align: center; margin-bottom: 30px;
-            background: linear-gradient(135deg, #ffb300 0%, #ff8f00 100%);
-            color: white; padding: 20px; border-radius: 10px;
-            box-shadow: 0 4px 15px rgba(255, 143, 0, 0.3);
-        }
-        .header h1 { font-size: 2.5rem; color: white; margin-bottom: 10px;
-            text-shadow: 2px 2px 4px rgba(0,0,0,0.2);}
-        .ntp-status { font-size: 0.9rem; padding: 5px 15px; border-radius: 20px; display: inline-block; }
-        .ntp-synced { background: #c8e6c9; color: #2e7d32; }
-        .ntp-not-synced { background: #ffcccb; color: #c62828; }
-        .tanks { display: grid; grid-template-columns: repeat(auto-fit, minmax(250px, 1fr));
-                 gap: 20px; margin-bottom: 30px; }
-        .tank-card { background: linear-gradient(145deg, #fff3e0 0%, #ffe0b2 100%);
-            border: 2px solid #ffb74d; border-radius: 15px; padding: 25px;
-            box-shadow: 0 4px 15px rgba(255, 183, 77, 0.2); text-align: center; transition: transform 0.2s; }
-        .tank-card:hover { transform: translateY(-2px); box-shadow: 0 6px 20px rgba(255, 183, 77, 0.3); }
-        .tank-card.offline { background: linear-gradient(145deg, #efebe9 0%, #d7ccc8 100%);
-            border-color: #a1887f; opacity: 0.8; }
-        .tank-title { font-size: 1.3rem; font-weight: bold; margin-bottom: 15px; color: #bf360c; }
-        .distance { font-size: 3rem; font-weight: bold; margin-bottom: 15px; color: #e65100; }
-        .distance.offline { color: #8d6e63; }
-        .status-chip { display: inline-block; padding: 8px 16px; border-radius: 25px; font-weight: bold; font-size: 0.9rem; margin-bottom: 15px; text-transform: uppercase; }
-        .status-ok { background: #c8e6c9; color: #1b5e20; }
-        .status-at-risk { background: #ffcdd2; color: #b71c1c; }
-        .status-offline { background: #bcaaa4; color: #3e2723; }
-        .last-update { font-size: 0.95rem; color: #6c757d; margin-bottom: 10px; }
-        .battery { font-size: 0.85rem; color: #6c757d; }
-        .fill-bar-container { width: 100%; height: 120px; background: #f3e5ab; border-radius: 8px; margin: 15px 0; position: relative; border: 2px solid #d4af37; }
-        .fill-bar { width: 100%; background: linear-gradient(to top, #d4af37, #ffd700, #ffb300);
-            border-radius: 6px; transition: height 0.5s ease; position: absolute; bottom: 0; box-shadow: inset 0 2px 4px rgba(0,0,0,0.1); }
-        .fill-percentage { position: absolute; top: 50%; left: 50%; transform: translate(-50%, -50%);
-            font-weight: bold; color: #3e2723; font-size: 0.9rem; text-shadow: 1px 1px 2px rgba(255,255,255,0.8); }
-        .waiting-connection { color: #6c757d; font-style: italic; }
-        .control-panel { background: linear-gradient(135deg, #3e2723 0%, #5d4037 100%); color: #fff8e1; border: 2px solid #8d6e63; }
-        .control-panel .tank-title { color: #fff8e1; margin-bottom: 20px; }
-        .control-buttons { display: flex; flex-direction: column; gap: 10px; }
-        .control-btn { background: rgba(255,255,255,0.2); border: 1px solid rgba(255,255,255,0.3);
-            color: white; padding: 12px 16px; border-radius: 8px; cursor: pointer; font-size: 0.9rem; font-weight: 500; transition: all 0.2s; }
-        .control-btn:hover { background: rgba(255,255,255,0.3); transform: translateY(-1px); }
-        .control-btn:active { transform: translateY(0); }
-        .control-btn.test { background: rgba(255,193,7,0.4); border-color: rgba(255,193,7,0.6); }
-        .control-btn.clear { background: rgba(139,195,74,0.4); border-color: rgba(139,195,74,0.6); }
-        .footer { text-align: center; font-size: 0.8rem; color: #5d4037;
-            background: linear-gradient(145deg, #fff3e0 0%, #ffe0b2 100%); border: 2px solid #ffb74d; padding: 15px; border-radius: 10px; box-shadow: 0 2px 10px rgba(255,183,77,0.2); }
-        .footer div { margin: 2px 0; }
-        .loading { text-align: center; padding: 50px; color: #8d6e63; }
-        @media (max-width: 600px) {
-            .container { padding: 15px; }
-            .header h1 { font-size: 2rem; }
-            .distance { font-size: 2.5rem; }
-            .tank-card { padding: 20px; }
-        }
-    </style>
-</head>
-<body>
-    <div class="container">
-        <div class="header">
-            <h1>🍯 Warcola Honey Farms</h1>
-            <div class="ntp-status" id="ntpStatus">Syncing...</div>
-        </div>
-        <div class="tanks" id="tanksContainer">
-            <div class="loading">Waiting for sensor data...</div>
-        </div>
-        <div class="footer" id="footer">
-            <div>Loading...</div>
-        </div>
-    </div>
-    <script>
-        let lastUpdateTime = Date.now();
-        let hasReceivedData = false;
-        const TANK_HEIGHTS = { 0: 90, 1: 85, 2: 95 };
-
-        function formatTime(dateStr){ if(!dateStr) return 'Never'; const d=new Date(dateStr); return d.toLocaleTimeString('en-US',{hour12:false}); }
-        function formatTimeSince(sec){ if(sec==null) return 'Unknown'; if(sec<60) return `${sec}s ago`; const m=Math.floor(sec/60); if(m<60) return `${m}m ago`; const h=Math.floor(m/60); return `${h}h ${m%60}m ago`; }
-        function calculateHoneyLevel(id, dist){ if(dist==null) return null; const h=TANK_HEIGHTS[id]||90; const lvl=h - dist; return Math.max(0, lvl); }
-        function calculateFillPercentage(id, dist){ const lvl=calculateHoneyLevel(id, dist); if(lvl==null) return 0; const h=TANK_HEIGHTS[id]||90; return Math.min(100, Math.max(0, (lvl/h)*100)); }
-
-        async function sirenControl(action){
-          try{
-            const r = await fetch('/api/siren', { method:'POST', headers:{'Content-Type':'application/json'}, body: JSON.stringify({action}) });
-            const j = await r.json().catch(()=>null);
-            if(!r.ok){ console.error('Siren action failed', r.status, j||''); alert(j && j.error ? j.error : `Siren action failed (${r.status})`); }
-          }catch(e){ console.error('Siren action error', e); alert('Siren action error'); }
-        }
-
-        function updateTankDisplay(data){
-          const c = document.getElementById('tanksContainer');
-          const ntp = document.getElementById('ntpStatus');
-          hasReceivedData = true;
-          ntp.textContent = data.server_time_iso ? 'Synced' : 'Not Synced';
-          ntp.className = `ntp-status ${data.server_time_iso ? 'ntp-synced' : 'ntp-not-synced'}`;
-
-          let html = `
-            <div class="tank-card control-panel">
-              <div class="tank-title">🚨 Siren Control</div>
-              <div class="control-buttons">
-                <button class="control-btn test"  onclick="sirenControl('test')">Test Siren</button>
-                <button class="control-btn"       onclick="sirenControl('snooze_10m')">Snooze 10 Minutes</button>
-                <button class="control-btn"       onclick="sirenControl('snooze_20m')">Snooze 20 Minutes</button>
-                <button class="control-btn"       onclick="sirenControl('snooze_1h')">Snooze 1 Hour</button>
-                <button class="control-btn clear" onclick="sirenControl('clear_snooze')">Clear Snooze</button>
-              </div>
-            </div>
-          `;
-
-          for(let i=0;i<3;i++){
-            const t = (data.tanks||[]).find(x=>x.tank_id===i) || {tank_id:i,distance_cm:null,at_risk:false,last_update_iso:null,last_seen_secs_ago:null,battery_mV:0,offline:true};
-            const offline = t.offline || (t.last_seen_secs_ago>300);
-            const hasData = t.distance_cm!=null;
-            let statusClass='status-offline', statusText='OFFLINE';
-            if(!offline && hasData){ if(t.at_risk){statusClass='status-at-risk'; statusText='AT RISK';} else {statusClass='status-ok'; statusText='OK';} }
-            const distText = hasData ? `${t.distance_cm.toFixed(1)} cm` : '--';
-            const honeyLvl = calculateHoneyLevel(i, t.distance_cm);
-            const fillPct  = calculateFillPercentage(i, t.distance_cm);
-            const honeyText = honeyLvl!=null ? `${honeyLvl.toFixed(1)} cm` : '--';
-            const bat = t.battery_mV>0 ? `<div class="battery">🔋 ${(t.battery_mV/1000).toFixed(2)}V</div>` : '';
-            html += `
-              <div class="tank-card ${offline?'offline':''}">
-                <div class="tank-title">Tank ${i+1}</div>
-                <div class="distance ${offline?'offline':''}">
-                  Distance: ${distText}<br><small>Honey: ${honeyText}</small>
-                </div>
-                <div class="fill-bar-container">
-                  <div class="fill-bar" style="height:${fillPct}%"></div>
-                  <div class="fill-percentage">${hasData? (fillPct|0)+'%':'--'}</div>
-                </div>
-                <div class="status-chip ${statusClass}">${statusText}</div>
-                <div class="last-update">${formatTimeSince(t.last_seen_secs_ago)} (${formatTime(t.last_update_iso)})</div>
-                ${bat}
-              </div>`;
-          }
-          c.innerHTML = html;
-          lastUpdateTime = Date.now();
-        }
-
-        function showWaitingConnection(){
-          const c = document.getElementById('tanksContainer');
-          const ntp = document.getElementById('ntpStatus');
-          ntp.textContent='Waiting...'; ntp.className='ntp-status ntp-not-synced';
-          let html = `
-            <div class="tank-card control-panel">
-              <div class="tank-title">🚨 Siren Control</div>
-              <div class="control-buttons">
-                <button class="control-btn test"  onclick="sirenControl('test')">Test Siren</button>
-                <button class="control-btn"       onclick="sirenControl('snooze_10m')">Snooze 10 Minutes</button>
-                <button class="control-btn"       onclick="sirenControl('snooze_20m')">Snooze 20 Minutes</button>
-                <button class="control-btn"       onclick="sirenControl('snooze_1h')">Snooze 1 Hour</button>
-                <button class="control-btn clear" onclick="sirenControl('clear_snooze')">Clear Snooze</button>
-              </div>
-            </div>`;
-          for(let i=0;i<3;i++){
-            html += `
-              <div class="tank-card">
-                <div class="tank-title">Tank ${i+1}</div>
-                <div class="distance waiting-connection">Distance: --<br><small>Honey: --</small></div>
-                <div class="fill-bar-container"><div class="fill-bar" style="height:0%"></div><div class="fill-percentage">--</div></div>
-                <div class="status-chip status-offline">WAITING CONNECTION</div>
-                <div class="last-update waiting-connection">No data received yet</div>
-              </div>`;
-          }
-          c.innerHTML = html;
-        }
-
-        function updateFooter(){
-          const f = document.getElementById('footer');
-          f.innerHTML = `
-            <div>MAC: CC:DB:A7:92:C2:B8</div>
-            <div>Last refresh: ${new Date(lastUpdateTime).toLocaleTimeString()}</div>
-            <div>Version: 1.0</div>`;
-        }
-
-        async function fetchData(){
-          try{
-            const r = await fetch('/api/status');
-            if(!r.ok) throw new Error('HTTP '+r.status);
-            const j = await r.json();
-            updateTankDisplay(j);
-            updateFooter();
-          }catch(err){
-            console.error('Failed to fetch data:', err);
-            if(!hasReceivedData){
-              showWaitingConnection();
-            }else{
-              document.getElementById('tanksContainer').innerHTML =
-                `<div class="loading" style="color:#dc3545;">Connection Error<br><small>Retrying in 10s...</small></div>`;
-            }
-          }
-        }
-
-        showWaitingConnection(); fetchData(); updateFooter();
-        setInterval(fetchData, 10000); setInterval(updateFooter, 1000);
-    </script>
-</body>
-</html>)HTML";
+// The dashboard source lives in web/index.html; tools/build_dashboard.py minifies and
+// gzips it into include/index_html_gz.h (INDEX_HTML_GZ[] + content-hash ETag) on
+// every PlatformIO build.
 
 // ================== Utilities ==================
-static String iso8601_utc(time_t t) {
-  if (t <= 0) return String();
+static void iso8601_utc(time_t t, char *buf, size_t n) {
   struct tm tm{};
   gmtime_r(&t, &tm);
-  char buf[24];
-  strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &tm);
-  return String(buf);
+  strftime(buf, n, "%Y-%m-%dT%H:%M:%SZ", &tm);
 }
 
 static bool ntpSynced() { return time(nullptr) > 1609459200; } // > 2021-01-01
 
-static bool macEquals(const uint8_t *a, const uint8_t *b) { return memcmp(a,b,6)==0; }
-static int tankIdFromMac(const uint8_t *mac) {
-  for (int i=0;i<MAX_TANKS;i++) if (macEquals(mac, MAC_SENSORS[i])) return i;
-  return -1;
-}
 
 // ================== ESP-NOW receive ==================
-static void onDataRecv(const uint8_t *mac, const uint8_t *data, int len) { 
-  Serial.printf("ESP-NOW RX: %02X:%02X:%02X:%02X:%02X:%02X len=%d\n", 
-                mac[0],mac[1],mac[2],mac[3],mac[4],mac[5], len);
-  
-  if (len != (int)sizeof(SensorPacket)) {
-    Serial.printf("Wrong packet size, expected %d got %d\n", sizeof(SensorPacket), len);
-    return;
+static bool checkTankId(const uint8_t *mac, uint8_t tank_id) {
+  if (!registry.valid(tank_id)) {
+    Serial.printf("Invalid tank_id: %d\n", tank_id);
+    mRxTankId.inc();
+    return false;
+  }
+  // Optional: verify claimed tank_id matches known MAC mapping
+  int expected = registry.find(mac);
+  if (expected >= 0 && (uint8_t)expected != tank_id) {
+    Serial.printf("Tank ID mismatch: MAC suggests %d but packet claims %d\n", expected, tank_id);
+    mRxTankMismatch.inc(expected);
+    return false;
   }
+  return true;
+}
 
-  SensorPacket p;
-  memcpy(&p, data, sizeof(p));
+// Every stored reading (live or backfilled) goes through here, in time order per tank.
+static void recordReading(uint8_t tid, uint32_t t_s, uint16_t mm, uint16_t battery_mV, uint8_t flags) {
+  if (!tankHistory[tid].append(t_s, mm)) return;
+  tankRollups[tid].add(t_s, mm);
+  if (tlogReady && ntpSynced()) {
+    const uint32_t epoch = (uint32_t)time(nullptr) - (millis() / 1000UL - t_s);
+    tlog.append(TlogRecord{epoch, tid, flags, mm, battery_mV});
+  }
+}
 
-  // CRC & version
-  auto calc = crc8((const uint8_t*)&p, sizeof(p)-1);
-  if (p.crc8 != calc) {
-    Serial.printf("CRC mismatch: expected %02X got %02X\n", calc, p.crc8);
-    return;
+static void applyReading(uint8_t tid, uint16_t distance_mm, uint16_t battery_mV, uint8_t flags, uint32_t rxMs) {
+  const bool valid = (flags & 0x01) && distance_mm>0;
+  const float d_cm = valid ? (distance_mm / 10.0f) : NAN;
+
+  Serial.printf("Tank %d: distance=%.1fcm battery=%dmV flags=0x%02X valid=%s\n", 
+    tid, d_cm, battery_mV, flags, valid ? "YES" : "NO");
+
+  TankState &t = tanks[tid];
+  t.distanceCm   = d_cm;
+  t.battery_mV   = battery_mV;
+  t.lastRxMillis = rxMs;
+  t.lastRxEpoch  = ntpSynced()? (uint32_t)time(nullptr) : 0;
+  recordReading(tid, rxMs / 1000UL, valid ? distance_mm : 0, battery_mV, flags);
+  statusDirty = true;
+  t.ssePending = true;
+  ssePendingAny = true;
+}
+
+// v2 frames carry the sensor's per-wake seq: a retry after a lost ack repeats it.
+// v3 adds the boot nonce, which resets the window when the sensor power-cycles.
+// Returns false for a frame that was already applied, or an old one from this boot.
+static bool acceptSequenced(const SensorReading &r, uint32_t rxMs) {
+  if (r.ver < 2) return true;
+  LinkStats &l = sensorLink[r.tank_id];
+  const SeqVerdict v = l.accept(r.seq, r.boot);
+  if (v == SEQ_DUPLICATE) {
+    Serial.printf("Tank %d: duplicate seq %u ignored\n", r.tank_id, r.seq);
+    mRxDuplicate.inc();
+    return false;
+  }
+  if (v == SEQ_STALE) {
+    Serial.printf("Tank %d: stale seq %u ignored (newest %u)\n", r.tank_id, r.seq, l.newest);
+    mRxStale.inc();
+    return false;
+  }
+  if (v == SEQ_RESTART) Serial.printf("Tank %d: sensor restarted (seq %u, boot %04X)\n", r.tank_id, r.seq, r.boot);
+  const uint32_t latencyMs = r.age_ms + (millis() - rxMs);
+  l.latency(latencyMs);
+  mReadingAge.observe(latencyMs);
+  return true;
+}
+
+// Sensor peers take ESP_NOW_MAX_TOTAL_PEER_NUM minus the siren and broadcast entries.
+static const int MAX_SENSOR_PEERS = ESP_NOW_MAX_TOTAL_PEER_NUM - 2;
+static const uint8_t MAC_BROADCAST[6] = {0xFF,0xFF,0xFF,0xFF,0xFF,0xFF};
+
+// The sensor listens for a few tens of ms after our ack, so this goes out from the
+// consumer right away; until_ms is taken at send time, so queueing delay doesn't skew it.
+static void sendSlotReply(const uint8_t *mac, uint8_t tank_id, uint16_t seq) {
+  const SlotReply rep = slotAssign(tank_id, seq, tankCount, (uint64_t)(esp_timer_get_time() / 1000));
+  const uint8_t *to = tank_id < MAX_SENSOR_PEERS ? mac : MAC_BROADCAST;
+  const esp_err_t result = esp_now_send(to, (const uint8_t *)&rep, sizeof(rep));
+  (result == ESP_OK ? mSlotOk : mSlotFail).inc();
+  Serial.printf("Tank %d: slot %u/%u, centre in %ums (%s%s)\n", tank_id, rep.slot, rep.slots, rep.until_ms,
+    to == mac ? "unicast" : "broadcast", result == ESP_OK ? "" : ", send failed");
+}
+
+// Without slots, a plain ack: sensors broadcasting one frame per wake wait for ours
+// and the siren's before they sleep (sensor_packet.h AppAck).
+static void sendAppAck(const uint8_t *mac, uint8_t tank_id, uint16_t seq) {
+  const AppAck a = makeAppAck(tank_id, seq, ACK_FROM_WEBSERVER);
+  const uint8_t *to = tank_id < MAX_SENSOR_PEERS ? mac : MAC_BROADCAST;
+  (esp_now_send(to, (const uint8_t *)&a, sizeof(a)) == ESP_OK ? mAckOk : mAckFail).inc();
+}
+
+// Right after acceptSequenced(): new readings only, the siren has the rest.
+static void relayToSiren(const SensorReading &r, uint32_t rxMs) {
+  if (!SIREN_RELAY || r.ver < 2) return;
+  static uint32_t relayBoot = 0;   // drawn once WiFi is up, so esp_random() has RF entropy
+  static uint16_t relaySeq = 0;
+  while (!relayBoot) relayBoot = esp_random();
+  const RelayFrame f = makeRelay(r, relayBoot, ++relaySeq, millis() - rxMs, RELAY_KEY);
+  (esp_now_send(MAC_SIREN, (const uint8_t *)&f, sizeof(f)) == ESP_OK ? mRelayOk : mRelayFail).inc();
+}
+
+static void onHistoryBatch(const uint8_t *mac, const uint8_t *data, int len, uint32_t rxMs) {
+  // Normalise v1/v2 headers; the reading fields mean the same in both.
+  SensorReading r{};
+  uint8_t  count = 0;
+  uint16_t next_tx_s = 0;
+  size_t   hdrLen = 0;
+  switch (decodeHistoryHeader(data, len, r, count, next_tx_s, hdrLen)) {
+    case PKT_OK: break;
+    case PKT_BAD_CRC:
+      Serial.printf("Batch CRC mismatch: expected %02X got %02X\n", crc8(data, len-1), data[len-1]);
+      mRxCrc.inc();
+      return;
+    default:
+      Serial.printf("Bad batch header: ver=%d len=%d\n", data[0], len);
+      mRxVersion.inc();
+      return;
+  }
+  if (!checkTankId(mac, r.tank_id)) return;
+  // Before the duplicate check: a retry means the sensor missed the ack, and with it
+  // possibly the reply.
+  if (r.ver >= 2) (SLOT_SCHEDULE ? sendSlotReply : sendAppAck)(mac, r.tank_id, r.seq);
+  if (!acceptSequenced(r, rxMs)) return;
+  mRxAccepted.inc();
+  relayToSiren(r, rxMs);
+
+  // Older readings arrive newest-first; decode them, then store oldest-first so the
+  // history ring stays in time order ahead of the newest reading.
+  static const uint8_t MAX_BACKFILL = 32;
+  HistoryDelta bf[MAX_BACKFILL];
+  const uint8_t *payload = data + hdrLen;
+  const size_t   plen    = len - hdrLen - 1;
+  bool   truncated;
+  size_t trailer;
+  const uint8_t nBackfill = historyDecodeDeltas(payload, plen, count, r.distance_mm, bf, MAX_BACKFILL,
+                                                truncated, trailer);
+  if (truncated) Serial.printf("Batch truncated at reading %d/%d\n", nBackfill + 1, count);
+  const uint32_t rxS = rxMs / 1000UL;
+  for (int i = nBackfill - 1; i >= 0; --i) {
+    if (bf[i].ageS < rxS) recordReading(r.tank_id, rxS - bf[i].ageS, bf[i].mm, 0, bf[i].mm ? 0x01 : 0x00);
+  }
+  if (nBackfill) Serial.printf("Tank %d: backfilled %d readings (oldest -%us)\n", r.tank_id, nBackfill,
+                               (unsigned)bf[nBackfill - 1].ageS);
+
+  // A power budget, if any, follows the last delta.
+  PowerReport pr;
+  if (trailer < plen && powerDecode(payload + trailer, plen - trailer, pr)) {
+    tankPower[r.tank_id].report   = pr;
+    tankPower[r.tank_id].rxMillis = rxMs ? rxMs : 1;
+    Serial.printf("Tank %d: power budget %u wakes / %us, %.2f mAh/day\n",
+      r.tank_id, pr.wakes, (unsigned)pr.windowS, powerMahPerDay(pr, nullptr, nullptr));
   }
-  if (p.ver != 1) {
-    Serial.printf("Wrong version: %d\n", p.ver);
+
+  tanks[r.tank_id].reportIntervalS = r.interval_s;
+  applyReading(r.tank_id, r.distance_mm, r.battery_mV, r.flags, rxMs);
+  // The sensor may legitimately stay quiet until next_tx_s; add a minute of slack.
+  uint32_t expectMs = next_tx_s * 1000UL + 60000UL;
+  tanks[r.tank_id].offlineAfterMs = max(OFFLINE_MS, expectMs);
+}
+
+// Consumer side (loop): everything that used to run inside the Wi-Fi callback.
+static void handleFrame(const uint8_t *mac, const uint8_t *data, int len, uint32_t rxMs) {
+  Serial.printf("ESP-NOW RX: %02X:%02X:%02X:%02X:%02X:%02X len=%d\n", 
+                mac[0],mac[1],mac[2],mac[3],mac[4],mac[5], len);
+
+  // From the siren: acks to our commands (CommandAck is a SensorPacketV1's size, so
+  // go by sender). Its broadcast acks to sensors without a peer entry are not ours.
+  if (memcmp(mac, MAC_SIREN, 6) == 0) {
+    CommandAck a;
+    if (decodeCommandAck(data, len, a)) cmdq.onAck(a, rxMs);
     return;
   }
-  if (p.tank_id >= MAX_TANKS) {
-    Serial.printf("Invalid tank_id: %d\n", p.tank_id);
+  if (isHistoryBatch(data, len)) {
+    onHistoryBatch(mac, data, len, rxMs);
     return;
   }
 
-  // Optional: verify claimed tank_id matches known MAC mapping
-  int expected = tankIdFromMac(mac);
-  if (expected >= 0 && (uint8_t)expected != p.tank_id) {
-    Serial.printf("Tank ID mismatch: MAC suggests %d but packet claims %d\n", expected, p.tank_id);
-    return;
+  SensorReading p;
+  switch (decodeSensorPacket(data, len, p)) {
+    case PKT_OK: break;
+    case PKT_BAD_SIZE:
+      Serial.printf("Wrong packet size, expected %d, %d or %d got %d\n",
+        sizeof(SensorPacketV1), sizeof(SensorPacketV2), sizeof(SensorPacketV3), len);
+      mRxSize.inc();
+      return;
+    case PKT_BAD_CRC:
+      Serial.printf("CRC mismatch: got %02X\n", data[len-1]);
+      mRxCrc.inc();
+      return;
+    case PKT_BAD_VERSION:
+      Serial.printf("Wrong version: %d\n", data[0]);
+      mRxVersion.inc();
+      return;
   }
+  if (!checkTankId(mac, p.tank_id)) return;
+  if (!acceptSequenced(p, rxMs)) return;
+  mRxAccepted.inc();
+  relayToSiren(p, rxMs);
 
-  const bool valid = (p.flags & 0x01) && p.distance_mm>0;
-  const float d_cm = valid ? (p.distance_mm / 10.0f) : NAN;
+  tanks[p.tank_id].reportIntervalS = p.interval_s;
+  applyReading(p.tank_id, p.distance_mm, p.battery_mV, p.flags, rxMs);
+  // A v2 frame says how long the sensor sleeps; v1 gets the fixed default.
+  uint32_t expectMs = p.interval_s * 1000UL + 60000UL;
+  tanks[p.tank_id].offlineAfterMs = max(OFFLINE_MS, expectMs);
+}
 
-  Serial.printf("Tank %d: distance=%.1fcm battery=%dmV flags=0x%02X valid=%s\n", 
-    p.tank_id, d_cm, p.battery_mV, p.flags, valid ? "YES" : "NO");
+static RxQueue rxQueue;
 
-  lastDistanceCm[p.tank_id] = d_cm;
-  lastBattery_mV[p.tank_id] = p.battery_mV;
-  lastRxMillis[p.tank_id]   = millis();
-  lastRxEpoch[p.tank_id]    = ntpSynced()? time(nullptr) : 0;
+// Runs in the Wi-Fi driver task: copy the frame and return. No logging, no state.
+static void onDataRecv(const uint8_t *mac, const uint8_t *data, int len) {
+  const uint32_t t0 = micros();
+  if (!rxQueue.push(mac, data, len, millis())) mRxQueueFull.inc();
+  const uint32_t us = micros() - t0;
+  if (us > rxQueue.cbMaxUs) rxQueue.cbMaxUs = us;
+}
+
+static void processRx() {
+  while (const RxFrame *f = rxQueue.front()) {
+    handleFrame(f->mac, f->data, f->len, f->rxMs);
+    rxQueue.pop();
+  }
 }
 
 // ================== ESP-NOW command sending ==================
@@ -370,67 +506,477 @@ static bool addPeer(const uint8_t mac[6]) {
   return (result == ESP_OK);
 }
 
-static bool sendCommand(uint8_t cmd, uint8_t tank_id, uint16_t ms=0) {
-  CommandPacket c{};
-  c.ver  = 1;
-  c.type = 0xC1;
-  c.cmd  = cmd;
-  c.tank_id = tank_id;   // 0/1/2 or 255 for ALL
-  c.ms   = ms;
-  c.crc8 = crc8((uint8_t*)&c, sizeof(c)-1);
-  esp_err_t result = esp_now_send(MAC_SIREN, (uint8_t*)&c, sizeof(c));
-  Serial.printf("Command sent to siren: cmd=%d tank=%d ms=%d result=%s\n", 
-    cmd, tank_id, ms, (result == ESP_OK) ? "OK" : "FAILED");
-  return result == ESP_OK;
+static void sseBroadcast(const char *event, const char *data);
+
+// One command JSON object: where it is and, once finished, how long it took.
+// queue_ms: queued -> first send; ack_ms: first send -> siren's ack (retries
+// included); apply_ms: queued -> ack.
+static int commandJson(const CmdSlot &c, char *buf, size_t cap) {
+  const bool sent = c.tries > 0, acked = c.state == CMD_APPLIED || c.state == CMD_REJECTED;
+  return snprintf(buf, cap,
+    "{\"id\":%u,\"cmd\":%u,\"tank_id\":%u,\"ms\":%lu,\"state\":\"%s\",\"ok\":%s,\"tries\":%u,"
+    "\"queue_ms\":%ld,\"ack_ms\":%ld,\"apply_ms\":%ld,\"superseded_by\":%u}",
+    c.pkt.id, c.pkt.cmd, c.pkt.tank_id, (unsigned long)c.pkt.ms, cmdStateName(c.state),
+    (c.state == CMD_FAILED || c.state == CMD_REJECTED) ? "false" : "true", c.tries,
+    sent ? (long)(c.firstSentMs - c.queuedMs) : -1L,
+    acked ? (long)(c.doneMs - c.firstSentMs) : -1L,
+    acked ? (long)(c.doneMs - c.queuedMs) : -1L, c.supersededBy);
+}
+
+// CommandQueue::onDone: metrics, log and the dashboard's "siren" event.
+static void onCommandDone(const CmdSlot &c, void *) {
+  switch (c.state) {
+    case CMD_APPLIED:    mCmdApplied.inc(); mCmdApply.observe((c.doneMs - c.queuedMs) * 1000UL); break;
+    case CMD_REJECTED:   mCmdRejected.inc(); break;
+    case CMD_FAILED:     mCmdFailed.inc(); break;
+    case CMD_SUPERSEDED: mCmdSuperseded.inc(); break;
+  }
+  char ev[256];
+  if (commandJson(c, ev, sizeof(ev)) >= (int)sizeof(ev)) return;
+  Serial.printf("Siren command done: %s\n", ev);
+  sseBroadcast("siren", ev);
+}
+
+// Queue for the siren; loop() sends it (commandPoll()). Returns the id, 0 if the queue
+// is full of unfinished commands.
+static uint16_t queueCommand(uint8_t cmd, uint8_t tank_id, uint32_t ms=0) {
+  const uint16_t id = cmdq.submit(cmd, tank_id, ms, millis());
+  if (!id) mCmdQueueFull.inc();
+  Serial.printf("Command queued for siren: cmd=%d tank=%d ms=%lu id=%u\n", cmd, tank_id, (unsigned long)ms, id);
+  return id;
+}
+
+// First sends and resends, never more than one frame per call.
+static void commandPoll() {
+  const CommandPacketV2 *c = cmdq.due(millis());
+  if (!c) return;
+  const uint32_t t0 = micros();
+  const esp_err_t result = esp_now_send(MAC_SIREN, (const uint8_t *)c, sizeof(*c));
+  mCmdLatency.observe(micros() - t0);
+  (result == ESP_OK ? mCmdOk : mCmdFail).inc();
 }
 
 // ================== HTTP handlers ==================
+// GET / redirects to the content-hashed dashboard URL, which is cached for a year
+// (see dashboard_asset.h).
+static uint32_t rootServed = 0, root304 = 0, rootRedirects = 0;
+
 static void handleRoot() {
-  server.send_P(200, "text/html", INDEX_HTML);
+  const DashboardReply r = dashboardReply(server.arg("v").c_str(), server.header("If-None-Match").c_str());
+  if (r.code == 302) {
+    rootRedirects++;
+    server.sendHeader("Location", DASHBOARD_URL);
+    server.sendHeader("Cache-Control", "no-cache");
+    server.send(302);
+    return;
+  }
+
+  server.sendHeader("ETag", INDEX_HTML_ETAG);
+  server.sendHeader("Cache-Control", DASHBOARD_CACHE_CONTROL);
+  if (r.code == 304) {
+    root304++;
+    server.send(304);
+    return;
+  }
+  rootServed++;
+  server.sendHeader("Content-Encoding", "gzip");
+  server.send_P(200, "text/html", (const char*)r.body, r.len);
+}
+
+// /api/status is served from a snapshot rebuilt only when its inputs change (see
+// status_snapshot.h). Everything "now"-relative stays out of the body (clients age
+// readings with the X-Uptime-S header), so unchanged polls are answered 304.
+static const size_t STATUS_TANK_BYTES = 208;  // one tank's object, worst case (200) + slack
+static char    *statusBuf = nullptr;     // sized by allocTanks()
+static size_t   statusCap = 0;
+static size_t   statusLen = 0;
+static StatusSnapshot statusSnap = {};
+
+static bool statusAppend(size_t &pos, const char *fmt, ...) {
+  if (pos >= statusCap) return false;
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(statusBuf + pos, statusCap - pos, fmt, ap);
+  va_end(ap);
+  if (n < 0 || (size_t)n >= statusCap - pos) { pos = statusCap; return false; }
+  pos += n;
+  return true;
+}
+
+// Refreshes every tank's offline flag; offlineFlips counts the transitions.
+static void scanOffline(uint32_t nowMs) {
+  for (uint16_t i=0;i<tankCount;i++) {
+    TankState &t = tanks[i];
+    const bool offline = (!t.lastRxMillis) || (nowMs - t.lastRxMillis > t.offlineAfterMs);
+    if (offline != t.offline) { t.offline = offline; offlineFlips++; }
+  }
+}
+
+static void rebuildStatus(bool ntp, int channel) {
+  statusDirty = false;   // clear first: a packet landing mid-build marks it again
+  char iso[24];
+  size_t pos = 0;
+  bool ok = true;
+
+  if (ntp) iso8601_utc(time(nullptr), iso, sizeof(iso));
+  ok &= statusAppend(pos, "{\"updated_iso\":%s%s%s,\"ntp_synced\":%s,\"wifi_channel\":%d,\"tanks\":[",
+                     ntp ? "\"" : "", ntp ? iso : "null", ntp ? "\"" : "",
+                     ntp ? "true" : "false", channel);
+  for (uint16_t i=0;i<tankCount;i++) {
+    const TankState &t = tanks[i];
+    bool have = !isnan(t.distanceCm);
+    bool at_risk = have && (t.distanceCm <= 6.0f);
+
+    ok &= statusAppend(pos, "%s{\"tank_id\":%u,\"height_cm\":%u,\"distance_cm\":", i ? "," : "",
+                       (unsigned)i, (unsigned)SENSORS[i].height_cm);
+    ok &= have ? statusAppend(pos, "%.1f", t.distanceCm) : statusAppend(pos, "null");
+    ok &= statusAppend(pos, ",\"at_risk\":%s,\"last_update_iso\":", at_risk ? "true" : "false");
+    if (t.lastRxEpoch > 0) {
+      iso8601_utc(t.lastRxEpoch, iso, sizeof(iso));
+      ok &= statusAppend(pos, "\"%s\"", iso);
+    } else {
+      ok &= statusAppend(pos, "null");
+    }
+    ok &= statusAppend(pos, ",\"last_seen_uptime_s\":");
+    ok &= t.lastRxMillis ? statusAppend(pos, "%u", (unsigned)(t.lastRxMillis / 1000UL)) : statusAppend(pos, "null");
+    ok &= statusAppend(pos, ",\"battery_mV\":%u,\"report_interval_s\":", (unsigned)t.battery_mV);
+    ok &= t.reportIntervalS ? statusAppend(pos, "%u", (unsigned)t.reportIntervalS) : statusAppend(pos, "null");
+    ok &= statusAppend(pos, ",\"offline\":%s}", t.offline ? "true" : "false");
+  }
+  ok &= statusAppend(pos, "]}");
+  if (!ok) Serial.println("Status snapshot truncated!");
+
+  statusLen = ok ? pos : strlen(statusBuf);
+  statusSeal(statusSnap, statusBuf, statusLen, offlineFlips, ntp, channel);
 }
 
 static void handleStatus() {
+  scanOffline(millis());
+  const bool ntp     = ntpSynced();
+  const int  channel = WiFi.channel();
+  const StatusTrigger why = statusTrigger(statusSnap, statusDirty, offlineFlips, ntp, channel);
+  if (why != STATUS_CURRENT) {
+    rebuildStatus(ntp, channel);
+    mStatusBuilds[why - 1].inc();
+  }
+
+  char uptime[12];
+  snprintf(uptime, sizeof(uptime), "%u", (unsigned)(millis() / 1000UL));
+  server.sendHeader("ETag", statusSnap.etag);
+  server.sendHeader("Cache-Control", "no-cache");
+  server.sendHeader("X-Uptime-S", uptime);
+
+  if (statusReplyCode(statusSnap, server.header("If-None-Match").c_str()) == 304) {
+    mStatus304.inc();
+    server.send(304);
+    return;
+  }
+  mStatus200.inc();
+  mStatusBytes.inc(statusLen);
+  server.send_P(200, "application/json", statusBuf, statusLen);
+}
+
+// ================== Server-Sent Events ==================
+// GET /api/events keeps the socket (see sse_hub.h): the handler writes the SSE
+// headers itself and parks the WiFiClient in the hub, so handleClient() goes
+// straight back to serving everyone else.
+static const int SSE_MAX_CLIENTS = 4;
+static SseHub<WiFiClient, SSE_MAX_CLIENTS> sse;
+static uint32_t   sseOfflineFlips = 0;
+static uint32_t   sseLastPing = 0;
+
+static void sseBroadcast(const char *event, const char *data) {
+  sse.broadcast(event, data);
+}
+
+static void sseSendTank(const char *event, uint16_t i, uint32_t nowMs) {
+  const TankState &t = tanks[i];
+  char data[256];
+  char iso[24] = "";
+  const bool have = !isnan(t.distanceCm);
+  if (t.lastRxEpoch > 0) iso8601_utc(t.lastRxEpoch, iso, sizeof(iso));
+
+  char dist[12] = "null";
+  if (have) snprintf(dist, sizeof(dist), "%.1f", t.distanceCm);
+  char seen[12] = "null";
+  if (t.lastRxMillis) snprintf(seen, sizeof(seen), "%u", (unsigned)(t.lastRxMillis / 1000UL));
+
+  snprintf(data, sizeof(data),
+    "{\"tank_id\":%u,\"distance_cm\":%s,\"at_risk\":%s,\"last_update_iso\":%s%s%s,"
+    "\"last_seen_uptime_s\":%s,\"battery_mV\":%u,\"offline\":%s,\"uptime_s\":%u}",
+    (unsigned)i, dist, (have && t.distanceCm <= 6.0f) ? "true" : "false",
+    iso[0] ? "\"" : "", iso[0] ? iso : "null", iso[0] ? "\"" : "",
+    seen, (unsigned)t.battery_mV, t.offline ? "true" : "false",
+    (unsigned)(nowMs / 1000UL));
+  sseBroadcast(event, data);
+}
+
+static void handleEvents() {
+  const int slot = sse.freeSlot();
+  if (slot < 0) {
+    server.send(503, "application/json", "{\"error\":\"too many event streams\"}");
+    return;
+  }
+
+  WiFiClient c = server.client();
+  c.setNoDelay(true);
+  if (!sse.open(slot, c)) return;
+  Serial.printf("SSE client %d connected\n", slot);
+}
+
+// Called from loop(): flush per-tank updates flagged by applyReading(), offline
+// transitions, and a keep-alive comment that also reaps dead sockets.
+static void ssePoll() {
   const uint32_t nowMs = millis();
-  time_t nowEpoch = time(nullptr);
-  String nowIso   = ntpSynced()? iso8601_utc(nowEpoch) : String();
-
-  String json = "{\"server_time_iso\":\"";
-  json += nowIso;
-  json += "\",\"ntp_synced\":";
-  json += (ntpSynced()? "true":"false");
-  json += ",\"wifi_channel\":";
-  json += String(WiFi.channel());
-  json += ",\"tanks\":[";
-  for (int i=0;i<MAX_TANKS;i++) {
-    if (i) json += ",";
-    bool have = !isnan(lastDistanceCm[i]);
-    bool offline = (!lastRxMillis[i]) || (nowMs - lastRxMillis[i] > 5UL*60UL*1000UL); // >5 min
-    bool at_risk = have && (lastDistanceCm[i] <= 6.0f);
-
-    json += "{\"tank_id\":";
-    json += String(i);
-    json += ",\"distance_cm\":";
-    if (have) { json += String(lastDistanceCm[i], 1); } else { json += "null"; }
-    json += ",\"at_risk\":";
-    json += (at_risk? "true":"false");
-    json += ",\"last_update_iso\":";
-    if (lastRxEpoch[i] > 0) { json += "\"" + iso8601_utc(lastRxEpoch[i]) + "\""; } else { json += "null"; }
-    json += ",\"last_seen_secs_ago\":";
-    if (lastRxMillis[i] == 0) { json += "null"; }
-    else { json += String((nowMs - lastRxMillis[i]) / 1000UL); }
-    json += ",\"battery_mV\":";
-    json += String((unsigned)lastBattery_mV[i]);
-    json += ",\"offline\":";
-    json += (offline? "true":"false");
-    json += "}";
-  }
-  json += "]}";
-
-  server.send(200, "application/json", json);
-}
-
-// POST /api/siren  with JSON: {"action":"test" | "snooze_10m" | "snooze_20m" | "snooze_1h" | "clear_snooze"}
+  scanOffline(nowMs);
+
+  if (ssePendingAny) {
+    ssePendingAny = false;
+    for (uint16_t i=0;i<tankCount;i++) {
+      if (!tanks[i].ssePending) continue;
+      tanks[i].ssePending = false;
+      sseSendTank("tank", i, nowMs);
+    }
+  }
+
+  if (offlineFlips != sseOfflineFlips) {
+    sseOfflineFlips = offlineFlips;
+    for (uint16_t i=0;i<tankCount;i++) {
+      TankState &t = tanks[i];
+      if (t.offline == t.sseOffline) continue;
+      t.sseOffline = t.offline;
+      sseSendTank("offline", i, nowMs);
+    }
+  }
+
+  if (nowMs - sseLastPing > 15000) {
+    sseLastPing = nowMs;
+    sse.ping();
+  }
+}
+
+// ================== History API ==================
+// GET /api/history?tank=N[&from=T][&to=T][&step=S | &tier=minute|hour|day]
+// Times are Unix seconds once NTP is synced, otherwise seconds of webserver uptime
+// ("time_base" says which). step > 0 averages valid readings into S-second buckets
+// while decoding. tier= answers from the rollups instead of raw samples, one point
+// per bucket: [start, min, max, avg, first, last, count]. The body is streamed in
+// chunks (chunked_out.h) straight off the decoder / bucket walk.
+static void sendChunk(const char *s, size_t n) { server.sendContent(s, n); }
+
+static void historyPoint(ChunkedOut &out, bool &first, uint32_t t, int64_t offset, uint32_t mm) {
+  out.printf(first ? "[%lu," : ",[%lu,", (unsigned long)(t + offset));
+  if (mm) out.printf("%u.%u]", (unsigned)(mm / 10), (unsigned)(mm % 10));
+  else    out.printf("null]");
+  first = false;
+}
+
+static void historyCm(ChunkedOut &out, uint32_t mm) {
+  out.printf(",%u.%u", (unsigned)(mm / 10), (unsigned)(mm % 10));
+}
+
+static void historyRollups(ChunkedOut &out, const RollupTier &tier, uint32_t from, uint32_t to, int64_t offset) {
+  bool first = true;
+  rollupForEach(tier, from, to, [&](const RollupBucket &k) {
+    out.printf(first ? "[%lu" : ",[%lu", (unsigned long)(k.start(tier.width) + offset));
+    historyCm(out, k.min);
+    historyCm(out, k.max);
+    historyCm(out, k.avg());
+    historyCm(out, k.first);
+    historyCm(out, k.last);
+    out.printf(",%u]", (unsigned)k.count);
+    first = false;
+  });
+}
+
+static void handleHistory() {
+  const int tank = server.hasArg("tank") ? server.arg("tank").toInt() : -1;
+  if (tank < 0 || tank >= tankCount) {
+    char err[48];
+    snprintf(err, sizeof(err), "{\"error\":\"tank must be 0..%u\"}", (unsigned)(tankCount - 1));
+    server.send(400, "application/json", err);
+    return;
+  }
+
+  const bool ntp = ntpSynced();
+  const int64_t offset = ntp ? (int64_t)time(nullptr) - (int64_t)(millis() / 1000UL) : 0;
+  auto toUptime = [&](const char *arg, uint32_t dflt) -> uint32_t {
+    if (!server.hasArg(arg)) return dflt;
+    int64_t v = strtoll(server.arg(arg).c_str(), nullptr, 10) - offset;
+    return v < 0 ? 0 : (v > 0xFFFFFFFFLL ? 0xFFFFFFFFUL : (uint32_t)v);
+  };
+  const uint32_t from = toUptime("from", 0);
+  const uint32_t to   = toUptime("to", 0xFFFFFFFFUL);
+  const uint32_t step = server.hasArg("step") ? (uint32_t)strtoul(server.arg("step").c_str(), nullptr, 10) : 0;
+
+  int tier = -1;
+  if (server.hasArg("tier")) {
+    const String name = server.arg("tier");
+    if      (name == "minute") tier = TIER_MINUTE;
+    else if (name == "hour")   tier = TIER_HOUR;
+    else if (name == "day")    tier = TIER_DAY;
+    else {
+      server.send(400, "application/json", "{\"error\":\"tier must be minute, hour or day\"}");
+      return;
+    }
+  }
+
+  const TankHistory &h = tankHistory[tank];
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+
+  ChunkedOut out(sendChunk);
+  out.printf("{\"tank_id\":%d,\"time_base\":\"%s\",\"step\":%u,", tank, ntp ? "epoch" : "uptime", (unsigned)step);
+  out.printf("\"samples\":%u,\"bytes\":%u,\"evicted\":%u,",
+             (unsigned)h.samples, (unsigned)h.used(), (unsigned)h.evicted);
+
+  if (tier >= 0) {
+    const RollupTier &rt = tankRollups[tank].tiers[tier];
+    out.printf("\"tier\":\"%s\",\"width_s\":%u,\"points\":[", server.arg("tier").c_str(), (unsigned)rt.width);
+    historyRollups(out, rt, from, to, offset);
+    out.printf("]}");
+    out.flush();
+    server.sendContent("");
+    return;
+  }
+
+  out.printf("\"points\":[");
+
+  bool first = true;
+  uint32_t bucket = 0, sum = 0, n = 0;
+  bool open = false;
+  TankHistory::Cursor cur = h.begin();
+  uint32_t t;
+  uint16_t mm;
+  while (cur.next(t, mm)) {
+    if (t < from) continue;
+    if (t > to) break;
+    if (!step) { historyPoint(out, first, t, offset, mm); continue; }
+
+    const uint32_t b = from + ((t - from) / step) * step;
+    if (open && b != bucket) {
+      historyPoint(out, first, bucket, offset, n ? (sum + n / 2) / n : 0);
+      sum = n = 0;
+    }
+    bucket = b;
+    open = true;
+    if (mm) { sum += mm; n++; }
+  }
+  if (open) historyPoint(out, first, bucket, offset, n ? (sum + n / 2) / n : 0);
+
+  out.printf("]}");
+  out.flush();
+  server.sendContent("");
+}
+
+// GET /api/log?tank=&from=&to=  (Unix seconds) — readings from the SD telemetry log.
+static void handleLog() {
+  if (!tlogReady) {
+    server.send(503, "application/json", "{\"error\":\"telemetry log not available\"}");
+    return;
+  }
+  const int tank = server.hasArg("tank") ? server.arg("tank").toInt() : -1;
+  const uint32_t from = server.hasArg("from") ? (uint32_t)strtoul(server.arg("from").c_str(), nullptr, 10) : 0;
+  const uint32_t to   = server.hasArg("to")   ? (uint32_t)strtoul(server.arg("to").c_str(), nullptr, 10)   : 0xFFFFFFFFUL;
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+
+  ChunkedOut out(sendChunk);
+  out.printf("{\"time_base\":\"epoch\",\"points\":[");
+  bool first = true;
+  const uint32_t reads = tlog.query(from, to, tank, [&](const TlogRecord &r) {
+    out.printf(first ? "[%lu,%d," : ",[%lu,%d,", (unsigned long)r.t, r.tank_id);
+    if (r.distance_mm) out.printf("%u.%u", (unsigned)(r.distance_mm / 10), (unsigned)(r.distance_mm % 10));
+    else               out.printf("null");
+    out.printf(",%u,%u]", (unsigned)r.battery_mV, (unsigned)r.flags);
+    first = false;
+  });
+  out.printf("],\"pages_read\":%u}", (unsigned)reads);
+  out.flush();
+  server.sendContent("");
+}
+
+// GET /api/power — each tank's last power budget as estimated mAh/day per wake phase
+// (power_budget.h). Tanks that haven't reported one yet are left out.
+static void handlePower() {
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+
+  ChunkedOut out(sendChunk);
+  out.printf("{\"phases\":[");
+  for (uint8_t i = 0; i < PH_COUNT; ++i) out.printf(i ? ",\"%s\"" : "\"%s\"", POWER_PHASE_NAMES[i]);
+  out.printf("],\"phase_ma\":[");
+  for (uint8_t i = 0; i < PH_COUNT; ++i) out.printf(i ? ",%g" : "%g", POWER_PHASE_MA[i]);
+  out.printf("],\"sleep_ma\":%g,\"tanks\":[", POWER_SLEEP_MA);
+
+  bool first = true;
+  const uint32_t now = millis();
+  for (uint16_t t = 0; t < tankCount; t++) {
+    const TankPower &p = tankPower[t];
+    if (!p.rxMillis) continue;
+    float mah[PH_COUNT], sleep;
+    const float total = powerMahPerDay(p.report, mah, &sleep);
+    out.printf(first ? "{\"tank_id\":%u," : ",{\"tank_id\":%u,", (unsigned)t);
+    out.printf("\"age_s\":%lu,\"window_s\":%lu,", (unsigned long)((now - p.rxMillis) / 1000UL),
+               (unsigned long)p.report.windowS);
+    out.printf("\"wakes\":%u,\"tx_wakes\":%u,\"ms_per_wake\":[", p.report.wakes, p.report.txWakes);
+    for (uint8_t i = 0; i < PH_COUNT; ++i) out.printf(i ? ",%u" : "%u", p.report.avgMs[i]);
+    out.printf("],\"mah_per_day\":[");
+    for (uint8_t i = 0; i < PH_COUNT; ++i) out.printf(i ? ",%.3f" : "%.3f", mah[i]);
+    out.printf("],\"sleep_mah_per_day\":%.3f,\"total_mah_per_day\":%.3f}", sleep, total);
+    first = false;
+  }
+  out.printf("]}");
+  out.flush();
+  server.sendContent("");
+}
+
+// GET /metrics — Prometheus text exposition of the registry in metrics.h.
+static void handleMetrics() {
+  mUptime.set(millis() / 1000UL);
+  mHeapFree.set(ESP.getFreeHeap());
+  mRssi.set(WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0);
+  mRxHighWater.set(rxQueue.highWater);
+  for (uint16_t i = 0; i < tankCount; i++) {
+    mLinkLost.set(i, sensorLink[i].lost);
+    if (tankPower[i].rxMillis) mSensorPower.set(i, (uint32_t)(powerMahPerDay(tankPower[i].report, nullptr, nullptr) * 1000.0f + 0.5f));
+  }
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "text/plain; version=0.0.4", "");
+  ChunkedOut out(sendChunk);
+  metricsRender(out);
+  out.flush();
+  server.sendContent("");
+}
+
+// POST /api/siren  with JSON: {"action":"test" | "snooze_10m" | "snooze_20m" | "snooze_1h" | "clear_snooze"
+//                               | "predict_on" | "predict_off"}
 // Optional: support {"tank": 0|1|2|"all"} later; defaults to ALL tanks (255)
+// Queues the command and answers 202 {"ok":true,"id":N,"state":"queued"} right away;
+// the outcome comes as a "siren" SSE event and from GET /api/siren?id=N.
+struct SirenAction { const char *name; uint8_t cmd; uint32_t ms; };
+static const SirenAction SIREN_ACTIONS[] = {
+  {"test",         CMD_FORCE_ON,       5000},
+  {"clear_snooze", CMD_CLEAR_SNOOZE,   0},
+  {"snooze_10m",   CMD_SNOOZE_MS,      10UL*60UL*1000UL},
+  {"snooze_20m",   CMD_SNOOZE_MS,      20UL*60UL*1000UL},
+  {"snooze_1h",    CMD_SNOOZE_MS,      60UL*60UL*1000UL},
+  {"predict_on",   CMD_SET_PREDICTIVE, 1},
+  {"predict_off",  CMD_SET_PREDICTIVE, 0},
+};
+
+static void sendQueued(uint16_t id) {
+  if (!id) {
+    server.send(503, "application/json", "{\"ok\":false,\"error\":\"command queue full\"}");
+    return;
+  }
+  char buf[64];
+  snprintf(buf, sizeof(buf), "{\"ok\":true,\"id\":%u,\"state\":\"queued\"}", id);
+  server.send(202, "application/json", buf);
+}
+
 static void handleSirenPost() {
   if (!server.hasArg("plain")) {
     server.send(400, "application/json", "{\"error\":\"missing body\"}");
@@ -454,46 +1000,116 @@ static void handleSirenPost() {
   // Default to ALL tanks; you can add per-tank control by reading doc["tank"]
   uint8_t tank_id = 255;
 
-  bool ok = false;
-
-  if (strcmp(action, "test") == 0) {
-    ok = sendCommand(/*FORCE_ON*/1, tank_id, /*ms*/5000);
-    server.send(200, "application/json", String("{\"ok\":")+(ok?"true}":"false}"));
-    return;
+  for (const SirenAction &a : SIREN_ACTIONS) {
+    if (strcmp(action, a.name) == 0) {
+      sendQueued(queueCommand(a.cmd, tank_id, a.ms));
+      return;
+    }
   }
 
-  if (strcmp(action, "clear_snooze") == 0) {
-    ok = sendCommand(/*CLEAR_SNOOZE*/4, tank_id, 0);
-    server.send(200, "application/json", String("{\"ok\":")+(ok?"true}":"false}"));
-    return;
-  }
+  server.send(400, "application/json", "{\"error\":\"unknown action\"}");
+}
 
-  // New: map your UI snoozes to SNOOZE_CUSTOM_MS (cmd=5)
-  if (strcmp(action, "snooze_10m") == 0) {
-    ok = sendCommand(/*SNOOZE_CUSTOM_MS*/5, tank_id, 10*60*1000);
-    server.send(200, "application/json", String("{\"ok\":")+(ok?"true}":"false}"));
+// GET /api/siren?id=N: one command's state and latencies (commandJson()). Without id,
+// every command the queue still remembers, oldest first, plus the queue's counters.
+static void handleSirenGet() {
+  char buf[256];
+  if (server.hasArg("id")) {
+    const CmdSlot *c = cmdq.find((uint16_t)server.arg("id").toInt());
+    if (!c) {
+      server.send(404, "application/json", "{\"error\":\"unknown id\"}");
+      return;
+    }
+    commandJson(*c, buf, sizeof(buf));
+    server.send(200, "application/json", buf);
     return;
   }
-  if (strcmp(action, "snooze_20m") == 0) {
-    ok = sendCommand(/*SNOOZE_CUSTOM_MS*/5, tank_id, 20*60*1000);
-    server.send(200, "application/json", String("{\"ok\":")+(ok?"true}":"false}"));
-    return;
+  const CmdSlot *order[CMDQ_DEPTH];
+  size_t n = 0;
+  for (const CmdSlot &c : cmdq.slot) {
+    if (c.state == CMD_FREE) continue;
+    size_t i = n++;
+    for (; i > 0 && (int16_t)(order[i - 1]->pkt.id - c.pkt.id) > 0; --i) order[i] = order[i - 1];
+    order[i] = &c;
   }
-  if (strcmp(action, "snooze_1h") == 0) {
-    ok = sendCommand(/*SNOOZE_CUSTOM_MS*/5, tank_id, 60*60*1000);
-    server.send(200, "application/json", String("{\"ok\":")+(ok?"true}":"false}"));
-    return;
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, "application/json", "");
+  ChunkedOut out(sendChunk);
+  int len = snprintf(buf, sizeof(buf),
+    "{\"submitted\":%lu,\"coalesced\":%lu,\"dropped\":%lu,\"sends\":%lu,\"resends\":%lu,"
+    "\"applied\":%lu,\"rejected\":%lu,\"failed\":%lu,\"commands\":[",
+    (unsigned long)cmdq.submitted, (unsigned long)cmdq.coalesced, (unsigned long)cmdq.dropped,
+    (unsigned long)cmdq.sends, (unsigned long)cmdq.resends, (unsigned long)cmdq.applied,
+    (unsigned long)cmdq.rejected, (unsigned long)cmdq.failed);
+  out.write(buf, len);
+  for (size_t i = 0; i < n; ++i) {
+    if (i) out.printf(",");
+    len = commandJson(*order[i], buf, sizeof(buf));
+    out.write(buf, len < (int)sizeof(buf) ? len : sizeof(buf) - 1);
   }
-
-  server.send(400, "application/json", "{\"error\":\"unknown action\"}");
+  out.printf("]}");
+  out.flush();
+  server.sendContent("");
 }
 
 // ================== Setup ==================
+// ================== Per-tank allocation ==================
+// Everything per tank is sized here, once, from the SENSORS table.
+static bool allocTanks(uint16_t n) {
+  if (!registry.begin(SENSORS, n)) return false;
+  Serial.printf("Registry: %u tanks, %u MACs indexed, %u duplicate MACs ignored\n",
+    (unsigned)n, (unsigned)registry.indexed, (unsigned)registry.duplicates);
+
+  // Full-size ring and tiers while TANK_HISTORY_RAM allows, otherwise scaled down.
+  const uint32_t fullTiers = ROLLUP_MINUTES + ROLLUP_HOURS + ROLLUP_DAYS;
+  const uint32_t full  = HISTORY_RING_BYTES + fullTiers * sizeof(RollupBucket);
+  const float    scale = (float)TANK_HISTORY_RAM / n >= full ? 1.0f : (float)TANK_HISTORY_RAM / n / full;
+  uint32_t ring = HISTORY_RING_BYTES;
+  while (ring > 64 && ring > HISTORY_RING_BYTES * scale) ring >>= 1;
+  const uint16_t minutes = max(1, (int)(ROLLUP_MINUTES * scale));
+  const uint16_t hours   = max(1, (int)(ROLLUP_HOURS * scale));
+  const uint16_t days    = max(1, (int)(ROLLUP_DAYS * scale));
+  const uint32_t tiers   = minutes + hours + days;
+
+  tanks        = (TankState *)calloc(n, sizeof(TankState));
+  tankHistory  = (TankHistory *)calloc(n, sizeof(TankHistory));
+  tankRollups  = (TankRollups *)calloc(n, sizeof(TankRollups));
+  sensorLink   = new LinkStats[n];
+  tankPower    = (TankPower *)calloc(n, sizeof(TankPower));
+  uint8_t      *ringMem = (uint8_t *)malloc((size_t)n * ring);
+  RollupBucket *pool    = (RollupBucket *)calloc((size_t)n * tiers, sizeof(RollupBucket));
+  uint32_t     *vecs    = (uint32_t *)calloc(3 * n, sizeof(uint32_t));
+  statusCap = 160 + (size_t)n * STATUS_TANK_BYTES;
+  statusBuf = (char *)malloc(statusCap);
+  if (!tanks || !tankHistory || !tankRollups || !tankPower || !ringMem || !pool || !vecs || !statusBuf) return false;
+
+  for (uint16_t i = 0; i < n; i++) {
+    tanks[i].distanceCm     = NAN;
+    tanks[i].offlineAfterMs = OFFLINE_MS;
+    tankHistory[i].init(ringMem + (size_t)i * ring, ring);
+    tankRollups[i].init(pool + (size_t)i * tiers, minutes, hours, days);
+  }
+  mRxTankMismatch.bind(vecs, n);
+  mLinkLost.bind(vecs + n, n);
+  mSensorPower.bind(vecs + 2 * n, n);
+  statusBuf[0] = 0;
+  tankCount = n;
+  Serial.printf("Per tank: %u B history ring, rollups %u min / %u h / %u d; status buffer %u B\n",
+    (unsigned)ring, minutes, hours, days, (unsigned)statusCap);
+  return true;
+}
+
 void setup() {
   Serial.begin(115200);
   delay(200);
   Serial.println("\nWebserver MCU booting…");
 
+  // 0) Per-tank state
+  if (!allocTanks(SENSOR_COUNT)) {
+    Serial.printf("Out of memory for %u tanks; halting.\n", (unsigned)SENSOR_COUNT);
+    while (true) delay(1000);
+  }
+
   // 1) Wi-Fi STA
   WiFi.mode(WIFI_STA);
   WiFi.setAutoReconnect(true);
@@ -519,6 +1135,10 @@ void setup() {
   configTime(0, 0, NTP_POOL);
   Serial.println("NTP requested (UTC).");
 
+  // Siren command ids restart at 1; a fresh boot nonce tells the siren so
+  cmdq.begin((uint16_t)esp_random());
+  cmdq.onDone = onCommandDone;
+
   // 3) ESP-NOW - Initialize AFTER WiFi power save is disabled
   if (esp_now_init() != ESP_OK) {
     Serial.println("ESP-NOW init failed!");
@@ -527,34 +1147,60 @@ void setup() {
     esp_err_t cb_result = esp_now_register_recv_cb(onDataRecv);
     Serial.printf("ESP-NOW receive callback registered: %s\n", (cb_result == ESP_OK) ? "OK" : "FAILED");
     
-    // Add all sensor peers for better RX reliability
-    for (int i = 0; i < MAX_TANKS; i++) {
+    // Add sensor peers for better RX reliability. ESP-NOW caps the peer list, and
+    // frames from the rest still arrive (the registry, not the peer list, vets them).
+    // Slot replies to sensors without a peer entry go out by broadcast.
+    for (int i = 0; i < tankCount && i < MAX_SENSOR_PEERS; i++) {
       esp_now_peer_info_t sensor_peer{};
-      memcpy(sensor_peer.peer_addr, MAC_SENSORS[i], 6);
+      memcpy(sensor_peer.peer_addr, SENSORS[i].mac, 6);
       sensor_peer.channel = 0;  // Use current WiFi channel
       sensor_peer.encrypt = false;
       esp_err_t add_result = esp_now_add_peer(&sensor_peer);
       Serial.printf("Added sensor %d peer: %s\n", i, (add_result == ESP_OK) ? "OK" : "FAILED");
     }
+    if (tankCount > MAX_SENSOR_PEERS) {
+      Serial.printf("%d sensors beyond the ESP-NOW peer limit are received without a peer entry\n",
+        tankCount - MAX_SENSOR_PEERS);
+    }
     
     // Add siren peer for sending commands
     addPeer(MAC_SIREN);
+    addPeer(MAC_BROADCAST);   // channel announces, and replies to sensors without a peer
     Serial.println("ESP-NOW ready.");
   }
 
   // Small delay to ensure ESP-NOW is fully initialized
   delay(50);
 
-  // 4) HTTP routes
-  server.on("/", HTTP_GET, handleRoot);
-  server.on("/api/status", HTTP_GET, handleStatus);
-  server.on("/api/siren", HTTP_POST, handleSirenPost);
+#if TELEMETRY_LOG
+  // 4) Telemetry log on SD
+  if (tlogDev.open() && tlog.begin(&tlogDev, TLOG_PAGES_PER_SEG)) {
+    tlogReady = true;
+    Serial.printf("Telemetry log: %u segments, next page %u (seq %u, %u pages recovered)\n",
+      tlog.segments, tlog.nextPage, tlog.nextSeq, tlog.recoveredPages);
+  } else {
+    Serial.println("Telemetry log: SD not available, history stays RAM-only.");
+  }
+#endif
+
+  // 5) HTTP routes
+  server.on("/",            HTTP_GET,  [](){ timed(mHttpRoot,    handleRoot); });
+  server.on("/api/status",  HTTP_GET,  [](){ timed(mHttpStatus,  handleStatus); });
+  server.on("/api/events",  HTTP_GET,  [](){ timed(mHttpEvents,  handleEvents); });
+  server.on("/api/history", HTTP_GET,  [](){ timed(mHttpHistory, handleHistory); });
+  server.on("/api/log",     HTTP_GET,  [](){ timed(mHttpLog,     handleLog); });
+  server.on("/api/power",   HTTP_GET,  [](){ timed(mHttpPower,   handlePower); });
+  server.on("/metrics",     HTTP_GET,  [](){ timed(mHttpMetrics, handleMetrics); });
+  static const char *statusHeaders[] = {"If-None-Match"};
+  server.collectHeaders(statusHeaders, 1);
+  server.on("/api/siren",   HTTP_POST, [](){ timed(mHttpSiren,   handleSirenPost); });
+  server.on("/api/siren",   HTTP_GET,  [](){ timed(mHttpSiren,   handleSirenGet); });
 
   // Legacy optional GET endpoints
-  server.on("/api/force_on",    HTTP_GET, [](){ bool ok=sendCommand(1,255,5000); server.send(200,"application/json",String("{\"ok\":")+(ok?"true}":"false}")); });
-  server.on("/api/force_off",   HTTP_GET, [](){ bool ok=sendCommand(2,255,0);    server.send(200,"application/json",String("{\"ok\":")+(ok?"true}":"false}")); });
-  server.on("/api/snooze",      HTTP_GET, [](){ bool ok=sendCommand(3,255,0);    server.send(200,"application/json",String("{\"ok\":")+(ok?"true}":"false}")); });
-  server.on("/api/clear_snooze",HTTP_GET, [](){ bool ok=sendCommand(4,255,0);    server.send(200,"application/json",String("{\"ok\":")+(ok?"true}":"false}")); });
+  server.on("/api/force_on",    HTTP_GET, [](){ timed(mHttpLegacy, [](){ sendQueued(queueCommand(1,255,5000)); }); });
+  server.on("/api/force_off",   HTTP_GET, [](){ timed(mHttpLegacy, [](){ sendQueued(queueCommand(2,255,0)); }); });
+  server.on("/api/snooze",      HTTP_GET, [](){ timed(mHttpLegacy, [](){ sendQueued(queueCommand(3,255,0)); }); });
+  server.on("/api/clear_snooze",HTTP_GET, [](){ timed(mHttpLegacy, [](){ sendQueued(queueCommand(4,255,0)); }); });
 
   server.begin();
   Serial.println("HTTP server started on port 80.");
@@ -565,7 +1211,16 @@ void setup() {
 
 // ================== Loop ==================
 void loop() {
+  processRx();
+  commandPoll();
   server.handleClient();
+  ssePoll();
+
+  static uint32_t lastTlogFlush = 0;
+  if (tlogReady && millis() - lastTlogFlush > TLOG_FLUSH_MS) {
+    lastTlogFlush = millis();
+    tlog.flush();
+  }
 
   // Power save diagnostic check (every 30s)
   static uint32_t lastPowerSaveCheck = 0;
@@ -580,13 +1235,40 @@ void loop() {
     lastPowerSaveCheck = millis();
   }
 
+  // Channel announce for the siren
+  static uint32_t lastAnnounce = 0;
+  if (millis() - lastAnnounce >= ANNOUNCE_MS) {
+    lastAnnounce = millis();
+    const ChannelAnnounce a = makeAnnounce((uint8_t)WiFi.channel());
+    if (a.channel && esp_now_send(MAC_BROADCAST, (const uint8_t *)&a, sizeof(a)) == ESP_OK) mAnnounce.inc();
+  }
+
   // Heartbeat
   static uint32_t lastBeat = 0;
   if (millis() - lastBeat > 10000) {
     lastBeat = millis();
-    Serial.printf("[beat] NTP %s | CH %d | IP %s\n",
+    uint32_t statusBuilds = 0;
+    for (const Counter &c : mStatusBuilds) statusBuilds += c.value();
+    Serial.printf("[beat] NTP %s | CH %d | IP %s | status builds=%u 200=%u 304=%u bytes=%u\n",
       ntpSynced()? "synced":"not-synced",
       WiFi.channel(),
-      WiFi.localIP().toString().c_str());
+      WiFi.localIP().toString().c_str(),
+      statusBuilds, mStatus200.value(), mStatus304.value(), mStatusBytes.value());
+    Serial.printf("[beat] SSE events=%u dropped=%u | dashboard 200=%u 304=%u redirects=%u (%u B gz)\n",
+      sse.eventsSent, sse.dropped, rootServed, root304, rootRedirects, (unsigned)INDEX_HTML_GZ_LEN);
+    Serial.printf("[beat] RX queue pushed=%u dropped=%u oversize=%u high_water=%u/%d cb_max=%uus\n",
+      rxQueue.pushed, rxQueue.dropped, rxQueue.oversize, rxQueue.highWater, RX_QUEUE_DEPTH, rxQueue.cbMaxUs);
+    Serial.printf("[beat] siren cmds submitted=%u coalesced=%u dropped=%u sends=%u resends=%u applied=%u rejected=%u failed=%u\n",
+      cmdq.submitted, cmdq.coalesced, cmdq.dropped, cmdq.sends, cmdq.resends, cmdq.applied, cmdq.rejected, cmdq.failed);
+    for (uint16_t i = 0; i < tankCount; i++) {
+      const LinkStats &l = sensorLink[i];
+      if (!l.synced) continue;
+      Serial.printf("[beat] T%d link seq=%u rx=%u dup=%u stale=%u lost=%u (%.1f%%) restarts=%u latency avg=%ums max=%ums\n",
+        i, l.newest, l.received, l.duplicates, l.stale, l.lost, 100.0f * l.lossRate(), l.restarts, l.latAvgMs(), l.latMaxMs);
+    }
+    if (tlogReady) {
+      Serial.printf("[beat] TLOG appends=%u pages=%u errors=%u buffered=%u write_amp=%.2f\n",
+        tlog.appends, tlog.pagesWritten, tlog.writeErrors, tlog.pending, tlog.writeAmplification());
+    }
   }
 }
@@ -0,0 +1,75 @@
+# build_dashboard.py — Webserver MCU: web/index.html -> include/index_html_gz.h
+#
+# Minifies the dashboard (conservatively: whitespace and whole-line comments only,
+# newlines are kept so JS semicolon insertion and trailing // comments stay safe),
+# gzips it deterministically and emits a PROGMEM byte array plus a content-hash
+# ETag. handleRoot() serves it with Content-Encoding: gzip.
+#
+# Runs automatically as a PlatformIO pre-script (extra_scripts in platformio.ini)
+# and only rewrites the header when the output changes. Standalone:
+#     python3 tools/build_dashboard.py
+import gzip
+import hashlib
+import os
+import re
+
+try:
+    Import("env")  # noqa: F821  (PlatformIO/SCons)
+    PROJECT_DIR = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SRC = os.path.join(PROJECT_DIR, "web", "index.html")
+OUT = os.path.join(PROJECT_DIR, "include", "index_html_gz.h")
+
+
+def minify(html):
+    out = []
+    for line in html.splitlines():
+        line = line.strip()
+        if not line or line.startswith("//"):
+            continue
+        line = re.sub(r"/\*.*?\*/", "", line)  # single-line CSS comments
+        line = re.sub(r">\s+<", "><", line)
+        if line:
+            out.append(line)
+    return "\n".join(out) + "\n"
+
+
+def build():
+    with open(SRC, encoding="utf-8") as f:
+        raw = f.read()
+    mini = minify(raw).encode("utf-8")
+    gz = gzip.compress(mini, compresslevel=9, mtime=0)
+    etag = hashlib.sha256(gz).hexdigest()[:16]
+
+    rows = []
+    for i in range(0, len(gz), 20):
+        rows.append("  " + ",".join("0x%02x" % b for b in gz[i:i + 20]) + ",")
+
+    header = (
+        "// index_html_gz.h — GENERATED by tools/build_dashboard.py from web/index.html.\n"
+        "// Do not edit; change web/index.html and rebuild.\n"
+        "// raw %d B -> minified %d B -> gzip %d B\n"
+        "#pragma once\n"
+        "#include <stdint.h>\n"
+        "#include <stddef.h>\n\n"
+        "#define INDEX_HTML_ETAG \"\\\"%s\\\"\"\n"
+        "#define INDEX_HTML_HASH \"%s\"\n\n"
+        "static const size_t INDEX_HTML_GZ_LEN = %d;\n"
+        "static const uint8_t INDEX_HTML_GZ[] PROGMEM = {\n%s\n};\n"
+        % (len(raw.encode("utf-8")), len(mini), len(gz), etag, etag, len(gz), "\n".join(rows))
+    )
+
+    old = None
+    if os.path.exists(OUT):
+        with open(OUT, encoding="utf-8") as f:
+            old = f.read()
+    if header != old:
+        with open(OUT, "w", encoding="utf-8") as f:
+            f.write(header)
+        print("build_dashboard: %s (%d -> %d -> %d B, etag %s)"
+              % (os.path.relpath(OUT, PROJECT_DIR), len(raw), len(mini), len(gz), etag))
+
+
+build()